@@ -0,0 +1,194 @@
+#include "AppOptions.h"
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <climits>
+
+// Prints the supported command line arguments
+static void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+        << "  --frame-mode=vsync|cap|idle|unlimited  Frame pacing (default vsync)\n"
+        << "  --fps=N                      Frame rate limit for --frame-mode=cap (default 60)\n"
+        << "  --gpu-budget=MS              GPU time target for dynamic resolution, 0 disables it (default 14)\n"
+        << "  --sharpen=S                  Upscale sharpening strength from 0 to 1 (default 0.5)\n"
+        << "  --trace-frames=N             Write a CPU trace of the first N frames (profiling builds)\n"
+        << "  --sim-hz=N                   Simulation thread tick rate, 0 runs it on the render thread (default 60)\n"
+        << "  --job-threads=N              Worker threads for culling, draw lists and visitors, 0 = none\n"
+        << "                               (default one per core besides the main thread)\n"
+        << "  --audio=OUTPUT               Sound output: winmm (sound card, Windows default), null (mixed and\n"
+        << "                               discarded, default elsewhere and headless), wav:FILE (recorded) or off\n"
+        << "  --pack=FILE|off              Asset pack written by museum_cook (default museum.pack, loose files\n"
+        << "                               when it does not exist)\n"
+        << "  --shared-meshes              Share imported model files with other instances running side by side\n"
+        << "                               (each model imported and held in memory once)\n"
+        << "  --hot-reload                 Reload edited model and shader files while running (a file that fails\n"
+        << "                               to import or compile keeps the version in use)\n"
+        << "  --resolution=WxH             Window / render resolution (default 800x600)\n"
+        << "  --headless[=egl|osmesa]      Render offscreen without a display (default egl)\n"
+        << "  --frames=N                   Stop after N frames (headless default 300)\n"
+        << "  --dump-frames=DIR            Save every rendered frame as DIR/frame_NNNN.png\n"
+        << "  --golden=DIR                 Compare every frame with DIR/frame_NNNN.png\n"
+        << "  --golden-tolerance=N         Largest channel difference counted as equal (default 2)\n"
+        << "  --benchmark[=FILE]           Run the full robot tour with fixed steps, write JSON (default benchmark.json)\n"
+        << "  --hitch-ms=MS                Frame time counted as a hitch in the benchmark (default 33.3)\n"
+        << "  --rooms=N --exhibits=N --robots=N --visitors=N --lights=N --triangles=N --seed=N\n"
+        << "                               Generate a stress-test museum (N rooms, exhibits per room, robots, crowd\n"
+        << "                               visitors, lights up to 32, triangles per generated exhibit or 0 for the\n"
+        << "                               model files)\n";
+}
+
+// Whole number of at least minimum, nothing but digits after it
+static bool parseInt(const std::string& value, int minimum, int& result) {
+    char* end = nullptr;
+    long number = std::strtol(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0' || number < minimum || number > INT_MAX) return false;
+    result = (int)number;
+    return true;
+}
+
+// Number from minimum to maximum, nothing but digits after it
+static bool parseFloat(const std::string& value, float minimum, float maximum, float& result) {
+    char* end = nullptr;
+    float number = std::strtof(value.c_str(), &end);
+    if (value.empty() || *end != '\0' || !(number >= minimum && number <= maximum)) return false;
+    result = number;
+    return true;
+}
+
+// Reports an argument whose value is out of range, like an unknown option
+static bool invalidValue(const char* program, const std::string& key, const std::string& value) {
+    std::cerr << "Invalid value for " << key << ": " << value << "\n";
+    printUsage(program);
+    return false;
+}
+
+bool parseAppOptions(int argc, char** argv, AppOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        // Split "--key=value" into key and value
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = (eq == std::string::npos) ? "" : arg.substr(eq + 1);
+
+        if (key == "--frame-mode") {
+            if (!parseFrameMode(value.c_str(), options.frameMode)) {
+                std::cerr << "Unknown frame mode: " << value << "\n";
+                printUsage(argv[0]);
+                return false;
+            }
+        }
+        else if (key == "--fps") {
+            if (!parseInt(value, 1, options.targetFps)) return invalidValue(argv[0], key, value);
+        }
+        else if (key == "--gpu-budget") {
+            if (!parseFloat(value, 0.0f, 1000.0f, options.gpuBudgetMs)) return invalidValue(argv[0], key, value);
+        }
+        else if (key == "--sharpen") {
+            if (!parseFloat(value, 0.0f, 1.0f, options.sharpness)) return invalidValue(argv[0], key, value);
+        }
+        else if (key == "--trace-frames") {
+            if (!parseInt(value, 0, options.traceFrames)) return invalidValue(argv[0], key, value);
+        }
+        else if (key == "--sim-hz") {
+            if (!parseInt(value, 0, options.simulationHz)) return invalidValue(argv[0], key, value);
+        }
+        else if (key == "--job-threads") {
+            if (!parseInt(value, 0, options.jobThreads)) return invalidValue(argv[0], key, value);
+        }
+        else if (key == "--audio") {
+            options.audioOutput = value;
+            if (value != "winmm" && value != "null" && value != "off" && (value.compare(0, 4, "wav:") != 0 || value.size() <= 4)) {
+                std::cerr << "Unknown audio output: " << value << "\n";
+                return false;
+            }
+        }
+        else if (key == "--pack") {
+            options.packPath = value;
+            if (value.empty()) {
+                std::cerr << "Missing asset pack file\n";
+                return false;
+            }
+        }
+        else if (key == "--shared-meshes") options.sharedMeshes = true;
+        else if (key == "--hot-reload") options.hotReload = true;
+        else if (key == "--resolution") {
+            size_t x = value.find('x');
+            if (x == std::string::npos || !parseInt(value.substr(0, x), 1, options.width) ||
+                !parseInt(value.substr(x + 1), 1, options.height)) return invalidValue(argv[0], key, value);
+        }
+        else if (key == "--headless") {
+            options.headless = true;
+            if (!value.empty()) options.headlessApi = value;
+            if (options.headlessApi != "egl" && options.headlessApi != "osmesa") {
+                std::cerr << "Unknown headless API: " << value << "\n";
+                return false;
+            }
+        }
+        else if (key == "--frames") {
+            if (!parseInt(value, 1, options.frameCount)) return invalidValue(argv[0], key, value);
+        }
+        else if (key == "--dump-frames") {
+            options.dumpDir = value;
+        }
+        else if (key == "--golden") {
+            options.goldenDir = value;
+        }
+        else if (key == "--golden-tolerance") {
+            if (!parseInt(value, 0, options.goldenTolerance)) return invalidValue(argv[0], key, value);
+        }
+        else if (key == "--benchmark") {
+            options.benchmark = true;
+            if (!value.empty()) options.benchmarkReport = value;
+        }
+        else if (key == "--hitch-ms") {
+            if (!parseFloat(value, 0.001f, 1000000.0f, options.hitchThresholdMs)) return invalidValue(argv[0], key, value);
+        }
+        else if (key == "--rooms" || key == "--exhibits" || key == "--robots" || key == "--visitors" ||
+            key == "--lights" || key == "--triangles" || key == "--seed") {
+            // A museum needs a room; everything else may be left out
+            int number;
+            int minimum = key == "--rooms" ? 1 : 0;
+            if (!parseInt(value, minimum, number)) return invalidValue(argv[0], key, value);
+            SceneParams& scene = options.sceneParams;
+            if (key == "--rooms") scene.rooms = number;
+            else if (key == "--exhibits") scene.exhibitsPerRoom = number;
+            else if (key == "--robots") scene.robots = number;
+            else if (key == "--visitors") scene.visitors = number;
+            else if (key == "--lights") scene.lights = number;
+            else if (key == "--triangles") scene.trianglesPerExhibit = number;
+            else scene.seed = (unsigned int)number;
+            options.generateScene = true;
+        }
+        else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+
+    // Headless runs are deterministic: fixed steps, full resolution and a frame limit
+    if (options.headless) {
+        if (options.audioOutput.empty()) options.audioOutput = "null";
+        if (options.frameCount <= 0 && !options.benchmark) options.frameCount = 300;
+        options.fixedTimestep = 1.0f / 60.0f;
+        options.gpuBudgetMs = 0.0f;
+    }
+
+    // Benchmarks run the same simulation every time and never wait for the display
+    if (options.benchmark) {
+        options.fixedTimestep = 1.0f / 60.0f;
+        options.gpuBudgetMs = 0.0f;
+        options.frameMode = FRAME_MODE_UNLIMITED;
+    }
+
+    // Sound card by default where there is a backend for it
+    if (options.audioOutput.empty()) {
+#ifdef _WIN32
+        options.audioOutput = "winmm";
+#else
+        options.audioOutput = "null";
+#endif
+    }
+    return true;
+}
@@ -0,0 +1,48 @@
+#ifndef APPOPTIONS_H
+#define APPOPTIONS_H
+
+#include <string>
+#include "FrameScheduler.h"
+#include "SceneGenerator.h"
+
+// Settings selected on the command line
+struct AppOptions {
+    FrameMode frameMode = FRAME_MODE_VSYNC;  // --frame-mode=vsync|cap|idle|unlimited
+    int targetFps = 60;                      // --fps=N (used by the cap mode)
+    float gpuBudgetMs = 14.0f;               // --gpu-budget=MS (0 keeps full resolution)
+    float sharpness = 0.5f;                  // --sharpen=0..1 (upscale sharpening strength)
+    int traceFrames = 0;                     // --trace-frames=N (CPU trace of the first N frames)
+    int simulationHz = 60;                   // --sim-hz=N (simulation thread rate, 0 = simulate on the render thread)
+    int jobThreads = -1;                     // --job-threads=N (frame job workers, -1 = one per extra core)
+    std::string audioOutput;                 // --audio=winmm|null|wav:FILE|off (empty = sound card, null when headless)
+    std::string packPath = "museum.pack";    // --pack=FILE|off (cooked models and sounds, used if the file exists)
+    bool sharedMeshes = false;               // --shared-meshes (imported model files shared between running instances)
+    bool hotReload = false;                  // --hot-reload (edited models and shaders reloaded while running)
+
+    // Window / render resolution
+    int width = 800;                         // --resolution=WxH
+    int height = 600;
+
+    // Headless rendering (no display needed, e.g. CI or render farm)
+    bool headless = false;                   // --headless[=egl|osmesa]
+    std::string headlessApi = "egl";         // Context creation API on GLFW's null platform
+    int frameCount = 0;                      // --frames=N (0 = run until closed, headless default 300)
+    float fixedTimestep = 0.0f;              // Simulation step in seconds, 0 = measured frame time
+    std::string dumpDir;                     // --dump-frames=DIR (write frame_NNNN.png)
+    std::string goldenDir;                   // --golden=DIR (compare with earlier dumps)
+    int goldenTolerance = 2;                 // --golden-tolerance=N (max channel difference)
+
+    // Scripted tour benchmark
+    bool benchmark = false;                  // --benchmark[=FILE]
+    std::string benchmarkReport = "benchmark.json";
+    float hitchThresholdMs = 33.3f;          // --hitch-ms=MS
+
+    // Synthetic stress scene instead of the hand-placed museum
+    bool generateScene = false;              // Set by any of --rooms/--exhibits/--robots/--visitors/--lights/--triangles/--seed
+    SceneParams sceneParams;
+};
+
+// Parses "--key=value" arguments, returns false (after printing usage) on errors
+bool parseAppOptions(int argc, char** argv, AppOptions& options);
+
+#endif
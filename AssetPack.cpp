@@ -0,0 +1,401 @@
+#include "AssetPack.h"
+#include "CpuProfiler.h"
+#include "JobSystem.h"
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+// LZ4 block rules: matches are at least 4 bytes, the last 5 bytes are always literals
+// and no match starts in the last 12 bytes
+static const size_t MIN_MATCH = 4;
+static const size_t LAST_LITERALS = 5;
+static const size_t MATCH_SAFE_DISTANCE = 12;
+static const size_t MAX_OFFSET = 65535;
+static const int HASH_BITS = 16;
+
+static unsigned int hashSequence(const unsigned char* data) {
+    unsigned int value;
+    std::memcpy(&value, data, 4);
+    return (value * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// Length above the 4-bit token field as a run of 255s and a final byte
+static bool writeLength(unsigned char*& out, unsigned char* end, size_t length) {
+    for (; length >= 255; length -= 255) {
+        if (out >= end) return false;
+        *out++ = 255;
+    }
+    if (out >= end) return false;
+    *out++ = (unsigned char)length;
+    return true;
+}
+
+// One sequence: literals followed by a match (matchLength 0 for the last, match-less sequence)
+static bool writeSequence(unsigned char*& out, unsigned char* end, const unsigned char* literals, size_t literalLength,
+                          size_t matchOffset, size_t matchLength) {
+    if (out >= end) return false;
+    unsigned char* token = out++;
+    *token = (unsigned char)((literalLength < 15 ? literalLength : 15) << 4);
+    if (literalLength >= 15 && !writeLength(out, end, literalLength - 15)) return false;
+    if ((size_t)(end - out) < literalLength) return false;
+    std::memcpy(out, literals, literalLength);
+    out += literalLength;
+    if (matchLength == 0) return true;
+
+    if (end - out < 2) return false;
+    *out++ = (unsigned char)matchOffset;
+    *out++ = (unsigned char)(matchOffset >> 8);
+    size_t extra = matchLength - MIN_MATCH;
+    *token |= (unsigned char)(extra < 15 ? extra : 15);
+    return extra < 15 || writeLength(out, end, extra - 15);
+}
+
+size_t packCompress(const unsigned char* source, size_t size, unsigned char* destination, size_t capacity) {
+    if (size == 0) return 0;
+    std::vector<unsigned int> table((size_t)1 << HASH_BITS, 0);     // Last position of every hashed 4-byte sequence
+    unsigned char* out = destination;
+    unsigned char* end = destination + capacity;
+    size_t anchor = 0, position = 0;
+    size_t matchLimit = size > MATCH_SAFE_DISTANCE ? size - MATCH_SAFE_DISTANCE : 0;
+
+    while (position < matchLimit) {
+        unsigned int hash = hashSequence(source + position);
+        size_t candidate = table[hash];
+        table[hash] = (unsigned int)position;
+        if (candidate >= position || position - candidate > MAX_OFFSET || std::memcmp(source + candidate, source + position, 4) != 0) {
+            position++;
+            continue;
+        }
+
+        // Grow the match backwards into the pending literals, then forwards
+        while (position > anchor && candidate > 0 && source[position - 1] == source[candidate - 1]) {
+            position--;
+            candidate--;
+        }
+        size_t length = MIN_MATCH;
+        size_t longest = size - LAST_LITERALS - position;
+        while (length < longest && source[position + length] == source[candidate + length]) length++;
+
+        if (!writeSequence(out, end, source + anchor, position - anchor, position - candidate, length)) return 0;
+        position += length;
+        anchor = position;
+    }
+    if (!writeSequence(out, end, source + anchor, size - anchor, 0, 0)) return 0;
+
+    size_t written = out - destination;
+    return written < size ? written : 0;
+}
+
+static bool readLength(const unsigned char*& in, const unsigned char* end, size_t& length) {
+    unsigned char byte;
+    do {
+        if (in >= end) return false;
+        byte = *in++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+bool packDecompress(const unsigned char* source, size_t compressedSize, unsigned char* destination, size_t size) {
+    const unsigned char* in = source;
+    const unsigned char* inEnd = source + compressedSize;
+    unsigned char* out = destination;
+    unsigned char* outEnd = destination + size;
+
+    while (in < inEnd) {
+        unsigned int token = *in++;
+        size_t literalLength = token >> 4;
+        if (literalLength == 15 && !readLength(in, inEnd, literalLength)) return false;
+        if (literalLength > (size_t)(inEnd - in) || literalLength > (size_t)(outEnd - out)) return false;
+        std::memcpy(out, in, literalLength);
+        in += literalLength;
+        out += literalLength;
+        if (in == inEnd) break;     // Last sequence has no match
+
+        if (inEnd - in < 2) return false;
+        size_t matchOffset = in[0] | (in[1] << 8);
+        in += 2;
+        size_t matchLength = (token & 15) + MIN_MATCH;
+        if ((token & 15) == 15 && !readLength(in, inEnd, matchLength)) return false;
+        if (matchOffset == 0 || matchOffset > (size_t)(out - destination) || matchLength > (size_t)(outEnd - out)) return false;
+
+        // Overlapping matches repeat the last bytes, so they are copied forwards byte by byte
+        const unsigned char* match = out - matchOffset;
+        if (matchOffset >= matchLength) std::memcpy(out, match, matchLength);
+        else for (size_t i = 0; i < matchLength; i++) out[i] = match[i];
+        out += matchLength;
+    }
+    return out == outEnd;
+}
+
+AssetPack::AssetPack() : assets(nullptr), chunks(nullptr), assetCount(0), chunkCount(0) {}
+
+void AssetPack::close() {
+    file.close();
+    assets = nullptr;
+    chunks = nullptr;
+    assetCount = chunkCount = 0;
+}
+
+bool AssetPack::open(const std::string& path) {
+    close();
+    if (!file.open(path)) return false;
+
+    // Tables are checked once here, so lookups and decoding need no bounds checks on them
+    const unsigned char* data = file.getData();
+    unsigned long long size = file.getSize();
+    PackHeader header;
+    bool valid = size >= sizeof(PackHeader);
+    if (valid) {
+        std::memcpy(&header, data, sizeof(header));
+        valid = std::memcmp(header.magic, "MPAK", 4) == 0 && header.version == PACK_VERSION &&
+                header.assetsOffset % 8 == 0 && header.chunksOffset % 8 == 0 &&
+                header.assetsOffset + (unsigned long long)header.assetCount * sizeof(PackAsset) <= size &&
+                header.chunksOffset + (unsigned long long)header.chunkCount * sizeof(PackChunk) <= size;
+    }
+    if (valid) {
+        assets = (const PackAsset*)(data + header.assetsOffset);
+        chunks = (const PackChunk*)(data + header.chunksOffset);
+        for (unsigned int i = 0; i < header.chunkCount && valid; i++) {
+            valid = chunks[i].offset + chunks[i].compressedSize <= size && chunks[i].compressedSize <= chunks[i].size &&
+                    chunks[i].size <= PACK_CHUNK_SIZE;
+        }
+        for (unsigned int i = 0; i < header.assetCount && valid; i++) {
+            const PackAsset& asset = assets[i];
+            valid = std::memchr(asset.name, '\0', PACK_NAME_LENGTH) != nullptr &&
+                    (unsigned long long)asset.firstChunk + asset.chunkCount <= header.chunkCount &&
+                    (asset.size + PACK_CHUNK_SIZE - 1) / PACK_CHUNK_SIZE == asset.chunkCount &&
+                    asset.infoOffset % 8 == 0 && asset.infoOffset + asset.infoSize <= size;
+        }
+    }
+    if (!valid) {
+        std::cerr << "ERROR::PACK::INVALID_FILE: " << path << std::endl;
+        close();
+        return false;
+    }
+    assetCount = (int)header.assetCount;
+    chunkCount = (int)header.chunkCount;
+    return true;
+}
+
+int AssetPack::find(const std::string& name) const {
+    for (int i = 0; i < assetCount; i++) {
+        if (name == assets[i].name) return i;
+    }
+    return -1;
+}
+
+const void* AssetPack::getInfo(int asset) const {
+    return assets[asset].infoSize > 0 ? file.getData() + assets[asset].infoOffset : nullptr;
+}
+
+bool AssetPack::isCurrent(int asset, const std::string& sourcePath) const {
+    unsigned long long size;
+    long long time;
+    if (!getSourceStamp(sourcePath, size, time)) return true;
+    return size == assets[asset].sourceSize && time == assets[asset].sourceTime;
+}
+
+// Chunks of one asset decoded in parallel, each to its fixed place in the destination
+struct PackDecodeJob {
+    const AssetPack* pack;
+    const PackAsset* asset;
+    unsigned char* destination;
+    std::atomic<int> failures;
+};
+
+static void decodeChunks(void* data, int begin, int end) {
+    PackDecodeJob* job = (PackDecodeJob*)data;
+    for (int i = begin; i < end; i++) {
+        int chunk = job->asset->firstChunk + i;
+        const PackChunk& info = job->pack->getChunk(chunk);
+        unsigned long long offset = (unsigned long long)i * PACK_CHUNK_SIZE;
+        bool ok = offset + info.size <= job->asset->size;
+        if (ok && info.compressedSize == info.size) std::memcpy(job->destination + offset, job->pack->chunkData(chunk), info.size);
+        else if (ok) ok = packDecompress(job->pack->chunkData(chunk), info.compressedSize, job->destination + offset, info.size);
+        if (!ok) job->failures.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool AssetPack::decompress(int asset, unsigned char* destination, JobSystem* jobs) const {
+    PROFILE_SCOPE("AssetPack::decompress");
+    PackDecodeJob job;
+    job.pack = this;
+    job.asset = &assets[asset];
+    job.destination = destination;
+    job.failures.store(0);
+    int count = (int)assets[asset].chunkCount;
+    if (jobs) jobs->parallelFor(count, 1, decodeChunks, &job);
+    else decodeChunks(&job, 0, count);
+    if (job.failures.load() > 0) {
+        std::cerr << "ERROR::PACK::CORRUPT_ASSET: " << assets[asset].name << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool getSourceStamp(const std::string& path, unsigned long long& size, long long& time) {
+    std::error_code error;
+    size = std::filesystem::file_size(path, error);
+    if (error) return false;
+    time = (long long)std::filesystem::last_write_time(path, error).time_since_epoch().count();
+    return !error;
+}
+
+AssetPackWriter::AssetPackWriter() : offset(0), compressedBytes(0), rawBytes(0) {}
+
+AssetPackWriter::~AssetPackWriter() {
+    // Unfinished pack: the previous file stays
+    if (output.is_open()) {
+        output.close();
+        std::error_code error;
+        std::filesystem::remove(temporaryPath, error);
+    }
+}
+
+bool AssetPackWriter::begin(const std::string& packPath) {
+    path = packPath;
+    temporaryPath = packPath + ".tmp";
+    output.open(temporaryPath.c_str(), std::ios::binary | std::ios::trunc);
+    if (!output) {
+        std::cerr << "ERROR::PACK::CANNOT_WRITE: " << temporaryPath << std::endl;
+        return false;
+    }
+    // Header placeholder, written again by finish
+    PackHeader header;
+    std::memset(&header, 0, sizeof(header));
+    offset = 0;
+    return write(&header, sizeof(header));
+}
+
+bool AssetPackWriter::write(const void* data, size_t size) {
+    output.write((const char*)data, size);
+    offset += size;
+    if (!output) {
+        std::cerr << "ERROR::PACK::CANNOT_WRITE: " << temporaryPath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Info blocks are read in place, so they start 8-byte aligned
+bool AssetPackWriter::addInfo(PackAsset& asset, const void* info, unsigned int infoSize) {
+    static const unsigned char padding[8] = { 0 };
+    if (offset % 8 != 0 && !write(padding, 8 - offset % 8)) return false;
+    asset.infoOffset = offset;
+    asset.infoSize = infoSize;
+    return infoSize == 0 || write(info, infoSize);
+}
+
+// Chunks of one asset compressed in parallel into their own buffers
+struct PackEncodeJob {
+    const unsigned char* data;
+    size_t size;
+    std::vector<std::vector<unsigned char>> outputs;
+    std::vector<size_t> sizes;
+};
+
+static void encodeChunks(void* data, int begin, int end) {
+    PackEncodeJob* job = (PackEncodeJob*)data;
+    for (int i = begin; i < end; i++) {
+        size_t offset = (size_t)i * PACK_CHUNK_SIZE;
+        size_t size = job->size - offset < PACK_CHUNK_SIZE ? job->size - offset : PACK_CHUNK_SIZE;
+        job->outputs[i].resize(size);
+        job->sizes[i] = packCompress(job->data + offset, size, job->outputs[i].data(), size);
+    }
+}
+
+bool AssetPackWriter::addAsset(const std::string& name, PackAssetType type, unsigned int cookVersion,
+                               const void* info, unsigned int infoSize, const unsigned char* data, size_t size,
+                               unsigned long long sourceSize, long long sourceTime, JobSystem* jobs) {
+    if (name.size() >= PACK_NAME_LENGTH) {
+        std::cerr << "ERROR::PACK::NAME_TOO_LONG: " << name << std::endl;
+        return false;
+    }
+    PackAsset asset;
+    std::memset(&asset, 0, sizeof(asset));
+    std::memcpy(asset.name, name.c_str(), name.size());
+    asset.type = type;
+    asset.cookVersion = cookVersion;
+    asset.size = size;
+    asset.sourceSize = sourceSize;
+    asset.sourceTime = sourceTime;
+    if (!addInfo(asset, info, infoSize)) return false;
+
+    PackEncodeJob job;
+    job.data = data;
+    job.size = size;
+    int count = (int)((size + PACK_CHUNK_SIZE - 1) / PACK_CHUNK_SIZE);
+    job.outputs.resize(count);
+    job.sizes.resize(count);
+    if (jobs) jobs->parallelFor(count, 1, encodeChunks, &job);
+    else encodeChunks(&job, 0, count);
+
+    // Chunks that do not shrink are stored as they are
+    asset.firstChunk = (unsigned int)chunks.size();
+    asset.chunkCount = (unsigned int)count;
+    for (int i = 0; i < count; i++) {
+        PackChunk chunk;
+        chunk.offset = offset;
+        chunk.size = (unsigned int)job.outputs[i].size();
+        chunk.compressedSize = job.sizes[i] > 0 ? (unsigned int)job.sizes[i] : chunk.size;
+        const unsigned char* bytes = job.sizes[i] > 0 ? job.outputs[i].data() : data + (size_t)i * PACK_CHUNK_SIZE;
+        if (!write(bytes, chunk.compressedSize)) return false;
+        chunks.push_back(chunk);
+        compressedBytes += chunk.compressedSize;
+    }
+    rawBytes += size;
+    assets.push_back(asset);
+    return true;
+}
+
+bool AssetPackWriter::copyAsset(const AssetPack& pack, int index) {
+    PackAsset asset = pack.getAsset(index);
+    if (!addInfo(asset, pack.getInfo(index), asset.infoSize)) return false;
+
+    unsigned int firstChunk = asset.firstChunk;
+    asset.firstChunk = (unsigned int)chunks.size();
+    for (unsigned int i = 0; i < asset.chunkCount; i++) {
+        PackChunk chunk = pack.getChunk(firstChunk + i);
+        const unsigned char* bytes = pack.chunkData(firstChunk + i);
+        chunk.offset = offset;
+        if (!write(bytes, chunk.compressedSize)) return false;
+        chunks.push_back(chunk);
+        compressedBytes += chunk.compressedSize;
+    }
+    rawBytes += asset.size;
+    assets.push_back(asset);
+    return true;
+}
+
+bool AssetPackWriter::finish() {
+    static const unsigned char padding[8] = { 0 };
+    PackHeader header;
+    std::memcpy(header.magic, "MPAK", 4);
+    header.version = PACK_VERSION;
+    header.assetCount = (unsigned int)assets.size();
+    header.chunkCount = (unsigned int)chunks.size();
+
+    if (offset % 8 != 0 && !write(padding, 8 - offset % 8)) return false;
+    header.assetsOffset = offset;
+    if (!assets.empty() && !write(assets.data(), assets.size() * sizeof(PackAsset))) return false;
+    header.chunksOffset = offset;
+    if (!chunks.empty() && !write(chunks.data(), chunks.size() * sizeof(PackChunk))) return false;
+
+    output.seekp(0);
+    output.write((const char*)&header, sizeof(header));
+    output.close();
+    if (!output) {
+        std::cerr << "ERROR::PACK::CANNOT_WRITE: " << temporaryPath << std::endl;
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error) {
+        std::cerr << "ERROR::PACK::CANNOT_REPLACE: " << path << " (" << error.message() << ")" << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,159 @@
+#ifndef ASSETPACK_H
+#define ASSETPACK_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+class JobSystem;
+
+// Pack file layout: header, compressed chunk data and info blocks, asset table, chunk table
+#define PACK_VERSION 1
+
+// Uncompressed bytes per chunk; chunks compress and decompress independently, so a
+// large asset decodes on all worker threads
+#define PACK_CHUNK_SIZE (256 * 1024)
+
+#define PACK_NAME_LENGTH 112
+
+enum PackAssetType {
+    PACK_ASSET_MESH = 1,    // CookedMeshInfo + vertices and indices (see ModelLoader)
+    PACK_ASSET_SOUND = 2    // WAV file as it was on disk
+};
+
+struct PackHeader {
+    char magic[4];                      // "MPAK"
+    unsigned int version;
+    unsigned int assetCount;
+    unsigned int chunkCount;
+    unsigned long long assetsOffset;    // PackAsset[assetCount]
+    unsigned long long chunksOffset;    // PackChunk[chunkCount]
+};
+
+struct PackAsset {
+    char name[PACK_NAME_LENGTH];        // Source path as the catalog names it, NUL terminated
+    unsigned int type;                  // PackAssetType
+    unsigned int cookVersion;           // Cooker settings the asset was built with
+    unsigned int firstChunk, chunkCount;
+    unsigned long long size;            // Uncompressed payload size
+    unsigned long long infoOffset;      // Uncompressed description of the payload (e.g. CookedMeshInfo)
+    unsigned int infoSize;
+    unsigned int reserved;
+    unsigned long long sourceSize;      // Source file when it was cooked (incremental cooking)
+    long long sourceTime;
+};
+
+struct PackChunk {
+    unsigned long long offset;
+    unsigned int compressedSize;        // Equal to size: stored uncompressed
+    unsigned int size;
+};
+
+// Cooked mesh payload: quantized vertices of every level of detail, then the indices
+#define COOKED_MESH_VERSION 3
+#define COOKED_MAX_LODS 4
+
+struct CookedVertex {
+    unsigned short position[4];         // Normalized to the bounding box (w unused)
+    signed char normal[4];              // Normalized -127..127 (w unused)
+};
+
+struct CookedLod {
+    unsigned int firstIndex, indexCount;
+};
+
+struct CookedMeshInfo {
+    unsigned int vertexCount;
+    unsigned int indexSize;             // 2 or 4 bytes
+    unsigned int lodCount;
+    CookedLod lods[COOKED_MAX_LODS];    // Level 0 is the full mesh
+    float boxLow[3], boxScale[3];       // position = boxLow + quantized / 65535 * boxScale (the same on all axes)
+    float boundsCenter[3], boundsRadius, footprintRadius;
+};
+
+// LZ4 block format (token, literals, 16-bit offset, match length) without a frame;
+// returns the compressed size, 0 when the result would not be smaller than the input
+size_t packCompress(const unsigned char* source, size_t size, unsigned char* destination, size_t capacity);
+
+// Decodes exactly size bytes, false on corrupt input (never writes past destination + size)
+bool packDecompress(const unsigned char* source, size_t compressedSize, unsigned char* destination, size_t size);
+
+// Read-only, memory-mapped asset pack written by museum_cook. Opening reads only the
+// tables; payloads are decompressed on request, chunk by chunk on the job system,
+// straight into the caller's memory (e.g. a mapped GL buffer).
+class AssetPack {
+public:
+    AssetPack();
+
+    // Maps the pack, false (after printing why) if it is missing or invalid
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return file.isOpen(); }
+
+    int getAssetCount() const { return assetCount; }
+    const PackAsset& getAsset(int asset) const { return assets[asset]; }
+    const PackChunk& getChunk(int chunk) const { return chunks[chunk]; }
+
+    // Asset index by name, -1 when the pack does not have it
+    int find(const std::string& name) const;
+
+    // Info block of an asset (e.g. CookedMeshInfo), null when it has none
+    const void* getInfo(int asset) const;
+
+    // True unless the source file exists and differs from the one that was cooked
+    bool isCurrent(int asset, const std::string& sourcePath) const;
+
+    // Decompresses the whole payload (getAsset(asset).size bytes); jobs may be null
+    bool decompress(int asset, unsigned char* destination, JobSystem* jobs) const;
+
+    // Compressed bytes of a chunk inside the mapping
+    const unsigned char* chunkData(int chunk) const { return file.getData() + chunks[chunk].offset; }
+
+private:
+    MappedFile file;
+    const PackAsset* assets;
+    const PackChunk* chunks;
+    int assetCount;
+    int chunkCount;
+};
+
+// Size and modification time of a file, false if it does not exist
+bool getSourceStamp(const std::string& path, unsigned long long& size, long long& time);
+
+// Writes a pack: assets are added one by one (new ones compressed on the job system,
+// unchanged ones copied from the previous pack without decoding), then finish writes
+// the tables. The file is written under a temporary name and renamed at the end.
+class AssetPackWriter {
+public:
+    AssetPackWriter();
+    ~AssetPackWriter();
+
+    bool begin(const std::string& path);
+
+    bool addAsset(const std::string& name, PackAssetType type, unsigned int cookVersion,
+                  const void* info, unsigned int infoSize, const unsigned char* data, size_t size,
+                  unsigned long long sourceSize, long long sourceTime, JobSystem* jobs);
+
+    // Copies an asset of an existing pack as it is
+    bool copyAsset(const AssetPack& pack, int asset);
+
+    // Writes the tables and replaces the target file (close any AssetPack reading it first)
+    bool finish();
+
+    unsigned long long getCompressedBytes() const { return compressedBytes; }
+    unsigned long long getRawBytes() const { return rawBytes; }
+
+private:
+    std::string path, temporaryPath;
+    std::ofstream output;
+    unsigned long long offset;
+    std::vector<PackAsset> assets;
+    std::vector<PackChunk> chunks;
+    unsigned long long compressedBytes, rawBytes;
+
+    bool write(const void* data, size_t size);
+    bool addInfo(PackAsset& asset, const void* info, unsigned int infoSize);
+};
+
+#endif
@@ -0,0 +1,136 @@
+#include "AssetReloader.h"
+#include "CpuProfiler.h"
+#include "Room.h"
+#include "Shader.h"
+#include <algorithm>
+#include <iostream>
+
+AssetReloader::AssetReloader(Room* room, const std::vector<ExhibitMesh>& meshes) : room(room), running(true) {
+    for (size_t i = 0; i < meshes.size(); i++) {
+        models.push_back({ meshes[i].path, meshes[i].importer });
+        if (!meshes[i].path.empty()) watcher.watch(meshes[i].path);
+    }
+    thread = std::thread(&AssetReloader::run, this);
+}
+
+AssetReloader::~AssetReloader() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        running = false;
+    }
+    wakeUp.notify_one();
+    thread.join();
+    for (size_t i = 0; i < requests.size(); i++) delete requests[i];
+    for (size_t i = 0; i < finished.size(); i++) delete finished[i];
+    for (size_t i = 0; i < compiling.size(); i++) compiling[i]->cancelReload();
+}
+
+void AssetReloader::watchShader(Shader* shader) {
+    shaders.push_back(shader);
+    watcher.watch(shader->getVertexPath());
+    watcher.watch(shader->getFragmentPath());
+}
+
+void AssetReloader::update() {
+    PROFILE_SCOPE("AssetReloader::update");
+    std::vector<std::string> changed;
+    watcher.poll(changed);
+
+    for (size_t c = 0; c < changed.size(); c++) {
+        // Models: imported on the import thread
+        bool requested = false;
+        for (size_t i = 0; i < models.size(); i++) {
+            if (models[i].path != changed[c]) continue;
+            std::cout << "Model changed, importing: " << changed[c] << std::endl;
+            std::lock_guard<std::mutex> guard(lock);
+            requests.push_back(new ModelImport{ (int)i, false, std::vector<Vertex>(), nullptr });
+            requested = true;
+        }
+        if (requested) wakeUp.notify_one();
+
+        // Shaders: compiled by the driver while the current program draws
+        for (size_t i = 0; i < shaders.size(); i++) {
+            Shader* shader = shaders[i];
+            if (shader->getVertexPath() != changed[c] && shader->getFragmentPath() != changed[c]) continue;
+            std::cout << "Shader changed, compiling: " << changed[c] << std::endl;
+            if (!shader->beginReload()) {
+                std::cerr << "ERROR::RELOAD::SHADER_FAILED: " << changed[c] << ", keeping the running version" << std::endl;
+                continue;
+            }
+            if (std::find(compiling.begin(), compiling.end(), shader) == compiling.end()) compiling.push_back(shader);
+        }
+    }
+
+    // Finished imports: the upload is the only work left for this thread
+    std::vector<ModelImport*> imports;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        imports.swap(finished);
+    }
+    for (size_t i = 0; i < imports.size(); i++) {
+        const ModelFile& file = models[imports[i]->mesh];
+        ModelLoader* model = nullptr;
+        if (imports[i]->imported) {
+            model = new ModelLoader(std::move(imports[i]->vertices));
+        }
+        else if (imports[i]->gltf) {
+            model = new ModelLoader(*imports[i]->gltf, file.path);
+            if (!model->isLoaded()) {
+                delete model;
+                model = nullptr;
+            }
+        }
+        if (model) {
+            room->replaceModel(imports[i]->mesh, model);
+            std::cout << "Reloaded model: " << file.path << " (" << model->getTriangleCount() << " triangles)" << std::endl;
+        }
+        else {
+            std::cerr << "ERROR::RELOAD::MODEL_FAILED: " << file.path << ", keeping the loaded version" << std::endl;
+        }
+        delete imports[i];
+    }
+
+    // Compiled shaders replace their program, failed ones leave it as it is
+    for (size_t i = 0; i < compiling.size(); ) {
+        ShaderReloadState state = compiling[i]->pollReload();
+        if (state == SHADER_RELOAD_PENDING) {
+            i++;
+            continue;
+        }
+        if (state == SHADER_RELOAD_DONE) std::cout << "Reloaded shader: " << compiling[i]->getVertexPath() << " + " << compiling[i]->getFragmentPath() << std::endl;
+        else if (state == SHADER_RELOAD_FAILED) std::cerr << "ERROR::RELOAD::SHADER_FAILED: " << compiling[i]->getVertexPath() << " + " << compiling[i]->getFragmentPath() << ", keeping the running version" << std::endl;
+        compiling.erase(compiling.begin() + i);
+    }
+}
+
+// Import thread: reads model files without touching OpenGL
+void AssetReloader::run() {
+    for (;;) {
+        ModelImport* import;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            wakeUp.wait(guard, [this]() { return !running || !requests.empty(); });
+            if (!running) return;
+            import = requests.front();
+            requests.pop_front();
+        }
+
+        // glTF files are parsed and read into memory here; their buffer views go to the GPU
+        // straight from the mapping, which needs the render thread
+        const ModelFile& file = models[import->mesh];
+        if (isGltfModel(file.path, file.importer)) {
+            import->gltf = new GltfFile();
+            if (import->gltf->open(file.path)) import->gltf->prefetch();
+            else {
+                delete import->gltf;
+                import->gltf = nullptr;
+            }
+        }
+        else {
+            import->imported = ModelLoader::importFile(file.path, file.importer, nullptr, import->vertices) && !import->vertices.empty();
+        }
+
+        std::lock_guard<std::mutex> guard(lock);
+        finished.push_back(import);
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef ASSETRELOADER_H
+#define ASSETRELOADER_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "FileWatcher.h"
+#include "GltfLoader.h"
+#include "ModelLoader.h"
+#include "SceneGenerator.h"
+
+class Room;
+class Shader;
+
+// Hot reload of exhibit models and shaders while the museum runs (--hot-reload). Changed
+// model files are read and parsed again on a background thread (glTF files too, only
+// their buffer upload is left to the render thread) and changed shader files are
+// compiled while the old program stays in use; both are swapped in by update() between two
+// frames. A model that fails to import or a shader that fails to compile is reported and the
+// old version stays live.
+class AssetReloader {
+public:
+    // - meshes: the room's meshes by index (generated meshes have no file and are not watched)
+    AssetReloader(Room* room, const std::vector<ExhibitMesh>& meshes);
+
+    // Stops the import thread (before the room and shaders are deleted)
+    ~AssetReloader();
+
+    // Recompiles the shader when one of its files changes (render thread, not owned)
+    void watchShader(Shader* shader);
+
+    // Render thread, between frames: starts reloads of changed files and swaps in the
+    // ones that finished
+    void update();
+
+private:
+    struct ModelFile {
+        std::string path;
+        ModelImporter importer;
+    };
+
+    // One import, from request to result
+    struct ModelImport {
+        int mesh;
+        bool imported;                  // Vertices were read (false for glTF)
+        std::vector<Vertex> vertices;
+        GltfFile* gltf;                 // Parsed glTF file, uploaded on the render thread (null if not read)
+
+        ~ModelImport() { delete gltf; }
+    };
+
+    Room* room;
+    std::vector<ModelFile> models;      // By mesh index, read by the import thread
+    std::vector<Shader*> shaders;
+    std::vector<Shader*> compiling;     // Shaders waiting for pollReload()
+    FileWatcher watcher;
+
+    // Import thread
+    std::thread thread;
+    std::mutex lock;
+    std::condition_variable wakeUp;
+    std::deque<ModelImport*> requests;
+    std::vector<ModelImport*> finished;
+    bool running;
+
+    void run();
+};
+
+#endif
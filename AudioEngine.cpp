@@ -0,0 +1,492 @@
+#include "AudioEngine.h"
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+// Sound card output uses the Win32 waveOut API, other platforms have the null and WAV backends
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <mmsystem.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+// Distance falloff of positional voices: full volume up to the reference distance,
+// then 1 / (1 + rolloff * (distance - reference))
+static const float AUDIO_REFERENCE_DISTANCE = 1.0f;
+static const float AUDIO_ROLLOFF = 0.3f;
+
+// Little endian fields of a WAV file
+static unsigned int readUint32(const unsigned char* data) {
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((unsigned int)data[3] << 24);
+}
+
+static unsigned int readUint16(const unsigned char* data) {
+    return data[0] | (data[1] << 8);
+}
+
+static void writeUint32(std::ofstream& file, unsigned int value) {
+    unsigned char bytes[4] = { (unsigned char)value, (unsigned char)(value >> 8), (unsigned char)(value >> 16), (unsigned char)(value >> 24) };
+    file.write((const char*)bytes, 4);
+}
+
+static void writeUint16(std::ofstream& file, unsigned int value) {
+    unsigned char bytes[2] = { (unsigned char)value, (unsigned char)(value >> 8) };
+    file.write((const char*)bytes, 2);
+}
+
+// Decodes a RIFF WAVE file (8/16/24/32-bit PCM or 32-bit float, mono or stereo) into floats
+static bool decodeWav(const std::string& path, const unsigned char* data, size_t dataSize, int& channels, int& sampleRate,
+                      std::vector<float>& samples) {
+    if (dataSize < 12 || std::memcmp(&data[0], "RIFF", 4) != 0 || std::memcmp(&data[8], "WAVE", 4) != 0) {
+        std::cerr << "ERROR::AUDIO::NOT_A_WAV_FILE: " << path << std::endl;
+        return false;
+    }
+
+    // Walk the chunks for the format and the samples
+    unsigned int format = 0, bits = 0;
+    const unsigned char* pcm = nullptr;
+    size_t pcmBytes = 0;
+    channels = 0;
+    size_t offset = 12;
+    while (offset + 8 <= dataSize) {
+        unsigned int size = readUint32(&data[offset + 4]);
+        const unsigned char* body = &data[offset + 8];
+        size_t available = dataSize - offset - 8;
+        if (size > available) size = (unsigned int)available;
+
+        if (std::memcmp(&data[offset], "fmt ", 4) == 0 && size >= 16) {
+            format = readUint16(body);
+            channels = readUint16(body + 2);
+            sampleRate = (int)readUint32(body + 4);
+            bits = readUint16(body + 14);
+            if (format == 0xFFFE && size >= 26) format = readUint16(body + 24);     // WAVE_FORMAT_EXTENSIBLE
+        }
+        else if (std::memcmp(&data[offset], "data", 4) == 0) {
+            pcm = body;
+            pcmBytes = size;
+        }
+        offset += 8 + size + (size & 1);
+    }
+
+    bool supported = (format == 1 && (bits == 8 || bits == 16 || bits == 24 || bits == 32)) || (format == 3 && bits == 32);
+    if (!pcm || !supported || channels < 1 || channels > 2 || sampleRate <= 0) {
+        std::cerr << "ERROR::AUDIO::UNSUPPORTED_WAV_FORMAT: " << path << " (format " << format << ", " << bits
+                  << " bits, " << channels << " channels)" << std::endl;
+        return false;
+    }
+
+    size_t bytesPerSample = bits / 8;
+    size_t count = pcmBytes / bytesPerSample / channels * channels;
+    samples.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        const unsigned char* sample = pcm + i * bytesPerSample;
+        if (format == 3) {
+            float value;
+            std::memcpy(&value, sample, 4);
+            samples[i] = value;
+        }
+        else if (bits == 8) samples[i] = (sample[0] - 128) / 128.0f;
+        else if (bits == 16) samples[i] = (short)readUint16(sample) / 32768.0f;
+        else if (bits == 24) samples[i] = ((int)((sample[0] << 8) | (sample[1] << 16) | ((unsigned int)sample[2] << 24)) >> 8) / 8388608.0f;
+        else samples[i] = (int)readUint32(sample) / 2147483648.0f;
+    }
+    return true;
+}
+
+// Linear resampling of interleaved samples to the mixer rate
+static void resample(std::vector<float>& samples, int channels, int fromRate, int toRate) {
+    if (fromRate == toRate || samples.empty()) return;
+    int frames = (int)samples.size() / channels;
+    int outFrames = (int)((long long)frames * toRate / fromRate);
+    std::vector<float> out(outFrames * channels);
+    double step = (double)fromRate / toRate;
+    for (int f = 0; f < outFrames; f++) {
+        double position = f * step;
+        int index = (int)position;
+        float blend = (float)(position - index);
+        int next = index + 1 < frames ? index + 1 : index;
+        for (int c = 0; c < channels; c++) {
+            out[f * channels + c] = samples[index * channels + c] * (1.0f - blend) + samples[next * channels + c] * blend;
+        }
+    }
+    samples.swap(out);
+}
+
+// Keeps the mixer at real-time speed when nothing downstream blocks it
+class RealTimePacer {
+public:
+    void start(int rate) {
+        sampleRate = rate;
+        deadline = std::chrono::steady_clock::now();
+    }
+
+    void wait(int frames) {
+        deadline += std::chrono::microseconds((long long)frames * 1000000 / sampleRate);
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (now - deadline > std::chrono::milliseconds(100)) deadline = now;    // Fell behind, do not catch up in a burst
+        std::this_thread::sleep_until(deadline);
+    }
+
+private:
+    int sampleRate = AUDIO_SAMPLE_RATE;
+    std::chrono::steady_clock::time_point deadline;
+};
+
+// Discards the mix (headless runs, machines without a sound card)
+class NullAudioBackend : public AudioBackend {
+public:
+    bool open(int sampleRate) override {
+        pacer.start(sampleRate);
+        return true;
+    }
+    void write(const short*, int frames) override { pacer.wait(frames); }
+    void close() override {}
+
+private:
+    RealTimePacer pacer;
+};
+
+// Records the mix as a 16-bit stereo WAV file (e.g. to check the sound of a headless run)
+class WavFileAudioBackend : public AudioBackend {
+public:
+    WavFileAudioBackend(const std::string& path) : path(path), dataBytes(0) {}
+
+    bool open(int sampleRate) override {
+        file.open(path.c_str(), std::ios::binary);
+        if (!file) {
+            std::cerr << "ERROR::AUDIO::CANNOT_WRITE: " << path << std::endl;
+            return false;
+        }
+        // Sizes are filled in by close()
+        file.write("RIFF", 4);
+        writeUint32(file, 0);
+        file.write("WAVEfmt ", 8);
+        writeUint32(file, 16);
+        writeUint16(file, 1);                   // PCM
+        writeUint16(file, 2);                   // Stereo
+        writeUint32(file, sampleRate);
+        writeUint32(file, sampleRate * 4);      // Bytes per second
+        writeUint16(file, 4);                   // Bytes per frame
+        writeUint16(file, 16);                  // Bits per sample
+        file.write("data", 4);
+        writeUint32(file, 0);
+        dataBytes = 0;
+        pacer.start(sampleRate);
+        return true;
+    }
+
+    void write(const short* samples, int frames) override {
+        for (int i = 0; i < frames * 2; i++) writeUint16(file, (unsigned short)samples[i]);
+        dataBytes += frames * 4;
+        pacer.wait(frames);
+    }
+
+    void close() override {
+        if (!file.is_open()) return;
+        file.seekp(4);
+        writeUint32(file, 36 + dataBytes);
+        file.seekp(40);
+        writeUint32(file, dataBytes);
+        file.close();
+    }
+
+private:
+    std::string path;
+    std::ofstream file;
+    unsigned int dataBytes;
+    RealTimePacer pacer;
+};
+
+#ifdef _WIN32
+// Sound card output through waveOut, a few blocks queued ahead
+class WinMMAudioBackend : public AudioBackend {
+public:
+    bool open(int sampleRate) override {
+        WAVEFORMATEX format = {};
+        format.wFormatTag = WAVE_FORMAT_PCM;
+        format.nChannels = 2;
+        format.nSamplesPerSec = sampleRate;
+        format.wBitsPerSample = 16;
+        format.nBlockAlign = 4;
+        format.nAvgBytesPerSec = sampleRate * 4;
+
+        event = CreateEvent(NULL, FALSE, FALSE, NULL);
+        if (waveOutOpen(&device, WAVE_MAPPER, &format, (DWORD_PTR)event, 0, CALLBACK_EVENT) != MMSYSERR_NOERROR) {
+            std::cerr << "ERROR::AUDIO::WAVEOUT_OPEN_FAILED" << std::endl;
+            CloseHandle(event);
+            return false;
+        }
+        for (int i = 0; i < BUFFERS; i++) {
+            std::memset(&headers[i], 0, sizeof(WAVEHDR));
+            buffers[i].resize(AUDIO_BLOCK_FRAMES * 2);
+        }
+        next = 0;
+        return true;
+    }
+
+    void write(const short* samples, int frames) override {
+        // Blocks until the oldest queued buffer has been played
+        WAVEHDR& header = headers[next];
+        while (header.dwFlags & WHDR_INQUEUE) WaitForSingleObject(event, 100);
+        if (header.dwFlags & WHDR_PREPARED) waveOutUnprepareHeader(device, &header, sizeof(WAVEHDR));
+
+        std::memcpy(buffers[next].data(), samples, frames * 4);
+        header.lpData = (LPSTR)buffers[next].data();
+        header.dwBufferLength = frames * 4;
+        header.dwFlags = 0;
+        waveOutPrepareHeader(device, &header, sizeof(WAVEHDR));
+        waveOutWrite(device, &header, sizeof(WAVEHDR));
+        next = (next + 1) % BUFFERS;
+    }
+
+    void close() override {
+        waveOutReset(device);
+        for (int i = 0; i < BUFFERS; i++) {
+            if (headers[i].dwFlags & WHDR_PREPARED) waveOutUnprepareHeader(device, &headers[i], sizeof(WAVEHDR));
+        }
+        waveOutClose(device);
+        CloseHandle(event);
+    }
+
+private:
+    static const int BUFFERS = 3;   // About 35 ms queued at 44.1 kHz
+    HWAVEOUT device;
+    HANDLE event;
+    WAVEHDR headers[BUFFERS];
+    std::vector<short> buffers[BUFFERS];
+    int next;
+};
+#endif
+
+AudioBackend* createAudioBackend(const std::string& name) {
+    if (name == "null") return new NullAudioBackend();
+    if (name.compare(0, 4, "wav:") == 0 && name.size() > 4) return new WavFileAudioBackend(name.substr(4));
+#ifdef _WIN32
+    if (name == "winmm") return new WinMMAudioBackend();
+#endif
+    std::cerr << "ERROR::AUDIO::UNKNOWN_BACKEND: " << name << std::endl;
+    return nullptr;
+}
+
+AudioEngine::AudioEngine(AudioBackend* backend) : backend(backend) {
+    nextVoice = 0;
+    running = false;
+    activeVoices = 0;
+    droppedCommands = 0;
+    mixMilliseconds = 0.0f;
+    voices.reserve(AUDIO_MAX_VOICES);
+    mixBuffer.resize(AUDIO_BLOCK_FRAMES * 2);
+    outputBuffer.resize(AUDIO_BLOCK_FRAMES * 2);
+
+    // Listener at the origin facing -z until the renderer sets the camera
+    Listener& ears = listener.writeBuffer();
+    ears.position = glm::vec3(0.0f);
+    ears.right = glm::vec3(1.0f, 0.0f, 0.0f);
+    listener.publish();
+}
+
+AudioEngine::~AudioEngine() {
+    stop();
+    delete backend;
+}
+
+int AudioEngine::loadSound(const std::string& path) {
+    std::ifstream file(path.c_str(), std::ios::binary);
+    if (!file) {
+        std::cerr << "ERROR::AUDIO::FILE_NOT_FOUND: " << path << std::endl;
+        return -1;
+    }
+    std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return loadSound(path, data.data(), data.size());
+}
+
+int AudioEngine::loadSound(const std::string& name, const unsigned char* data, size_t size) {
+    if (running) {
+        std::cerr << "ERROR::AUDIO::LOAD_AFTER_START: " << name << std::endl;
+        return -1;
+    }
+    Sound sound;
+    int sampleRate = AUDIO_SAMPLE_RATE;
+    if (!decodeWav(name, data, size, sound.channels, sampleRate, sound.samples)) return -1;
+
+    resample(sound.samples, sound.channels, sampleRate, AUDIO_SAMPLE_RATE);
+    sound.path = name;
+    sound.frames = (int)sound.samples.size() / sound.channels;
+    sounds.push_back(sound);
+    return (int)sounds.size() - 1;
+}
+
+int AudioEngine::findSound(const std::string& path) const {
+    for (size_t i = 0; i < sounds.size(); i++) {
+        if (sounds[i].path == path) return (int)i;
+    }
+    return -1;
+}
+
+bool AudioEngine::start() {
+    if (running || !backend) return running;
+    if (!backend->open(AUDIO_SAMPLE_RATE)) return false;
+    running = true;
+    thread = std::thread(&AudioEngine::run, this);
+    return true;
+}
+
+void AudioEngine::stop() {
+    if (!running) return;
+    running = false;
+    thread.join();
+    backend->close();
+}
+
+void AudioEngine::send(const Command& command) {
+    if (!commands.push(command)) droppedCommands.fetch_add(1, std::memory_order_relaxed);
+}
+
+AudioVoice AudioEngine::play(int sound, float volume, bool loop) {
+    if (sound < 0 || sound >= (int)sounds.size()) return 0;
+    if (++nextVoice == 0) nextVoice = 1;    // 0 means no voice
+    send({ COMMAND_PLAY, nextVoice, sound, volume, loop, false, glm::vec3(0.0f) });
+    return nextVoice;
+}
+
+AudioVoice AudioEngine::playAt(int sound, const glm::vec3& position, float volume, bool loop) {
+    if (sound < 0 || sound >= (int)sounds.size()) return 0;
+    if (++nextVoice == 0) nextVoice = 1;
+    send({ COMMAND_PLAY, nextVoice, sound, volume, loop, true, position });
+    return nextVoice;
+}
+
+void AudioEngine::stopVoice(AudioVoice voice) {
+    if (voice) send({ COMMAND_STOP, voice, -1, 0.0f, false, false, glm::vec3(0.0f) });
+}
+
+void AudioEngine::setVoicePosition(AudioVoice voice, const glm::vec3& position) {
+    if (voice) send({ COMMAND_MOVE, voice, -1, 0.0f, false, true, position });
+}
+
+void AudioEngine::setListener(const glm::vec3& position, const glm::vec3& right) {
+    Listener& ears = listener.writeBuffer();
+    ears.position = position;
+    ears.right = right;
+    listener.publish();
+}
+
+void AudioEngine::run() {
+    while (running.load(std::memory_order_acquire)) {
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        applyCommands();
+        mixBlock();
+        mixMilliseconds.store(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - begin).count(), std::memory_order_relaxed);
+
+        // Blocks until the output can take the next block
+        backend->write(outputBuffer.data(), AUDIO_BLOCK_FRAMES);
+    }
+}
+
+void AudioEngine::applyCommands() {
+    Command command;
+    while (commands.pop(command)) {
+        if (command.type == COMMAND_PLAY) {
+            if ((int)voices.size() >= AUDIO_MAX_VOICES) continue;  // Every voice busy, the sound is skipped
+            Voice voice;
+            voice.id = command.voice;
+            voice.sound = &sounds[command.sound];
+            voice.frame = 0;
+            voice.volume = command.volume;
+            voice.loop = command.loop;
+            voice.positional = command.positional;
+            voice.position = command.position;
+            voice.gainLeft = voice.gainRight = 0.0f;
+            voice.started = false;
+            voices.push_back(voice);
+            continue;
+        }
+        for (size_t i = 0; i < voices.size(); i++) {
+            if (voices[i].id != command.voice) continue;
+            if (command.type == COMMAND_STOP) {
+                voices[i] = voices.back();
+                voices.pop_back();
+            }
+            else voices[i].position = command.position;
+            break;
+        }
+    }
+}
+
+void AudioEngine::targetGains(const Voice& voice, const Listener& ears, float& left, float& right) const {
+    if (!voice.positional) {
+        left = right = voice.volume;
+        return;
+    }
+
+    // Distance falloff and equal-power panning from the side the sound comes from
+    glm::vec3 offset = voice.position - ears.position;
+    float distance = glm::length(offset);
+    float excess = distance > AUDIO_REFERENCE_DISTANCE ? distance - AUDIO_REFERENCE_DISTANCE : 0.0f;
+    float gain = voice.volume / (1.0f + AUDIO_ROLLOFF * excess);
+    float pan = distance > 1e-4f ? glm::dot(offset, ears.right) / distance : 0.0f;
+    float angle = (pan + 1.0f) * 0.785398f;     // 0 = left, pi/2 = right
+    left = gain * std::cos(angle) * 1.414214f;  // Centered sounds keep their volume
+    right = gain * std::sin(angle) * 1.414214f;
+}
+
+void AudioEngine::mixBlock() {
+    listener.update();
+    const Listener& ears = listener.readBuffer();
+    std::fill(mixBuffer.begin(), mixBuffer.end(), 0.0f);
+
+    for (size_t v = 0; v < voices.size();) {
+        Voice& voice = voices[v];
+        const Sound& sound = *voice.sound;
+
+        // Gains move linearly over the block, so moving sounds do not click
+        float targetLeft, targetRight;
+        targetGains(voice, ears, targetLeft, targetRight);
+        float left = voice.started ? voice.gainLeft : targetLeft;
+        float right = voice.started ? voice.gainRight : targetRight;
+        float stepLeft = (targetLeft - left) / AUDIO_BLOCK_FRAMES;
+        float stepRight = (targetRight - right) / AUDIO_BLOCK_FRAMES;
+
+        bool finished = false;
+        for (int f = 0; f < AUDIO_BLOCK_FRAMES; f++) {
+            if (voice.frame >= sound.frames) {
+                if (!voice.loop || sound.frames == 0) {
+                    finished = true;
+                    break;
+                }
+                voice.frame = 0;
+            }
+            float sampleLeft, sampleRight;
+            if (sound.channels == 1) sampleLeft = sampleRight = sound.samples[voice.frame];
+            else {
+                sampleLeft = sound.samples[voice.frame * 2];
+                sampleRight = sound.samples[voice.frame * 2 + 1];
+            }
+            mixBuffer[f * 2] += sampleLeft * left;
+            mixBuffer[f * 2 + 1] += sampleRight * right;
+            left += stepLeft;
+            right += stepRight;
+            voice.frame++;
+        }
+
+        voice.gainLeft = targetLeft;
+        voice.gainRight = targetRight;
+        voice.started = true;
+        if (finished) {
+            voices[v] = voices.back();
+            voices.pop_back();
+        }
+        else v++;
+    }
+
+    // Clip to 16 bits
+    for (int i = 0; i < AUDIO_BLOCK_FRAMES * 2; i++) {
+        float sample = mixBuffer[i];
+        if (sample > 1.0f) sample = 1.0f;
+        if (sample < -1.0f) sample = -1.0f;
+        outputBuffer[i] = (short)(sample * 32767.0f);
+    }
+    activeVoices.store((int)voices.size(), std::memory_order_relaxed);
+}
@@ -0,0 +1,136 @@
+#ifndef AUDIOENGINE_H
+#define AUDIOENGINE_H
+
+#include <glm/glm.hpp>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SpscRing.h"
+#include "TripleBuffer.h"
+
+// Output format of the mixer
+#define AUDIO_SAMPLE_RATE 44100
+#define AUDIO_BLOCK_FRAMES 512      // Frames mixed per block (11.6 ms at 44.1 kHz)
+#define AUDIO_MAX_VOICES 64         // Sounds playing at the same time
+#define AUDIO_COMMAND_CAPACITY 256  // Commands queued between two mixed blocks
+
+// Sound card, file or nothing: receives the mixed blocks (16-bit stereo)
+// and paces the mixer thread by blocking until it can take the next one.
+class AudioBackend {
+public:
+    virtual ~AudioBackend() {}
+    virtual bool open(int sampleRate) = 0;
+    virtual void write(const short* samples, int frames) = 0;     // Interleaved left/right
+    virtual void close() = 0;
+};
+
+// Creates the backend named on the command line:
+// "null" (discards, real-time pacing), "wav:FILE" (records the mix), "winmm" (Windows sound output)
+// Returns null (after printing why) for unknown or unavailable backends.
+AudioBackend* createAudioBackend(const std::string& name);
+
+// Playing sound, e.g. to stop it or move it
+typedef unsigned int AudioVoice;
+
+// Sound effects decoded into memory at startup and mixed on a dedicated thread.
+// The thread that plays sounds talks to the mixer through a lock-free command
+// ring, so playing a sound never touches the disk or waits for the mixer.
+// Positional voices are panned and attenuated relative to the listener.
+// Threading: loadSound before start(); play/stop/setVoicePosition from one thread
+// (the simulation); setListener from one thread (the renderer).
+class AudioEngine {
+public:
+    // Takes ownership of the backend
+    AudioEngine(AudioBackend* backend);
+    ~AudioEngine();
+
+    // Decodes a PCM or float WAV file (any rate, mono or stereo), returns its sound id or -1
+    int loadSound(const std::string& path);
+
+    // Decodes a WAV file already in memory (e.g. from the asset pack), found by name later
+    int loadSound(const std::string& name, const unsigned char* data, size_t size);
+
+    // Id of a loaded sound by file name, -1 if it was not loaded
+    int findSound(const std::string& path) const;
+
+    // Starts and stops the mixer thread
+    bool start();
+    void stop();
+
+    // Plays a sound at full width (e.g. UI) or at a position in the museum; 0 when it cannot play
+    AudioVoice play(int sound, float volume, bool loop);
+    AudioVoice playAt(int sound, const glm::vec3& position, float volume, bool loop);
+    void stopVoice(AudioVoice voice);
+    void setVoicePosition(AudioVoice voice, const glm::vec3& position);
+
+    // Ears of the listener (usually the camera): position and unit right vector
+    void setListener(const glm::vec3& position, const glm::vec3& right);
+
+    // Mixer statistics
+    int getActiveVoices() const { return activeVoices.load(std::memory_order_relaxed); }
+    int getDroppedCommands() const { return droppedCommands.load(std::memory_order_relaxed); }
+    float getMixMilliseconds() const { return mixMilliseconds.load(std::memory_order_relaxed); }
+
+private:
+    // Decoded sound, samples at AUDIO_SAMPLE_RATE
+    struct Sound {
+        std::string path;
+        int channels;               // 1 or 2
+        std::vector<float> samples; // Interleaved when stereo
+        int frames;
+    };
+
+    enum CommandType { COMMAND_PLAY, COMMAND_STOP, COMMAND_MOVE };
+    struct Command {
+        CommandType type;
+        AudioVoice voice;
+        int sound;
+        float volume;
+        bool loop;
+        bool positional;
+        glm::vec3 position;
+    };
+
+    struct Listener {
+        glm::vec3 position;
+        glm::vec3 right;
+    };
+
+    // Mixer side state of a playing sound
+    struct Voice {
+        AudioVoice id;
+        const Sound* sound;
+        int frame;                  // Next frame to play
+        float volume;
+        bool loop;
+        bool positional;
+        glm::vec3 position;
+        float gainLeft, gainRight;  // Gains at the end of the last block (ramped to avoid clicks)
+        bool started;               // Gains ramp from the first block on
+    };
+
+    AudioBackend* backend;
+    std::vector<Sound> sounds;
+    SpscRing<Command, AUDIO_COMMAND_CAPACITY> commands;
+    TripleBuffer<Listener> listener;
+    AudioVoice nextVoice;           // Producer side
+
+    // Mixer thread
+    std::thread thread;
+    std::atomic<bool> running;
+    std::vector<Voice> voices;
+    std::vector<float> mixBuffer;
+    std::vector<short> outputBuffer;
+    std::atomic<int> activeVoices;
+    std::atomic<int> droppedCommands;
+    std::atomic<float> mixMilliseconds;
+
+    void send(const Command& command);
+    void run();
+    void applyCommands();
+    void mixBlock();
+    void targetGains(const Voice& voice, const Listener& ears, float& left, float& right) const;
+};
+
+#endif
@@ -0,0 +1,215 @@
+#include "Behavior.h"
+#include "CpuProfiler.h"
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <new>
+
+// Pool block sizes are multiples of this
+#define BEHAVIOR_POOL_GRANULE 64
+
+// Blocks carved at once when a size class runs empty
+#define BEHAVIOR_POOL_REFILL 64
+
+// Free lists of coroutine frames, one per size class (64, 128, ... 1024 bytes).
+// Frames of ended scripts go back to their list, so steady spawning does not
+// touch the heap and frames of the same kind stay close together.
+// Pages are kept for the lifetime of the program.
+namespace {
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    std::mutex poolMutex;       // Scripts may be created on one thread and end on another
+    FreeBlock* freeLists[BEHAVIOR_POOL_MAX_FRAME / BEHAVIOR_POOL_GRANULE];
+
+    void* allocateFrame(size_t size) {
+        if (size > BEHAVIOR_POOL_MAX_FRAME) return ::operator new(size);
+        size_t sizeClass = (size + BEHAVIOR_POOL_GRANULE - 1) / BEHAVIOR_POOL_GRANULE - 1;
+
+        std::lock_guard<std::mutex> lock(poolMutex);
+        if (!freeLists[sizeClass]) {
+            // Carve a page into blocks of this class
+            size_t blockSize = (sizeClass + 1) * BEHAVIOR_POOL_GRANULE;
+            char* page = (char*)::operator new(blockSize * BEHAVIOR_POOL_REFILL);
+            for (int i = BEHAVIOR_POOL_REFILL - 1; i >= 0; i--) {
+                FreeBlock* block = (FreeBlock*)(page + i * blockSize);
+                block->next = freeLists[sizeClass];
+                freeLists[sizeClass] = block;
+            }
+        }
+        FreeBlock* block = freeLists[sizeClass];
+        freeLists[sizeClass] = block->next;
+        return block;
+    }
+
+    void releaseFrame(void* frame, size_t size) {
+        if (size > BEHAVIOR_POOL_MAX_FRAME) {
+            ::operator delete(frame);
+            return;
+        }
+        size_t sizeClass = (size + BEHAVIOR_POOL_GRANULE - 1) / BEHAVIOR_POOL_GRANULE - 1;
+
+        std::lock_guard<std::mutex> lock(poolMutex);
+        FreeBlock* block = (FreeBlock*)frame;
+        block->next = freeLists[sizeClass];
+        freeLists[sizeClass] = block;
+    }
+
+    // Timer heap order: earliest time on top
+    struct LaterTimer {
+        template <typename T>
+        bool operator()(const T& a, const T& b) const { return a.time > b.time; }
+    };
+}
+
+void* BehaviorTask::promise_type::operator new(size_t size) {
+    return allocateFrame(size);
+}
+
+void BehaviorTask::promise_type::operator delete(void* frame, size_t size) {
+    releaseFrame(frame, size);
+}
+
+void BehaviorTask::promise_type::unhandled_exception() {
+    std::cerr << "ERROR::BEHAVIOR::SCRIPT_THREW_AN_EXCEPTION" << std::endl;
+    std::terminate();
+}
+
+std::coroutine_handle<> BehaviorTask::promise_type::FinalAwaiter::await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+    std::coroutine_handle<> continuation = handle.promise().continuation;
+    return continuation ? continuation : std::noop_coroutine();
+}
+
+BehaviorTask& BehaviorTask::operator=(BehaviorTask&& other) noexcept {
+    if (this != &other) {
+        if (handle) handle.destroy();
+        handle = other.handle;
+        other.handle = nullptr;
+    }
+    return *this;
+}
+
+std::coroutine_handle<> BehaviorTask::await_suspend(std::coroutine_handle<> caller) noexcept {
+    // Jump straight into the callee, its final suspend jumps back
+    handle.promise().continuation = caller;
+    return handle;
+}
+
+BehaviorScheduler::BehaviorScheduler() {
+    clock = 0.0;
+    running = -1;
+    scriptCount = 0;
+}
+
+BehaviorScheduler::~BehaviorScheduler() {
+    for (size_t i = 0; i < slots.size(); i++) {
+        if (slots[i].root) slots[i].root.destroy();
+    }
+}
+
+BehaviorHandle BehaviorScheduler::spawn(BehaviorTask task) {
+    if (!task.handle) return BehaviorHandle();
+
+    int slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    else {
+        slot = (int)slots.size();
+        slots.push_back({ nullptr, nullptr, 0u, false });
+    }
+    slots[slot].root = task.handle;
+    slots[slot].waiting = task.handle;
+    task.handle = nullptr;      // The slot owns the frame now
+    scriptCount++;
+
+    BehaviorHandle handle = { slot, slots[slot].generation };
+    resume(slot);
+    return handle;
+}
+
+void BehaviorScheduler::cancel(BehaviorHandle handle) {
+    if (!isRunning(handle)) return;
+    if (handle.slot == running) {
+        std::cerr << "ERROR::BEHAVIOR::A_SCRIPT_CANNOT_CANCEL_ITSELF" << std::endl;
+        return;
+    }
+    // Destroying the root destroys the scripts it waits on; its timers and walks go stale
+    release(handle.slot);
+}
+
+bool BehaviorScheduler::isRunning(BehaviorHandle handle) const {
+    return handle.slot >= 0 && handle.slot < (int)slots.size() &&
+           slots[handle.slot].generation == handle.generation && slots[handle.slot].root;
+}
+
+void BehaviorScheduler::resume(int slot) {
+    // Scripts may spawn scripts, the outer one continues afterwards
+    int outer = running;
+    running = slot;
+    slots[slot].parked = false;
+    slots[slot].waiting.resume();
+    running = outer;
+
+    if (slots[slot].root.done()) release(slot);
+}
+
+void BehaviorScheduler::release(int slot) {
+    slots[slot].root.destroy();
+    slots[slot].root = nullptr;
+    slots[slot].waiting = nullptr;
+    slots[slot].generation++;
+    freeSlots.push_back(slot);
+    scriptCount--;
+}
+
+void BehaviorScheduler::WaitAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    int slot = scheduler->running;
+    scheduler->slots[slot].waiting = handle;
+    scheduler->timers.push_back({ scheduler->clock + seconds, slot, scheduler->slots[slot].generation });
+    std::push_heap(scheduler->timers.begin(), scheduler->timers.end(), LaterTimer());
+}
+
+void BehaviorScheduler::ParkAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    int slot = scheduler->running;
+    scheduler->slots[slot].waiting = handle;
+    scheduler->slots[slot].parked = true;
+}
+
+void BehaviorScheduler::wake(BehaviorHandle handle) {
+    if (!isRunning(handle) || !slots[handle.slot].parked) return;
+    slots[handle.slot].parked = false;     // Woken once, even if wake is called again
+    ready.push_back(handle);
+}
+
+BehaviorHandle BehaviorScheduler::current() const {
+    BehaviorHandle handle;
+    if (running >= 0) {
+        handle.slot = running;
+        handle.generation = slots[running].generation;
+    }
+    return handle;
+}
+
+void BehaviorScheduler::update(float deltaTime) {
+    PROFILE_SCOPE("BehaviorScheduler::update");
+    clock += deltaTime;
+
+    // Waits that are over (a wait started during this update fires in the next one)
+    while (!timers.empty() && timers.front().time <= clock) {
+        std::pop_heap(timers.begin(), timers.end(), LaterTimer());
+        const Timer& timer = timers.back();
+        ready.push_back({ timer.slot, timer.generation });
+        timers.pop_back();
+    }
+
+    // A script resumed earlier may have cancelled a later one (or woken another, which runs too)
+    for (size_t i = 0; i < ready.size(); i++) {
+        BehaviorHandle handle = ready[i];
+        if (slots[handle.slot].generation == handle.generation) resume(handle.slot);
+    }
+    ready.clear();
+}
@@ -0,0 +1,144 @@
+#ifndef BEHAVIOR_H
+#define BEHAVIOR_H
+
+#include <coroutine>
+#include <cstddef>
+#include <vector>
+
+class BehaviorScheduler;
+
+// Coroutine frames up to this size come from the frame pool, larger ones from the heap
+#define BEHAVIOR_POOL_MAX_FRAME 1024
+
+// Script of one agent (C++20 coroutine). A script runs until its first co_await,
+// then the scheduler resumes it when what it waits for is done. Scripts may
+// co_await other scripts; the caller continues when the callee returns.
+// Owns its coroutine frame: destroying a task destroys the frames it waits on.
+class BehaviorTask {
+public:
+    struct promise_type {
+        std::coroutine_handle<> continuation;   // Script waiting for this one (null for a spawned script)
+
+        BehaviorTask get_return_object() { return BehaviorTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception();
+
+        // At the end control goes back to the caller, or to the scheduler
+        struct FinalAwaiter {
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept;
+            void await_resume() noexcept {}
+        };
+        FinalAwaiter final_suspend() noexcept { return {}; }
+
+        // Frames are recycled instead of going through the heap every time
+        static void* operator new(size_t size);
+        static void operator delete(void* frame, size_t size);
+    };
+
+    BehaviorTask() {}
+    BehaviorTask(BehaviorTask&& other) noexcept : handle(other.handle) { other.handle = nullptr; }
+    BehaviorTask& operator=(BehaviorTask&& other) noexcept;
+    BehaviorTask(const BehaviorTask&) = delete;
+    BehaviorTask& operator=(const BehaviorTask&) = delete;
+    ~BehaviorTask() { if (handle) handle.destroy(); }
+
+    // co_await on a script runs it, the caller continues once it has returned
+    bool await_ready() const noexcept { return !handle || handle.done(); }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept;
+    void await_resume() const noexcept {}
+
+private:
+    friend class BehaviorScheduler;
+    explicit BehaviorTask(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+    std::coroutine_handle<promise_type> handle;
+};
+
+// Spawned script, e.g. to cancel it later. Stays valid (and harmless) after the script ended.
+struct BehaviorHandle {
+    int slot = -1;
+    unsigned int generation = 0;
+};
+
+// Runs the scripts of thousands of agents on one thread. Suspended scripts cost
+// nothing per update: waits sit in a timer heap, long actions (e.g. a walk
+// stepped by the movement system) park the script until they wake it, and
+// coroutine frames come from a pool of fixed size blocks.
+// Not thread-safe: spawn, cancel and update belong to one thread (the simulation).
+class BehaviorScheduler {
+public:
+    BehaviorScheduler();
+    ~BehaviorScheduler();
+
+    // Starts a script, it runs until its first co_await
+    BehaviorHandle spawn(BehaviorTask task);
+
+    // Destroys a script wherever it waits (not the script that is running)
+    void cancel(BehaviorHandle handle);
+    bool isRunning(BehaviorHandle handle) const;
+
+    // Advances the clock and resumes the scripts whose wait is over or that were woken
+    void update(float deltaTime);
+
+    // Resumes a script parked with co_await park() at the next update
+    // (in the running update when called from a script)
+    void wake(BehaviorHandle handle);
+
+    // Script being resumed, e.g. to hand to whatever wakes it (invalid outside scripts)
+    BehaviorHandle current() const;
+
+    // Awaitables for scripts of this scheduler
+    struct WaitAwaiter {
+        BehaviorScheduler* scheduler;
+        float seconds;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle);
+        void await_resume() const noexcept {}
+    };
+    struct ParkAwaiter {
+        BehaviorScheduler* scheduler;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle);
+        void await_resume() const noexcept {}
+    };
+
+    // co_await wait(s): resumes after s seconds (0 = next update)
+    WaitAwaiter wait(float seconds) { return WaitAwaiter{ this, seconds }; }
+
+    // co_await park(): resumes once wake() was called with the script's handle
+    ParkAwaiter park() { return ParkAwaiter{ this }; }
+
+    // Seconds since the scheduler was created (advanced by update)
+    double getTime() const { return clock; }
+
+    // Scripts spawned and not finished
+    int getScriptCount() const { return scriptCount; }
+
+private:
+    // Spawned script: its root frame and the innermost frame waiting for the scheduler
+    struct Slot {
+        std::coroutine_handle<BehaviorTask::promise_type> root;
+        std::coroutine_handle<> waiting;
+        unsigned int generation;    // Bumped when the script ends, stale timers and wakes skip it
+        bool parked;                // Suspended in park(), only then wake() resumes it
+    };
+    struct Timer {
+        double time;
+        int slot;
+        unsigned int generation;
+    };
+
+    double clock;
+    std::vector<Slot> slots;
+    std::vector<int> freeSlots;
+    std::vector<Timer> timers;          // Min-heap on time
+    std::vector<BehaviorHandle> ready;  // Scripts to resume this update
+    int running;                        // Slot of the script being resumed, -1 outside scripts
+    int scriptCount;
+
+    void resume(int slot);
+    void release(int slot);
+};
+
+#endif
@@ -0,0 +1,120 @@
+#include "Benchmark.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+glm::mat4 benchmarkCameraView(float simulatedTime) {
+    // Swing 40 degrees left and right of the default view while bobbing slightly
+    float angle = glm::radians(40.0f) * std::sin(simulatedTime * 0.15f);
+    float height = 3.0f + 0.75f * std::sin(simulatedTime * 0.4f);
+    glm::vec3 position(10.0f * std::sin(angle), height, 10.0f * std::cos(angle));
+
+    return glm::lookAt(position, glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+BenchmarkRecorder::BenchmarkRecorder(float hitchThresholdMs) : hitchThresholdMs(hitchThresholdMs) {
+}
+
+void BenchmarkRecorder::recordCpuFrame(float milliseconds) {
+    cpuMs.push_back(milliseconds);
+}
+
+// Summary statistics of one series
+struct FrameStats {
+    int count = 0;
+    float mean = 0.0f, p50 = 0.0f, p95 = 0.0f, p99 = 0.0f, max = 0.0f;
+    int hitches = 0;
+};
+
+// Nearest-rank percentile of sorted values
+static float percentile(const std::vector<float>& sorted, float p) {
+    if (sorted.empty()) return 0.0f;
+    size_t rank = (size_t)std::ceil(p / 100.0f * sorted.size());
+    if (rank < 1) rank = 1;
+    return sorted[rank - 1];
+}
+
+// Computes the statistics, ignoring negative (missing) samples
+static FrameStats computeStats(const std::vector<float>& values, float hitchThresholdMs) {
+    std::vector<float> sorted;
+    sorted.reserve(values.size());
+    for (size_t i = 0; i < values.size(); i++) {
+        if (values[i] >= 0.0f) sorted.push_back(values[i]);
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    FrameStats stats;
+    stats.count = (int)sorted.size();
+    if (sorted.empty()) return stats;
+
+    double sum = 0.0;
+    for (size_t i = 0; i < sorted.size(); i++) {
+        sum += sorted[i];
+        if (sorted[i] > hitchThresholdMs) stats.hitches++;
+    }
+    stats.mean = (float)(sum / sorted.size());
+    stats.p50 = percentile(sorted, 50.0f);
+    stats.p95 = percentile(sorted, 95.0f);
+    stats.p99 = percentile(sorted, 99.0f);
+    stats.max = sorted.back();
+    return stats;
+}
+
+// Writes one statistics object
+static void writeStats(std::ofstream& file, const char* name, const FrameStats& stats) {
+    file << "  \"" << name << "\": {\"frames\": " << stats.count << ", \"mean\": " << stats.mean
+        << ", \"p50\": " << stats.p50 << ", \"p95\": " << stats.p95 << ", \"p99\": " << stats.p99
+        << ", \"max\": " << stats.max << ", \"hitches\": " << stats.hitches << "}";
+}
+
+// Escapes quotes and backslashes for a JSON string
+static std::string jsonEscape(const std::string& text) {
+    std::string result;
+    for (size_t i = 0; i < text.size(); i++) {
+        if (text[i] == '"' || text[i] == '\\') result += '\\';
+        result += text[i];
+    }
+    return result;
+}
+
+bool BenchmarkRecorder::writeReport(const std::string& path, float simulatedSeconds, int width, int height,
+    const std::string& renderer) const {
+    FrameStats cpu = computeStats(cpuMs, hitchThresholdMs);
+    FrameStats gpu = computeStats(gpuMs, hitchThresholdMs);
+
+    // Frames where either side went over the threshold
+    int hitches = 0;
+    for (size_t i = 0; i < cpuMs.size(); i++) {
+        float gpuTime = i < gpuMs.size() ? gpuMs[i] : -1.0f;
+        if (cpuMs[i] > hitchThresholdMs || gpuTime > hitchThresholdMs) hitches++;
+    }
+
+    std::cout << "Benchmark: " << cpuMs.size() << " frames, " << simulatedSeconds << " s simulated\n"
+        << "  CPU ms  p50 " << cpu.p50 << "  p95 " << cpu.p95 << "  p99 " << cpu.p99 << "  max " << cpu.max << "\n"
+        << "  GPU ms  p50 " << gpu.p50 << "  p95 " << gpu.p95 << "  p99 " << gpu.p99 << "  max " << gpu.max << "\n"
+        << "  hitches (> " << hitchThresholdMs << " ms): " << hitches << "\n";
+
+    std::ofstream file(path.c_str());
+    if (!file.is_open()) {
+        std::cerr << "Could not write benchmark report: " << path << std::endl;
+        return false;
+    }
+
+    file << "{\n"
+        << "  \"version\": 1,\n"
+        << "  \"renderer\": \"" << jsonEscape(renderer) << "\",\n"
+        << "  \"resolution\": [" << width << ", " << height << "],\n"
+        << "  \"frames\": " << cpuMs.size() << ",\n"
+        << "  \"simulated_seconds\": " << simulatedSeconds << ",\n"
+        << "  \"exhibits\": " << sceneExhibits << ",\n"
+        << "  \"exhibit_triangles\": " << sceneTriangles << ",\n"
+        << "  \"hitch_threshold_ms\": " << hitchThresholdMs << ",\n"
+        << "  \"hitches\": " << hitches << ",\n";
+    writeStats(file, "cpu_ms", cpu);
+    file << ",\n";
+    writeStats(file, "gpu_ms", gpu);
+    file << "\n}\n";
+    return true;
+}
@@ -0,0 +1,39 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+// Camera of the benchmark tour: a slow sweep around the room that only depends on simulated time
+glm::mat4 benchmarkCameraView(float simulatedTime);
+
+// Records per-frame CPU and GPU times of a benchmark run and writes a JSON report
+class BenchmarkRecorder {
+public:
+    // - hitchThresholdMs: frames slower than this (CPU or GPU) count as hitches
+    BenchmarkRecorder(float hitchThresholdMs);
+
+    // CPU time of one frame, frames must be recorded in order
+    void recordCpuFrame(float milliseconds);
+
+    // Scene size written to the report, so runs of generated scenes can be plotted as curves
+    void setSceneSize(int exhibits, long long triangles) { sceneExhibits = exhibits; sceneTriangles = triangles; }
+
+    // Destination of the per-frame GPU times, filled in by GpuProfiler as results arrive
+    std::vector<float>* getGpuFrameTimes() { return &gpuMs; }
+
+    // Writes the report (also printed as a summary), returns false if the file could not be written
+    // - renderer: GL_RENDERER string so results from different machines are not mixed up
+    bool writeReport(const std::string& path, float simulatedSeconds, int width, int height,
+        const std::string& renderer) const;
+
+private:
+    float hitchThresholdMs;
+    int sceneExhibits = 0;
+    long long sceneTriangles = 0;
+    std::vector<float> cpuMs;   // Indexed by frame
+    std::vector<float> gpuMs;   // Indexed by frame, negative when no result was read back
+};
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef COMPONENTS_H
+#define COMPONENTS_H
+
+#include <glm/glm.hpp>
+#include "Behavior.h"
+
+// Components of the museum entities (plain data, see World)
+
+// Placement on the floor
+struct Transform {
+    glm::vec3 position;
+    float yaw;              // Rotation around the up axis in degrees
+    float scale;            // Uniform scale
+};
+
+// Exhibit mesh and look
+struct ExhibitModel {
+    int mesh;               // Index into Room's models
+    glm::vec3 color;        // Base color
+    int exhibit;            // Index of the exhibit in the scene (tour stops refer to it)
+    int catalogIndex;       // Entry of the museum information texts, -1 for synthetic exhibits
+};
+
+// Sphere around the position that holds the mesh at any yaw (for frustum culling)
+struct CullBounds {
+    float radius;
+};
+
+// Frustum test result of the last cullExhibits (render thread)
+struct Visibility {
+    unsigned char visible;
+    unsigned char lod;          // Level of detail chosen with the culling
+};
+
+// Point light at the entity's position
+struct LightSource {
+    glm::vec3 color;
+};
+
+// Walk toward a target, stepped by movementSystem
+struct Locomotion {
+    glm::vec3 target;
+    float arriveDistance;   // The walk ends this close to the target
+    float speedPerMeter;    // Speed = distance to the target * speedPerMeter,
+    float minSpeed;         // clamped to [minSpeed, maxSpeed] in m/s
+    float maxSpeed;
+    int route;              // Corners to follow in the route table, -1 for a straight line
+    int pathIndex;          // Next corner
+    BehaviorHandle script;  // Woken when the walk has arrived
+    bool active;
+};
+
+// Walk cycle clock of a robot, advances while it walks or scans
+struct Animation {
+    float time;
+};
+
+// Guide robot scan: the exhibit turns while the robot scans it, then the popup shows
+struct Scanner {
+    float angle;            // Exhibit rotation in degrees
+    int stop;               // Tour stop scanned last, -1 before the first scan
+    bool scanning;
+    bool popup;
+};
+
+// Robot walking from random exhibit to random exhibit
+struct Wanderer {
+    int targetExhibit;
+};
+
+#endif
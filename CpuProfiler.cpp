@@ -0,0 +1,183 @@
+#include "CpuProfiler.h"
+
+#ifdef MUSEUM_PROFILING
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+// Read the time stamp counter directly on x86, it is much cheaper than the OS clocks
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define PROFILER_USE_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PROFILER_USE_TSC 1
+#endif
+
+// Zones one thread can record during a single capture
+static const unsigned int EVENTS_PER_THREAD = 1 << 16;
+
+// One finished zone
+struct ProfileEvent {
+    const char* name;
+    unsigned long long start;
+    unsigned long long end;
+};
+
+// Events of one thread; only that thread writes, the dump only reads [0, count)
+struct ThreadBuffer {
+    ProfileEvent events[EVENTS_PER_THREAD];
+    std::atomic<unsigned int> count;
+    unsigned int generation;   // Capture the events belong to
+    int threadId;
+    std::string threadName;
+};
+
+// Global capture state
+static std::atomic<bool> capturing(false);
+static std::atomic<unsigned int> captureGeneration(0);
+static int framesRemaining = 0;
+static std::string capturePath;
+
+// Reference points to convert ticks to microseconds
+static unsigned long long startTicks = 0;
+static std::chrono::steady_clock::time_point startTime;
+
+// Every thread buffer ever created; the lock is only taken once per thread and when dumping
+static std::mutex registryMutex;
+static std::vector<ThreadBuffer*> registry;
+static thread_local ThreadBuffer* localBuffer = nullptr;
+
+// Current time in profiler ticks
+static inline unsigned long long profilerTicks() {
+#ifdef PROFILER_USE_TSC
+    return __rdtsc();
+#else
+    return (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// Returns the buffer of the calling thread, creating it on first use
+static ThreadBuffer* getThreadBuffer() {
+    if (localBuffer == nullptr) {
+        ThreadBuffer* buffer = new ThreadBuffer();
+        buffer->count.store(0, std::memory_order_relaxed);
+        buffer->generation = 0;
+
+        std::lock_guard<std::mutex> lock(registryMutex);
+        buffer->threadId = (int)registry.size();
+        buffer->threadName = buffer->threadId == 0 ? "Main" : "Thread " + std::to_string(buffer->threadId);
+        registry.push_back(buffer);
+        localBuffer = buffer;
+    }
+    return localBuffer;
+}
+
+CpuProfileScope::CpuProfileScope(const char* name) : name(name) {
+    active = capturing.load(std::memory_order_relaxed);
+    if (active) start = profilerTicks();
+}
+
+CpuProfileScope::~CpuProfileScope() {
+    if (!active) return;
+    unsigned long long end = profilerTicks();
+
+    ThreadBuffer* buffer = getThreadBuffer();
+
+    // First event of a new capture: the owning thread clears its own buffer
+    unsigned int generation = captureGeneration.load(std::memory_order_acquire);
+    if (buffer->generation != generation) {
+        buffer->generation = generation;
+        buffer->count.store(0, std::memory_order_relaxed);
+    }
+
+    // Full buffers drop events instead of blocking
+    unsigned int index = buffer->count.load(std::memory_order_relaxed);
+    if (index >= EVENTS_PER_THREAD) return;
+
+    buffer->events[index].name = name;
+    buffer->events[index].start = start;
+    buffer->events[index].end = end;
+    buffer->count.store(index + 1, std::memory_order_release);
+}
+
+void cpuProfilerStartCapture(int frames, const std::string& path) {
+    if (capturing.load()) return;
+
+    capturePath = path;
+    framesRemaining = frames;
+    startTicks = profilerTicks();
+    startTime = std::chrono::steady_clock::now();
+
+    captureGeneration.fetch_add(1, std::memory_order_release);
+    capturing.store(true, std::memory_order_release);
+    std::cout << "CPU profiler: capture started" << std::endl;
+}
+
+void cpuProfilerStopCapture() {
+    if (!capturing.load()) return;
+    capturing.store(false, std::memory_order_release);
+
+    // Ticks per microsecond, measured over the capture itself
+    unsigned long long stopTicks = profilerTicks();
+    double elapsedUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - startTime).count();
+    double ticksPerUs = elapsedUs > 0.0 ? (double)(stopTicks - startTicks) / elapsedUs : 1000.0;
+
+    std::ofstream file(capturePath.c_str());
+    if (!file.is_open()) {
+        std::cerr << "CPU profiler: could not write " << capturePath << std::endl;
+        return;
+    }
+
+    unsigned int generation = captureGeneration.load();
+    size_t written = 0;
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    std::lock_guard<std::mutex> lock(registryMutex);
+    bool first = true;
+    for (size_t t = 0; t < registry.size(); t++) {
+        ThreadBuffer* buffer = registry[t];
+
+        // Thread name metadata
+        file << (first ? "" : ",\n") << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":"
+            << buffer->threadId << ",\"args\":{\"name\":\"" << buffer->threadName << "\"}}";
+        first = false;
+
+        if (buffer->generation != generation) continue;  // Nothing recorded this capture
+
+        unsigned int count = buffer->count.load(std::memory_order_acquire);
+        for (unsigned int i = 0; i < count; i++) {
+            const ProfileEvent& e = buffer->events[i];
+            double ts = (double)(long long)(e.start - startTicks) / ticksPerUs;
+            double dur = (double)(e.end - e.start) / ticksPerUs;
+            file << ",\n{\"ph\":\"X\",\"name\":\"" << e.name << "\",\"pid\":1,\"tid\":" << buffer->threadId
+                << ",\"ts\":" << ts << ",\"dur\":" << dur << "}";
+            written++;
+        }
+    }
+    file << "\n]}\n";
+
+    std::cout << "CPU profiler: wrote " << written << " zones to " << capturePath << std::endl;
+}
+
+bool cpuProfilerIsCapturing() {
+    return capturing.load(std::memory_order_relaxed);
+}
+
+void cpuProfilerEndFrame() {
+    if (!capturing.load(std::memory_order_relaxed) || framesRemaining <= 0) return;
+    if (--framesRemaining == 0) cpuProfilerStopCapture();
+}
+
+void cpuProfilerSetThreadName(const char* name) {
+    ThreadBuffer* buffer = getThreadBuffer();
+    std::lock_guard<std::mutex> lock(registryMutex);
+    buffer->threadName = name;
+}
+
+#endif
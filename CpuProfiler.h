@@ -0,0 +1,62 @@
+#ifndef CPUPROFILER_H
+#define CPUPROFILER_H
+
+#include <string>
+
+// Scoped CPU zone profiler with Chrome trace (chrome://tracing, Perfetto) export.
+// Only compiled in when MUSEUM_PROFILING is defined, otherwise every macro is empty.
+//
+//   PROFILE_SCOPE("Room::update");   // times the enclosing scope
+//   PROFILE_FUNCTION();              // same, named after the function
+//   PROFILE_FRAME_END();             // once per frame, ends N-frame captures
+#ifdef MUSEUM_PROFILING
+
+// Times the scope it lives in while a capture is running
+class CpuProfileScope {
+public:
+    explicit CpuProfileScope(const char* name);  // name must be a string literal
+    ~CpuProfileScope();
+
+private:
+    const char* name;
+    unsigned long long start;
+    bool active;
+};
+
+// Starts recording; frames > 0 stops and writes the trace automatically after that many frames
+void cpuProfilerStartCapture(int frames, const std::string& path);
+
+// Stops recording and writes the Chrome trace JSON to the path given at start
+void cpuProfilerStopCapture();
+
+// True while zones are being recorded
+bool cpuProfilerIsCapturing();
+
+// Marks the end of a frame (counts down N-frame captures)
+void cpuProfilerEndFrame();
+
+// Names the calling thread in the trace
+void cpuProfilerSetThreadName(const char* name);
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) CpuProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+#define PROFILE_FRAME_END() cpuProfilerEndFrame()
+#define PROFILE_THREAD_NAME(name) cpuProfilerSetThreadName(name)
+
+#else
+
+// Profiling compiled out: nothing is generated
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_FUNCTION() ((void)0)
+#define PROFILE_FRAME_END() ((void)0)
+#define PROFILE_THREAD_NAME(name) ((void)0)
+
+inline void cpuProfilerStartCapture(int, const std::string&) {}
+inline void cpuProfilerStopCapture() {}
+inline bool cpuProfilerIsCapturing() { return false; }
+
+#endif
+
+#endif
@@ -0,0 +1,364 @@
+#include "Crowd.h"
+#include "NavGrid.h"
+#include "JobSystem.h"
+#include "CpuProfiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <xmmintrin.h>
+#define CROWD_SSE 1
+#endif
+
+// Agents moved per job
+static const int CROWD_CHUNK = 1024;
+
+// Visitors closer than this push each other apart; the hash cells are at least as large,
+// so every neighbour is in the 3x3 cells around an agent
+static const float CROWD_SEPARATION_DISTANCE = 0.6f;
+static const float CROWD_HASH_CELL = 0.75f;
+
+
+// Speed in m/s of the push between two visitors standing on the same spot
+static const float CROWD_SEPARATION_SPEED = 2.0f;
+
+// How fast the velocity follows the steering (1/s) and its limit (m/s)
+static const float CROWD_RESPONSE = 4.0f;
+static const float CROWD_MAX_SPEED = 1.8f;
+
+// Distance at which a visitor stops to look at its exhibit
+static const float CROWD_ARRIVE_DISTANCE = 1.5f;
+
+// Visitors blocked this long give up and pick another exhibit
+static const float CROWD_STUCK_SECONDS = 4.0f;
+static const float CROWD_STUCK_SPEED = 0.1f;
+
+// Longest step simulated at once (a hitch must not throw visitors through walls)
+static const float CROWD_MAX_STEP = 0.1f;
+
+// Next value of an agent's random state in [0, 1)
+static float nextRandom(unsigned int& state) {
+    state = state * 1664525u + 1013904223u;
+    return (state >> 8) * (1.0f / 16777216.0f);
+}
+
+Crowd::Crowd(NavGrid* grid, const std::vector<glm::vec3>& starts, const std::vector<glm::vec3>& points, unsigned int seed) : grid(grid) {
+    PROFILE_SCOPE("Crowd::build");
+    agentCount = (int)starts.size();
+    deltaTime = 0.0f;
+    updateMilliseconds = 0.0f;
+
+    // Flow fields of up to CROWD_MAX_FLOW_FIELDS points, spread over the list
+    int fields = (int)points.size() < CROWD_MAX_FLOW_FIELDS ? (int)points.size() : CROWD_MAX_FLOW_FIELDS;
+    for (int i = 0; i < fields; i++) {
+        pointsOfInterest.push_back(points[i * points.size() / fields]);
+        flowFields.push_back(std::vector<unsigned char>());
+        grid->buildFlowField(pointsOfInterest.back(), flowFields.back());
+    }
+
+    positionX.resize(agentCount);
+    positionZ.resize(agentCount);
+    velocityX.assign(agentCount, 0.0f);
+    velocityZ.assign(agentCount, 0.0f);
+    steerX.assign(agentCount, 0.0f);
+    steerZ.assign(agentCount, 0.0f);
+    nextX.resize(agentCount);
+    nextZ.resize(agentCount);
+    heading.assign(agentCount, 0.0f);
+    walkSpeed.resize(agentCount);
+    waitTimer.assign(agentCount, 0.0f);
+    slowTimer.assign(agentCount, 0.0f);
+    goal.assign(agentCount, -1);
+    random.resize(agentCount);
+
+    for (int i = 0; i < agentCount; i++) {
+        // Visitors moved to the same cell center are spread inside the cell,
+        // two agents on one spot would never push each other apart
+        glm::vec3 start = grid->nearestWalkable(starts[i]);
+        random[i] = seed * 2654435761u + (unsigned int)i * 40503u + 1u;
+        if (start.x != starts[i].x || start.z != starts[i].z) {
+            start.x += (nextRandom(random[i]) - 0.5f) * 0.2f;
+            start.z += (nextRandom(random[i]) - 0.5f) * 0.2f;
+        }
+        positionX[i] = start.x;
+        positionZ[i] = start.z;
+        walkSpeed[i] = 0.9f + 0.5f * nextRandom(random[i]);
+        pickGoal(i);
+    }
+
+    // The hash is linear in the cell (row * stride + column) with a row as wide as the museum,
+    // so the three cells of a row are neighbouring buckets, agents sorted by bucket are sorted
+    // by place, and rows only share buckets when the table is smaller than the floor
+    float minX = 0.0f, maxX = 0.0f;
+    for (size_t i = 0; i < starts.size() + points.size(); i++) {
+        float x = i < starts.size() ? starts[i].x : points[i - starts.size()].x;
+        minX = (i == 0 || x < minX) ? x : minX;
+        maxX = (i == 0 || x > maxX) ? x : maxX;
+    }
+    hashStride = (unsigned int)((maxX - minX) / CROWD_HASH_CELL) + 16u;
+
+    // Twice as many buckets as agents (a power of two) keeps the collisions rare,
+    // four rows at least keep neighbouring rows apart
+    unsigned int buckets = 64u;
+    while (buckets < 4u * hashStride || buckets < (unsigned int)agentCount * 2u) buckets *= 2u;
+    hashMask = buckets - 1u;
+    bucketStart.resize(buckets + 1);
+    bucketCursor.resize(buckets);
+    agentBucket.resize(agentCount);
+    sortedAgents.resize(agentCount);
+    sortedX.resize(agentCount + 3);     // Padding for the last group of four in addSeparation
+    sortedZ.resize(agentCount + 3);
+}
+
+unsigned int Crowd::bucketOf(int cellX, int cellZ) const {
+    return ((unsigned int)cellZ * hashStride + (unsigned int)cellX) & hashMask;
+}
+
+void Crowd::pickGoal(int agent) {
+    if (flowFields.empty()) return;
+
+    // Any other exhibit than the one just seen
+    int count = (int)flowFields.size();
+    int next = (int)(nextRandom(random[agent]) * count) % count;
+    if (next == goal[agent] && count > 1) next = (next + 1) % count;
+    goal[agent] = next;
+    slowTimer[agent] = 0.0f;
+}
+
+void Crowd::rebuildHash() {
+    PROFILE_SCOPE("Crowd::rebuildHash");
+
+    // Counting sort by bucket: count, prefix sum, scatter
+    std::fill(bucketStart.begin(), bucketStart.end(), 0);
+    for (int i = 0; i < agentCount; i++) {
+        agentBucket[i] = bucketOf((int)std::floor(positionX[i] / CROWD_HASH_CELL), (int)std::floor(positionZ[i] / CROWD_HASH_CELL));
+        bucketStart[agentBucket[i] + 1]++;
+    }
+    for (size_t b = 1; b < bucketStart.size(); b++) bucketStart[b] += bucketStart[b - 1];
+
+    std::copy(bucketStart.begin(), bucketStart.end() - 1, bucketCursor.begin());
+    for (int i = 0; i < agentCount; i++) {
+        int slot = bucketCursor[agentBucket[i]]++;
+        sortedAgents[slot] = i;
+        sortedX[slot] = positionX[i];
+        sortedZ[slot] = positionZ[i];
+    }
+}
+
+// Adds the push of every agent in sorted slots [begin, end) closer than the separation distance.
+// The offset times SPEED * (1 / distance - 1 / SEPARATION) is a push of SPEED * (1 - distance / SEPARATION),
+// clamped to zero beyond the separation distance and zero for the agent itself (zero offset),
+// so the loop needs no branches
+static void addSeparation(const float* sortedX, const float* sortedZ, int begin, int end,
+    float x, float z, float& steerX, float& steerZ) {
+    const float inverseSeparation = 1.0f / CROWD_SEPARATION_DISTANCE;
+    int k = begin;
+    if (k >= end) return;
+#ifdef CROWD_SSE
+    __m128 x4 = _mm_set1_ps(x);
+    __m128 z4 = _mm_set1_ps(z);
+    __m128 speed4 = _mm_set1_ps(CROWD_SEPARATION_SPEED);
+    __m128 inverseSeparation4 = _mm_set1_ps(inverseSeparation);
+    __m128 tiny4 = _mm_set1_ps(1e-12f);
+    __m128 zero4 = _mm_setzero_ps();
+    __m128 lane4 = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+    __m128 sumX = zero4, sumZ = zero4;
+
+    // Rows hold a few agents, so the last group of four is masked instead of
+    // finished one by one (the sorted arrays are padded for the read past the end)
+    for (; k < end; k += 4) {
+        __m128 offsetX = _mm_sub_ps(x4, _mm_loadu_ps(sortedX + k));
+        __m128 offsetZ = _mm_sub_ps(z4, _mm_loadu_ps(sortedZ + k));
+        __m128 distance2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(offsetX, offsetX), _mm_mul_ps(offsetZ, offsetZ)), tiny4);
+        __m128 weight = _mm_max_ps(zero4, _mm_mul_ps(speed4, _mm_sub_ps(_mm_rsqrt_ps(distance2), inverseSeparation4)));
+        weight = _mm_and_ps(weight, _mm_cmplt_ps(lane4, _mm_set1_ps((float)(end - k))));
+        sumX = _mm_add_ps(sumX, _mm_mul_ps(offsetX, weight));
+        sumZ = _mm_add_ps(sumZ, _mm_mul_ps(offsetZ, weight));
+    }
+    float lanesX[4], lanesZ[4];
+    _mm_storeu_ps(lanesX, sumX);
+    _mm_storeu_ps(lanesZ, sumZ);
+    steerX += lanesX[0] + lanesX[1] + lanesX[2] + lanesX[3];
+    steerZ += lanesZ[0] + lanesZ[1] + lanesZ[2] + lanesZ[3];
+#else
+    for (; k < end; k++) {
+        float offsetX = x - sortedX[k];
+        float offsetZ = z - sortedZ[k];
+        float distance2 = offsetX * offsetX + offsetZ * offsetZ + 1e-12f;
+        float weight = CROWD_SEPARATION_SPEED * (1.0f / std::sqrt(distance2) - inverseSeparation);
+        if (weight < 0.0f) weight = 0.0f;
+        steerX += offsetX * weight;
+        steerZ += offsetZ * weight;
+    }
+#endif
+}
+
+void Crowd::steerChunk(void* data, int begin, int end) {
+    Crowd* crowd = (Crowd*)data;
+    const int* agents = crowd->sortedAgents.data();
+    const float* sortedX = crowd->sortedX.data();
+    const float* sortedZ = crowd->sortedZ.data();
+    const int* bucketStart = crowd->bucketStart.data();
+
+    // Agents in bucket order: neighbours in space are handled one after the other,
+    // so their buckets and flow field cells are still in cache
+    for (int slot = begin; slot < end; slot++) {
+        int i = agents[slot];
+        float x = sortedX[slot];
+        float z = sortedZ[slot];
+
+        // Along the flow field, unless the visitor is looking at an exhibit
+        float desiredX = 0.0f, desiredZ = 0.0f;
+        if (crowd->waitTimer[i] <= 0.0f && crowd->goal[i] >= 0) {
+            glm::vec3 direction = crowd->grid->flowDirection(crowd->flowFields[crowd->goal[i]], glm::vec3(x, 0.0f, z));
+            desiredX = direction.x * crowd->walkSpeed[i];
+            desiredZ = direction.z * crowd->walkSpeed[i];
+        }
+
+        // Push away from the visitors in the 3x3 cells around; each row is one range
+        // of sorted slots unless it wraps around the end of the table
+        int cellX = (int)std::floor(x / CROWD_HASH_CELL);
+        int cellZ = (int)std::floor(z / CROWD_HASH_CELL);
+        for (int dz = -1; dz <= 1; dz++) {
+            unsigned int first = crowd->bucketOf(cellX - 1, cellZ + dz);
+            if (first + 2u <= crowd->hashMask) {
+                addSeparation(sortedX, sortedZ, bucketStart[first], bucketStart[first + 3], x, z, desiredX, desiredZ);
+                continue;
+            }
+            for (unsigned int b = 0; b < 3u; b++) {
+                unsigned int bucket = (first + b) & crowd->hashMask;
+                addSeparation(sortedX, sortedZ, bucketStart[bucket], bucketStart[bucket + 1], x, z, desiredX, desiredZ);
+            }
+        }
+        crowd->steerX[i] = desiredX;
+        crowd->steerZ[i] = desiredZ;
+    }
+}
+
+void Crowd::moveChunk(void* data, int begin, int end) {
+    Crowd* crowd = (Crowd*)data;
+    float deltaTime = crowd->deltaTime;
+    float blend = deltaTime * CROWD_RESPONSE < 1.0f ? deltaTime * CROWD_RESPONSE : 1.0f;
+    float* positionX = crowd->positionX.data();
+    float* positionZ = crowd->positionZ.data();
+    float* velocityX = crowd->velocityX.data();
+    float* velocityZ = crowd->velocityZ.data();
+    float* nextX = crowd->nextX.data();
+    float* nextZ = crowd->nextZ.data();
+    const float* steerX = crowd->steerX.data();
+    const float* steerZ = crowd->steerZ.data();
+
+    // Velocity follows the steering, limited to the top speed, then a tentative step
+    int i = begin;
+#ifdef CROWD_SSE
+    __m128 blend4 = _mm_set1_ps(blend);
+    __m128 step4 = _mm_set1_ps(deltaTime);
+    __m128 maxSpeed4 = _mm_set1_ps(CROWD_MAX_SPEED);
+    __m128 one4 = _mm_set1_ps(1.0f);
+    __m128 tiny4 = _mm_set1_ps(1e-12f);
+    for (; i + 4 <= end; i += 4) {
+        __m128 vx = _mm_loadu_ps(velocityX + i);
+        __m128 vz = _mm_loadu_ps(velocityZ + i);
+        vx = _mm_add_ps(vx, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(steerX + i), vx), blend4));
+        vz = _mm_add_ps(vz, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(steerZ + i), vz), blend4));
+
+        __m128 speed2 = _mm_max_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vz, vz)), tiny4);
+        __m128 scale = _mm_min_ps(one4, _mm_mul_ps(maxSpeed4, _mm_rsqrt_ps(speed2)));
+        vx = _mm_mul_ps(vx, scale);
+        vz = _mm_mul_ps(vz, scale);
+
+        _mm_storeu_ps(velocityX + i, vx);
+        _mm_storeu_ps(velocityZ + i, vz);
+        _mm_storeu_ps(nextX + i, _mm_add_ps(_mm_loadu_ps(positionX + i), _mm_mul_ps(vx, step4)));
+        _mm_storeu_ps(nextZ + i, _mm_add_ps(_mm_loadu_ps(positionZ + i), _mm_mul_ps(vz, step4)));
+    }
+#endif
+    for (; i < end; i++) {
+        float vx = velocityX[i] + (steerX[i] - velocityX[i]) * blend;
+        float vz = velocityZ[i] + (steerZ[i] - velocityZ[i]) * blend;
+        float speed2 = vx * vx + vz * vz;
+        if (speed2 > CROWD_MAX_SPEED * CROWD_MAX_SPEED) {
+            float scale = CROWD_MAX_SPEED / std::sqrt(speed2);
+            vx *= scale;
+            vz *= scale;
+        }
+        velocityX[i] = vx;
+        velocityZ[i] = vz;
+        nextX[i] = positionX[i] + vx * deltaTime;
+        nextZ[i] = positionZ[i] + vz * deltaTime;
+    }
+
+    // Walls and exhibits: slide along them, or stop when both directions are blocked
+    NavGrid* grid = crowd->grid;
+    for (i = begin; i < end; i++) {
+        if (!grid->isWalkable(glm::vec3(nextX[i], 0.0f, nextZ[i]))) {
+            if (grid->isWalkable(glm::vec3(nextX[i], 0.0f, positionZ[i]))) {
+                nextZ[i] = positionZ[i];
+                velocityZ[i] = 0.0f;
+            }
+            else if (grid->isWalkable(glm::vec3(positionX[i], 0.0f, nextZ[i]))) {
+                nextX[i] = positionX[i];
+                velocityX[i] = 0.0f;
+            }
+            else {
+                nextX[i] = positionX[i];
+                nextZ[i] = positionZ[i];
+                velocityX[i] = 0.0f;
+                velocityZ[i] = 0.0f;
+            }
+        }
+        positionX[i] = nextX[i];
+        positionZ[i] = nextZ[i];
+
+        float speed2 = velocityX[i] * velocityX[i] + velocityZ[i] * velocityZ[i];
+        if (speed2 > CROWD_STUCK_SPEED * CROWD_STUCK_SPEED) crowd->heading[i] = std::atan2(velocityX[i], velocityZ[i]);
+
+        // Looking at an exhibit, then on to the next one
+        if (crowd->waitTimer[i] > 0.0f) {
+            crowd->waitTimer[i] -= deltaTime;
+            if (crowd->waitTimer[i] <= 0.0f) crowd->pickGoal(i);
+            continue;
+        }
+        if (crowd->goal[i] < 0) continue;
+
+        const glm::vec3& target = crowd->pointsOfInterest[crowd->goal[i]];
+        float offsetX = target.x - positionX[i];
+        float offsetZ = target.z - positionZ[i];
+        if (offsetX * offsetX + offsetZ * offsetZ < CROWD_ARRIVE_DISTANCE * CROWD_ARRIVE_DISTANCE) {
+            crowd->waitTimer[i] = 2.0f + 4.0f * nextRandom(crowd->random[i]);
+            continue;
+        }
+
+        // Stuck in a crowd around the exhibit (or without a route): try another one
+        crowd->slowTimer[i] = speed2 < CROWD_STUCK_SPEED * CROWD_STUCK_SPEED ? crowd->slowTimer[i] + deltaTime : 0.0f;
+        if (crowd->slowTimer[i] > CROWD_STUCK_SECONDS) crowd->pickGoal(i);
+    }
+}
+
+void Crowd::update(float deltaTime, JobSystem* jobs) {
+    PROFILE_SCOPE("Crowd::update");
+    if (agentCount == 0) return;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    this->deltaTime = deltaTime < CROWD_MAX_STEP ? deltaTime : CROWD_MAX_STEP;
+
+    // Neighbours are looked up in this tick's positions, so the steering of every
+    // agent is independent and the chunks can run in any order
+    rebuildHash();
+    if (jobs) {
+        jobs->parallelFor(agentCount, CROWD_CHUNK, steerChunk, this);
+        jobs->parallelFor(agentCount, CROWD_CHUNK, moveChunk, this);
+    }
+    else {
+        steerChunk(this, 0, agentCount);
+        moveChunk(this, 0, agentCount);
+    }
+    updateMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Crowd::writeInstances(std::vector<glm::vec4>& instances) const {
+    instances.resize(agentCount);
+    for (int i = 0; i < agentCount; i++) {
+        instances[i] = glm::vec4(positionX[i], 0.0f, positionZ[i], heading[i]);
+    }
+}
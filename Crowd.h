@@ -0,0 +1,74 @@
+#ifndef CROWD_H
+#define CROWD_H
+
+#include <glm/glm.hpp>
+#include <vector>
+
+class NavGrid;
+class JobSystem;
+
+// Points of interest that get a flow field (each costs one byte per grid cell)
+#define CROWD_MAX_FLOW_FIELDS 16
+
+// Museum visitors walking from exhibit to exhibit, thousands at a time.
+// Agents are stored as one array per attribute, so the per-tick passes stream
+// through memory and the integration runs four agents per SSE instruction.
+// Every visitor follows the flow field of its exhibit (one shared field per
+// exhibit instead of a route per visitor) and keeps its distance from the
+// others found through a uniform spatial hash rebuilt every tick.
+// Not thread-safe: update and writeInstances belong to the simulation.
+class Crowd {
+public:
+    // - grid: walkable floor, flow fields are built on it (must outlive the crowd)
+    // - starts: visitor positions, moved to the nearest walkable spot
+    // - pointsOfInterest: places the visitors walk to (at most CROWD_MAX_FLOW_FIELDS are used)
+    Crowd(NavGrid* grid, const std::vector<glm::vec3>& starts, const std::vector<glm::vec3>& pointsOfInterest, unsigned int seed);
+
+    // Moves every visitor, in parallel chunks when jobs is given
+    void update(float deltaTime, JobSystem* jobs);
+
+    // One entry per visitor for instanced drawing: xyz = position, w = heading in radians
+    void writeInstances(std::vector<glm::vec4>& instances) const;
+
+    int getAgentCount() const { return agentCount; }
+    float getUpdateMilliseconds() const { return updateMilliseconds; }
+
+private:
+    NavGrid* grid;
+    int agentCount;
+    float deltaTime;            // Step of the running update, read by the chunk jobs
+    float updateMilliseconds;
+
+    // Agents, one array per attribute
+    std::vector<float> positionX, positionZ;
+    std::vector<float> velocityX, velocityZ;
+    std::vector<float> steerX, steerZ;      // Desired velocity of this tick
+    std::vector<float> nextX, nextZ;        // Integrated position before the collision test
+    std::vector<float> heading;             // Facing around the up axis in radians
+    std::vector<float> walkSpeed;           // Preferred speed in m/s
+    std::vector<float> waitTimer;           // Seconds left looking at the current exhibit
+    std::vector<float> slowTimer;           // Seconds spent barely moving (blocked by the crowd)
+    std::vector<int> goal;                  // Point of interest (flow field) walked to
+    std::vector<unsigned int> random;       // Per agent random state
+
+    // Points of interest and their flow fields
+    std::vector<glm::vec3> pointsOfInterest;
+    std::vector<std::vector<unsigned char> > flowFields;
+
+    // Spatial hash: agents sorted by bucket, with a copy of their positions in that order
+    unsigned int hashMask;
+    unsigned int hashStride;                // Buckets per row of cells
+    std::vector<int> bucketStart;           // First sorted entry of every bucket (size buckets + 1)
+    std::vector<int> bucketCursor;
+    std::vector<unsigned int> agentBucket;
+    std::vector<int> sortedAgents;
+    std::vector<float> sortedX, sortedZ;
+
+    unsigned int bucketOf(int cellX, int cellZ) const;
+    void rebuildHash();
+    void pickGoal(int agent);
+    static void steerChunk(void* crowd, int begin, int end);    // Flow field and separation (sorted slots)
+    static void moveChunk(void* crowd, int begin, int end);     // Integration, collisions and goals
+};
+
+#endif
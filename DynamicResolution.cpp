@@ -0,0 +1,95 @@
+#include "DynamicResolution.h"
+#include <cmath>
+
+// Quality limits of the controller
+static const float MIN_RENDER_SCALE = 0.5f;
+static const int MAX_LOD_BIAS = 3;
+
+// Frames between two LOD steps so every change can show its effect first
+static const int QUALITY_COOLDOWN_FRAMES = 30;
+
+DynamicResolution::DynamicResolution(float budgetMs) : budgetMs(budgetMs) {
+    minScale = MIN_RENDER_SCALE;
+    renderScale = 1.0f;
+    lodBias = 0;
+    gpuTimeMs = 0.0f;
+    qualityCooldown = 0;
+    frameIndex = 0;
+
+    glGenQueries(DYNAMIC_RESOLUTION_QUERY_FRAMES, startQueries);
+    glGenQueries(DYNAMIC_RESOLUTION_QUERY_FRAMES, endQueries);
+    for (int i = 0; i < DYNAMIC_RESOLUTION_QUERY_FRAMES; i++) pending[i] = false;
+}
+
+DynamicResolution::~DynamicResolution() {
+    glDeleteQueries(DYNAMIC_RESOLUTION_QUERY_FRAMES, startQueries);
+    glDeleteQueries(DYNAMIC_RESOLUTION_QUERY_FRAMES, endQueries);
+}
+
+void DynamicResolution::beginFrame() {
+    int slot = frameIndex % DYNAMIC_RESOLUTION_QUERY_FRAMES;
+
+    // Collect every finished measurement without waiting on the GPU
+    // (the slot about to be reused holds the oldest frame, the others follow in order)
+    for (int i = 0; i < DYNAMIC_RESOLUTION_QUERY_FRAMES; i++) {
+        int oldest = (slot + i) % DYNAMIC_RESOLUTION_QUERY_FRAMES;
+        if (!pending[oldest]) continue;
+
+        GLint available = 0;
+        glGetQueryObjectiv(endQueries[oldest], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available && i != 0) break;  // Newer frames cannot be ready either
+
+        // The slot about to be reused must be resolved, even if that means waiting
+        GLuint64 start = 0, end = 0;
+        glGetQueryObjectui64v(startQueries[oldest], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(endQueries[oldest], GL_QUERY_RESULT, &end);
+        pending[oldest] = false;
+        addSample((float)((end - start) / 1.0e6));
+    }
+
+    glQueryCounter(startQueries[slot], GL_TIMESTAMP);
+}
+
+void DynamicResolution::endFrame() {
+    int slot = frameIndex % DYNAMIC_RESOLUTION_QUERY_FRAMES;
+    glQueryCounter(endQueries[slot], GL_TIMESTAMP);
+    pending[slot] = true;
+    frameIndex++;
+}
+
+void DynamicResolution::addSample(float milliseconds) {
+    // Smooth out single spikes
+    gpuTimeMs = (gpuTimeMs == 0.0f) ? milliseconds : gpuTimeMs * 0.9f + milliseconds * 0.1f;
+    if (budgetMs <= 0.0f) return;
+
+    if (qualityCooldown > 0) qualityCooldown--;
+
+    if (gpuTimeMs > budgetMs) {
+        if (renderScale > minScale) {
+            // Pixel cost grows with the area, so scale both axes by the square root of the ratio
+            renderScale *= std::sqrt(budgetMs / gpuTimeMs);
+            if (renderScale < minScale) renderScale = minScale;
+        }
+        else if (qualityCooldown == 0) {
+            // Resolution is at its floor, give up other quality instead
+            if (lodBias < MAX_LOD_BIAS) {
+                lodBias++;
+                qualityCooldown = QUALITY_COOLDOWN_FRAMES;
+            }
+        }
+    }
+    else if (gpuTimeMs < budgetMs * 0.8f) {
+        // Plenty of headroom: restore quality in the reverse order it was given up
+        if (lodBias > 0) {
+            if (qualityCooldown == 0) {
+                lodBias--;
+                qualityCooldown = QUALITY_COOLDOWN_FRAMES;
+            }
+        }
+        else if (renderScale < 1.0f) {
+            // Grow slowly to avoid oscillating around the budget
+            renderScale += 0.02f;
+            if (renderScale > 1.0f) renderScale = 1.0f;
+        }
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef DYNAMICRESOLUTION_H
+#define DYNAMICRESOLUTION_H
+
+#include <glad/glad.h>
+
+// Number of frames a GPU timestamp may stay in flight before it is read back
+static const int DYNAMIC_RESOLUTION_QUERY_FRAMES = 4;
+
+// Adjusts the scene render scale (and, if that is not enough, other quality settings)
+// so the measured GPU time of the scene stays under a budget
+class DynamicResolution {
+public:
+    // - budgetMs: GPU time allowed for the 3D scene, 0 keeps full resolution
+    DynamicResolution(float budgetMs);
+    ~DynamicResolution();
+
+    // Reads back finished timings, updates the scale and starts timing the scene
+    void beginFrame();
+
+    // Stops timing the scene for this frame
+    void endFrame();
+
+    // Fraction of the window resolution the scene is rendered at (minScale..1)
+    float getRenderScale() const { return renderScale; }
+
+    // Extra level-of-detail bias for mesh selection (0 = full detail)
+    int getLodBias() const { return lodBias; }
+
+    // Smoothed GPU time of the scene in milliseconds
+    float getGpuTimeMs() const { return gpuTimeMs; }
+    float getBudgetMs() const { return budgetMs; }
+
+private:
+    float budgetMs;          // Target GPU time per frame
+    float minScale;          // Lowest allowed render scale
+    float renderScale;       // Current render scale
+    int lodBias;             // Current LOD bias
+    float gpuTimeMs;         // Exponentially smoothed measurement
+    int qualityCooldown;     // Frames to wait before the next LOD change
+
+    // Ring of timestamp pairs; timestamps (not GL_TIME_ELAPSED) so other timers can nest
+    unsigned int startQueries[DYNAMIC_RESOLUTION_QUERY_FRAMES];
+    unsigned int endQueries[DYNAMIC_RESOLUTION_QUERY_FRAMES];
+    bool pending[DYNAMIC_RESOLUTION_QUERY_FRAMES];
+    int frameIndex;
+
+    // Feeds one GPU measurement into the controller
+    void addSample(float milliseconds);
+};
+
+#endif
@@ -0,0 +1,220 @@
+#include "ExhibitCatalog.h"
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+// Removes spaces, tabs and the carriage return of Windows line endings
+static std::string trim(const std::string& text) {
+    size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) return "";
+    size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+// Strings of all entries, each stored once (periods and model paths repeat a lot)
+class StringPool {
+public:
+    StringPool() { add(""); }   // Offset 0 is the empty string
+
+    unsigned int add(const std::string& text) {
+        std::unordered_map<std::string, unsigned int>::iterator found = offsets.find(text);
+        if (found != offsets.end()) return found->second;
+        unsigned int offset = (unsigned int)data.size();
+        data.insert(data.end(), text.begin(), text.end());
+        data.push_back('\0');
+        offsets[text] = offset;
+        return offset;
+    }
+
+    const std::vector<char>& getData() const { return data; }
+
+private:
+    std::vector<char> data;
+    std::unordered_map<std::string, unsigned int> offsets;
+};
+
+bool compileExhibitCatalog(const std::string& sourcePath, const std::string& binaryPath) {
+    std::ifstream source(sourcePath.c_str());
+    if (!source) {
+        std::cerr << "ERROR::CATALOG::FILE_NOT_FOUND: " << sourcePath << std::endl;
+        return false;
+    }
+
+    std::vector<CatalogEntry> entries;
+    StringPool pool;
+    CatalogEntry entry;
+    bool inEntry = false, hasId = false, hasTitle = false;
+    unsigned int largestId = 0;
+    int lineNumber = 0, entryLine = 0;
+
+    // Closes the current block: an entry needs an id and a title
+    auto finishEntry = [&]() -> bool {
+        if (!inEntry) return true;
+        inEntry = false;
+        if (!hasId || !hasTitle) {
+            std::cerr << "ERROR::CATALOG::MISSING_" << (hasId ? "TITLE" : "ID") << ": " << sourcePath << ":" << entryLine << std::endl;
+            return false;
+        }
+        entries.push_back(entry);
+        if (entry.id > largestId) largestId = entry.id;
+        return true;
+    };
+
+    std::string line;
+    while (std::getline(source, line)) {
+        lineNumber++;
+        if (lineNumber == 1 && line.compare(0, 3, "\xEF\xBB\xBF") == 0) line = line.substr(3);     // UTF-8 byte order mark
+        std::string content = trim(line);
+        if (content.empty()) {
+            if (!finishEntry()) return false;
+            continue;
+        }
+        if (content[0] == '#') continue;
+
+        size_t colon = content.find(':');
+        if (colon == std::string::npos) {
+            std::cerr << "ERROR::CATALOG::EXPECTED_KEY_VALUE: " << sourcePath << ":" << lineNumber << std::endl;
+            return false;
+        }
+        std::string key = trim(content.substr(0, colon));
+        std::string value = trim(content.substr(colon + 1));
+
+        if (!inEntry) {
+            inEntry = true;
+            hasId = hasTitle = false;
+            entryLine = lineNumber;
+            std::memset(&entry, 0, sizeof(entry));
+            entry.scale = 1.0f;
+        }
+
+        if (key == "id") {
+            char* end;
+            unsigned long id = std::strtoul(value.c_str(), &end, 10);
+            if (value.empty() || *end != '\0' || id > CATALOG_MAX_ID) {
+                std::cerr << "ERROR::CATALOG::INVALID_ID: " << sourcePath << ":" << lineNumber << std::endl;
+                return false;
+            }
+            entry.id = (unsigned int)id;
+            hasId = true;
+        }
+        else if (key == "title") {
+            entry.title = pool.add(value);
+            hasTitle = true;
+        }
+        else if (key == "period") entry.period = pool.add(value);
+        else if (key == "description") entry.description = pool.add(value);
+        else if (key == "model") entry.model = pool.add(value);
+        else if (key == "importer") {
+            if (value != "auto" && value != "assimp" && value != "obj" && value != "gltf") {
+                std::cerr << "ERROR::CATALOG::UNKNOWN_IMPORTER: " << value << " at " << sourcePath << ":" << lineNumber << std::endl;
+                return false;
+            }
+            entry.importer = pool.add(value);
+        }
+        else if (key == "position") {
+            std::istringstream numbers(value);
+            if (!(numbers >> entry.position[0] >> entry.position[1] >> entry.position[2])) {
+                std::cerr << "ERROR::CATALOG::INVALID_POSITION: " << sourcePath << ":" << lineNumber << std::endl;
+                return false;
+            }
+        }
+        else if (key == "yaw") entry.yaw = (float)std::atof(value.c_str());
+        else if (key == "scale") entry.scale = (float)std::atof(value.c_str());
+        else {
+            std::cerr << "ERROR::CATALOG::UNKNOWN_KEY: " << key << " at " << sourcePath << ":" << lineNumber << std::endl;
+            return false;
+        }
+    }
+    if (!finishEntry()) return false;
+
+    // Id index: entry number of every id up to the largest one
+    unsigned int indexSize = entries.empty() ? 0 : largestId + 1;
+    std::vector<unsigned int> index(indexSize, CATALOG_NO_ENTRY);
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (index[entries[i].id] != CATALOG_NO_ENTRY) {
+            std::cerr << "ERROR::CATALOG::DUPLICATE_ID: " << entries[i].id << " in " << sourcePath << std::endl;
+            return false;
+        }
+        index[entries[i].id] = (unsigned int)i;
+    }
+
+    const std::vector<char>& strings = pool.getData();
+    CatalogHeader header;
+    std::memcpy(header.magic, "MCAT", 4);
+    header.version = CATALOG_VERSION;
+    header.entryCount = (unsigned int)entries.size();
+    header.indexSize = indexSize;
+    header.entriesOffset = sizeof(CatalogHeader);
+    header.indexOffset = header.entriesOffset + header.entryCount * (unsigned int)sizeof(CatalogEntry);
+    header.stringsOffset = header.indexOffset + indexSize * (unsigned int)sizeof(unsigned int);
+    header.stringsSize = (unsigned int)strings.size();
+
+    std::ofstream binary(binaryPath.c_str(), std::ios::binary);
+    if (!binary) {
+        std::cerr << "ERROR::CATALOG::CANNOT_WRITE: " << binaryPath << std::endl;
+        return false;
+    }
+    binary.write((const char*)&header, sizeof(header));
+    binary.write((const char*)entries.data(), entries.size() * sizeof(CatalogEntry));
+    binary.write((const char*)index.data(), index.size() * sizeof(unsigned int));
+    binary.write(strings.data(), strings.size());
+    if (!binary) {
+        std::cerr << "ERROR::CATALOG::CANNOT_WRITE: " << binaryPath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool ExhibitCatalog::open(const std::string& binaryPath) {
+    entries = nullptr;
+    index = nullptr;
+    strings = nullptr;
+    entryCount = 0;
+    indexSize = stringsSize = 0;
+    if (!file.open(binaryPath)) return false;
+
+    // Only the header and the section bounds are checked, entries are read on demand
+    const unsigned char* data = file.getData();
+    unsigned long long size = file.getSize();
+    CatalogHeader header;
+    bool valid = size >= sizeof(CatalogHeader);
+    if (valid) {
+        std::memcpy(&header, data, sizeof(header));
+        valid = std::memcmp(header.magic, "MCAT", 4) == 0 && header.version == CATALOG_VERSION &&
+                header.entriesOffset % 4 == 0 && header.indexOffset % 4 == 0 &&
+                header.entriesOffset + (unsigned long long)header.entryCount * sizeof(CatalogEntry) <= size &&
+                header.indexOffset + (unsigned long long)header.indexSize * sizeof(unsigned int) <= size &&
+                header.stringsOffset + (unsigned long long)header.stringsSize <= size &&
+                header.stringsSize > 0 && data[header.stringsOffset + header.stringsSize - 1] == '\0';
+    }
+    if (!valid) {
+        std::cerr << "ERROR::CATALOG::INVALID_FILE: " << binaryPath << std::endl;
+        file.close();
+        return false;
+    }
+
+    entries = (const CatalogEntry*)(data + header.entriesOffset);
+    index = (const unsigned int*)(data + header.indexOffset);
+    strings = (const char*)(data + header.stringsOffset);
+    entryCount = (int)header.entryCount;
+    indexSize = header.indexSize;
+    stringsSize = header.stringsSize;
+    return true;
+}
+
+bool loadExhibitCatalog(const std::string& sourcePath, const std::string& binaryPath, ExhibitCatalog& catalog) {
+    std::error_code error;
+    bool hasSource = std::filesystem::exists(sourcePath, error);
+    bool hasBinary = std::filesystem::exists(binaryPath, error);
+    bool stale = hasSource && (!hasBinary ||
+        std::filesystem::last_write_time(sourcePath, error) > std::filesystem::last_write_time(binaryPath, error));
+
+    // A broken source keeps the last good binary
+    if (stale && !compileExhibitCatalog(sourcePath, binaryPath) && !hasBinary) return false;
+    return catalog.open(binaryPath);
+}
@@ -0,0 +1,79 @@
+#ifndef EXHIBITCATALOG_H
+#define EXHIBITCATALOG_H
+
+#include <string>
+#include "MappedFile.h"
+
+// Binary catalog layout (little endian, version CATALOG_VERSION):
+//   CatalogHeader
+//   CatalogEntry[entryCount]          fixed-size records, strings as pool offsets
+//   unsigned int[indexSize]           entry of every id (CATALOG_NO_ENTRY for unused ids)
+//   char[stringsSize]                 UTF-8 string pool, every string NUL-terminated
+#define CATALOG_VERSION 2
+#define CATALOG_NO_ENTRY 0xFFFFFFFFu
+#define CATALOG_MAX_ID 16777215u        // Keeps the id index below 64 MB
+
+struct CatalogHeader {
+    char magic[4];                  // "MCAT"
+    unsigned int version;
+    unsigned int entryCount;
+    unsigned int indexSize;         // Largest id + 1
+    unsigned int entriesOffset;     // Byte offsets from the start of the file
+    unsigned int indexOffset;
+    unsigned int stringsOffset;
+    unsigned int stringsSize;
+};
+
+// One artifact; the strings are offsets into the pool (see ExhibitCatalog::text)
+struct CatalogEntry {
+    unsigned int id;
+    unsigned int title;
+    unsigned int period;
+    unsigned int description;
+    unsigned int model;             // Model file, "" if the exhibit is not placed in the museum
+    unsigned int importer;          // How the model is read: "auto" ("" too), "assimp", "obj" or "gltf"
+    float position[3];              // Placement in the museum room
+    float yaw;                      // Degrees around the up axis
+    float scale;
+};
+
+// Exhibit texts and placements, memory-mapped from a compiled catalog.
+// Opening only checks the header, lookups by id are one index read and never
+// allocate; strings point straight into the mapping. Read-only once open, so
+// any thread may look entries up.
+class ExhibitCatalog {
+public:
+    bool open(const std::string& binaryPath);
+    void close() { file.close(); }
+    bool isOpen() const { return file.isOpen(); }
+
+    int getEntryCount() const { return entryCount; }
+    const CatalogEntry& getEntry(int index) const { return entries[index]; }
+
+    // Entry of an id, null if the catalog has none
+    const CatalogEntry* find(unsigned int id) const {
+        if (id >= indexSize || index[id] >= (unsigned int)entryCount) return nullptr;
+        return &entries[index[id]];
+    }
+
+    // String of the pool ("" for offsets outside it)
+    const char* text(unsigned int offset) const { return offset < stringsSize ? strings + offset : ""; }
+
+private:
+    MappedFile file;
+    const CatalogEntry* entries = nullptr;
+    const unsigned int* index = nullptr;
+    const char* strings = nullptr;
+    int entryCount = 0;
+    unsigned int indexSize = 0;
+    unsigned int stringsSize = 0;
+};
+
+// Compiles the text catalog (blocks of "key: value" lines, see catalog.txt) into the
+// binary layout above; false (after printing the line) on syntax errors or duplicate ids
+bool compileExhibitCatalog(const std::string& sourcePath, const std::string& binaryPath);
+
+// Recompiles the binary when the source is newer (or the binary is missing), then maps it
+bool loadExhibitCatalog(const std::string& sourcePath, const std::string& binaryPath, ExhibitCatalog& catalog);
+
+#endif
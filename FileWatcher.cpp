@@ -0,0 +1,95 @@
+#include "FileWatcher.h"
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// Quiet time before a change is reported, and time between modification time scans
+static const double FILE_WATCH_SETTLE_SECONDS = 0.25;
+static const double FILE_WATCH_SCAN_SECONDS = 0.5;
+
+static double watchSeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Modification time as a number, 0 if the file does not exist
+static long long modificationTime(const std::string& path) {
+    std::error_code error;
+    std::filesystem::file_time_type time = std::filesystem::last_write_time(path, error);
+    return error ? 0 : (long long)time.time_since_epoch().count();
+}
+
+FileWatcher::FileWatcher() {
+    notify = -1;
+    lastScan = 0.0;
+#ifdef __linux__
+    notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (notify < 0) std::cerr << "ERROR::FILE_WATCHER::INOTIFY_FAILED, comparing modification times instead" << std::endl;
+#endif
+}
+
+FileWatcher::~FileWatcher() {
+#ifdef __linux__
+    if (notify >= 0) close(notify);   // Removes the watches
+#endif
+}
+
+void FileWatcher::watch(const std::string& path) {
+    for (size_t i = 0; i < files.size(); i++) {
+        if (files[i].path == path) return;
+    }
+    std::filesystem::path file(path);
+    WatchedFile watched = { path, file.filename().string(), -1, modificationTime(path), -1.0 };
+#ifdef __linux__
+    // One watch per directory; adding a directory again returns its existing watch
+    if (notify >= 0) {
+        std::string directory = file.has_parent_path() ? file.parent_path().string() : ".";
+        watched.directory = inotify_add_watch(notify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+        if (watched.directory < 0) std::cerr << "ERROR::FILE_WATCHER::WATCH_FAILED: " << directory << std::endl;
+    }
+#endif
+    files.push_back(watched);
+}
+
+void FileWatcher::poll(std::vector<std::string>& changed) {
+    double now = watchSeconds();
+
+#ifdef __linux__
+    if (notify >= 0) {
+        alignas(inotify_event) char buffer[4096];
+        for (;;) {
+            ssize_t length = read(notify, buffer, sizeof(buffer));
+            if (length <= 0) break;
+            for (ssize_t offset = 0; offset < length; ) {
+                const inotify_event* event = (const inotify_event*)(buffer + offset);
+                offset += sizeof(inotify_event) + event->len;
+                if (event->len == 0) continue;
+                for (size_t i = 0; i < files.size(); i++) {
+                    if (files[i].directory == event->wd && files[i].name == event->name) files[i].changedAt = now;
+                }
+            }
+        }
+    }
+#endif
+
+    // Files without an inotify watch are compared with their last modification time
+    if (now - lastScan >= FILE_WATCH_SCAN_SECONDS) {
+        lastScan = now;
+        for (size_t i = 0; i < files.size(); i++) {
+            if (files[i].directory >= 0) continue;
+            long long time = modificationTime(files[i].path);
+            if (time == files[i].time) continue;
+            files[i].time = time;
+            if (time != 0) files[i].changedAt = now;
+        }
+    }
+
+    for (size_t i = 0; i < files.size(); i++) {
+        if (files[i].changedAt < 0.0 || now - files[i].changedAt < FILE_WATCH_SETTLE_SECONDS) continue;
+        files[i].changedAt = -1.0;
+        changed.push_back(files[i].path);
+    }
+}
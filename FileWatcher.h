@@ -0,0 +1,39 @@
+#ifndef FILEWATCHER_H
+#define FILEWATCHER_H
+
+#include <string>
+#include <vector>
+
+// Reports files that were written since the last poll. On Linux the files' directories are
+// watched with inotify (editors that save to a temporary file and rename it are seen too);
+// elsewhere, or when inotify is not available, modification times are compared twice a
+// second. A change is reported once the file has been quiet for a moment, so a file that is
+// written in several steps is only read when it is complete.
+class FileWatcher {
+public:
+    FileWatcher();
+    ~FileWatcher();
+
+    // Adds a file to watch (the file does not need to exist yet)
+    void watch(const std::string& path);
+
+    // Appends the watched files that changed and settled since the last call, each once
+    void poll(std::vector<std::string>& changed);
+
+private:
+    struct WatchedFile {
+        std::string path;
+        std::string name;           // File name inside its directory
+        int directory;              // inotify watch of the directory, -1 without
+        long long time;             // Modification time seen by the last scan
+        double changedAt;           // When the newest change was seen, < 0 = none pending
+    };
+    std::vector<WatchedFile> files;
+    int notify;                     // inotify descriptor, -1 = compare modification times
+    double lastScan;
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+};
+
+#endif
@@ -0,0 +1,71 @@
+#include "FrameCapture.h"
+#include "PngImage.h"
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+
+FrameCapture::FrameCapture(const std::string& dumpDir, const std::string& goldenDir, int tolerance)
+    : dumpDir(dumpDir), goldenDir(goldenDir), tolerance(tolerance) {
+    comparedFrames = 0;
+    failedFrames = 0;
+    missingGoldens = 0;
+    worstDifference = 0;
+}
+
+// Builds "<dir>/frame_0042.png"
+static std::string frameFileName(const std::string& dir, int frameIndex) {
+    char name[32];
+    snprintf(name, sizeof(name), "frame_%04d.png", frameIndex);
+    return dir + "/" + name;
+}
+
+void FrameCapture::capture(SceneTarget& target, int frameIndex) {
+    if (!isEnabled()) return;
+
+    int width, height;
+    target.readPixels(pixels, width, height);
+
+    if (!dumpDir.empty()) {
+        writePng(frameFileName(dumpDir, frameIndex), width, height, pixels);
+    }
+
+    if (!goldenDir.empty()) {
+        int goldenWidth, goldenHeight;
+        std::vector<unsigned char> golden;
+        if (!readPng(frameFileName(goldenDir, frameIndex), goldenWidth, goldenHeight, golden) ||
+            goldenWidth != width || goldenHeight != height) {
+            missingGoldens++;
+            return;
+        }
+
+        // Count pixels whose channels differ by more than the tolerance
+        int differentPixels = 0;
+        int frameWorst = 0;
+        for (size_t i = 0; i < pixels.size(); i += 4) {
+            int pixelWorst = 0;
+            for (int c = 0; c < 3; c++) {
+                int difference = std::abs((int)pixels[i + c] - (int)golden[i + c]);
+                if (difference > pixelWorst) pixelWorst = difference;
+            }
+            if (pixelWorst > tolerance) differentPixels++;
+            if (pixelWorst > frameWorst) frameWorst = pixelWorst;
+        }
+
+        comparedFrames++;
+        if (frameWorst > worstDifference) worstDifference = frameWorst;
+        if (differentPixels > 0) {
+            failedFrames++;
+            std::cout << "Frame " << frameIndex << ": " << differentPixels
+                << " pixels differ from the golden image (max difference " << frameWorst << ")\n";
+        }
+    }
+}
+
+bool FrameCapture::printSummary() const {
+    if (goldenDir.empty()) return true;
+
+    std::cout << "Golden image comparison: " << comparedFrames << " frames compared, "
+        << failedFrames << " failed, " << missingGoldens << " missing, max difference "
+        << worstDifference << " (tolerance " << tolerance << ")\n";
+    return failedFrames == 0 && missingGoldens == 0;
+}
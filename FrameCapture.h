@@ -0,0 +1,38 @@
+#ifndef FRAMECAPTURE_H
+#define FRAMECAPTURE_H
+
+#include <string>
+#include <vector>
+#include "SceneTarget.h"
+
+// Saves rendered frames as PNG and/or compares them with golden images of an earlier run
+class FrameCapture {
+public:
+    // - dumpDir: folder for frame_NNNN.png files ("" disables dumping)
+    // - goldenDir: folder with reference frames ("" disables comparison)
+    // - tolerance: largest per-channel difference still counted as equal
+    FrameCapture(const std::string& dumpDir, const std::string& goldenDir, int tolerance);
+
+    // True when frames have to be read back at all
+    bool isEnabled() const { return !dumpDir.empty() || !goldenDir.empty(); }
+
+    // Reads the scene target back and dumps/compares it as frame number frameIndex
+    void capture(SceneTarget& target, int frameIndex);
+
+    // Prints the comparison result, returns false if any frame differed from its golden image
+    bool printSummary() const;
+
+private:
+    std::string dumpDir;
+    std::string goldenDir;
+    int tolerance;
+
+    int comparedFrames;    // Frames that had a golden image
+    int failedFrames;      // Frames with pixels above the tolerance
+    int missingGoldens;    // Frames without a readable golden image
+    int worstDifference;   // Largest channel difference seen
+
+    std::vector<unsigned char> pixels;  // Reused readback buffer
+};
+
+#endif
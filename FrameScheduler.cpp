@@ -0,0 +1,97 @@
+#include "FrameScheduler.h"
+#include <chrono>
+#include <thread>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <mmsystem.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+// Number of frames rendered after an input event before going idle again
+static const int IDLE_SETTLE_FRAMES = 3;
+
+// Below this margin the sleep is finished by spinning, OS sleeps are not precise enough
+static const double SPIN_MARGIN = 0.002;
+
+FrameScheduler::FrameScheduler(FrameMode mode, int targetFps) : mode(mode) {
+    if (targetFps <= 0) targetFps = 60;
+    frameDuration = 1.0 / targetFps;
+    nextFrameTime = 0.0;
+    idleTimeout = 0.5;
+    settleFrames = IDLE_SETTLE_FRAMES;
+
+#ifdef _WIN32
+    // Raise the scheduler resolution so short sleeps are close to 1 ms
+    if (mode == FRAME_MODE_FPS_CAP) timeBeginPeriod(1);
+#endif
+}
+
+FrameScheduler::~FrameScheduler() {
+#ifdef _WIN32
+    if (mode == FRAME_MODE_FPS_CAP) timeEndPeriod(1);
+#endif
+}
+
+void FrameScheduler::begin() {
+    // Capped mode does its own pacing, unlimited mode never waits, the others wait for the display
+    glfwSwapInterval((mode == FRAME_MODE_FPS_CAP || mode == FRAME_MODE_UNLIMITED) ? 0 : 1);
+    nextFrameTime = glfwGetTime() + frameDuration;
+}
+
+void FrameScheduler::endFrame(bool sceneChanged) {
+    if (mode == FRAME_MODE_FPS_CAP) {
+        sleepUntil(nextFrameTime);
+
+        // Schedule the next slot; resync if we fell more than one frame behind
+        double now = glfwGetTime();
+        nextFrameTime += frameDuration;
+        if (nextFrameTime < now) nextFrameTime = now + frameDuration;
+
+        glfwPollEvents();
+    }
+    else if (mode == FRAME_MODE_IDLE) {
+        if (sceneChanged) settleFrames = IDLE_SETTLE_FRAMES;
+
+        if (settleFrames > 0) {
+            // Still animating or settling the UI, keep rendering at vsync rate
+            settleFrames--;
+            glfwPollEvents();
+        }
+        else {
+            // Nothing moves: block until input arrives or the timeout refreshes the screen
+            double waitStart = glfwGetTime();
+            glfwWaitEventsTimeout(idleTimeout);
+
+            // Woken early means an event arrived, let ImGui process it over a few frames
+            if (glfwGetTime() - waitStart < idleTimeout) settleFrames = IDLE_SETTLE_FRAMES;
+        }
+    }
+    else {
+        glfwPollEvents();
+    }
+}
+
+void FrameScheduler::sleepUntil(double targetTime) {
+    double remaining = targetTime - glfwGetTime();
+
+    // Coarse sleep for most of the remaining time
+    if (remaining > SPIN_MARGIN) {
+        std::this_thread::sleep_for(std::chrono::duration<double>(remaining - SPIN_MARGIN));
+    }
+
+    // Spin for the final part of the slot
+    while (glfwGetTime() < targetTime) {
+        std::this_thread::yield();
+    }
+}
+
+bool parseFrameMode(const char* name, FrameMode& mode) {
+    if (std::strcmp(name, "vsync") == 0) mode = FRAME_MODE_VSYNC;
+    else if (std::strcmp(name, "cap") == 0) mode = FRAME_MODE_FPS_CAP;
+    else if (std::strcmp(name, "idle") == 0) mode = FRAME_MODE_IDLE;
+    else if (std::strcmp(name, "unlimited") == 0) mode = FRAME_MODE_UNLIMITED;
+    else return false;
+    return true;
+}
@@ -0,0 +1,43 @@
+#ifndef FRAMESCHEDULER_H
+#define FRAMESCHEDULER_H
+
+#include <GLFW/glfw3.h>
+
+// How the main loop paces its frames
+enum FrameMode {
+    FRAME_MODE_VSYNC = 0,   // Swap interval 1, the display drives the frame rate
+    FRAME_MODE_FPS_CAP,     // Swap interval 0, sleep until the next frame slot
+    FRAME_MODE_IDLE,        // Vsync while active, block on events while nothing changes
+    FRAME_MODE_UNLIMITED    // Swap interval 0 and no waiting (benchmarks)
+};
+
+// Decides how long the main loop waits between frames
+class FrameScheduler {
+public:
+    FrameScheduler(FrameMode mode, int targetFps);
+    ~FrameScheduler();
+
+    // Applies the swap interval, must be called with the GL context current
+    void begin();
+
+    // Called after swapping buffers: sleeps or blocks as needed and processes window events
+    // - sceneChanged: result of Room::update for this frame
+    void endFrame(bool sceneChanged);
+
+    FrameMode getMode() const { return mode; }
+
+private:
+    FrameMode mode;
+    double frameDuration;    // Target seconds per frame in FPS cap mode
+    double nextFrameTime;    // Time the next capped frame may start
+    double idleTimeout;      // Longest block in idle mode before a refresh frame
+    int settleFrames;        // Frames still rendered after a wake-up so ImGui can catch up
+
+    // Sleeps until the given glfwGetTime() value, spinning for the last bit
+    void sleepUntil(double targetTime);
+};
+
+// Parses "vsync", "cap", "idle" or "unlimited", returns false for unknown names
+bool parseFrameMode(const char* name, FrameMode& mode);
+
+#endif
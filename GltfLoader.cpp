@@ -0,0 +1,446 @@
+#include "GltfLoader.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+// GLB container: header, then a JSON chunk and an optional binary chunk
+static const unsigned int GLB_MAGIC = 0x46546C67u;         // "glTF"
+static const unsigned int GLB_CHUNK_JSON = 0x4E4F534Au;    // "JSON"
+static const unsigned int GLB_CHUNK_BIN = 0x004E4942u;     // "BIN\0"
+
+// Deepest JSON nesting and node hierarchy accepted (guards against broken or cyclic files)
+static const int GLTF_MAX_DEPTH = 64;
+
+// Parsed JSON value; objects keep their keys in file order
+struct JsonValue {
+    enum Type { JSON_NULL, JSON_BOOL, JSON_NUMBER, JSON_STRING, JSON_ARRAY, JSON_OBJECT };
+    Type type = JSON_NULL;
+    double number = 0.0;
+    bool boolean = false;
+    std::string text;
+    std::vector<std::string> keys;      // Object keys, one per item
+    std::vector<JsonValue> items;       // Array elements or object values
+
+    const JsonValue* get(const char* key) const {
+        if (type != JSON_OBJECT) return nullptr;
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (keys[i] == key) return &items[i];
+        }
+        return nullptr;
+    }
+
+    int getInt(const char* key, int fallback) const {
+        const JsonValue* value = get(key);
+        return value && value->type == JSON_NUMBER ? (int)value->number : fallback;
+    }
+
+    size_t size() const { return type == JSON_ARRAY ? items.size() : 0; }
+};
+
+// Recursive descent JSON reader over the JSON chunk
+class JsonReader {
+public:
+    JsonReader(const char* text, size_t length) : p(text), end(text + length) {}
+
+    bool parse(JsonValue& value) {
+        if (!parseValue(value, 0)) return false;
+        skipSpace();
+        return p == end || *p == '\0';
+    }
+
+private:
+    const char* p;
+    const char* end;
+
+    void skipSpace() {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) p++;
+    }
+
+    bool literal(const char* word) {
+        size_t length = std::strlen(word);
+        if ((size_t)(end - p) < length || std::memcmp(p, word, length) != 0) return false;
+        p += length;
+        return true;
+    }
+
+    static void appendUtf8(std::string& text, unsigned int code) {
+        if (code < 0x80) text += (char)code;
+        else if (code < 0x800) {
+            text += (char)(0xC0 | (code >> 6));
+            text += (char)(0x80 | (code & 0x3F));
+        }
+        else if (code < 0x10000) {
+            text += (char)(0xE0 | (code >> 12));
+            text += (char)(0x80 | ((code >> 6) & 0x3F));
+            text += (char)(0x80 | (code & 0x3F));
+        }
+        else {
+            text += (char)(0xF0 | (code >> 18));
+            text += (char)(0x80 | ((code >> 12) & 0x3F));
+            text += (char)(0x80 | ((code >> 6) & 0x3F));
+            text += (char)(0x80 | (code & 0x3F));
+        }
+    }
+
+    bool parseHex(unsigned int& code) {
+        if (end - p < 4) return false;
+        code = 0;
+        for (int i = 0; i < 4; i++, p++) {
+            char c = *p;
+            code <<= 4;
+            if (c >= '0' && c <= '9') code |= c - '0';
+            else if (c >= 'a' && c <= 'f') code |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') code |= c - 'A' + 10;
+            else return false;
+        }
+        return true;
+    }
+
+    bool parseString(std::string& text) {
+        p++;    // Opening quote
+        while (p < end && *p != '"') {
+            if (*p != '\\') {
+                text += *p++;
+                continue;
+            }
+            if (++p >= end) return false;
+            char escape = *p++;
+            if (escape == 'n') text += '\n';
+            else if (escape == 't') text += '\t';
+            else if (escape == 'r') text += '\r';
+            else if (escape == 'b') text += '\b';
+            else if (escape == 'f') text += '\f';
+            else if (escape == 'u') {
+                unsigned int code;
+                if (!parseHex(code)) return false;
+                // Surrogate pair for characters outside the basic plane
+                if (code >= 0xD800 && code < 0xDC00 && end - p >= 6 && p[0] == '\\' && p[1] == 'u') {
+                    p += 2;
+                    unsigned int low;
+                    if (!parseHex(low)) return false;
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                }
+                appendUtf8(text, code);
+            }
+            else text += escape;    // \" \\ \/
+        }
+        if (p >= end) return false;
+        p++;    // Closing quote
+        return true;
+    }
+
+    bool parseValue(JsonValue& value, int depth) {
+        if (depth > GLTF_MAX_DEPTH) return false;
+        skipSpace();
+        if (p >= end) return false;
+
+        if (*p == '{') {
+            value.type = JsonValue::JSON_OBJECT;
+            p++;
+            skipSpace();
+            if (p < end && *p == '}') {
+                p++;
+                return true;
+            }
+            for (;;) {
+                skipSpace();
+                if (p >= end || *p != '"') return false;
+                value.keys.push_back(std::string());
+                if (!parseString(value.keys.back())) return false;
+                skipSpace();
+                if (p >= end || *p++ != ':') return false;
+                value.items.push_back(JsonValue());
+                if (!parseValue(value.items.back(), depth + 1)) return false;
+                skipSpace();
+                if (p < end && *p == ',') p++;
+                else if (p < end && *p == '}') {
+                    p++;
+                    return true;
+                }
+                else return false;
+            }
+        }
+        if (*p == '[') {
+            value.type = JsonValue::JSON_ARRAY;
+            p++;
+            skipSpace();
+            if (p < end && *p == ']') {
+                p++;
+                return true;
+            }
+            for (;;) {
+                value.items.push_back(JsonValue());
+                if (!parseValue(value.items.back(), depth + 1)) return false;
+                skipSpace();
+                if (p < end && *p == ',') p++;
+                else if (p < end && *p == ']') {
+                    p++;
+                    return true;
+                }
+                else return false;
+            }
+        }
+        if (*p == '"') {
+            value.type = JsonValue::JSON_STRING;
+            return parseString(value.text);
+        }
+        if (literal("true") || literal("false")) {
+            value.type = JsonValue::JSON_BOOL;
+            value.boolean = p[-4] == 't';
+            return true;
+        }
+        if (literal("null")) return true;
+
+        // Number: strtod needs a terminated string, numbers are short
+        char buffer[64];
+        size_t length = 0;
+        while (p + length < end && length < sizeof(buffer) - 1 && std::strchr("+-0123456789.eE", p[length])) length++;
+        if (length == 0) return false;
+        std::memcpy(buffer, p, length);
+        buffer[length] = '\0';
+        value.type = JsonValue::JSON_NUMBER;
+        value.number = std::strtod(buffer, nullptr);
+        p += length;
+        return true;
+    }
+};
+
+static unsigned int readUint32(const unsigned char* data) {
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((unsigned int)data[3] << 24);
+}
+
+static int componentSize(int componentType) {
+    if (componentType == GLTF_BYTE || componentType == GLTF_UNSIGNED_BYTE) return 1;
+    if (componentType == GLTF_SHORT || componentType == GLTF_UNSIGNED_SHORT) return 2;
+    if (componentType == GLTF_UNSIGNED_INT || componentType == GLTF_FLOAT) return 4;
+    return 0;
+}
+
+static int componentCount(const std::string& type) {
+    if (type == "SCALAR") return 1;
+    if (type == "VEC2") return 2;
+    if (type == "VEC3") return 3;
+    if (type == "VEC4" || type == "MAT2") return 4;
+    if (type == "MAT3") return 9;
+    if (type == "MAT4") return 16;
+    return 0;
+}
+
+// Number array of a node property (matrix, translation, rotation, scale)
+static bool readNumbers(const JsonValue* value, float* out, size_t count) {
+    if (!value || value->size() != count) return false;
+    for (size_t i = 0; i < count; i++) out[i] = (float)value->items[i].number;
+    return true;
+}
+
+// Local matrix of a node: "matrix" (column major) or translation * rotation * scale
+static glm::mat4 nodeMatrix(const JsonValue& node) {
+    glm::mat4 matrix(1.0f);
+    float values[16];
+    if (readNumbers(node.get("matrix"), values, 16)) {
+        for (int column = 0; column < 4; column++) {
+            for (int row = 0; row < 4; row++) matrix[column][row] = values[column * 4 + row];
+        }
+        return matrix;
+    }
+
+    float t[3] = { 0.0f, 0.0f, 0.0f }, r[4] = { 0.0f, 0.0f, 0.0f, 1.0f }, s[3] = { 1.0f, 1.0f, 1.0f };
+    readNumbers(node.get("translation"), t, 3);
+    readNumbers(node.get("rotation"), r, 4);
+    readNumbers(node.get("scale"), s, 3);
+
+    // Rotation matrix of the unit quaternion (x, y, z, w), columns scaled
+    float x = r[0], y = r[1], z = r[2], w = r[3];
+    matrix[0] = glm::vec4(1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + z * w), 2.0f * (x * z - y * w), 0.0f) * s[0];
+    matrix[1] = glm::vec4(2.0f * (x * y - z * w), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + x * w), 0.0f) * s[1];
+    matrix[2] = glm::vec4(2.0f * (x * z + y * w), 2.0f * (y * z - x * w), 1.0f - 2.0f * (x * x + y * y), 0.0f) * s[2];
+    matrix[3] = glm::vec4(t[0], t[1], t[2], 1.0f);
+    return matrix;
+}
+
+// Walks a node and its children, every node with a mesh becomes an instance
+static void addNode(const JsonValue& nodes, int index, const glm::mat4& parent, int depth, int meshCount,
+                    std::vector<GltfInstance>& instances) {
+    if (index < 0 || index >= (int)nodes.size() || depth > GLTF_MAX_DEPTH) return;
+    const JsonValue& node = nodes.items[index];
+    glm::mat4 transform = parent * nodeMatrix(node);
+
+    int mesh = node.getInt("mesh", -1);
+    if (mesh >= 0 && mesh < meshCount) instances.push_back({ mesh, transform });
+
+    const JsonValue* children = node.get("children");
+    for (size_t i = 0; children && i < children->size(); i++) {
+        addNode(nodes, (int)children->items[i].number, transform, depth + 1, meshCount, instances);
+    }
+}
+
+int GltfFile::elementSize(const GltfAccessor& accessor) {
+    return componentSize(accessor.componentType) * accessor.components;
+}
+
+const unsigned char* GltfFile::elementData(const GltfAccessor& accessor, int index) const {
+    const GltfBufferView& view = bufferViews[accessor.bufferView];
+    int stride = view.stride > 0 ? view.stride : elementSize(accessor);
+    return binary + view.offset + accessor.offset + (size_t)index * stride;
+}
+
+glm::vec3 GltfFile::readVec3(const GltfAccessor& accessor, int index) const {
+    const unsigned char* data = elementData(accessor, index);
+    float values[3] = { 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < 3 && i < accessor.components; i++) {
+        switch (accessor.componentType) {
+        case GLTF_FLOAT: std::memcpy(&values[i], data + i * 4, 4); break;
+        case GLTF_BYTE: values[i] = (float)(signed char)data[i]; if (accessor.normalized) values[i] = std::fmax(values[i] / 127.0f, -1.0f); break;
+        case GLTF_UNSIGNED_BYTE: values[i] = (float)data[i]; if (accessor.normalized) values[i] /= 255.0f; break;
+        case GLTF_SHORT: {
+            short value;
+            std::memcpy(&value, data + i * 2, 2);
+            values[i] = accessor.normalized ? std::fmax(value / 32767.0f, -1.0f) : (float)value;
+            break;
+        }
+        case GLTF_UNSIGNED_SHORT: {
+            unsigned short value;
+            std::memcpy(&value, data + i * 2, 2);
+            values[i] = accessor.normalized ? value / 65535.0f : (float)value;
+            break;
+        }
+        }
+    }
+    return glm::vec3(values[0], values[1], values[2]);
+}
+
+unsigned int GltfFile::readIndex(const GltfAccessor& accessor, int index) const {
+    const unsigned char* data = elementData(accessor, index);
+    if (accessor.componentType == GLTF_UNSIGNED_BYTE) return data[0];
+    if (accessor.componentType == GLTF_UNSIGNED_SHORT) return data[0] | (data[1] << 8);
+    return readUint32(data);
+}
+
+void GltfFile::prefetch() const {
+    volatile unsigned char sum = 0;
+    for (size_t i = 0; i < binarySize; i += 4096) sum = sum + binary[i];
+}
+
+bool GltfFile::open(const std::string& path) {
+    if (!file.open(path)) return false;
+    const unsigned char* data = file.getData();
+    size_t size = file.getSize();
+
+    // Container: header, JSON chunk, binary chunk
+    if (size < 20 || readUint32(data) != GLB_MAGIC || readUint32(data + 4) != 2) {
+        std::cerr << "ERROR::GLTF::NOT_A_GLB_2_FILE: " << path << std::endl;
+        return false;
+    }
+    size_t jsonLength = readUint32(data + 12);
+    if (readUint32(data + 16) != GLB_CHUNK_JSON || 20 + jsonLength > size) {
+        std::cerr << "ERROR::GLTF::MISSING_JSON_CHUNK: " << path << std::endl;
+        return false;
+    }
+    size_t binOffset = 20 + ((jsonLength + 3) & ~(size_t)3);
+    if (binOffset + 8 <= size && readUint32(data + binOffset + 4) == GLB_CHUNK_BIN) {
+        binarySize = readUint32(data + binOffset);
+        binary = data + binOffset + 8;
+        if (binOffset + 8 + binarySize > size) {
+            std::cerr << "ERROR::GLTF::TRUNCATED_BINARY_CHUNK: " << path << std::endl;
+            return false;
+        }
+    }
+
+    JsonValue root;
+    JsonReader reader((const char*)data + 20, jsonLength);
+    if (!reader.parse(root) || root.type != JsonValue::JSON_OBJECT) {
+        std::cerr << "ERROR::GLTF::INVALID_JSON: " << path << std::endl;
+        return false;
+    }
+
+    // Buffer views: only the embedded buffer (buffer 0 without uri) is supported
+    const JsonValue* views = root.get("bufferViews");
+    for (size_t i = 0; views && i < views->size(); i++) {
+        const JsonValue& view = views->items[i];
+        // Negative values are rejected before they become sizes, and the length is checked
+        // against what is left after the offset so the sum cannot wrap (Win32 builds)
+        int offset = view.getInt("byteOffset", 0);
+        int length = view.getInt("byteLength", 0);
+        GltfBufferView bufferView;
+        bufferView.offset = offset >= 0 ? (size_t)offset : 0;
+        bufferView.length = length >= 0 ? (size_t)length : 0;
+        bufferView.stride = view.getInt("byteStride", 0);
+        if (view.getInt("buffer", 0) != 0 || offset < 0 || length < 0 || bufferView.stride < 0 ||
+            bufferView.offset > binarySize || bufferView.length > binarySize - bufferView.offset) {
+            std::cerr << "ERROR::GLTF::EXTERNAL_OR_INVALID_BUFFER: " << path << " (bufferView " << i << ")" << std::endl;
+            return false;
+        }
+        bufferViews.push_back(bufferView);
+    }
+
+    // Accessors, checked against their buffer view once so readers need no bounds checks
+    const JsonValue* accessorList = root.get("accessors");
+    for (size_t i = 0; accessorList && i < accessorList->size(); i++) {
+        const JsonValue& item = accessorList->items[i];
+        const JsonValue* type = item.get("type");
+        const JsonValue* normalized = item.get("normalized");
+        GltfAccessor accessor;
+        accessor.bufferView = item.getInt("bufferView", -1);
+        int offset = item.getInt("byteOffset", 0);
+        accessor.offset = offset >= 0 ? (size_t)offset : 0;
+        accessor.componentType = item.getInt("componentType", 0);
+        accessor.components = type ? componentCount(type->text) : 0;
+        accessor.count = item.getInt("count", 0);
+        accessor.normalized = normalized && normalized->boolean;
+
+        float low[3], high[3];
+        accessor.hasBounds = readNumbers(item.get("min"), low, 3) && readNumbers(item.get("max"), high, 3);
+        accessor.min = accessor.hasBounds ? glm::vec3(low[0], low[1], low[2]) : glm::vec3(0.0f);
+        accessor.max = accessor.hasBounds ? glm::vec3(high[0], high[1], high[2]) : glm::vec3(0.0f);
+
+        bool valid = offset >= 0 && elementSize(accessor) > 0 && accessor.count >= 0 && accessor.bufferView < (int)bufferViews.size();
+        if (valid && accessor.bufferView >= 0 && accessor.count > 0) {
+            const GltfBufferView& view = bufferViews[accessor.bufferView];
+            size_t stride = view.stride > 0 ? view.stride : elementSize(accessor);
+            valid = accessor.offset + (accessor.count - 1) * stride + elementSize(accessor) <= view.length;
+        }
+        if (!valid) {
+            std::cerr << "ERROR::GLTF::INVALID_ACCESSOR: " << path << " (accessor " << i << ")" << std::endl;
+            return false;
+        }
+        accessors.push_back(accessor);
+    }
+
+    const JsonValue* meshList = root.get("meshes");
+    for (size_t i = 0; meshList && i < meshList->size(); i++) {
+        GltfMesh mesh;
+        const JsonValue* primitives = meshList->items[i].get("primitives");
+        for (size_t j = 0; primitives && j < primitives->size(); j++) {
+            const JsonValue& item = primitives->items[j];
+            const JsonValue* attributes = item.get("attributes");
+            GltfPrimitive primitive;
+            primitive.position = attributes ? attributes->getInt("POSITION", -1) : -1;
+            primitive.normal = attributes ? attributes->getInt("NORMAL", -1) : -1;
+            primitive.indices = item.getInt("indices", -1);
+            primitive.mode = item.getInt("mode", GLTF_TRIANGLES);
+            int accessorCount = (int)accessors.size();
+            if (primitive.position >= accessorCount || primitive.normal >= accessorCount || primitive.indices >= accessorCount) {
+                std::cerr << "ERROR::GLTF::INVALID_PRIMITIVE: " << path << " (mesh " << i << ")" << std::endl;
+                return false;
+            }
+            mesh.primitives.push_back(primitive);
+        }
+        meshes.push_back(mesh);
+    }
+
+    // Instances from the node hierarchy of the default scene (every mesh once when there is none)
+    const JsonValue* nodes = root.get("nodes");
+    const JsonValue* scenes = root.get("scenes");
+    int sceneIndex = root.getInt("scene", 0);
+    if (nodes && scenes && sceneIndex >= 0 && sceneIndex < (int)scenes->size()) {
+        const JsonValue* roots = scenes->items[sceneIndex].get("nodes");
+        for (size_t i = 0; roots && i < roots->size(); i++) {
+            addNode(*nodes, (int)roots->items[i].number, glm::mat4(1.0f), 0, (int)meshes.size(), instances);
+        }
+    }
+    else {
+        for (size_t i = 0; i < meshes.size(); i++) instances.push_back({ (int)i, glm::mat4(1.0f) });
+    }
+    return true;
+}
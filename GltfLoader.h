@@ -0,0 +1,93 @@
+#ifndef GLTFLOADER_H
+#define GLTFLOADER_H
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+// glTF component types (same values as the GL enums)
+#define GLTF_BYTE 5120
+#define GLTF_UNSIGNED_BYTE 5121
+#define GLTF_SHORT 5122
+#define GLTF_UNSIGNED_SHORT 5123
+#define GLTF_UNSIGNED_INT 5125
+#define GLTF_FLOAT 5126
+
+// glTF primitive mode of triangle lists (the only mode drawn)
+#define GLTF_TRIANGLES 4
+
+// Byte range of the binary chunk
+struct GltfBufferView {
+    size_t offset;      // From the start of the binary chunk
+    size_t length;
+    int stride;         // 0 = tightly packed
+};
+
+// Typed view of a buffer view (e.g. positions as 3 floats, indices as unsigned shorts)
+struct GltfAccessor {
+    int bufferView;         // -1 = all zeros (not supported for drawing)
+    size_t offset;          // Byte offset inside the buffer view
+    int componentType;      // GLTF_FLOAT, GLTF_UNSIGNED_SHORT, ...
+    int components;         // 1 (SCALAR) to 4 (VEC4), 16 (MAT4)
+    int count;
+    bool normalized;        // Integer values map to [0, 1] / [-1, 1]
+    bool hasBounds;         // min/max given (required for positions)
+    glm::vec3 min, max;
+};
+
+// One draw: accessor indices, -1 when absent
+struct GltfPrimitive {
+    int position;
+    int normal;
+    int indices;
+    int mode;
+};
+
+struct GltfMesh {
+    std::vector<GltfPrimitive> primitives;
+};
+
+// A mesh placed by a node of the default scene
+struct GltfInstance {
+    int mesh;
+    glm::mat4 transform;    // Node matrix including all parent nodes
+};
+
+// Binary glTF 2.0 (.glb) file: the JSON structure is parsed into the tables below,
+// the binary chunk stays in the memory-mapped file, so buffer views can go to the
+// GPU straight from the mapping (see ModelLoader). Only the GLB container with its
+// embedded buffer is supported, not .gltf files with external buffers.
+class GltfFile {
+public:
+    // Maps and parses the file, false (after printing why) on errors
+    bool open(const std::string& path);
+
+    std::vector<GltfBufferView> bufferViews;
+    std::vector<GltfAccessor> accessors;
+    std::vector<GltfMesh> meshes;
+    std::vector<GltfInstance> instances;
+
+    // Reads one byte of every page of the binary chunk, so the OS loads the file now and a
+    // later upload from the mapping does not wait for the disk (hot reload's import thread)
+    void prefetch() const;
+
+    // Bytes of a buffer view inside the mapping
+    const unsigned char* viewData(int view) const { return binary + bufferViews[view].offset; }
+
+    // Reads element i of an accessor as floats (integer types converted, normalized if flagged)
+    glm::vec3 readVec3(const GltfAccessor& accessor, int index) const;
+    unsigned int readIndex(const GltfAccessor& accessor, int index) const;
+
+    // Size in bytes of one element of an accessor
+    static int elementSize(const GltfAccessor& accessor);
+
+private:
+    MappedFile file;
+    const unsigned char* binary = nullptr;
+    size_t binarySize = 0;
+
+    const unsigned char* elementData(const GltfAccessor& accessor, int index) const;
+};
+
+#endif
@@ -0,0 +1,214 @@
+#include "GpuProfiler.h"
+#include "imgui/imgui.h"
+#include <fstream>
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+
+GpuProfiler::GpuProfiler() {
+    passNameCount = 0;
+    historyHead = 0;
+    historyCount = 0;
+    frameNumber = 0;
+    activePass = -1;
+    droppedFrames = 0;
+    frameSink = nullptr;
+
+    // All queries are created once and reused round-robin
+    for (int f = 0; f < GPU_PROFILER_FRAMES; f++) {
+        for (int p = 0; p < GPU_PROFILER_MAX_PASSES; p++) {
+            glGenQueries(1, &frames[f].passes[p].time);
+            glGenQueries(1, &frames[f].passes[p].primitives);
+            glGenQueries(1, &frames[f].passes[p].samples);
+        }
+        frames[f].passCount = 0;
+        frames[f].frameNumber = 0;
+        frames[f].pending = false;
+    }
+
+    for (int i = 0; i < GPU_PROFILER_HISTORY; i++) historyFrame[i] = 0;
+    for (int p = 0; p < GPU_PROFILER_MAX_PASSES; p++) {
+        std::memset(history[p].gpuMs, 0, sizeof(history[p].gpuMs));
+        std::memset(history[p].primitives, 0, sizeof(history[p].primitives));
+        std::memset(history[p].samples, 0, sizeof(history[p].samples));
+    }
+}
+
+GpuProfiler::~GpuProfiler() {
+    for (int f = 0; f < GPU_PROFILER_FRAMES; f++) {
+        for (int p = 0; p < GPU_PROFILER_MAX_PASSES; p++) {
+            glDeleteQueries(1, &frames[f].passes[p].time);
+            glDeleteQueries(1, &frames[f].passes[p].primitives);
+            glDeleteQueries(1, &frames[f].passes[p].samples);
+        }
+    }
+}
+
+void GpuProfiler::beginFrame() {
+    int slot = (int)(frameNumber % GPU_PROFILER_FRAMES);
+
+    // Resolve finished frames from oldest to newest
+    for (int i = 0; i < GPU_PROFILER_FRAMES; i++) {
+        FrameQueries& frame = frames[(slot + i) % GPU_PROFILER_FRAMES];
+        if (!frame.pending) continue;
+
+        // The last query of a frame finishes last, so it tells if the whole frame is done
+        GLint available = 1;
+        if (frame.passCount > 0) {
+            glGetQueryObjectiv(frame.passes[frame.passCount - 1].samples, GL_QUERY_RESULT_AVAILABLE, &available);
+        }
+        if (!available) break;
+
+        resolveFrame(frame);
+    }
+
+    // The slot about to be reused is still busy: drop its results instead of stalling
+    if (frames[slot].pending) {
+        frames[slot].pending = false;
+        droppedFrames++;
+    }
+
+    frames[slot].passCount = 0;
+    frames[slot].frameNumber = frameNumber;
+}
+
+void GpuProfiler::beginPass(const char* name) {
+    FrameQueries& frame = frames[frameNumber % GPU_PROFILER_FRAMES];
+    if (activePass >= 0 || frame.passCount >= GPU_PROFILER_MAX_PASSES) return;
+
+    int index = findPass(name);
+    if (index < 0) return;
+
+    // One query per target can be active at the same time
+    activePass = frame.passCount++;
+    frame.passIndex[activePass] = index;
+    glBeginQuery(GL_TIME_ELAPSED, frame.passes[activePass].time);
+    glBeginQuery(GL_PRIMITIVES_GENERATED, frame.passes[activePass].primitives);
+    glBeginQuery(GL_SAMPLES_PASSED, frame.passes[activePass].samples);
+}
+
+void GpuProfiler::endPass() {
+    if (activePass < 0) return;
+    glEndQuery(GL_TIME_ELAPSED);
+    glEndQuery(GL_PRIMITIVES_GENERATED);
+    glEndQuery(GL_SAMPLES_PASSED);
+    activePass = -1;
+}
+
+void GpuProfiler::endFrame() {
+    endPass();
+    frames[frameNumber % GPU_PROFILER_FRAMES].pending = true;
+    frameNumber++;
+}
+
+void GpuProfiler::flush() {
+    endPass();
+
+    // Oldest frame first so the history stays in order
+    int slot = (int)(frameNumber % GPU_PROFILER_FRAMES);
+    for (int i = 0; i < GPU_PROFILER_FRAMES; i++) {
+        FrameQueries& frame = frames[(slot + i) % GPU_PROFILER_FRAMES];
+        if (frame.pending) resolveFrame(frame);
+    }
+}
+
+int GpuProfiler::findPass(const char* name) {
+    for (int i = 0; i < passNameCount; i++) {
+        if (history[i].name == name) return i;
+    }
+    if (passNameCount >= GPU_PROFILER_MAX_PASSES) return -1;
+    history[passNameCount].name = name;
+    return passNameCount++;
+}
+
+void GpuProfiler::resolveFrame(FrameQueries& frame) {
+    int column = historyHead;
+    historyFrame[column] = frame.frameNumber;
+
+    // Passes that did not run this frame read as zero
+    for (int p = 0; p < passNameCount; p++) {
+        history[p].gpuMs[column] = 0.0f;
+        history[p].primitives[column] = 0;
+        history[p].samples[column] = 0;
+    }
+
+    for (int q = 0; q < frame.passCount; q++) {
+        GLuint64 nanoseconds = 0;
+        GLuint primitives = 0, samples = 0;
+        glGetQueryObjectui64v(frame.passes[q].time, GL_QUERY_RESULT, &nanoseconds);
+        glGetQueryObjectuiv(frame.passes[q].primitives, GL_QUERY_RESULT, &primitives);
+        glGetQueryObjectuiv(frame.passes[q].samples, GL_QUERY_RESULT, &samples);
+
+        PassHistory& pass = history[frame.passIndex[q]];
+        pass.gpuMs[column] += (float)(nanoseconds / 1.0e6);
+        pass.primitives[column] += primitives;
+        pass.samples[column] += samples;
+    }
+
+    // Per-frame total for benchmark reports
+    if (frameSink) {
+        float total = 0.0f;
+        for (int p = 0; p < passNameCount; p++) total += history[p].gpuMs[column];
+        if (frameSink->size() <= (size_t)frame.frameNumber) frameSink->resize((size_t)frame.frameNumber + 1, -1.0f);
+        (*frameSink)[(size_t)frame.frameNumber] = total;
+    }
+
+    frame.pending = false;
+    historyHead = (historyHead + 1) % GPU_PROFILER_HISTORY;
+    if (historyCount < GPU_PROFILER_HISTORY) historyCount++;
+}
+
+void GpuProfiler::drawPanel() {
+    ImGui::SetNextWindowPos(ImVec2(10, 420), ImGuiCond_FirstUseEver);
+    ImGui::PushStyleColor(ImGuiCol_WindowBg, ImVec4(0.1f, 0.1f, 0.1f, 0.5f));
+    ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.7f, 0.7f, 0.7f, 1.0f));
+    ImGui::Begin("GPU Profiler", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+
+    // Oldest column of the ring, used as the plot offset
+    int offset = (historyCount < GPU_PROFILER_HISTORY) ? 0 : historyHead;
+    int newest = (historyHead + GPU_PROFILER_HISTORY - 1) % GPU_PROFILER_HISTORY;
+
+    float totalMs = 0.0f;
+    for (int p = 0; p < passNameCount; p++) {
+        const PassHistory& pass = history[p];
+        float latest = historyCount > 0 ? pass.gpuMs[newest] : 0.0f;
+        totalMs += latest;
+
+        char overlay[64];
+        snprintf(overlay, sizeof(overlay), "%.3f ms", latest);
+        ImGui::Text("%s  |  %u prims  |  %u samples", pass.name.c_str(),
+            historyCount > 0 ? pass.primitives[newest] : 0u,
+            historyCount > 0 ? pass.samples[newest] : 0u);
+        ImGui::PlotLines(("##" + pass.name).c_str(), pass.gpuMs, historyCount, offset, overlay,
+            0.0f, 4.0f, ImVec2(300, 40));
+    }
+
+    ImGui::Separator();
+    ImGui::Text("Total: %.3f ms   Dropped frames: %d", totalMs, droppedFrames);
+    if (ImGui::Button("Export CSV")) {
+        exportCsv("gpu_profile.csv");
+    }
+
+    ImGui::End();
+    ImGui::PopStyleColor(2);
+}
+
+bool GpuProfiler::exportCsv(const std::string& path) const {
+    std::ofstream file(path.c_str());
+    if (!file.is_open()) {
+        std::cerr << "Could not write GPU profile: " << path << std::endl;
+        return false;
+    }
+
+    file << "frame,pass,gpu_ms,primitives,samples\n";
+    int start = (historyCount < GPU_PROFILER_HISTORY) ? 0 : historyHead;
+    for (int i = 0; i < historyCount; i++) {
+        int column = (start + i) % GPU_PROFILER_HISTORY;
+        for (int p = 0; p < passNameCount; p++) {
+            file << historyFrame[column] << ',' << history[p].name << ','
+                << history[p].gpuMs[column] << ',' << history[p].primitives[column] << ','
+                << history[p].samples[column] << '\n';
+        }
+    }
+    return true;
+}
@@ -0,0 +1,84 @@
+#ifndef GPUPROFILER_H
+#define GPUPROFILER_H
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+
+// Limits of the profiler
+static const int GPU_PROFILER_MAX_PASSES = 8;    // Render passes that can be measured per frame
+static const int GPU_PROFILER_FRAMES = 5;        // Frames of queries kept in flight
+static const int GPU_PROFILER_HISTORY = 240;     // Frames kept for the graph and CSV export
+
+// Measures GPU time, primitives and samples of each render pass with a ring of queries
+class GpuProfiler {
+public:
+    GpuProfiler();
+    ~GpuProfiler();
+
+    // Collects finished results of earlier frames, never waits on the GPU
+    void beginFrame();
+
+    // Wraps a render pass; passes may not nest
+    void beginPass(const char* name);
+    void endPass();
+
+    // Closes the frame so its queries can be read back later
+    void endFrame();
+
+    // Waits for every frame still in flight and records it (end of a benchmark run)
+    void flush();
+
+    // Also stores the total GPU time of every frame at sink[frameNumber] (missing frames stay -1)
+    void setFrameSink(std::vector<float>* sink) { frameSink = sink; }
+
+    // Draws the "GPU Profiler" ImGui panel with rolling graphs
+    void drawPanel();
+
+    // Writes the recorded history as CSV, returns false if the file could not be written
+    bool exportCsv(const std::string& path) const;
+
+private:
+    // Queries of one pass in one frame
+    struct PassQueries {
+        unsigned int time;        // GL_TIME_ELAPSED
+        unsigned int primitives;  // GL_PRIMITIVES_GENERATED
+        unsigned int samples;     // GL_SAMPLES_PASSED
+    };
+
+    // Queries issued during one frame
+    struct FrameQueries {
+        PassQueries passes[GPU_PROFILER_MAX_PASSES];
+        int passIndex[GPU_PROFILER_MAX_PASSES];  // Which named pass each query set belongs to
+        int passCount;
+        long long frameNumber;
+        bool pending;
+    };
+
+    // Recorded results of one named pass
+    struct PassHistory {
+        std::string name;
+        float gpuMs[GPU_PROFILER_HISTORY];
+        unsigned int primitives[GPU_PROFILER_HISTORY];
+        unsigned int samples[GPU_PROFILER_HISTORY];
+    };
+
+    FrameQueries frames[GPU_PROFILER_FRAMES];
+    PassHistory history[GPU_PROFILER_MAX_PASSES];
+    long long historyFrame[GPU_PROFILER_HISTORY];  // Frame number of each history column
+    int passNameCount;       // Named passes seen so far
+    int historyHead;         // Next history column to write
+    int historyCount;        // Valid history columns
+    long long frameNumber;   // Frames started so far
+    int activePass;          // Query set currently open, -1 if none
+    int droppedFrames;       // Results discarded because the GPU was too far behind
+    std::vector<float>* frameSink;  // Optional per-frame totals (not owned)
+
+    // Finds or registers a pass name
+    int findPass(const char* name);
+
+    // Copies the results of a finished frame into the history
+    void resolveFrame(FrameQueries& frame);
+};
+
+#endif
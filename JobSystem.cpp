@@ -0,0 +1,261 @@
+#include "JobSystem.h"
+#include "CpuProfiler.h"
+#include "imgui/imgui.h"
+#include <cstdio>
+#include <iostream>
+
+// Queue index of the running thread (0 for any thread the system did not create or attach)
+static thread_local int threadQueueIndex = 0;
+
+// Jobs currently running on this thread (nested when a job waits for other jobs)
+static thread_local int threadJobDepth = 0;
+
+JobSystem::JobSystem(int workerThreads, int callerThreads) {
+    running = true;
+    queuedJobs = 0;
+    historyIndex = 0;
+
+    if (workerThreads < 0) workerThreads = 0;
+    callerCount = callerThreads > 1 ? callerThreads : 1;
+    for (int i = 0; i < callerCount + workerThreads; i++) {
+        ThreadQueue* queue = new ThreadQueue();
+        queue->busyNanoseconds = 0;
+        queues.push_back(queue);
+    }
+    utilization.assign(queues.size(), 0.0f);
+    history.assign(queues.size(), std::vector<float>(JOB_SYSTEM_HISTORY, 0.0f));
+
+    for (int i = 0; i < workerThreads; i++) {
+        workers.push_back(std::thread(&JobSystem::workerLoop, this, callerCount + i));
+    }
+    frameStart = std::chrono::steady_clock::now();
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        running = false;
+    }
+    wakeUp.notify_all();
+    for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+    for (size_t i = 0; i < queues.size(); i++) delete queues[i];
+}
+
+int JobSystem::defaultWorkerCount() {
+    int cores = (int)std::thread::hardware_concurrency();
+    return cores > 1 ? cores - 1 : 0;
+}
+
+void JobSystem::attachCaller(int caller) {
+    if (caller < 1 || caller >= callerCount) {
+        std::cerr << "ERROR::JOB_SYSTEM::INVALID_CALLER: " << caller << ", sharing the main thread's queue" << std::endl;
+        return;
+    }
+    threadQueueIndex = caller;
+}
+
+int JobSystem::currentThreadIndex() const {
+    return threadQueueIndex < (int)queues.size() ? threadQueueIndex : 0;
+}
+
+void JobSystem::schedule(JobFunction function, void* data, int begin, int end, std::atomic<int>& pending) {
+    pending.fetch_add(1, std::memory_order_relaxed);
+
+    // Without workers the job simply runs now
+    if (workers.empty()) {
+        function(data, begin, end);
+        pending.fetch_sub(1, std::memory_order_release);
+        return;
+    }
+
+    ThreadQueue* queue = queues[currentThreadIndex()];
+    {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        queue->jobs.push_back({ function, data, begin, end, &pending });
+    }
+    queuedJobs.fetch_add(1, std::memory_order_release);
+
+    // Take the lock so a worker cannot miss the wake-up between its check and its wait
+    { std::lock_guard<std::mutex> lock(sleepMutex); }
+    wakeUp.notify_one();
+}
+
+bool JobSystem::runOneJob(int threadIndex) {
+    Job job;
+    bool found = false;
+
+    // Newest job of the own queue (still warm in cache)
+    {
+        ThreadQueue* own = queues[threadIndex];
+        std::lock_guard<std::mutex> lock(own->mutex);
+        if (!own->jobs.empty()) {
+            job = own->jobs.back();
+            own->jobs.pop_back();
+            found = true;
+        }
+    }
+
+    // Otherwise steal the oldest (usually largest remaining) job of another thread;
+    // callers leave each other's queues alone
+    for (size_t i = 1; !found && i < queues.size(); i++) {
+        int victimIndex = (int)((threadIndex + i) % queues.size());
+        if (threadIndex < callerCount && victimIndex < callerCount) continue;
+        ThreadQueue* victim = queues[victimIndex];
+        std::lock_guard<std::mutex> lock(victim->mutex);
+        if (!victim->jobs.empty()) {
+            job = victim->jobs.front();
+            victim->jobs.pop_front();
+            found = true;
+        }
+    }
+    if (!found) return false;
+    queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+
+    // Only the outermost job is timed, nested jobs are already inside its time
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    threadJobDepth++;
+    job.function(job.data, job.begin, job.end);
+    threadJobDepth--;
+    if (threadJobDepth == 0) {
+        queues[threadIndex]->busyNanoseconds.fetch_add(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count(),
+            std::memory_order_relaxed);
+    }
+
+    job.pending->fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+void JobSystem::wait(std::atomic<int>& pending) {
+    int self = currentThreadIndex();
+    while (pending.load(std::memory_order_acquire) > 0) {
+        if (!runOneJob(self)) std::this_thread::yield();
+    }
+}
+
+void JobSystem::parallelFor(int count, int chunkSize, JobFunction function, void* data) {
+    if (count <= 0) return;
+    if (chunkSize < 1) chunkSize = 1;
+
+    std::atomic<int> pending(0);
+    for (int begin = 0; begin < count; begin += chunkSize) {
+        int end = begin + chunkSize < count ? begin + chunkSize : count;
+        schedule(function, data, begin, end, pending);
+    }
+    wait(pending);
+}
+
+void JobSystem::workerLoop(int threadIndex) {
+    threadQueueIndex = threadIndex;
+    char name[32];
+    snprintf(name, sizeof(name), "Worker %d", threadIndex - callerCount + 1);
+    PROFILE_THREAD_NAME(name);
+
+    while (running) {
+        if (runOneJob(threadIndex)) continue;
+
+        // Nothing to do: sleep until a job is scheduled
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeUp.wait(lock, [this]() { return !running || queuedJobs.load(std::memory_order_acquire) > 0; });
+    }
+}
+
+void JobSystem::beginFrame() {
+    frameStart = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < queues.size(); i++) queues[i]->busyNanoseconds = 0;
+}
+
+void JobSystem::endFrame() {
+    double frameNanoseconds = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - frameStart).count();
+    if (frameNanoseconds <= 0.0) return;
+
+    for (size_t i = 0; i < queues.size(); i++) {
+        float busy = (float)(queues[i]->busyNanoseconds.load(std::memory_order_relaxed) / frameNanoseconds);
+        utilization[i] = busy > 1.0f ? 1.0f : busy;
+        history[i][historyIndex] = utilization[i] * 100.0f;
+    }
+    historyIndex = (historyIndex + 1) % JOB_SYSTEM_HISTORY;
+}
+
+void JobSystem::drawPanel(const TaskGraph* graph) {
+    ImGui::Begin("Job System");
+    ImGui::Text("%d threads (%d workers)", (int)queues.size(), (int)workers.size());
+
+    // Share of the frame every thread spent running jobs
+    float total = 0.0f;
+    for (size_t i = 0; i < queues.size(); i++) {
+        char label[48];
+        if (i == 0) snprintf(label, sizeof(label), "Main %3.0f%%", utilization[i] * 100.0f);
+        else if ((int)i < callerCount) snprintf(label, sizeof(label), "Caller %d %3.0f%%", (int)i, utilization[i] * 100.0f);
+        else snprintf(label, sizeof(label), "Worker %d %3.0f%%", (int)i - callerCount + 1, utilization[i] * 100.0f);
+        ImGui::PlotLines(label, history[i].data(), JOB_SYSTEM_HISTORY, historyIndex, nullptr, 0.0f, 100.0f, ImVec2(200, 30));
+        total += utilization[i];
+    }
+    ImGui::Text("Average utilization: %.0f%%", total * 100.0f / queues.size());
+
+    // Durations of the frame graph tasks
+    if (graph) {
+        ImGui::Separator();
+        for (int i = 0; i < graph->getTaskCount(); i++) {
+            ImGui::Text("%-18s %6.3f ms", graph->getTaskName(i), graph->getTaskMilliseconds(i));
+        }
+    }
+    ImGui::End();
+}
+
+int TaskGraph::addTask(const char* name, std::function<void()> function, bool mainThreadOnly) {
+    Task task;
+    task.name = name;
+    task.function = function;
+    task.mainThreadOnly = mainThreadOnly;
+    task.dependencyCount = 0;
+    task.milliseconds = 0.0f;
+    tasks.push_back(task);
+    return (int)tasks.size() - 1;
+}
+
+void TaskGraph::addDependency(int before, int after) {
+    tasks[before].dependents.push_back(after);
+    tasks[after].dependencyCount++;
+}
+
+void TaskGraph::runTaskJob(void* data, int, int) {
+    Task* task = (Task*)data;
+    PROFILE_SCOPE(task->name);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    task->function();
+    task->milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void TaskGraph::run(JobSystem& jobs) {
+    // Remaining dependencies of every task for this run
+    std::vector<int> waitingFor(tasks.size());
+    std::vector<int> ready;
+    for (size_t i = 0; i < tasks.size(); i++) {
+        waitingFor[i] = tasks[i].dependencyCount;
+        if (waitingFor[i] == 0) ready.push_back((int)i);
+    }
+
+    // Wave by wave: all ready tasks run together, then their dependents become ready
+    std::vector<int> next;
+    while (!ready.empty()) {
+        std::atomic<int> pending(0);
+        for (size_t i = 0; i < ready.size(); i++) {
+            if (!tasks[ready[i]].mainThreadOnly) jobs.schedule(runTaskJob, &tasks[ready[i]], 0, 1, pending);
+        }
+        for (size_t i = 0; i < ready.size(); i++) {
+            if (tasks[ready[i]].mainThreadOnly) runTaskJob(&tasks[ready[i]], 0, 1);
+        }
+        jobs.wait(pending);
+
+        next.clear();
+        for (size_t i = 0; i < ready.size(); i++) {
+            const std::vector<int>& dependents = tasks[ready[i]].dependents;
+            for (size_t d = 0; d < dependents.size(); d++) {
+                if (--waitingFor[dependents[d]] == 0) next.push_back(dependents[d]);
+            }
+        }
+        ready.swap(next);
+    }
+}
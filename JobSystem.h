@@ -0,0 +1,128 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Number of frames of utilization history kept for the panel
+#define JOB_SYSTEM_HISTORY 120
+
+// Job entry point: processes the items [begin, end) of whatever data points to
+typedef void (*JobFunction)(void* data, int begin, int end);
+
+// Work-stealing job scheduler. Every thread (workers and the threads that wait)
+// owns a queue; it takes its newest job first and steals the oldest job of
+// another queue when its own is empty. Waiting threads run jobs instead of
+// blocking, so jobs may start and wait for other jobs. A waiting caller thread
+// only helps with its own and the workers' jobs, never another caller's, so
+// e.g. the render thread does not end up running simulation work.
+class JobSystem {
+public:
+    // - workerThreads: threads besides the calling one (0 = all jobs run on the caller)
+    // - callerThreads: threads that schedule and wait with their own queue, the creating
+    //   thread included; the others take theirs with attachCaller
+    JobSystem(int workerThreads, int callerThreads = 1);
+    ~JobSystem();
+
+    // Gives the calling thread the queue of caller 1..callerThreads-1 (once, before its first job)
+    void attachCaller(int caller);
+
+    // Threads that run the jobs of one parallelFor: the workers plus the waiting caller
+    int getThreadCount() const { return (int)workers.size() + 1; }
+
+    // Queues fn(data, begin, end) and returns immediately; pending is decremented when it finished
+    void schedule(JobFunction function, void* data, int begin, int end, std::atomic<int>& pending);
+
+    // Runs jobs until pending reaches zero
+    void wait(std::atomic<int>& pending);
+
+    // Splits [0, count) into chunks of chunkSize, runs them on all threads and waits
+    void parallelFor(int count, int chunkSize, JobFunction function, void* data);
+
+    // Per-frame utilization: time every thread spent inside jobs
+    void beginFrame();
+    void endFrame();
+    float getUtilization(int thread) const { return utilization[thread]; }
+
+    // "Job System" window with per-thread utilization of the last frames
+    void drawPanel(const class TaskGraph* graph = nullptr);
+
+    // Worker count for this machine (one thread per core, minus the main thread)
+    static int defaultWorkerCount();
+
+private:
+    struct Job {
+        JobFunction function;
+        void* data;
+        int begin, end;
+        std::atomic<int>* pending;
+    };
+
+    // One queue per thread, padded so neighbouring queues do not share cache lines
+    struct ThreadQueue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+        std::atomic<long long> busyNanoseconds;   // Time spent in jobs since beginFrame
+        char padding[64];
+    };
+
+    std::vector<ThreadQueue*> queues;   // Callers first (0 is the creating thread), then the workers
+    int callerCount;
+    std::vector<std::thread> workers;
+    std::atomic<bool> running;
+    std::atomic<int> queuedJobs;        // Jobs waiting in any queue
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+
+    // Instrumentation (owner thread only)
+    std::chrono::steady_clock::time_point frameStart;
+    std::vector<float> utilization;                  // Last frame, 0..1 per thread
+    std::vector<std::vector<float> > history;       // Percent per thread, ring of JOB_SYSTEM_HISTORY
+    int historyIndex;
+
+    int currentThreadIndex() const;
+    bool runOneJob(int threadIndex);    // Own queue first, then steal; false when all are empty
+    void workerLoop(int threadIndex);
+};
+
+// Tasks with dependencies, run once per frame. Tasks that touch the GL context
+// or window are marked main-thread-only; all others run as jobs (and may use
+// parallelFor themselves).
+class TaskGraph {
+public:
+    // Returns the task index used by addDependency
+    // - name: string literal, it is kept as the task's zone name in CPU profiler traces
+    int addTask(const char* name, std::function<void()> function, bool mainThreadOnly = false);
+
+    // "after" starts only once "before" has finished
+    void addDependency(int before, int after);
+
+    // Runs every task once in dependency order, on the calling thread plus the job system
+    void run(JobSystem& jobs);
+
+    // Instrumentation of the last run
+    int getTaskCount() const { return (int)tasks.size(); }
+    const char* getTaskName(int task) const { return tasks[task].name; }
+    float getTaskMilliseconds(int task) const { return tasks[task].milliseconds; }
+
+private:
+    struct Task {
+        const char* name;
+        std::function<void()> function;
+        bool mainThreadOnly;
+        std::vector<int> dependents;
+        int dependencyCount;
+        float milliseconds;     // Duration of the last run
+    };
+    std::vector<Task> tasks;
+
+    static void runTaskJob(void* data, int begin, int end);
+};
+
+#endif
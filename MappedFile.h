@@ -0,0 +1,35 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file. Pages are loaded by the OS on first
+// touch and shared with other processes mapping the same file, so opening a
+// large data file costs about the same as opening a small one.
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    // Maps the file, false (after printing why) if it cannot be opened or is empty
+    bool open(const std::string& path);
+    void close();
+
+    const unsigned char* getData() const { return data; }
+    size_t getSize() const { return size; }
+    bool isOpen() const { return data != nullptr; }
+
+private:
+    const unsigned char* data;
+    size_t size;
+#ifdef _WIN32
+    void* file;         // HANDLE of the file and of its mapping
+    void* mapping;
+#endif
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+};
+
+#endif
@@ -1,33 +1,332 @@
 #include "ModelLoader.h"
+#include "AssetPack.h"
+#include "CpuProfiler.h"
+#include "GltfLoader.h"
+#include "ObjParser.h"
+#include "Shader.h"
+#include "SharedMesh.h"
+#include "StreamBuffer.h"
 #include <glad/glad.h>
 #include <iostream>
 #include <fstream>
+#include <cmath>
+
+bool parseModelImporter(const std::string& name, ModelImporter& importer) {
+    if (name == "auto") importer = MODEL_IMPORTER_AUTO;
+    else if (name == "assimp") importer = MODEL_IMPORTER_ASSIMP;
+    else if (name == "obj") importer = MODEL_IMPORTER_OBJ;
+    else if (name == "gltf") importer = MODEL_IMPORTER_GLTF;
+    else return false;
+    return true;
+}
+
+bool isGltfModel(const std::string& path, ModelImporter importer) {
+    bool glbFile = path.size() >= 4 && (path.compare(path.size() - 4, 4, ".glb") == 0 || path.compare(path.size() - 4, 4, ".GLB") == 0);
+    return importer == MODEL_IMPORTER_GLTF || (importer == MODEL_IMPORTER_AUTO && glbFile);
+}
 
 // Constructor: Loads the model from the given file path
-ModelLoader::ModelLoader(const std::string& path) {
+ModelLoader::ModelLoader(const std::string& path, ModelImporter modelImporter, JobSystem* jobs, bool shareMesh) {
+    PROFILE_SCOPE("ModelLoader::load");
+
+    // Binary glTF goes to the GPU without a vertex list
+    if (isGltfModel(path, modelImporter)) {
+        GltfFile gltf;
+        if (gltf.open(path)) loadGltf(gltf, path);
+        return;
+    }
+
+    // Triangles another instance already imported are uploaded from its shared memory
+    if (shareMesh) {
+        sharedMesh = new SharedMesh();
+        SharedMeshState state = sharedMesh->open(path, modelImporter);
+        if (state == SHARED_MESH_ATTACHED) {
+            sharedMesh->getBounds(boundsCenter, boundsRadius, footprintRadius);
+            setupBuffers(sharedMesh->getVertices(), sharedMesh->getVertexCount());
+            return;
+        }
+        if (state == SHARED_MESH_UNAVAILABLE) {
+            delete sharedMesh;
+            sharedMesh = nullptr;
+        }
+    }
+
+    // A failed import leaves the shared mesh unpublished, it is removed for the next instance to try
+    if (!importFile(path, modelImporter, jobs, vertices)) {
+        delete sharedMesh;
+        sharedMesh = nullptr;
+        return;
+    }
+    computeBounds();
+
+    // The published copy replaces this process's own
+    if (sharedMesh && sharedMesh->publish(vertices, boundsCenter, boundsRadius, footprintRadius)) {
+        std::vector<Vertex>().swap(vertices);
+        setupBuffers(sharedMesh->getVertices(), sharedMesh->getVertexCount());
+        return;
+    }
+    delete sharedMesh;
+    sharedMesh = nullptr;
+
+    // Set up OpenGL buffers (VAO, VBO)
+    setupBuffers(vertices.data(), vertices.size());
+}
+
+// Reads the triangles of an OBJ file or of the first mesh Assimp finds into vertices
+bool ModelLoader::importFile(const std::string& path, ModelImporter modelImporter, JobSystem* jobs, std::vector<Vertex>& vertices) {
+    // Plain OBJ files skip Assimp's generic pipeline
+    bool objFile = path.size() >= 4 && (path.compare(path.size() - 4, 4, ".obj") == 0 || path.compare(path.size() - 4, 4, ".OBJ") == 0);
+    if (modelImporter == MODEL_IMPORTER_OBJ || (modelImporter == MODEL_IMPORTER_AUTO && objFile)) return parseObjFile(path, vertices, jobs);
+
     Assimp::Importer importer;
 
     // Read the model file with triangulation and normal generation
-    const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenNormals);
+    const aiScene* scene;
+    {
+        PROFILE_SCOPE("Assimp::ReadFile");
+        scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenNormals);
+    }
 
     // Error checking: ensure the scene was loaded correctly
-    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
+    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode || scene->mNumMeshes == 0) {
         std::cerr << "Assimp Error: " << importer.GetErrorString() << std::endl;
-        return;
+        return false;
     }
 
     // For simplicity, only the first mesh is processed
     aiMesh* mesh = scene->mMeshes[0];
 
     // Process the mesh to extract vertex data
-    processMesh(mesh);
+    processMesh(mesh, vertices);
+    return true;
+}
 
-    // Set up OpenGL buffers (VAO, VBO)
-    setupBuffers();
+ModelLoader::ModelLoader(const GltfFile& gltf, const std::string& path) {
+    loadGltf(gltf, path);
+}
+
+// Constructor: Uses generated vertices instead of a file
+ModelLoader::ModelLoader(std::vector<Vertex> generatedVertices) : vertices(std::move(generatedVertices)) {
+    computeBounds();
+    setupBuffers(vertices.data(), vertices.size());
+}
+
+ModelLoader::~ModelLoader() {
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    if (!partArrays.empty()) glDeleteVertexArrays((int)partArrays.size(), partArrays.data());
+    if (!partBuffers.empty()) glDeleteBuffers((int)partBuffers.size(), partBuffers.data());
+    delete sharedMesh;
+}
+
+long long ModelLoader::getTriangleCount() const {
+    return parts.empty() ? vertexCount / 3 : partTriangles;
+}
+
+// Normals summed from the unnormalized face normals, so large faces weigh more
+std::vector<glm::vec3> ModelLoader::generateNormals(const GltfFile& gltf, int position, int indices) {
+    const GltfAccessor& positions = gltf.accessors[position];
+    std::vector<glm::vec3> normals(positions.count, glm::vec3(0.0f));
+    int count = indices >= 0 ? gltf.accessors[indices].count : positions.count;
+    for (int i = 0; i + 2 < count; i += 3) {
+        unsigned int corner[3];
+        for (int j = 0; j < 3; j++) corner[j] = indices >= 0 ? gltf.readIndex(gltf.accessors[indices], i + j) : (unsigned int)(i + j);
+        if (corner[0] >= normals.size() || corner[1] >= normals.size() || corner[2] >= normals.size()) continue;
+        glm::vec3 a = gltf.readVec3(positions, corner[0]);
+        glm::vec3 face = glm::cross(gltf.readVec3(positions, corner[1]) - a, gltf.readVec3(positions, corner[2]) - a);
+        for (int j = 0; j < 3; j++) normals[corner[j]] += face;
+    }
+    for (size_t i = 0; i < normals.size(); i++) {
+        float length = glm::length(normals[i]);
+        normals[i] = length > 0.0f ? normals[i] / length : glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+    return normals;
+}
+
+// The used buffer views are uploaded once each, straight from the mapped file, and the
+// vertex attributes read them in their stored format (e.g. normalized shorts), so
+// nothing is converted or copied on the CPU
+void ModelLoader::loadGltf(const GltfFile& gltf, const std::string& path) {
+    PROFILE_SCOPE("ModelLoader::loadGltf");
+    // Buffer of a view, uploaded on first use. Views are shared between primitives, so the
+    // callers bind the returned buffer to their vertex array every time
+    std::vector<unsigned int> viewBuffers(gltf.bufferViews.size(), 0);
+    auto uploadView = [&](int view, GLenum target) -> unsigned int {
+        if (viewBuffers[view] == 0) {
+            glGenBuffers(1, &viewBuffers[view]);
+            glBindBuffer(target, viewBuffers[view]);
+            glBufferData(target, gltf.bufferViews[view].length, gltf.viewData(view), GL_STATIC_DRAW);
+            partBuffers.push_back(viewBuffers[view]);
+        }
+        return viewBuffers[view];
+    };
+
+    // Attribute location from an accessor, in the accessor's own component type
+    auto bindAttribute = [&](unsigned int location, int accessorIndex) {
+        const GltfAccessor& accessor = gltf.accessors[accessorIndex];
+        glBindBuffer(GL_ARRAY_BUFFER, uploadView(accessor.bufferView, GL_ARRAY_BUFFER));
+        glVertexAttribPointer(location, accessor.components, accessor.componentType, accessor.normalized ? GL_TRUE : GL_FALSE,
+                              gltf.bufferViews[accessor.bufferView].stride, (void*)accessor.offset);
+        glEnableVertexAttribArray(location);
+    };
+
+    // Primitives shared by several nodes keep one vertex array
+    std::vector<std::vector<unsigned int>> primitiveArrays(gltf.meshes.size());
+    for (size_t i = 0; i < gltf.meshes.size(); i++) primitiveArrays[i].assign(gltf.meshes[i].primitives.size(), 0);
+
+    glm::vec3 low(0.0f), high(0.0f);
+    float footprintSquared = 0.0f;
+    int skipped = 0;
+    for (size_t i = 0; i < gltf.instances.size(); i++) {
+        const GltfInstance& instance = gltf.instances[i];
+        const std::vector<GltfPrimitive>& primitives = gltf.meshes[instance.mesh].primitives;
+        for (size_t j = 0; j < primitives.size(); j++) {
+            const GltfPrimitive& primitive = primitives[j];
+            const GltfAccessor* positions = primitive.position >= 0 ? &gltf.accessors[primitive.position] : nullptr;
+            const GltfAccessor* indices = primitive.indices >= 0 ? &gltf.accessors[primitive.indices] : nullptr;
+            bool drawable = primitive.mode == GLTF_TRIANGLES && positions && positions->bufferView >= 0 &&
+                            positions->componentType == GLTF_FLOAT && positions->components == 3 &&
+                            (!indices || (indices->bufferView >= 0 && indices->components == 1 &&
+                                          (indices->componentType == GLTF_UNSIGNED_BYTE || indices->componentType == GLTF_UNSIGNED_SHORT ||
+                                           indices->componentType == GLTF_UNSIGNED_INT)));
+            if (!drawable) {
+                skipped++;
+                continue;
+            }
+
+            unsigned int& vao = primitiveArrays[instance.mesh][j];
+            if (vao == 0) {
+                glGenVertexArrays(1, &vao);
+                partArrays.push_back(vao);
+                glBindVertexArray(vao);
+                bindAttribute(0, primitive.position);
+                if (primitive.normal >= 0 && gltf.accessors[primitive.normal].bufferView >= 0) bindAttribute(1, primitive.normal);
+                else {
+                    std::vector<glm::vec3> normals = generateNormals(gltf, primitive.position, primitive.indices);
+                    unsigned int normalBuffer;
+                    glGenBuffers(1, &normalBuffer);
+                    partBuffers.push_back(normalBuffer);
+                    glBindBuffer(GL_ARRAY_BUFFER, normalBuffer);
+                    glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(glm::vec3), normals.data(), GL_STATIC_DRAW);
+                    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+                    glEnableVertexAttribArray(1);
+                }
+                // The element buffer binding is part of the vertex array state
+                if (indices) glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, uploadView(indices->bufferView, GL_ELEMENT_ARRAY_BUFFER));
+                glBindVertexArray(0);
+            }
+
+            ModelPart part;
+            part.vao = vao;
+            part.count = indices ? indices->count : positions->count;
+            part.indexType = indices ? (unsigned int)indices->componentType : 0;
+            part.indexOffset = indices ? indices->offset : 0;
+            part.transform = instance.transform;
+            part.lod = 0;
+            parts.push_back(part);
+            partTriangles += part.count / 3;
+
+            // Bounds from the accessor's box corners (positions are read only when min/max are missing)
+            glm::vec3 boxLow = positions->min, boxHigh = positions->max;
+            if (!positions->hasBounds) {
+                for (int k = 0; k < positions->count; k++) {
+                    glm::vec3 position = gltf.readVec3(*positions, k);
+                    boxLow = k == 0 ? position : glm::min(boxLow, position);
+                    boxHigh = k == 0 ? position : glm::max(boxHigh, position);
+                }
+            }
+            for (int corner = 0; corner < 8; corner++) {
+                glm::vec3 point((corner & 1) ? boxHigh.x : boxLow.x, (corner & 2) ? boxHigh.y : boxLow.y, (corner & 4) ? boxHigh.z : boxLow.z);
+                glm::vec3 placed = glm::vec3(instance.transform * glm::vec4(point, 1.0f));
+                bool first = parts.size() == 1 && corner == 0;
+                low = first ? placed : glm::min(low, placed);
+                high = first ? placed : glm::max(high, placed);
+                footprintSquared = std::fmax(footprintSquared, placed.x * placed.x + placed.z * placed.z);
+            }
+        }
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    if (skipped > 0) std::cerr << "ERROR::GLTF::SKIPPED_PRIMITIVES: " << skipped << " in " << path << " (only float triangle lists are drawn)" << std::endl;
+    if (parts.empty()) {
+        std::cerr << "ERROR::GLTF::NO_DRAWABLE_MESH: " << path << std::endl;
+        return;
+    }
+    boundsCenter = (low + high) * 0.5f;
+    boundsRadius = glm::length(high - low) * 0.5f;
+    footprintRadius = std::sqrt(footprintSquared);
+}
+
+// One buffer holds vertices and indices; it is filled by decompressing the pack's chunks
+// in parallel into the mapped buffer, so the payload never lands in a CPU-side copy
+ModelLoader::ModelLoader(const AssetPack& pack, int asset, JobSystem* jobs) {
+    PROFILE_SCOPE("ModelLoader::loadPacked");
+    const PackAsset& entry = pack.getAsset(asset);
+    const CookedMeshInfo* info = (const CookedMeshInfo*)pack.getInfo(asset);
+    bool valid = entry.type == PACK_ASSET_MESH && (entry.cookVersion >> 8) == COOKED_MESH_VERSION && info &&
+                 entry.infoSize == sizeof(CookedMeshInfo) && (info->indexSize == 2 || info->indexSize == 4) &&
+                 info->lodCount >= 1 && info->lodCount <= COOKED_MAX_LODS;
+    unsigned long long indicesOffset = valid ? (unsigned long long)info->vertexCount * sizeof(CookedVertex) : 0;
+    for (unsigned int l = 0; valid && l < info->lodCount; l++) {
+        valid = indicesOffset + ((unsigned long long)info->lods[l].firstIndex + info->lods[l].indexCount) * info->indexSize <= entry.size;
+    }
+    if (!valid) {
+        std::cerr << "ERROR::MODEL::INVALID_PACKED_MESH: " << entry.name << std::endl;
+        return;
+    }
+
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, entry.size, nullptr, GL_STATIC_DRAW);
+    unsigned char* mapped = (unsigned char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, entry.size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    bool decoded = mapped && pack.decompress(asset, mapped, jobs);
+    if (mapped && glUnmapBuffer(GL_ARRAY_BUFFER) == GL_FALSE) decoded = false;     // Buffer contents lost (e.g. mode switch)
+    if (!decoded) {
+        std::cerr << "ERROR::MODEL::PACKED_UPLOAD_FAILED: " << entry.name << std::endl;
+        glBindVertexArray(0);
+        return;
+    }
+
+    // Quantized attributes are read as normalized integers; the box scale moves into the model matrix
+    // (uniform, so the normal matrix keeps the normals' directions)
+    glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(CookedVertex), (void*)offsetof(CookedVertex, position));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_BYTE, GL_TRUE, sizeof(CookedVertex), (void*)offsetof(CookedVertex, normal));
+    glEnableVertexAttribArray(1);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, VBO);
+    glBindVertexArray(0);
+
+    glm::mat4 dequantize(1.0f);
+    for (int k = 0; k < 3; k++) {
+        dequantize[k][k] = info->boxScale[k];
+        dequantize[3][k] = info->boxLow[k];
+    }
+    lodCount = (int)info->lodCount;
+    for (int l = 0; l < lodCount; l++) {
+        ModelPart part;
+        part.vao = VAO;
+        part.count = (int)info->lods[l].indexCount;
+        part.indexType = info->indexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        part.indexOffset = (size_t)(indicesOffset + (unsigned long long)info->lods[l].firstIndex * info->indexSize);
+        part.transform = dequantize;
+        part.lod = l;
+        parts.push_back(part);
+    }
+    partTriangles = info->lods[0].indexCount / 3;
+    boundsCenter = glm::vec3(info->boundsCenter[0], info->boundsCenter[1], info->boundsCenter[2]);
+    boundsRadius = info->boundsRadius;
+    footprintRadius = info->footprintRadius;
 }
 
 // Extracts vertex positions and normals from the mesh
 void ModelLoader::processMesh(aiMesh* mesh) {
+    processMesh(mesh, vertices);
+}
+
+void ModelLoader::processMesh(const aiMesh* mesh, std::vector<Vertex>& vertices) {
+    PROFILE_SCOPE("ModelLoader::processMesh");
     for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
         Vertex vertex;
 
@@ -50,15 +349,45 @@ void ModelLoader::processMesh(aiMesh* mesh) {
     }
 }
 
+// Bounding sphere around the center of the bounding box
+void ModelLoader::computeBounds() {
+    if (vertices.empty()) return;
+
+    glm::vec3 low = vertices[0].Position;
+    glm::vec3 high = vertices[0].Position;
+    for (size_t i = 1; i < vertices.size(); i++) {
+        low = glm::min(low, vertices[i].Position);
+        high = glm::max(high, vertices[i].Position);
+    }
+    boundsCenter = (low + high) * 0.5f;
+
+    float radiusSquared = 0.0f;
+    float footprintSquared = 0.0f;
+    for (size_t i = 0; i < vertices.size(); i++) {
+        glm::vec3 offset = vertices[i].Position - boundsCenter;
+        float distanceSquared = glm::dot(offset, offset);
+        if (distanceSquared > radiusSquared) radiusSquared = distanceSquared;
+
+        // Exhibits turn around the up axis through their origin
+        const glm::vec3& position = vertices[i].Position;
+        float axisSquared = position.x * position.x + position.z * position.z;
+        if (axisSquared > footprintSquared) footprintSquared = axisSquared;
+    }
+    boundsRadius = std::sqrt(radiusSquared);
+    footprintRadius = std::sqrt(footprintSquared);
+}
+
 // Sets up the Vertex Array Object and Vertex Buffer Object
-void ModelLoader::setupBuffers() {
+void ModelLoader::setupBuffers(const Vertex* data, size_t count) {
+    PROFILE_SCOPE("ModelLoader::setupBuffers");
+    vertexCount = (int)count;
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
     glBindVertexArray(VAO);
 
     // Bind and load vertex data into the buffer
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, count * sizeof(Vertex), data, GL_STATIC_DRAW);
 
     // Set vertex attribute for position (location = 0)
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
@@ -75,6 +404,46 @@ void ModelLoader::setupBuffers() {
 // Draws the model using glDrawArrays
 void ModelLoader::drawModel() {
     glBindVertexArray(VAO);
-    glDrawArrays(GL_TRIANGLES, 0, vertices.size()); // Draw all vertices as triangles
+    glDrawArrays(GL_TRIANGLES, 0, vertexCount); // Draw all vertices as triangles
+    glBindVertexArray(0);
+}
+
+int ModelLoader::getPartCount(int lod) const {
+    if (parts.empty()) return 1;
+    int level = lod < lodCount ? lod : lodCount - 1;
+    int count = 0;
+    for (size_t i = 0; i < parts.size(); i++) {
+        if (parts[i].lod == level) count++;
+    }
+    return count;
+}
+
+const glm::mat4& ModelLoader::getPartTransform(int lod, int part) const {
+    static const glm::mat4 identity(1.0f);
+    int level = lod < lodCount ? lod : lodCount - 1;
+    for (size_t i = 0; i < parts.size(); i++) {
+        if (parts[i].lod == level && part-- == 0) return parts[i].transform;
+    }
+    return identity;
+}
+
+void ModelLoader::drawInstanced(const Shader& shader, int lod, int count, int objectOffset) const {
+    if (count == 0) return;
+    if (parts.empty()) {
+        shader.setInt("objectOffset", objectOffset);
+        glBindVertexArray(VAO);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, vertexCount, count);
+        glBindVertexArray(0);
+        return;
+    }
+    int level = lod < lodCount ? lod : lodCount - 1;
+    int part = 0;
+    for (size_t i = 0; i < parts.size(); i++) {
+        if (parts[i].lod != level) continue;
+        shader.setInt("objectOffset", objectOffset + part++ * count * OBJECT_TEXELS);
+        glBindVertexArray(parts[i].vao);
+        if (parts[i].indexType != 0) glDrawElementsInstanced(GL_TRIANGLES, parts[i].count, parts[i].indexType, (void*)parts[i].indexOffset, count);
+        else glDrawArraysInstanced(GL_TRIANGLES, 0, parts[i].count, count);
+    }
     glBindVertexArray(0);
 }
\ No newline at end of file
@@ -17,25 +17,121 @@ struct Vertex {
     glm::vec3 Normal;    // Normal vector for lighting
 };
 
+class JobSystem;
+class Shader;
+class GltfFile;
+class AssetPack;
+class SharedMesh;
+
+// How a model file is read
+enum ModelImporter {
+    MODEL_IMPORTER_AUTO,    // Parallel OBJ parser for .obj files, Assimp for everything else
+    MODEL_IMPORTER_ASSIMP,  // Assimp for every format (triangulation and flat normals by Assimp)
+    MODEL_IMPORTER_OBJ,     // Parallel OBJ parser (see ObjParser.h)
+    MODEL_IMPORTER_GLTF     // Binary glTF 2.0, buffer views uploaded as they are (see GltfLoader.h)
+};
+
+// Parses "auto", "assimp", "obj" or "gltf", false for anything else
+bool parseModelImporter(const std::string& name, ModelImporter& importer);
+
+// True if the model is read as binary glTF (the gltf importer, or a .glb file with auto)
+bool isGltfModel(const std::string& path, ModelImporter importer);
+
 // Class to load and render a 3D model
 class ModelLoader {
 public:
     std::vector<Vertex> vertices;  // List of vertices extracted from the model
 
+    // Bounding sphere of the vertices in model space (used for culling)
+    glm::vec3 boundsCenter = glm::vec3(0.0f);
+    float boundsRadius = 0.0f;
+
+    // Largest distance of a vertex from the model's up axis (floor footprint for navigation)
+    float footprintRadius = 0.0f;
+
     // Constructor: loads a model from the given file path
-    ModelLoader(const std::string& path);
+    // - jobs: threads for the OBJ parser (may be null)
+    // - shareMesh: keep the imported triangles in shared memory for other instances of the
+    //   museum, or upload them from there when one already imported the file (see SharedMesh.h);
+    //   vertices stays empty then
+    ModelLoader(const std::string& path, ModelImporter importer = MODEL_IMPORTER_AUTO, JobSystem* jobs = nullptr,
+                bool shareMesh = false);
+
+    // Constructor: uploads already generated or imported triangles (e.g. synthetic stress-test
+    // meshes, or a model file imported on another thread)
+    ModelLoader(std::vector<Vertex> generatedVertices);
+
+    // Constructor: uploads a binary glTF file opened and parsed by the caller (e.g. on an
+    // import thread); path is only used in messages
+    ModelLoader(const GltfFile& gltf, const std::string& path);
+
+    // Constructor: decompresses a cooked mesh of an asset pack (see museum_cook) straight
+    // into a mapped GL buffer, on the job system's threads when there is one
+    ModelLoader(const AssetPack& pack, int asset, JobSystem* jobs = nullptr);
+
+    ~ModelLoader();
 
     // Draws the loaded model using OpenGL
     void drawModel();
 
-private:
-    unsigned int VAO, VBO;  // OpenGL buffers: Vertex Array Object and Vertex Buffer Object
+    // Levels of detail (only cooked meshes have more than one); lod arguments are clamped to them
+    int getLodCount() const { return lodCount; }
 
-    // Extracts vertices and normals from the given mesh
+    // Parts drawn for a level of detail (1 unless the model is a glTF or cooked mesh), and the
+    // transform each part adds to the exhibit's model matrix
+    int getPartCount(int lod) const;
+    const glm::mat4& getPartTransform(int lod, int part) const;
+
+    // Draws count copies of every part of a level of detail, one instanced call per part.
+    // Copy i of part p is placed by the object objectOffset + (p * count + i) * OBJECT_TEXELS
+    // texels into the streamed per-object data (see vertex_shader.glsl).
+    void drawInstanced(const Shader& shader, int lod, int count, int objectOffset) const;
+
+    // Triangles drawn per instance (glTF models keep no vertex list)
+    long long getTriangleCount() const;
+
+    // False if the model file could not be loaded (nothing is drawn)
+    bool isLoaded() const { return vertexCount > 0 || !parts.empty(); }
+
+    // Extracts vertices and normals from the given mesh (public for the microbenchmarks)
     void processMesh(aiMesh* mesh);
+    static void processMesh(const aiMesh* mesh, std::vector<Vertex>& vertices);
+
+    // Reads the triangles of an OBJ or Assimp model file without touching OpenGL (hot reload
+    // imports on a background thread, museum_cook cooks what it returns); not for glTF files,
+    // false if the file cannot be read
+    static bool importFile(const std::string& path, ModelImporter importer, JobSystem* jobs, std::vector<Vertex>& vertices);
+
+private:
+    unsigned int VAO = 0, VBO = 0;  // OpenGL buffers: Vertex Array Object and Vertex Buffer Object
+    int vertexCount = 0;            // Vertices in VBO
+    SharedMesh* sharedMesh = nullptr;  // Held while the model is loaded, so other instances can attach
+
+    // One glTF primitive drawn by one node, or one level of detail of a cooked mesh
+    struct ModelPart {
+        unsigned int vao;
+        int count;                  // Indices, or vertices when not indexed
+        unsigned int indexType;     // GL_UNSIGNED_BYTE/SHORT/INT, 0 = glDrawArrays
+        size_t indexOffset;         // Byte offset of the first index in the element buffer
+        glm::mat4 transform;        // Node transform, or the dequantization of cooked positions
+        int lod;
+    };
+    std::vector<ModelPart> parts;
+    std::vector<unsigned int> partArrays, partBuffers;     // GL objects shared by the parts
+    long long partTriangles = 0;    // Of level 0
+    int lodCount = 1;
 
     // Sets up the OpenGL VAO and VBO for rendering
-    void setupBuffers();
+    void setupBuffers(const Vertex* data, size_t count);
+
+    // Uploads the buffer views of a .glb file and creates one part per drawn primitive
+    void loadGltf(const GltfFile& gltf, const std::string& path);
+
+    // Area-weighted vertex normals of a primitive without a NORMAL attribute
+    static std::vector<glm::vec3> generateNormals(const GltfFile& gltf, int position, int indices);
+
+    // Computes the bounding sphere and footprint from the vertices
+    void computeBounds();
 };
 
 #endif
\ No newline at end of file
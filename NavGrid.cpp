@@ -0,0 +1,606 @@
+#include "NavGrid.h"
+#include "CpuProfiler.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+// Grid resolution and robot size in meters
+static const float NAV_CELL_SIZE = 0.25f;
+static const float NAV_ROBOT_RADIUS = 0.3f;
+
+// Rooms are 10x10 with walls on their edges, doorways join neighbouring rooms
+static const float NAV_ROOM_HALF_SIZE = 5.0f;
+static const float NAV_DOOR_HALF_WIDTH = 0.75f;
+
+// Largest distance between the centers of neighbouring rooms (the generator uses 11)
+static const float NAV_MAX_ROOM_SPACING = 12.0f;
+
+// Routes kept before the cache starts over
+static const size_t NAV_PATH_CACHE_SIZE = 4096;
+
+// Cells searched around a blocked point for a walkable one
+static const int NAV_NEAREST_RADIUS = 16;
+
+// Step costs in cells
+static const float NAV_STRAIGHT = 1.0f;
+static const float NAV_DIAGONAL = 1.41421356f;
+
+// Neighbour offsets: four straight steps, then four diagonal ones
+static const int NEIGHBOUR_X[8] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+static const int NEIGHBOUR_Z[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+
+NavGrid::NavGrid(const std::vector<glm::vec3>& roomOrigins, const std::vector<NavObstacle>& obstacles) {
+    PROFILE_SCOPE("NavGrid::build");
+    stamp = 0;
+    portalStamp = 0;
+    cacheHits = 0;
+    cacheMisses = 0;
+
+    // Grid covering every room plus a margin
+    glm::vec3 low = roomOrigins.empty() ? glm::vec3(0.0f) : roomOrigins[0];
+    glm::vec3 high = low;
+    for (size_t i = 1; i < roomOrigins.size(); i++) {
+        low = glm::min(low, roomOrigins[i]);
+        high = glm::max(high, roomOrigins[i]);
+    }
+    float margin = NAV_ROOM_HALF_SIZE + 1.0f;
+    minX = low.x - margin;
+    minZ = low.z - margin;
+    width = (int)std::ceil((high.x - low.x + 2.0f * margin) / NAV_CELL_SIZE);
+    height = (int)std::ceil((high.z - low.z + 2.0f * margin) / NAV_CELL_SIZE);
+    walkable.assign(width * height, 0);
+    cellRoom.assign(width * height, -1);
+
+    // Room floors, kept a robot radius away from the walls
+    float inner = NAV_ROOM_HALF_SIZE - NAV_ROBOT_RADIUS;
+    for (size_t r = 0; r < roomOrigins.size(); r++) {
+        const glm::vec3& origin = roomOrigins[r];
+        CellRect rect = cellRect(origin.x - NAV_ROOM_HALF_SIZE, origin.z - NAV_ROOM_HALF_SIZE,
+            origin.x + NAV_ROOM_HALF_SIZE, origin.z + NAV_ROOM_HALF_SIZE);
+        roomRects.push_back(rect);
+        roomPortals.push_back(std::vector<int>());
+
+        for (int z = rect.z0; z <= rect.z1; z++) {
+            for (int x = rect.x0; x <= rect.x1; x++) {
+                glm::vec3 center = cellCenter(z * width + x);
+                if (std::fabs(center.x - origin.x) <= inner && std::fabs(center.z - origin.z) <= inner) {
+                    walkable[z * width + x] = 1;
+                }
+            }
+        }
+    }
+
+    // Doorways in the middle of the walls between neighbouring rooms
+    float doorHalfWidth = NAV_DOOR_HALF_WIDTH - NAV_ROBOT_RADIUS;
+    for (size_t a = 0; a < roomOrigins.size(); a++) {
+        for (size_t b = a + 1; b < roomOrigins.size(); b++) {
+            glm::vec3 offset = roomOrigins[b] - roomOrigins[a];
+            bool alongX = std::fabs(offset.z) < 0.5f && std::fabs(offset.x) > 2.0f * NAV_ROOM_HALF_SIZE
+                && std::fabs(offset.x) <= NAV_MAX_ROOM_SPACING;
+            bool alongZ = std::fabs(offset.x) < 0.5f && std::fabs(offset.z) > 2.0f * NAV_ROOM_HALF_SIZE
+                && std::fabs(offset.z) <= NAV_MAX_ROOM_SPACING;
+            if (!alongX && !alongZ) continue;
+
+            // Corridor from one floor to the other through the gap between the walls
+            glm::vec3 middle = (roomOrigins[a] + roomOrigins[b]) * 0.5f;
+            float halfLength = (alongX ? std::fabs(offset.x) : std::fabs(offset.z)) * 0.5f - inner + NAV_CELL_SIZE;
+            float halfX = alongX ? halfLength : doorHalfWidth;
+            float halfZ = alongX ? doorHalfWidth : halfLength;
+            CellRect corridor = cellRect(middle.x - halfX, middle.z - halfZ, middle.x + halfX, middle.z + halfZ);
+            for (int z = corridor.z0; z <= corridor.z1; z++) {
+                for (int x = corridor.x0; x <= corridor.x1; x++) {
+                    glm::vec3 center = cellCenter(z * width + x);
+                    if (std::fabs(center.x - middle.x) <= halfX && std::fabs(center.z - middle.z) <= halfZ) {
+                        walkable[z * width + x] = 1;
+                    }
+                }
+            }
+
+            // The doorway center is a portal of both rooms, their search areas grow to reach it
+            Portal portal;
+            portal.cell = cellAt(middle);
+            portals.push_back(portal);
+            int portalX = portal.cell % width;
+            int portalZ = portal.cell / width;
+            size_t pair[2] = { a, b };
+            for (int i = 0; i < 2; i++) {
+                CellRect& rect = roomRects[pair[i]];
+                rect.x0 = portalX < rect.x0 ? portalX : rect.x0;
+                rect.z0 = portalZ < rect.z0 ? portalZ : rect.z0;
+                rect.x1 = portalX > rect.x1 ? portalX : rect.x1;
+                rect.z1 = portalZ > rect.z1 ? portalZ : rect.z1;
+                roomPortals[pair[i]].push_back((int)portals.size() - 1);
+            }
+        }
+    }
+
+    // Cluster of every cell (doorway cells belong to the first room that reaches them)
+    for (size_t r = 0; r < roomRects.size(); r++) {
+        const CellRect& rect = roomRects[r];
+        for (int z = rect.z0; z <= rect.z1; z++) {
+            for (int x = rect.x0; x <= rect.x1; x++) {
+                if (cellRoom[z * width + x] < 0) cellRoom[z * width + x] = (int)r;
+            }
+        }
+    }
+
+    // Exhibit footprints, grown by the robot radius
+    for (size_t i = 0; i < obstacles.size(); i++) {
+        const glm::vec3& center = obstacles[i].center;
+        float radius = obstacles[i].radius + NAV_ROBOT_RADIUS;
+        CellRect rect = cellRect(center.x - radius, center.z - radius, center.x + radius, center.z + radius);
+        for (int z = rect.z0; z <= rect.z1; z++) {
+            for (int x = rect.x0; x <= rect.x1; x++) {
+                glm::vec3 offset = cellCenter(z * width + x) - glm::vec3(center.x, 0.0f, center.z);
+                if (glm::dot(offset, offset) <= radius * radius) walkable[z * width + x] = 0;
+            }
+        }
+    }
+
+    // Scratch memory, allocated once
+    gScore.assign(walkable.size(), 0.0f);
+    parent.assign(walkable.size(), -1);
+    openStamp.assign(walkable.size(), 0);
+    closedStamp.assign(walkable.size(), 0);
+    portalCost.assign(portals.size(), 0.0f);
+    portalGoalCost.assign(portals.size(), 0.0f);
+    portalParent.assign(portals.size(), -1);
+    portalParentEdge.assign(portals.size(), -1);
+    portalOpenStamp.assign(portals.size(), 0);
+    portalClosedStamp.assign(portals.size(), 0);
+    portalGoalStamp.assign(portals.size(), 0);
+
+    // Distance fields of every doorway over its rooms, then the doorway to doorway routes
+    // (the edges of the portal graph) read from them
+    roomFields.resize(roomRects.size());
+    for (size_t r = 0; r < roomRects.size(); r++) {
+        const CellRect& rect = roomRects[r];
+        const std::vector<int>& list = roomPortals[r];
+        int rectWidth = rect.x1 - rect.x0 + 1;
+        int rectCells = rectWidth * (rect.z1 - rect.z0 + 1);
+        roomFields[r].assign(rectCells * list.size(), -1.0f);
+
+        for (size_t k = 0; k < list.size(); k++) {
+            int portalCell = portals[list[k]].cell;
+            if (!walkable[portalCell]) continue;
+            search(portalCell, -1, rect);
+
+            float* field = &roomFields[r][k * rectCells];
+            for (int z = rect.z0; z <= rect.z1; z++) {
+                for (int x = rect.x0; x <= rect.x1; x++) {
+                    int cell = z * width + x;
+                    if (closedStamp[cell] == stamp) field[(z - rect.z0) * rectWidth + (x - rect.x0)] = gScore[cell];
+                }
+            }
+        }
+
+        for (size_t i = 0; i < list.size(); i++) {
+            for (size_t k = 0; k < list.size(); k++) {
+                float cost = fieldCost((int)r, (int)k, portals[list[i]].cell);
+                if (i == k || cost < 0.0f) continue;
+                PortalEdge edge;
+                edge.to = list[k];
+                edge.cost = cost;
+                descend((int)r, (int)k, portals[list[i]].cell, routeCells);
+                appendSmoothed(routeCells, edge.waypoints);
+                portals[list[i]].edges.push_back(edge);
+            }
+        }
+    }
+}
+
+int NavGrid::cellAt(const glm::vec3& position) const {
+    int x = (int)std::floor((position.x - minX) / NAV_CELL_SIZE);
+    int z = (int)std::floor((position.z - minZ) / NAV_CELL_SIZE);
+    x = x < 0 ? 0 : (x >= width ? width - 1 : x);
+    z = z < 0 ? 0 : (z >= height ? height - 1 : z);
+    return z * width + x;
+}
+
+glm::vec3 NavGrid::cellCenter(int cell) const {
+    return glm::vec3(minX + (cell % width + 0.5f) * NAV_CELL_SIZE, 0.0f, minZ + (cell / width + 0.5f) * NAV_CELL_SIZE);
+}
+
+NavGrid::CellRect NavGrid::cellRect(float x0, float z0, float x1, float z1) const {
+    int low = cellAt(glm::vec3(x0, 0.0f, z0));
+    int high = cellAt(glm::vec3(x1, 0.0f, z1));
+    CellRect rect = { low % width, low / width, high % width, high / width };
+    return rect;
+}
+
+int NavGrid::nearestWalkableCell(int cell) const {
+    if (walkable[cell]) return cell;
+
+    // Rings of growing size around the cell, the closest walkable cell of the first ring with one wins
+    int cellX = cell % width;
+    int cellZ = cell / width;
+    for (int ring = 1; ring <= NAV_NEAREST_RADIUS; ring++) {
+        int best = -1;
+        int bestDistance = 0;
+        for (int z = cellZ - ring; z <= cellZ + ring; z++) {
+            for (int x = cellX - ring; x <= cellX + ring; x++) {
+                // Only the border of the ring, the inside was searched before
+                if (z != cellZ - ring && z != cellZ + ring && x != cellX - ring && x != cellX + ring) continue;
+                if (x < 0 || z < 0 || x >= width || z >= height || !walkable[z * width + x]) continue;
+                int distance = (x - cellX) * (x - cellX) + (z - cellZ) * (z - cellZ);
+                if (best < 0 || distance < bestDistance) {
+                    best = z * width + x;
+                    bestDistance = distance;
+                }
+            }
+        }
+        if (best >= 0) return best;
+    }
+    return -1;
+}
+
+glm::vec3 NavGrid::nearestWalkable(const glm::vec3& position) const {
+    int cell = cellAt(position);
+    int nearest = nearestWalkableCell(cell);
+    if (nearest < 0 || nearest == cell) return glm::vec3(position.x, 0.0f, position.z);
+    return cellCenter(nearest);
+}
+
+// Octile distance between two cells, a consistent A* heuristic on an 8-connected grid
+static float octileDistance(int from, int to, int width) {
+    int dx = std::abs(from % width - to % width);
+    int dz = std::abs(from / width - to / width);
+    int shorter = dx < dz ? dx : dz;
+    return (dx + dz) * NAV_STRAIGHT + shorter * (NAV_DIAGONAL - 2.0f * NAV_STRAIGHT);
+}
+
+bool NavGrid::search(int startCell, int goalCell, const CellRect& rect) {
+    // New stamp instead of clearing the scratch arrays
+    if (++stamp == 0) {
+        std::fill(openStamp.begin(), openStamp.end(), 0u);
+        std::fill(closedStamp.begin(), closedStamp.end(), 0u);
+        stamp = 1;
+    }
+
+    heap.clear();
+    gScore[startCell] = 0.0f;
+    parent[startCell] = -1;
+    openStamp[startCell] = stamp;
+    heap.push_back({ goalCell >= 0 ? octileDistance(startCell, goalCell, width) : 0.0f, startCell });
+
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+        int cell = heap.back().index;
+        heap.pop_back();
+        if (closedStamp[cell] == stamp) continue;   // Outdated entry
+        closedStamp[cell] = stamp;
+        if (cell == goalCell) return true;
+
+        int x = cell % width;
+        int z = cell / width;
+        for (int d = 0; d < 8; d++) {
+            int nextX = x + NEIGHBOUR_X[d];
+            int nextZ = z + NEIGHBOUR_Z[d];
+            if (nextX < rect.x0 || nextX > rect.x1 || nextZ < rect.z0 || nextZ > rect.z1) continue;
+            int next = nextZ * width + nextX;
+            if (!walkable[next] || closedStamp[next] == stamp) continue;
+
+            // Diagonal steps must not cut the corner of a wall or footprint
+            if (d >= 4 && (!walkable[z * width + nextX] || !walkable[nextZ * width + x])) continue;
+
+            float cost = gScore[cell] + (d >= 4 ? NAV_DIAGONAL : NAV_STRAIGHT);
+            if (openStamp[next] == stamp && cost >= gScore[next]) continue;
+            openStamp[next] = stamp;
+            gScore[next] = cost;
+            parent[next] = cell;
+            heap.push_back({ cost + (goalCell >= 0 ? octileDistance(next, goalCell, width) : 0.0f), next });
+            std::push_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+        }
+    }
+    return false;
+}
+
+float NavGrid::fieldCost(int room, int k, int cell) const {
+    const CellRect& rect = roomRects[room];
+    int rectWidth = rect.x1 - rect.x0 + 1;
+    const float* field = &roomFields[room][k * rectWidth * (rect.z1 - rect.z0 + 1)];
+    int x = cell % width;
+    int z = cell / width;
+    if (x < rect.x0 || x > rect.x1 || z < rect.z0 || z > rect.z1) return -1.0f;
+    float cost = field[(z - rect.z0) * rectWidth + (x - rect.x0)];
+    if (cost >= 0.0f) return cost;
+
+    // A robot standing on a blocked cell (e.g. pushed into a footprint) steps off it first
+    for (int d = 0; d < 8; d++) {
+        int nextX = x + NEIGHBOUR_X[d];
+        int nextZ = z + NEIGHBOUR_Z[d];
+        if (nextX < rect.x0 || nextX > rect.x1 || nextZ < rect.z0 || nextZ > rect.z1) continue;
+        float next = field[(nextZ - rect.z0) * rectWidth + (nextX - rect.x0)];
+        if (next < 0.0f) continue;
+        next += d >= 4 ? NAV_DIAGONAL : NAV_STRAIGHT;
+        if (cost < 0.0f || next < cost) cost = next;
+    }
+    return cost;
+}
+
+void NavGrid::descend(int room, int k, int cell, std::vector<int>& cells) const {
+    const CellRect& rect = roomRects[room];
+    int rectWidth = rect.x1 - rect.x0 + 1;
+    int rectCells = rectWidth * (rect.z1 - rect.z0 + 1);
+    const float* field = &roomFields[room][k * rectCells];
+    int target = portals[roomPortals[room][k]].cell;
+
+    // Always the neighbour closest to the doorway: a shortest route without stored parents
+    cells.clear();
+    cells.push_back(cell);
+    while (cell != target && (int)cells.size() <= rectCells) {
+        int x = cell % width;
+        int z = cell / width;
+        int best = -1;
+        float bestCost = 0.0f;
+        for (int d = 0; d < 8; d++) {
+            int nextX = x + NEIGHBOUR_X[d];
+            int nextZ = z + NEIGHBOUR_Z[d];
+            if (nextX < rect.x0 || nextX > rect.x1 || nextZ < rect.z0 || nextZ > rect.z1) continue;
+            float cost = field[(nextZ - rect.z0) * rectWidth + (nextX - rect.x0)];
+            if (cost < 0.0f) continue;
+            if (d >= 4 && walkable[cell] && (!walkable[z * width + nextX] || !walkable[nextZ * width + x])) continue;
+            cost += d >= 4 ? NAV_DIAGONAL : NAV_STRAIGHT;
+            if (best < 0 || cost < bestCost) {
+                best = nextZ * width + nextX;
+                bestCost = cost;
+            }
+        }
+        if (best < 0) break;
+        cell = best;
+        cells.push_back(cell);
+    }
+}
+
+void NavGrid::tracePath(int cell, std::vector<int>& cells) const {
+    cells.clear();
+    for (int c = cell; c >= 0; c = parent[c]) cells.push_back(c);
+    std::reverse(cells.begin(), cells.end());
+}
+
+void NavGrid::seedPortalSearch(int startRoom, int startCell, int goalCell) {
+    // New portal stamp for the graph search
+    if (++portalStamp == 0) {
+        std::fill(portalOpenStamp.begin(), portalOpenStamp.end(), 0u);
+        std::fill(portalClosedStamp.begin(), portalClosedStamp.end(), 0u);
+        std::fill(portalGoalStamp.begin(), portalGoalStamp.end(), 0u);
+        portalStamp = 1;
+    }
+
+    // Distances from the start to the doorways of its room are the starting costs
+    heap.clear();
+    const std::vector<int>& startPortals = roomPortals[startRoom];
+    for (size_t k = 0; k < startPortals.size(); k++) {
+        float cost = fieldCost(startRoom, (int)k, startCell);
+        if (cost < 0.0f) continue;
+        int p = startPortals[k];
+        portalOpenStamp[p] = portalStamp;
+        portalCost[p] = cost;
+        portalParent[p] = -1;
+        portalParentEdge[p] = (int)k;   // Doorway of the start room
+        heap.push_back({ cost + (goalCell >= 0 ? octileDistance(portals[p].cell, goalCell, width) : 0.0f), p });
+        std::push_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+    }
+}
+
+int NavGrid::portalSearch(int goalCell) {
+    // A* over the doorways until no cheaper way to a goal doorway is left
+    float bestCost = 0.0f;
+    int bestPortal = -1;
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+        HeapEntry entry = heap.back();
+        heap.pop_back();
+        int p = entry.index;
+        if (portalClosedStamp[p] == portalStamp) continue;
+        portalClosedStamp[p] = portalStamp;
+        if (bestPortal >= 0 && entry.priority >= bestCost) break;
+
+        if (portalGoalStamp[p] == portalStamp) {
+            float total = portalCost[p] + portalGoalCost[p];
+            if (bestPortal < 0 || total < bestCost) {
+                bestCost = total;
+                bestPortal = p;
+            }
+        }
+
+        const std::vector<PortalEdge>& edges = portals[p].edges;
+        for (size_t e = 0; e < edges.size(); e++) {
+            int next = edges[e].to;
+            float cost = portalCost[p] + edges[e].cost;
+            if (portalClosedStamp[next] == portalStamp) continue;
+            if (portalOpenStamp[next] == portalStamp && cost >= portalCost[next]) continue;
+            portalOpenStamp[next] = portalStamp;
+            portalCost[next] = cost;
+            portalParent[next] = p;
+            portalParentEdge[next] = (int)e;
+            heap.push_back({ cost + (goalCell >= 0 ? octileDistance(portals[next].cell, goalCell, width) : 0.0f), next });
+            std::push_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+        }
+    }
+    return bestPortal;
+}
+
+bool NavGrid::planRoute(int startCell, int goalCell, std::vector<glm::vec3>& path) {
+    int startRoom = cellRoom[startCell];
+    int goalRoom = cellRoom[goalCell];
+    if (startRoom < 0 || goalRoom < 0) return false;
+
+    // Same room: one search (when the room itself connects them)
+    if (startRoom == goalRoom && search(startCell, goalCell, roomRects[startRoom])) {
+        tracePath(goalCell, routeCells);
+        appendSmoothed(routeCells, path);
+        return true;
+    }
+
+    const std::vector<int>& goalPortals = roomPortals[goalRoom];
+
+    // Distances from the start to the doorways of its room, then to the doorways of the goal room
+    seedPortalSearch(startRoom, startCell, goalCell);
+    for (size_t k = 0; k < goalPortals.size(); k++) {
+        float cost = fieldCost(goalRoom, (int)k, goalCell);
+        if (cost < 0.0f) continue;
+        portalGoalStamp[goalPortals[k]] = portalStamp;
+        portalGoalCost[goalPortals[k]] = cost;
+    }
+    int bestPortal = portalSearch(goalCell);
+    if (bestPortal < 0) return false;
+
+    // Doorways from the start room to the goal room
+    portalChain.clear();
+    for (int p = bestPortal; p >= 0; p = portalParent[p]) portalChain.push_back(p);
+    std::reverse(portalChain.begin(), portalChain.end());
+
+    // Start leg, then the stored doorway to doorway routes, then the goal leg backwards.
+    // Every doorway stays a corner of the route, only the first and last legs are smoothed here.
+    descend(startRoom, portalParentEdge[portalChain[0]], startCell, routeCells);
+    appendSmoothed(routeCells, path);
+    for (size_t i = 1; i < portalChain.size(); i++) {
+        const PortalEdge& edge = portals[portalChain[i - 1]].edges[portalParentEdge[portalChain[i]]];
+        path.insert(path.end(), edge.waypoints.begin(), edge.waypoints.end());
+    }
+    for (size_t k = 0; k < goalPortals.size(); k++) {
+        if (goalPortals[k] != bestPortal) continue;
+        descend(goalRoom, (int)k, goalCell, routeCells);
+        std::reverse(routeCells.begin(), routeCells.end());
+        appendSmoothed(routeCells, path);
+        break;
+    }
+    return true;
+}
+
+bool NavGrid::lineOfSight(int fromCell, int toCell) const {
+    // Samples every quarter cell along the line between the cell centers
+    float fromX = fromCell % width + 0.5f;
+    float fromZ = fromCell / width + 0.5f;
+    float dx = toCell % width + 0.5f - fromX;
+    float dz = toCell / width + 0.5f - fromZ;
+    float longest = std::fabs(dx) > std::fabs(dz) ? std::fabs(dx) : std::fabs(dz);
+    int steps = (int)(longest * 4.0f) + 1;
+
+    for (int i = 1; i <= steps; i++) {
+        float t = (float)i / steps;
+        int cell = (int)(fromZ + dz * t) * width + (int)(fromX + dx * t);
+        if (!walkable[cell]) return false;
+    }
+    return true;
+}
+
+void NavGrid::appendSmoothed(const std::vector<int>& cells, std::vector<glm::vec3>& path) const {
+    if (cells.size() < 2) return;
+
+    // Keeps only the corners: a cell is skipped while the last corner still sees the next cell
+    size_t anchor = 0;
+    for (size_t i = 2; i < cells.size(); i++) {
+        if (!lineOfSight(cells[anchor], cells[i])) {
+            anchor = i - 1;
+            path.push_back(cellCenter(cells[anchor]));
+        }
+    }
+    path.push_back(cellCenter(cells.back()));
+}
+
+bool NavGrid::findPath(const glm::vec3& start, const glm::vec3& goal, std::vector<glm::vec3>& path) {
+    PROFILE_SCOPE("NavGrid::findPath");
+    path.clear();
+
+    int startCell = cellAt(start);
+    int exactGoalCell = cellAt(goal);
+    int goalCell = nearestWalkableCell(exactGoalCell);
+    if (goalCell < 0) return false;
+
+    long long key = (long long)startCell * (long long)walkable.size() + goalCell;
+    std::unordered_map<long long, std::vector<glm::vec3> >::const_iterator cached = cache.find(key);
+    if (cached != cache.end()) {
+        cacheHits++;
+        path = cached->second;
+    }
+    else {
+        cacheMisses++;
+        if (!planRoute(startCell, goalCell, path)) {
+            path.clear();
+            return false;
+        }
+        if (path.empty()) path.push_back(cellCenter(goalCell));  // Start and goal share a cell
+
+        if (cache.size() >= NAV_PATH_CACHE_SIZE) cache.clear();
+        cache[key] = path;
+    }
+
+    // The route ends exactly at the goal when the goal itself is walkable
+    if (goalCell == exactGoalCell) path.back() = glm::vec3(goal.x, 0.0f, goal.z);
+    return true;
+}
+
+void NavGrid::measureDistances(const glm::vec3& from, const std::vector<glm::vec3>& targets, std::vector<float>& distances) {
+    PROFILE_SCOPE("NavGrid::measureDistances");
+    distances.resize(targets.size());
+    int startCell = cellAt(from);
+    int startRoom = cellRoom[startCell];
+
+    // Every doorway's distance from the start, and every cell of the start room
+    if (startRoom >= 0) {
+        seedPortalSearch(startRoom, startCell, -1);
+        portalSearch(-1);
+        search(startCell, -1, roomRects[startRoom]);
+    }
+
+    for (size_t i = 0; i < targets.size(); i++) {
+        glm::vec3 offset = targets[i] - from;
+        float straight = std::sqrt(offset.x * offset.x + offset.z * offset.z);
+        int cell = nearestWalkableCell(cellAt(targets[i]));
+        distances[i] = straight;    // Robots walk straight where there is no route
+        if (startRoom < 0 || cell < 0 || cellRoom[cell] < 0) continue;
+
+        // Shortest of the way inside the start room and the ways through every doorway of the target room
+        int room = cellRoom[cell];
+        float best = (room == startRoom && closedStamp[cell] == stamp) ? gScore[cell] : -1.0f;
+        const std::vector<int>& list = roomPortals[room];
+        for (size_t k = 0; k < list.size(); k++) {
+            if (portalClosedStamp[list[k]] != portalStamp) continue;
+            float cost = fieldCost(room, (int)k, cell);
+            if (cost < 0.0f) continue;
+            cost += portalCost[list[k]];
+            if (best < 0.0f || cost < best) best = cost;
+        }
+        if (best >= 0.0f) distances[i] = best * NAV_CELL_SIZE;
+    }
+}
+
+void NavGrid::buildFlowField(const glm::vec3& goal, std::vector<unsigned char>& field) {
+    PROFILE_SCOPE("NavGrid::buildFlowField");
+    field.assign(walkable.size(), NAV_FLOW_NONE);
+    int goalCell = nearestWalkableCell(cellAt(goal));
+    if (goalCell < 0) return;
+
+    // Dijkstra outward from the goal: every cell's parent is its next step toward the goal
+    CellRect all = { 0, 0, width - 1, height - 1 };
+    search(goalCell, -1, all);
+    for (size_t cell = 0; cell < walkable.size(); cell++) {
+        if (closedStamp[cell] != stamp || parent[cell] < 0) continue;
+        int dx = parent[cell] % width - (int)cell % width;
+        int dz = parent[cell] / width - (int)cell / width;
+        for (int d = 0; d < 8; d++) {
+            if (NEIGHBOUR_X[d] == dx && NEIGHBOUR_Z[d] == dz) field[cell] = (unsigned char)d;
+        }
+    }
+    field[goalCell] = NAV_FLOW_GOAL;
+}
+
+glm::vec3 NavGrid::flowDirection(const std::vector<unsigned char>& field, const glm::vec3& position) const {
+    // Unit vectors of the neighbour steps
+    static const float DIAGONAL = 0.70710678f;
+    static const float DIRECTION_X[8] = { 1.0f, -1.0f, 0.0f, 0.0f, DIAGONAL, DIAGONAL, -DIAGONAL, -DIAGONAL };
+    static const float DIRECTION_Z[8] = { 0.0f, 0.0f, 1.0f, -1.0f, DIAGONAL, -DIAGONAL, DIAGONAL, -DIAGONAL };
+
+    unsigned char step = field[cellAt(position)];
+    if (step >= 8) return glm::vec3(0.0f);
+    return glm::vec3(DIRECTION_X[step], 0.0f, DIRECTION_Z[step]);
+}
+
+bool NavGrid::isWalkable(const glm::vec3& position) const {
+    int x = (int)std::floor((position.x - minX) / NAV_CELL_SIZE);
+    int z = (int)std::floor((position.z - minZ) / NAV_CELL_SIZE);
+    if (x < 0 || z < 0 || x >= width || z >= height) return false;
+    return walkable[z * width + x] != 0;
+}
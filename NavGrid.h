@@ -0,0 +1,140 @@
+#ifndef NAVGRID_H
+#define NAVGRID_H
+
+#include <glm/glm.hpp>
+#include <unordered_map>
+#include <vector>
+
+// Flow field entries besides the eight neighbour steps (see NavGrid::buildFlowField)
+#define NAV_FLOW_GOAL 8
+#define NAV_FLOW_NONE 255
+
+// Circle on the floor that robots have to walk around (an exhibit footprint)
+struct NavObstacle {
+    glm::vec3 center;   // y is ignored
+    float radius;
+};
+
+// Walkable floor of the museum as an occupancy grid, built from the room walls
+// and the exhibit footprints. Every room is a cluster of cells and neighbouring
+// rooms are joined by a doorway whose center cell is a portal. The walking
+// distance from every doorway to every cell of its rooms is computed once, so
+// routes between rooms are a small search over the doorways plus lookups; only
+// routes inside a single room run A* (over that room's cells alone).
+// Not thread-safe (queries share scratch memory): used by the simulation only.
+class NavGrid {
+public:
+    // - roomOrigins: centers of the 10x10 rooms
+    // - obstacles: exhibit footprints
+    NavGrid(const std::vector<glm::vec3>& roomOrigins, const std::vector<NavObstacle>& obstacles);
+
+    // Smoothed route from start to goal on the floor (y = 0), without the start itself
+    // Routes are cached per start and goal cell, so repeated stop-to-stop trips cost a copy
+    // Returns false (and an empty path) when the goal cannot be reached
+    bool findPath(const glm::vec3& start, const glm::vec3& goal, std::vector<glm::vec3>& path);
+
+    // Walking distances in meters from one point to many (e.g. for ordering a tour)
+    // Straight-line distance for targets without a route
+    void measureDistances(const glm::vec3& from, const std::vector<glm::vec3>& targets, std::vector<float>& distances);
+
+    // Walkable point nearest to position (e.g. where to stand in front of an exhibit)
+    glm::vec3 nearestWalkable(const glm::vec3& position) const;
+
+    // Flow field toward goal over the whole grid, for crowds that share a destination:
+    // one byte per cell, the neighbour step (0..7) toward the goal, NAV_FLOW_GOAL or NAV_FLOW_NONE
+    void buildFlowField(const glm::vec3& goal, std::vector<unsigned char>& field);
+
+    // Unit direction a flow field gives at position (zero at the goal or without a route)
+    // Only reads the grid, so crowds may call it from several threads
+    glm::vec3 flowDirection(const std::vector<unsigned char>& field, const glm::vec3& position) const;
+    bool isWalkable(const glm::vec3& position) const;
+
+    // Drops all cached routes
+    void clearCache() { cache.clear(); }
+
+    // Statistics
+    long long getCacheHits() const { return cacheHits; }
+    long long getCacheMisses() const { return cacheMisses; }
+    int getCellCount() const { return (int)walkable.size(); }
+    int getPortalCount() const { return (int)portals.size(); }
+
+private:
+    // Inclusive cell bounds
+    struct CellRect {
+        int x0, z0, x1, z1;
+    };
+
+    // Route between two doorways of the same room
+    struct PortalEdge {
+        int to;                             // Portal index
+        float cost;                         // Length in cells
+        std::vector<glm::vec3> waypoints;   // Smoothed, from this doorway (excluded) to the other one
+    };
+
+    struct Portal {
+        int cell;
+        std::vector<PortalEdge> edges;
+    };
+
+    struct HeapEntry {
+        float priority;
+        int index;
+        bool operator>(const HeapEntry& other) const { return priority > other.priority; }
+    };
+
+    // Grid
+    float minX, minZ;                       // World position of the grid corner
+    int width, height;
+    std::vector<unsigned char> walkable;
+    std::vector<int> cellRoom;              // Room cluster of every cell, -1 outside all rooms
+    std::vector<CellRect> roomRects;        // Cells searched for routes inside a room
+    std::vector<std::vector<int> > roomPortals;
+    std::vector<Portal> portals;
+
+    // Per room and doorway: distance of every cell of the room rect to the doorway (negative = unreachable)
+    std::vector<std::vector<float> > roomFields;
+
+    // Search scratch, reused by every query (stamps replace clearing)
+    std::vector<float> gScore;
+    std::vector<int> parent;
+    std::vector<unsigned int> openStamp, closedStamp;
+    unsigned int stamp;
+    std::vector<HeapEntry> heap;
+
+    // Portal graph scratch
+    std::vector<float> portalCost, portalGoalCost;
+    std::vector<int> portalParent, portalParentEdge;
+    std::vector<unsigned int> portalOpenStamp, portalClosedStamp, portalGoalStamp;
+    unsigned int portalStamp;
+    std::vector<int> routeCells, portalChain;
+
+    // Smoothed routes by start and goal cell
+    std::unordered_map<long long, std::vector<glm::vec3> > cache;
+    long long cacheHits, cacheMisses;
+
+    int cellAt(const glm::vec3& position) const;
+    glm::vec3 cellCenter(int cell) const;
+    CellRect cellRect(float x0, float z0, float x1, float z1) const;
+    int nearestWalkableCell(int cell) const;
+
+    // A* from startCell to goalCell inside rect, or Dijkstra over the whole rect when goalCell < 0
+    // Returns true when goalCell was reached
+    bool search(int startCell, int goalCell, const CellRect& rect);
+    void tracePath(int cell, std::vector<int>& cells) const;   // Start to cell, after search
+
+    // Distance field of doorway k of a room
+    float fieldCost(int room, int k, int cell) const;                   // Negative when unreachable
+    void descend(int room, int k, int cell, std::vector<int>& cells) const;   // Cell to the doorway
+    bool planRoute(int startCell, int goalCell, std::vector<glm::vec3>& path);
+
+    // Doorway graph search: seeds the doorways of the start room, then A* toward goalCell
+    // (whose doorways are marked in portalGoalStamp) or, with goalCell < 0, every doorway
+    void seedPortalSearch(int startRoom, int startCell, int goalCell);
+    int portalSearch(int goalCell);     // Goal doorway of the best route, -1 if none
+    bool lineOfSight(int fromCell, int toCell) const;
+
+    // Appends the corners of a cell route (without its first cell) to path
+    void appendSmoothed(const std::vector<int>& cells, std::vector<glm::vec3>& path) const;
+};
+
+#endif
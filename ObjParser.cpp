@@ -0,0 +1,327 @@
+#include "ObjParser.h"
+#include "MappedFile.h"
+#include "JobSystem.h"
+#include "CpuProfiler.h"
+#include <cstring>
+#include <iostream>
+
+// Smallest chunk parsed by one job (smaller files are parsed in fewer chunks)
+static const size_t OBJ_MIN_CHUNK_BYTES = 256 * 1024;
+
+// Chunks per thread, so threads that finish early can steal the rest
+static const int OBJ_CHUNKS_PER_THREAD = 4;
+
+// Corner of a triangle: position and normal index (-1 = none). Relative (negative)
+// indices are resolved against the chunk's own counts and flagged, the merge adds
+// the number of positions and normals of the chunks before it.
+struct ObjCorner {
+    int position;
+    int normal;
+    unsigned char relative;     // OBJ_RELATIVE_POSITION | OBJ_RELATIVE_NORMAL
+};
+
+static const unsigned char OBJ_RELATIVE_POSITION = 1;
+static const unsigned char OBJ_RELATIVE_NORMAL = 2;
+
+// One line-aligned part of the file and what was parsed from it
+struct ObjChunk {
+    const char* begin;
+    const char* end;
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    std::vector<ObjCorner> corners;     // Three per triangle
+    bool invalidIndex;
+
+    // Filled in before the merge: items of all chunks before this one
+    int positionBase;
+    int normalBase;
+    size_t vertexBase;
+};
+
+// Shared state of the parallel passes
+struct ObjParse {
+    std::vector<ObjChunk> chunks;
+    std::vector<glm::vec3> positions;   // All chunks, in file order
+    std::vector<glm::vec3> normals;
+    std::vector<Vertex>* vertices;
+};
+
+// Powers of ten for the float parser
+static const double OBJ_POWERS_OF_TEN[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static double powerOfTen(int exponent) {
+    double scale = 1.0;
+    int magnitude = exponent < 0 ? -exponent : exponent;
+    while (magnitude > 22) {
+        scale *= 1e22;
+        magnitude -= 22;
+    }
+    scale *= OBJ_POWERS_OF_TEN[magnitude];
+    return exponent < 0 ? 1.0 / scale : scale;
+}
+
+static bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static void skipBlanks(const char*& p, const char* end) {
+    while (p < end && isBlank(*p)) p++;
+}
+
+// Decimal float ("-1.25", "3", ".5", "1e-3"): digits go into an integer mantissa,
+// scaled once by a power of ten. Much faster than strtod, exact to float precision.
+static bool parseFloat(const char*& p, const char* end, float& value) {
+    skipBlanks(p, end);
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+
+    unsigned long long mantissa = 0;
+    int exponent = 0, digits = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++, digits++) {
+        if (mantissa < 100000000000000000ull) mantissa = mantissa * 10 + (*p - '0');
+        else exponent++;    // Digits past the precision only scale
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++, digits++) {
+            if (mantissa < 100000000000000000ull) {
+                mantissa = mantissa * 10 + (*p - '0');
+                exponent--;
+            }
+        }
+    }
+    if (digits == 0) return false;
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char* start = p++;
+        bool negativeExponent = false;
+        if (p < end && (*p == '-' || *p == '+')) negativeExponent = *p++ == '-';
+        int power = 0;
+        if (p < end && *p >= '0' && *p <= '9') {
+            for (; p < end && *p >= '0' && *p <= '9'; p++) {
+                if (power < 10000) power = power * 10 + (*p - '0');
+            }
+            exponent += negativeExponent ? -power : power;
+        }
+        else p = start;     // Not an exponent after all
+    }
+
+    double result = (double)mantissa;
+    if (exponent != 0) result *= powerOfTen(exponent);
+    value = (float)(negative ? -result : result);
+    return true;
+}
+
+static bool parseInt(const char*& p, const char* end, int& value) {
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+    if (p >= end || *p < '0' || *p > '9') return false;
+    int result = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++) result = result * 10 + (*p - '0');
+    value = negative ? -result : result;
+    return true;
+}
+
+// One face corner "v", "v/vt", "v//vn" or "v/vt/vn"; indices become 0-based
+static bool parseCorner(const char*& p, const char* end, const ObjChunk& chunk, ObjCorner& corner) {
+    int position, normal = 0, texture;
+    if (!parseInt(p, end, position) || position == 0) return false;
+    if (p < end && *p == '/') {
+        p++;
+        if (p < end && *p != '/') parseInt(p, end, texture);   // Texture coordinates are not used
+        if (p < end && *p == '/') {
+            p++;
+            parseInt(p, end, normal);
+        }
+    }
+
+    corner.relative = 0;
+    if (position > 0) corner.position = position - 1;
+    else {
+        corner.position = (int)chunk.positions.size() + position;
+        corner.relative |= OBJ_RELATIVE_POSITION;
+    }
+    if (normal > 0) corner.normal = normal - 1;
+    else if (normal < 0) {
+        corner.normal = (int)chunk.normals.size() + normal;
+        corner.relative |= OBJ_RELATIVE_NORMAL;
+    }
+    else corner.normal = -1;
+    return true;
+}
+
+// Pass 1: positions, normals and triangles of each chunk
+static void parseChunks(void* data, int begin, int end) {
+    ObjParse& parse = *(ObjParse*)data;
+    for (int c = begin; c < end; c++) {
+        ObjChunk& chunk = parse.chunks[c];
+        const char* p = chunk.begin;
+        while (p < chunk.end) {
+            const char* lineEnd = (const char*)std::memchr(p, '\n', chunk.end - p);
+            if (!lineEnd) lineEnd = chunk.end;
+            skipBlanks(p, lineEnd);
+
+            if (lineEnd - p >= 2 && p[0] == 'v' && isBlank(p[1])) {
+                glm::vec3 position;
+                p++;
+                if (parseFloat(p, lineEnd, position.x) && parseFloat(p, lineEnd, position.y) && parseFloat(p, lineEnd, position.z)) {
+                    chunk.positions.push_back(position);
+                }
+                else chunk.positions.push_back(glm::vec3(0.0f));    // Keeps the numbering of the later positions
+            }
+            else if (lineEnd - p >= 3 && p[0] == 'v' && p[1] == 'n' && isBlank(p[2])) {
+                glm::vec3 normal;
+                p += 2;
+                if (parseFloat(p, lineEnd, normal.x) && parseFloat(p, lineEnd, normal.y) && parseFloat(p, lineEnd, normal.z)) {
+                    chunk.normals.push_back(normal);
+                }
+                else chunk.normals.push_back(glm::vec3(0.0f, 1.0f, 0.0f));
+            }
+            else if (lineEnd - p >= 2 && p[0] == 'f' && isBlank(p[1])) {
+                // Fan: first corner, previous corner, current corner
+                ObjCorner first, previous, corner;
+                int count = 0;
+                p++;
+                for (;;) {
+                    skipBlanks(p, lineEnd);
+                    if (p >= lineEnd || !parseCorner(p, lineEnd, chunk, corner)) break;
+                    if (count == 0) first = corner;
+                    else if (count >= 2) {
+                        chunk.corners.push_back(first);
+                        chunk.corners.push_back(previous);
+                        chunk.corners.push_back(corner);
+                    }
+                    previous = corner;
+                    count++;
+                }
+            }
+            p = lineEnd + 1;
+        }
+    }
+}
+
+// Pass 2: every chunk copies its positions and normals into the merged arrays
+static void gatherChunks(void* data, int begin, int end) {
+    ObjParse& parse = *(ObjParse*)data;
+    for (int c = begin; c < end; c++) {
+        ObjChunk& chunk = parse.chunks[c];
+        if (!chunk.positions.empty()) {
+            std::memcpy(&parse.positions[chunk.positionBase], chunk.positions.data(), chunk.positions.size() * sizeof(glm::vec3));
+        }
+        if (!chunk.normals.empty()) {
+            std::memcpy(&parse.normals[chunk.normalBase], chunk.normals.data(), chunk.normals.size() * sizeof(glm::vec3));
+        }
+    }
+}
+
+// Pass 3: triangles of every chunk become vertices, with flat normals where the file has none
+static void buildVertices(void* data, int begin, int end) {
+    ObjParse& parse = *(ObjParse*)data;
+    int positionCount = (int)parse.positions.size();
+    int normalCount = (int)parse.normals.size();
+    for (int c = begin; c < end; c++) {
+        ObjChunk& chunk = parse.chunks[c];
+        Vertex* out = parse.vertices->data() + chunk.vertexBase;
+        for (size_t t = 0; t + 2 < chunk.corners.size(); t += 3) {
+            int positions[3], normals[3];
+            for (int k = 0; k < 3; k++) {
+                const ObjCorner& corner = chunk.corners[t + k];
+                positions[k] = corner.position + ((corner.relative & OBJ_RELATIVE_POSITION) ? chunk.positionBase : 0);
+                normals[k] = corner.normal < 0 && !(corner.relative & OBJ_RELATIVE_NORMAL) ? -1 :
+                    corner.normal + ((corner.relative & OBJ_RELATIVE_NORMAL) ? chunk.normalBase : 0);
+                if (positions[k] < 0 || positions[k] >= positionCount || normals[k] >= normalCount ||
+                    (normals[k] < 0 && (corner.relative & OBJ_RELATIVE_NORMAL))) {
+                    chunk.invalidIndex = true;
+                    positions[k] = 0;
+                    normals[k] = -1;
+                }
+            }
+            if (chunk.invalidIndex) continue;
+
+            glm::vec3 faceNormal(0.0f);
+            if (normals[0] < 0 || normals[1] < 0 || normals[2] < 0) {
+                const glm::vec3& corner = parse.positions[positions[0]];
+                glm::vec3 cross = glm::cross(parse.positions[positions[1]] - corner, parse.positions[positions[2]] - corner);
+                float length = glm::length(cross);
+                faceNormal = length > 0.0f ? cross / length : glm::vec3(0.0f, 1.0f, 0.0f);
+            }
+            for (int k = 0; k < 3; k++) {
+                out[t + k].Position = parse.positions[positions[k]];
+                out[t + k].Normal = normals[k] >= 0 ? parse.normals[normals[k]] : faceNormal;
+            }
+        }
+    }
+}
+
+// Runs a pass over all chunks, on the job system when there is one
+static void runPass(JobSystem* jobs, ObjParse& parse, JobFunction function) {
+    int count = (int)parse.chunks.size();
+    if (jobs && count > 1) jobs->parallelFor(count, 1, function, &parse);
+    else function(&parse, 0, count);
+}
+
+bool parseObjFile(const std::string& path, std::vector<Vertex>& vertices, JobSystem* jobs) {
+    PROFILE_SCOPE("ObjParser::parse");
+    MappedFile file;
+    if (!file.open(path)) return false;
+    const char* text = (const char*)file.getData();
+    size_t size = file.getSize();
+
+    // Line-aligned chunks: every chunk but the last ends right after a newline
+    int threads = jobs ? jobs->getThreadCount() : 1;
+    size_t chunkCount = (size_t)threads * OBJ_CHUNKS_PER_THREAD;
+    if (chunkCount > size / OBJ_MIN_CHUNK_BYTES) chunkCount = size / OBJ_MIN_CHUNK_BYTES;
+    if (chunkCount < 1) chunkCount = 1;
+
+    ObjParse parse;
+    parse.vertices = &vertices;
+    const char* start = text;
+    for (size_t c = 0; c < chunkCount && start < text + size; c++) {
+        const char* stop = text + size * (c + 1) / chunkCount;
+        if (stop < start) stop = start;
+        const char* newline = (const char*)std::memchr(stop, '\n', text + size - stop);
+        stop = (c + 1 == chunkCount || !newline) ? text + size : newline + 1;
+
+        ObjChunk chunk;
+        chunk.begin = start;
+        chunk.end = stop;
+        chunk.invalidIndex = false;
+        parse.chunks.push_back(chunk);
+        start = stop;
+    }
+    runPass(jobs, parse, parseChunks);
+
+    // Where every chunk's items go in the merged arrays
+    size_t positionCount = 0, normalCount = 0, vertexCount = 0;
+    for (size_t c = 0; c < parse.chunks.size(); c++) {
+        ObjChunk& chunk = parse.chunks[c];
+        chunk.positionBase = (int)positionCount;
+        chunk.normalBase = (int)normalCount;
+        chunk.vertexBase = vertexCount;
+        positionCount += chunk.positions.size();
+        normalCount += chunk.normals.size();
+        vertexCount += chunk.corners.size();
+    }
+    parse.positions.resize(positionCount);
+    parse.normals.resize(normalCount);
+    runPass(jobs, parse, gatherChunks);
+
+    size_t first = vertices.size();
+    vertices.resize(first + vertexCount);
+    for (size_t c = 0; c < parse.chunks.size(); c++) parse.chunks[c].vertexBase += first;
+    runPass(jobs, parse, buildVertices);
+
+    for (size_t c = 0; c < parse.chunks.size(); c++) {
+        if (parse.chunks[c].invalidIndex) {
+            std::cerr << "ERROR::OBJ::INDEX_OUT_OF_RANGE: " << path << std::endl;
+            vertices.resize(first);
+            return false;
+        }
+    }
+    if (vertexCount == 0) {
+        std::cerr << "ERROR::OBJ::NO_TRIANGLES: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
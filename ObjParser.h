@@ -0,0 +1,20 @@
+#ifndef OBJPARSER_H
+#define OBJPARSER_H
+
+#include <string>
+#include <vector>
+#include "ModelLoader.h"
+
+class JobSystem;
+
+// Wavefront OBJ reader for large scan exports, used by ModelLoader instead of Assimp.
+// The file is memory-mapped and split into line-aligned chunks that are parsed in
+// parallel; the chunks are then merged into one triangle list (three vertices per
+// triangle, like Assimp's output). Faces with more corners are fanned into triangles.
+// Vertices without a normal get the flat normal of their triangle (as aiProcess_GenNormals).
+// Reads positions, normals and faces (v, vn, f with v, v/vt, v//vn and v/vt/vn corners,
+// negative indices too); everything else is skipped.
+// Returns false (after printing why) if the file cannot be read or an index is out of range.
+bool parseObjFile(const std::string& path, std::vector<Vertex>& vertices, JobSystem* jobs);
+
+#endif
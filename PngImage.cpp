@@ -0,0 +1,198 @@
+#include "PngImage.h"
+#include <fstream>
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+
+// Largest payload of one uncompressed deflate block
+static const size_t STORED_BLOCK_SIZE = 65535;
+
+static const unsigned char PNG_SIGNATURE[8] = { 137, 'P', 'N', 'G', '\r', '\n', 26, '\n' };
+
+// CRC-32 used by PNG chunks
+static unsigned int crc32(const unsigned char* data, size_t length, unsigned int crc = 0) {
+    static unsigned int table[256];
+    static bool tableReady = false;
+    if (!tableReady) {
+        for (unsigned int n = 0; n < 256; n++) {
+            unsigned int c = n;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[n] = c;
+        }
+        tableReady = true;
+    }
+
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+// Adler-32 checksum that ends a zlib stream
+static unsigned int adler32(const unsigned char* data, size_t length) {
+    unsigned int a = 1, b = 0;
+    for (size_t i = 0; i < length; i++) {
+        a = (a + data[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    return (b << 16) | a;
+}
+
+static void putBigEndian(std::vector<unsigned char>& out, unsigned int value) {
+    out.push_back((unsigned char)(value >> 24));
+    out.push_back((unsigned char)(value >> 16));
+    out.push_back((unsigned char)(value >> 8));
+    out.push_back((unsigned char)value);
+}
+
+static unsigned int getBigEndian(const unsigned char* p) {
+    return ((unsigned int)p[0] << 24) | ((unsigned int)p[1] << 16) | ((unsigned int)p[2] << 8) | p[3];
+}
+
+// Appends one chunk (length, type, data, CRC)
+static void writeChunk(std::ofstream& file, const char* type, const std::vector<unsigned char>& data) {
+    std::vector<unsigned char> chunk;
+    putBigEndian(chunk, (unsigned int)data.size());
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    putBigEndian(chunk, crc32(&chunk[4], chunk.size() - 4));
+    file.write((const char*)chunk.data(), chunk.size());
+}
+
+bool writePng(const std::string& path, int width, int height, const std::vector<unsigned char>& pixels) {
+    if (width <= 0 || height <= 0 || pixels.size() < (size_t)width * height * 4) return false;
+
+    std::ofstream file(path.c_str(), std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Could not write image: " << path << std::endl;
+        return false;
+    }
+    file.write((const char*)PNG_SIGNATURE, 8);
+
+    // Header: 8-bit RGBA, no interlacing
+    std::vector<unsigned char> header;
+    putBigEndian(header, (unsigned int)width);
+    putBigEndian(header, (unsigned int)height);
+    header.push_back(8);  // Bit depth
+    header.push_back(6);  // Color type RGBA
+    header.push_back(0);  // Compression
+    header.push_back(0);  // Filter method
+    header.push_back(0);  // Interlace
+    writeChunk(file, "IHDR", header);
+
+    // Scanlines, each prefixed with filter type 0 (none)
+    size_t rowBytes = (size_t)width * 4;
+    std::vector<unsigned char> raw;
+    raw.reserve((rowBytes + 1) * height);
+    for (int y = 0; y < height; y++) {
+        raw.push_back(0);
+        raw.insert(raw.end(), pixels.begin() + y * rowBytes, pixels.begin() + (y + 1) * rowBytes);
+    }
+
+    // zlib stream made of stored deflate blocks
+    std::vector<unsigned char> zlib;
+    zlib.push_back(0x78);
+    zlib.push_back(0x01);
+    for (size_t offset = 0; offset < raw.size(); offset += STORED_BLOCK_SIZE) {
+        size_t length = raw.size() - offset < STORED_BLOCK_SIZE ? raw.size() - offset : STORED_BLOCK_SIZE;
+        bool last = offset + length == raw.size();
+        zlib.push_back(last ? 1 : 0);
+        zlib.push_back((unsigned char)(length & 0xFF));
+        zlib.push_back((unsigned char)(length >> 8));
+        zlib.push_back((unsigned char)(~length & 0xFF));
+        zlib.push_back((unsigned char)((~length >> 8) & 0xFF));
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + length);
+    }
+    putBigEndian(zlib, adler32(raw.data(), raw.size()));
+    writeChunk(file, "IDAT", zlib);
+
+    writeChunk(file, "IEND", std::vector<unsigned char>());
+    return file.good();
+}
+
+// Paeth predictor of the PNG filter type 4
+static unsigned char paeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) return (unsigned char)a;
+    if (pb <= pc) return (unsigned char)b;
+    return (unsigned char)c;
+}
+
+bool readPng(const std::string& path, int& width, int& height, std::vector<unsigned char>& pixels) {
+    std::ifstream file(path.c_str(), std::ios::binary);
+    if (!file.is_open()) return false;
+    std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (data.size() < 8 || std::memcmp(data.data(), PNG_SIGNATURE, 8) != 0) return false;
+
+    // Walk the chunks, collecting the header and all IDAT data
+    std::vector<unsigned char> zlib;
+    width = height = 0;
+    size_t pos = 8;
+    while (pos + 12 <= data.size()) {
+        unsigned int length = getBigEndian(&data[pos]);
+        const unsigned char* type = &data[pos + 4];
+        const unsigned char* body = &data[pos + 8];
+        if (pos + 12 + length > data.size()) return false;
+
+        if (std::memcmp(type, "IHDR", 4) == 0) {
+            width = (int)getBigEndian(body);
+            height = (int)getBigEndian(body + 4);
+            if (body[8] != 8 || body[9] != 6 || body[12] != 0) {
+                std::cerr << "Unsupported PNG format (8-bit RGBA only): " << path << std::endl;
+                return false;
+            }
+        }
+        else if (std::memcmp(type, "IDAT", 4) == 0) {
+            zlib.insert(zlib.end(), body, body + length);
+        }
+        else if (std::memcmp(type, "IEND", 4) == 0) {
+            break;
+        }
+        pos += 12 + length;
+    }
+    if (width <= 0 || height <= 0 || zlib.size() < 2) return false;
+
+    // Inflate stored blocks only
+    std::vector<unsigned char> raw;
+    size_t z = 2;
+    bool last = false;
+    while (!last) {
+        if (z + 5 > zlib.size()) return false;
+        last = (zlib[z] & 1) != 0;
+        if ((zlib[z] & 6) != 0) {
+            std::cerr << "Compressed PNG data is not supported: " << path << std::endl;
+            return false;
+        }
+        size_t length = zlib[z + 1] | (zlib[z + 2] << 8);
+        z += 5;
+        if (z + length > zlib.size()) return false;
+        raw.insert(raw.end(), zlib.begin() + z, zlib.begin() + z + length);
+        z += length;
+    }
+
+    // Undo the scanline filters
+    size_t rowBytes = (size_t)width * 4;
+    if (raw.size() < (rowBytes + 1) * height) return false;
+    pixels.assign(rowBytes * height, 0);
+    for (int y = 0; y < height; y++) {
+        unsigned char filter = raw[y * (rowBytes + 1)];
+        const unsigned char* src = &raw[y * (rowBytes + 1) + 1];
+        unsigned char* dst = &pixels[y * rowBytes];
+        const unsigned char* up = y > 0 ? &pixels[(y - 1) * rowBytes] : nullptr;
+
+        for (size_t x = 0; x < rowBytes; x++) {
+            int a = x >= 4 ? dst[x - 4] : 0;
+            int b = up ? up[x] : 0;
+            int c = (up && x >= 4) ? up[x - 4] : 0;
+            switch (filter) {
+            case 0: dst[x] = src[x]; break;
+            case 1: dst[x] = (unsigned char)(src[x] + a); break;
+            case 2: dst[x] = (unsigned char)(src[x] + b); break;
+            case 3: dst[x] = (unsigned char)(src[x] + ((a + b) >> 1)); break;
+            case 4: dst[x] = (unsigned char)(src[x] + paeth(a, b, c)); break;
+            default: return false;
+            }
+        }
+    }
+    return true;
+}
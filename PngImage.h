@@ -0,0 +1,14 @@
+#ifndef PNGIMAGE_H
+#define PNGIMAGE_H
+
+#include <string>
+#include <vector>
+
+// Writes an 8-bit RGBA image as PNG using uncompressed deflate blocks
+// - pixels: width * height * 4 bytes, first row is the top of the image
+bool writePng(const std::string& path, int width, int height, const std::vector<unsigned char>& pixels);
+
+// Reads an 8-bit RGBA PNG written by writePng (only uncompressed deflate blocks are supported)
+bool readPng(const std::string& path, int& width, int& height, std::vector<unsigned char>& pixels);
+
+#endif
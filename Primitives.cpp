@@ -12,8 +12,29 @@ static unsigned int cubeVAO = 0, cubeVBO = 0;
 static unsigned int cylVAO = 0, cylVBO = 0;
 static unsigned int sphereVAO = 0, sphereVBO = 0;
 
-// Function to draw a cube using a VAO/VBO setup
-void drawCube(Shader& shader, const glm::mat4& transform) {
+// Instanced draws: one shared per-instance buffer and a VAO per primitive that reads it
+static unsigned int instanceVBO = 0;
+static size_t instanceCapacity = 0;     // Instances the buffer holds
+static int instanceCount = 0;
+static unsigned int cubeInstancedVAO = 0, cylInstancedVAO = 0;
+
+// VAO with the positions of geometryVBO and the instance data as attribute 2
+static unsigned int setupInstancedVAO(unsigned int geometryVBO) {
+    unsigned int vao;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, geometryVBO);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);     // Next value per instance, not per vertex
+    return vao;
+}
+
+// Creates the cube VAO/VBO on first use
+static void setupCube() {
     if (cubeVAO == 0) {
         // Vertex data for a unit cube centered at the origin
         float vertices[] = {
@@ -41,15 +62,21 @@ void drawCube(Shader& shader, const glm::mat4& transform) {
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
         glEnableVertexAttribArray(0);
     }
+}
 
-    // Set model matrix in shader
-    shader.setMat4("model", transform);
+// Function to draw cubes using a VAO/VBO setup
+void drawCubes(Shader& shader, int objectOffset, int count) {
+    if (count == 0) return;
+    setupCube();
+
+    // The objects hold the model matrices and colors
+    shader.setInt("objectOffset", objectOffset);
     glBindVertexArray(cubeVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 36, count);
 }
 
-// Function to draw a cylinder using triangle strip logic
-void drawCylinder(Shader& shader, const glm::mat4& transform) {
+// Creates the cylinder VAO/VBO on first use
+static void setupCylinder() {
     const int segments = 36;
     if (cylVAO == 0) {
         std::vector<float> vertices;
@@ -77,14 +104,20 @@ void drawCylinder(Shader& shader, const glm::mat4& transform) {
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
         glEnableVertexAttribArray(0);
     }
+}
+
+// Function to draw cylinders using triangle strip logic
+void drawCylinders(Shader& shader, int objectOffset, int count) {
+    if (count == 0) return;
+    setupCylinder();
 
-    shader.setMat4("model", transform);
+    shader.setInt("objectOffset", objectOffset);
     glBindVertexArray(cylVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 36 * 6); // 6 vertices per segment
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 36 * 6, count); // 6 vertices per segment
 }
 
-// Function to draw a sphere made of latitude and longitude segments
-void drawSphere(Shader& shader, const glm::mat4& transform) {
+// Creates the sphere VAO/VBO made of latitude and longitude segments on first use
+static void setupSphere() {
     if (sphereVAO == 0) {
         std::vector<float> vertices;
         const unsigned int X_SEGMENTS = 17;
@@ -113,54 +146,78 @@ void drawSphere(Shader& shader, const glm::mat4& transform) {
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
         glEnableVertexAttribArray(0);
     }
+}
+
+// Function to draw spheres
+void drawSpheres(Shader& shader, int objectOffset, int count) {
+    if (count == 0) return;
+    setupSphere();
 
-    shader.setMat4("model", transform);
+    shader.setInt("objectOffset", objectOffset);
     glBindVertexArray(sphereVAO);
-    glDrawArrays(GL_POINTS, 0, (16 + 1) * (16 + 1)); // Drawing as points
+    glDrawArraysInstanced(GL_POINTS, 0, (16 + 1) * (16 + 1), count); // Drawing as points
+}
+
+// Function to pose a humanoid robot with animation
+void poseHumanoidRobot(RobotSkeleton& skeleton, glm::vec3 robotPos, float time, bool isScanning, float scanAngle) {
+
+    // Animated angle for arms and legs
+    float swing = sin(time * 0.5f) * glm::radians(30.0f);
+
+    // Only the parts whose animation changed are rebuilt
+    skeleton.setRootPosition(robotPos);
+    skeleton.setLimbSwing(swing);
+    skeleton.setScanAngle(isScanning, scanAngle);
+    skeleton.updateWorldTransforms();
 }
 
-// Function to draw a humanoid robot with animation
-void drawHumanoidRobot(Shader& shader, glm::vec3 robotPos, float time, bool isScanning, float scanAngle) {
-    // Animated angles for arms and legs
-    float armAngle = sin(time * 0.5f) * glm::radians(30.0f);
-    float legAngle = sin(time * 0.5f) * glm::radians(30.0f);
+void writeHumanoidRobot(const RobotSkeleton& skeleton, ObjectData* cubes, ObjectData* spheres, ObjectData* cylinders) {
+    glm::vec4 color(0.0f, 0.0f, 0.0f, 1.0f);
 
-    // Torso (cube)
-    glm::mat4 torso = glm::translate(glm::mat4(1.0f), robotPos + glm::vec3(0.0f, 1.2f, 0.0f));
-    torso = glm::scale(torso, glm::vec3(0.25f, 1.2f, 0.2f));
-    shader.setVec3("objectColor", glm::vec3(0.0f, 0.0f, 0.0f));
-    drawCube(shader, torso);
+    // Torso and legs (cubes, the legs swinging in opposite directions)
+    cubes[0] = { skeleton.getPartMatrix(ROBOT_TORSO), color };
+    cubes[1] = { skeleton.getPartMatrix(ROBOT_LEFT_LEG), color };
+    cubes[2] = { skeleton.getPartMatrix(ROBOT_RIGHT_LEG), color };
 
     // Head (sphere)
-    glm::mat4 head = glm::translate(glm::mat4(1.0f), robotPos + glm::vec3(0.0f, 2.1f, 0.0f));
-    head = glm::scale(head, glm::vec3(0.2f));
-    shader.setVec3("objectColor", glm::vec3(0.0f, 0.0f, 0.0f));
-    drawSphere(shader, head);
-
-    // Left arm (cylinder, animated)
-    glm::mat4 leftArm = glm::translate(glm::mat4(1.0f), robotPos + glm::vec3(-0.3f, 1.3f, 0.0f));
-    leftArm = glm::rotate(leftArm, armAngle, glm::vec3(1.0f, 0.0f, 0.0f));
-    leftArm = glm::scale(leftArm, glm::vec3(0.1f, 0.8f, 0.1f));
-    drawCylinder(shader, leftArm);
-
-    // Right arm (cylinder, rotates if scanning)
-    glm::mat4 rightArm = glm::translate(glm::mat4(1.0f), robotPos + glm::vec3(0.3f, 1.3f, 0.0f));
-    if (isScanning) {
-        rightArm = glm::rotate(rightArm, glm::radians(scanAngle), glm::vec3(0.0f, 1.0f, 0.0f));
+    spheres[0] = { skeleton.getPartMatrix(ROBOT_HEAD), color };
+
+    // Arms (cylinders, the right one rotates while scanning)
+    cylinders[0] = { skeleton.getPartMatrix(ROBOT_LEFT_ARM), color };
+    cylinders[1] = { skeleton.getPartMatrix(ROBOT_RIGHT_ARM), color };
+}
+
+void setPrimitiveInstances(const std::vector<glm::vec4>& instances) {
+    if (instanceVBO == 0) glGenBuffers(1, &instanceVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+
+    // The buffer only grows; afterwards the data is replaced in place
+    if (instances.size() > instanceCapacity) {
+        glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(glm::vec4), instances.data(), GL_STREAM_DRAW);
+        instanceCapacity = instances.size();
+    }
+    else if (!instances.empty()) {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(glm::vec4), instances.data());
     }
-    rightArm = glm::scale(rightArm, glm::vec3(0.1f, 0.8f, 0.1f));
-    shader.setVec3("objectColor", glm::vec3(0.0f, 0.0f, 0.0f));
-    drawCylinder(shader, rightArm);
-
-    // Left leg (cube, animated)
-    glm::mat4 leftLeg = glm::translate(glm::mat4(1.0f), robotPos + glm::vec3(-0.2f, 0.4f, 0.0f));
-    leftLeg = glm::rotate(leftLeg, legAngle, glm::vec3(1.0f, 0.0f, 0.0f));
-    leftLeg = glm::scale(leftLeg, glm::vec3(0.15f, 1.2f, 0.15f));
-    drawCube(shader, leftLeg);
-
-    // Right leg (cube, opposite angle)
-    glm::mat4 rightLeg = glm::translate(glm::mat4(1.0f), robotPos + glm::vec3(0.2f, 0.4f, 0.0f));
-    rightLeg = glm::rotate(rightLeg, -legAngle, glm::vec3(1.0f, 0.0f, 0.0f));
-    rightLeg = glm::scale(rightLeg, glm::vec3(0.15f, 1.2f, 0.15f));
-    drawCube(shader, rightLeg);
-}
\ No newline at end of file
+    instanceCount = (int)instances.size();
+}
+
+void drawCubeInstanced(Shader& shader, int objectOffset) {
+    if (instanceCount == 0) return;
+    setupCube();
+    if (cubeInstancedVAO == 0) cubeInstancedVAO = setupInstancedVAO(cubeVBO);
+
+    shader.setInt("objectOffset", objectOffset);
+    glBindVertexArray(cubeInstancedVAO);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 36, instanceCount);
+}
+
+void drawCylinderInstanced(Shader& shader, int objectOffset) {
+    if (instanceCount == 0) return;
+    setupCylinder();
+    if (cylInstancedVAO == 0) cylInstancedVAO = setupInstancedVAO(cylVBO);
+
+    shader.setInt("objectOffset", objectOffset);
+    glBindVertexArray(cylInstancedVAO);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 36 * 6, instanceCount);
+}
@@ -8,25 +8,46 @@
 
 // Custom shader class
 #include "Shader.h"
+#include "RobotSkeleton.h"
+#include "StreamBuffer.h"
 
 // Standard libraries
 #include <vector>
 #include <cmath>
 
-// Draws a cube with the given shader and transformation matrix
-void drawCube(Shader& shader, const glm::mat4& transform);
-
-// Draws a cylinder (approximated by triangle segments)
-void drawCylinder(Shader& shader, const glm::mat4& transform);
-
-// Draws a sphere using latitude and longitude segments
-void drawSphere(Shader& shader, const glm::mat4& transform);
-
-// Draws a humanoid robot composed of cubes, spheres, and cylinders
+// Draw count cubes, cylinders (approximated by triangle segments) or spheres (latitude and
+// longitude segments) in one call; copy i is placed and colored by the i-th object from the
+// texel objectOffset of the streamed per-object data (see vertex_shader.glsl)
+void drawCubes(Shader& shader, int objectOffset, int count);
+void drawCylinders(Shader& shader, int objectOffset, int count);
+void drawSpheres(Shader& shader, int objectOffset, int count);
+
+// Body parts of a humanoid robot per primitive (cubes: torso and legs, sphere: head,
+// cylinders: arms)
+#define ROBOT_CUBE_PARTS 3
+#define ROBOT_SPHERE_PARTS 1
+#define ROBOT_CYLINDER_PARTS 2
+
+// Poses a humanoid robot composed of cubes, spheres, and cylinders
+// - skeleton: transform hierarchy of the robot, only dirty parts are recomputed
 // - robotPos: position in the scene
 // - time: used for animation (arms/legs movement)
 // - isScanning: if true, enables scanning animation for the right arm
 // - scanAngle: rotation angle of the scanning arm
-void drawHumanoidRobot(Shader& shader, glm::vec3 robotPos, float time, bool isScanning = false, float scanAngle = 0.0f);
+void poseHumanoidRobot(RobotSkeleton& skeleton, glm::vec3 robotPos, float time, bool isScanning = false, float scanAngle = 0.0f);
+
+// Writes the parts of a posed robot as objects, the ROBOT_*_PARTS of each primitive into
+// its own array, so the parts of many robots are drawn with one call per primitive
+void writeHumanoidRobot(const RobotSkeleton& skeleton, ObjectData* cubes, ObjectData* spheres, ObjectData* cylinders);
+
+// Instance data for the instanced draws below (e.g. a crowd), one entry per copy:
+// xyz = position, w = rotation around the up axis in radians (vertex attribute 2)
+void setPrimitiveInstances(const std::vector<glm::vec4>& instances);
+
+// Draw one copy per instance in a single call; the object at the texel objectOffset places
+// the primitive relative to each instance and colors it (needs a shader that reads
+// attribute 2, e.g. crowd_vertex.glsl)
+void drawCubeInstanced(Shader& shader, int objectOffset);
+void drawCylinderInstanced(Shader& shader, int objectOffset);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include "RobotSkeleton.h"
+#include <glm/gtc/matrix_transform.hpp>
+
+// Use SSE intrinsics on x86/x64 compilers that support them
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define ROBOT_SKELETON_SSE 1
+#endif
+
+// Multiplies two column-major 4x4 matrices (out = a * b)
+void multiplyMat4(const glm::mat4& a, const glm::mat4& b, glm::mat4& out) {
+#ifdef ROBOT_SKELETON_SSE
+    // Load the four columns of a once
+    __m128 a0 = _mm_loadu_ps(&a[0][0]);
+    __m128 a1 = _mm_loadu_ps(&a[1][0]);
+    __m128 a2 = _mm_loadu_ps(&a[2][0]);
+    __m128 a3 = _mm_loadu_ps(&a[3][0]);
+
+    // Each output column is a linear combination of the columns of a
+    float result[16];
+    for (int j = 0; j < 4; j++) {
+        __m128 col = _mm_mul_ps(a0, _mm_set1_ps(b[j][0]));
+        col = _mm_add_ps(col, _mm_mul_ps(a1, _mm_set1_ps(b[j][1])));
+        col = _mm_add_ps(col, _mm_mul_ps(a2, _mm_set1_ps(b[j][2])));
+        col = _mm_add_ps(col, _mm_mul_ps(a3, _mm_set1_ps(b[j][3])));
+        _mm_storeu_ps(&result[j * 4], col);
+    }
+
+    // Copy through a temporary so out may alias a or b
+    for (int j = 0; j < 4; j++) {
+        out[j] = glm::vec4(result[j * 4], result[j * 4 + 1], result[j * 4 + 2], result[j * 4 + 3]);
+    }
+#else
+    out = a * b;
+#endif
+}
+
+RobotSkeleton::RobotSkeleton() {
+    // Hierarchy and rest offsets (torso center is 1.2 above the floor)
+    parent[ROBOT_ROOT] = -1;               offset[ROBOT_ROOT] = glm::vec3(0.0f);
+    parent[ROBOT_TORSO] = ROBOT_ROOT;      offset[ROBOT_TORSO] = glm::vec3(0.0f, 1.2f, 0.0f);
+    parent[ROBOT_HEAD] = ROBOT_TORSO;      offset[ROBOT_HEAD] = glm::vec3(0.0f, 0.9f, 0.0f);
+    parent[ROBOT_LEFT_ARM] = ROBOT_TORSO;  offset[ROBOT_LEFT_ARM] = glm::vec3(-0.3f, 0.1f, 0.0f);
+    parent[ROBOT_RIGHT_ARM] = ROBOT_TORSO; offset[ROBOT_RIGHT_ARM] = glm::vec3(0.3f, 0.1f, 0.0f);
+    parent[ROBOT_LEFT_LEG] = ROBOT_TORSO;  offset[ROBOT_LEFT_LEG] = glm::vec3(-0.2f, -0.8f, 0.0f);
+    parent[ROBOT_RIGHT_LEG] = ROBOT_TORSO; offset[ROBOT_RIGHT_LEG] = glm::vec3(0.2f, -0.8f, 0.0f);
+
+    // Size of the primitive drawn for each part
+    shapeScale[ROBOT_ROOT] = glm::vec3(1.0f);
+    shapeScale[ROBOT_TORSO] = glm::vec3(0.25f, 1.2f, 0.2f);
+    shapeScale[ROBOT_HEAD] = glm::vec3(0.2f);
+    shapeScale[ROBOT_LEFT_ARM] = glm::vec3(0.1f, 0.8f, 0.1f);
+    shapeScale[ROBOT_RIGHT_ARM] = glm::vec3(0.1f, 0.8f, 0.1f);
+    shapeScale[ROBOT_LEFT_LEG] = glm::vec3(0.15f, 1.2f, 0.15f);
+    shapeScale[ROBOT_RIGHT_LEG] = glm::vec3(0.15f, 1.2f, 0.15f);
+
+    rootPosition = glm::vec3(0.0f);
+    limbSwing = 0.0f;
+    scanning = false;
+    scanAngle = 0.0f;
+
+    // Everything must be built on the first update
+    for (int i = 0; i < ROBOT_PART_COUNT; i++) {
+        localDirty[i] = true;
+        worldDirty[i] = true;
+    }
+}
+
+void RobotSkeleton::setRootPosition(const glm::vec3& position) {
+    if (position == rootPosition) return;
+    rootPosition = position;
+    localDirty[ROBOT_ROOT] = true;
+}
+
+void RobotSkeleton::setLimbSwing(float angle) {
+    if (angle == limbSwing) return;
+    limbSwing = angle;
+    localDirty[ROBOT_LEFT_ARM] = true;
+    localDirty[ROBOT_LEFT_LEG] = true;
+    localDirty[ROBOT_RIGHT_LEG] = true;
+}
+
+void RobotSkeleton::setScanAngle(bool isScanning, float angle) {
+    if (isScanning == scanning && (!isScanning || angle == scanAngle)) return;
+    scanning = isScanning;
+    scanAngle = angle;
+    localDirty[ROBOT_RIGHT_ARM] = true;
+}
+
+// Rebuilds the local matrix of one part from the current animation values
+void RobotSkeleton::buildLocal(int part) {
+    glm::vec3 translation = (part == ROBOT_ROOT) ? rootPosition : offset[part];
+    glm::mat4 m = glm::translate(glm::mat4(1.0f), translation);
+
+    switch (part) {
+    case ROBOT_LEFT_ARM:
+    case ROBOT_LEFT_LEG:
+        m = glm::rotate(m, limbSwing, glm::vec3(1.0f, 0.0f, 0.0f));
+        break;
+    case ROBOT_RIGHT_LEG:
+        m = glm::rotate(m, -limbSwing, glm::vec3(1.0f, 0.0f, 0.0f)); // Opposite angle
+        break;
+    case ROBOT_RIGHT_ARM:
+        if (scanning) {
+            m = glm::rotate(m, glm::radians(scanAngle), glm::vec3(0.0f, 1.0f, 0.0f));
+        }
+        break;
+    default:
+        break;
+    }
+
+    local[part] = m;
+}
+
+// Parents come first, so a single pass sees every parent already composed
+void RobotSkeleton::updateWorldTransforms() {
+    for (int i = 0; i < ROBOT_PART_COUNT; i++) {
+        bool dirty = localDirty[i] || (parent[i] >= 0 && worldDirty[parent[i]]);
+        worldDirty[i] = dirty;
+        if (!dirty) continue;
+
+        if (localDirty[i]) {
+            buildLocal(i);
+            localDirty[i] = false;
+        }
+
+        if (parent[i] < 0) world[i] = local[i];
+        else multiplyMat4(world[parent[i]], local[i], world[i]);
+
+        // Apply the shape scale by scaling the first three columns
+        drawMatrix[i] = world[i];
+        drawMatrix[i][0] *= shapeScale[i].x;
+        drawMatrix[i][1] *= shapeScale[i].y;
+        drawMatrix[i][2] *= shapeScale[i].z;
+    }
+}
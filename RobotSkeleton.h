@@ -0,0 +1,60 @@
+#ifndef ROBOTSKELETON_H
+#define ROBOTSKELETON_H
+
+// GLM for matrix and vector types
+#include <glm/glm.hpp>
+
+// Body parts of the humanoid robot, stored parent-first
+// (a part always comes after its parent so one forward pass is enough)
+enum RobotPart {
+    ROBOT_ROOT = 0,     // Robot position on the floor
+    ROBOT_TORSO,        // Child of root
+    ROBOT_HEAD,         // Child of torso
+    ROBOT_LEFT_ARM,     // Child of torso
+    ROBOT_RIGHT_ARM,    // Child of torso (scanning arm)
+    ROBOT_LEFT_LEG,     // Child of torso
+    ROBOT_RIGHT_LEG,    // Child of torso
+    ROBOT_PART_COUNT
+};
+
+// Multiplies two column-major 4x4 matrices (out = a * b), using SSE when available
+void multiplyMat4(const glm::mat4& a, const glm::mat4& b, glm::mat4& out);
+
+// Small skeletal transform hierarchy for the robot (root -> torso -> head/arms/legs)
+class RobotSkeleton {
+public:
+    RobotSkeleton();
+
+    // Animation inputs; a part is only marked dirty when its value actually changes
+    void setRootPosition(const glm::vec3& position);
+    void setLimbSwing(float angle);                      // Arm and leg swing angle in radians
+    void setScanAngle(bool isScanning, float scanAngle); // Right arm rotation in degrees
+
+    // Rebuilds dirty local matrices and composes world matrices in one linear pass
+    void updateWorldTransforms();
+
+    // World matrix of a part with its shape scale applied, ready to be drawn
+    const glm::mat4& getPartMatrix(int part) const { return drawMatrix[part]; }
+
+private:
+    int parent[ROBOT_PART_COUNT];            // Parent index (-1 for the root)
+    glm::vec3 offset[ROBOT_PART_COUNT];      // Translation relative to the parent
+    glm::vec3 shapeScale[ROBOT_PART_COUNT];  // Scale of the primitive (not inherited by children)
+
+    glm::mat4 local[ROBOT_PART_COUNT];       // Local transform (offset * rotation)
+    glm::mat4 world[ROBOT_PART_COUNT];       // Composed transform without shape scale
+    glm::mat4 drawMatrix[ROBOT_PART_COUNT];  // World transform with shape scale
+    bool localDirty[ROBOT_PART_COUNT];       // Local matrix needs to be rebuilt
+    bool worldDirty[ROBOT_PART_COUNT];       // World matrix needs to be recomposed
+
+    // Current animation values
+    glm::vec3 rootPosition;
+    float limbSwing;
+    bool scanning;
+    float scanAngle;
+
+    // Rebuilds the local matrix of one part from the animation values
+    void buildLocal(int part);
+};
+
+#endif
@@ -2,33 +2,109 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include "ModelLoader.h"
 #include "Primitives.h"
+#include "GpuProfiler.h"
+#include "CpuProfiler.h"
+#include "JobSystem.h"
+#include "NavGrid.h"
+#include "TourPlanner.h"
+#include "Crowd.h"
+#include "Systems.h"
+#include "AudioEngine.h"
+#include "ExhibitCatalog.h"
+#include "AssetPack.h"
+#include "StreamBuffer.h"
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include "imgui/imgui.h"
-#include <windows.h>
-#include <mmsystem.h>
-#pragma comment(lib, "winmm.lib")
+#include <string>
+#include <iostream>
+#include <algorithm>
+#include <mutex>
+#include <chrono>
 
-Room::Room() {
+// Texture unit of the per-object data
+static const int OBJECT_BUFFER_UNIT = 0;
+
+Room::Room(const SceneDescription& scene, JobSystem* jobs, const AssetPack* pack, bool shareMeshes) {
+    jobSystem = jobs;
     shader = new Shader("vertex_shader.glsl", "fragment_shader.glsl");
+    objectStream = new StreamBuffer();
     setupFloor();
     setupWall();
     setupPlinth();
-    setupModels();
+    setupModels(scene.meshes, pack, shareMeshes);
+
+    roomOrigins = scene.roomOrigins;
+    tour = scene.tour;
+    lightAttenuation = scene.lightAttenuation;
+
+    // Exhibits and lights become entities, each kind stored as one archetype
+    for (size_t i = 0; i < scene.exhibits.size(); i++) {
+        const Exhibit& exhibit = scene.exhibits[i];
+        const ModelLoader* model = models[exhibit.mesh];
+        Transform transform = { exhibit.position, exhibit.yaw, exhibit.scale };
+        ExhibitModel look = { exhibit.mesh, exhibit.color, (int)i, exhibit.catalogIndex };
+        CullBounds bounds = { exhibit.scale * (glm::length(model->boundsCenter) + model->boundsRadius) };
+        exhibitEntities.push_back(world.create(transform, look, bounds, Visibility{ 1, 0 }));
+    }
+    for (size_t i = 0; i < scene.lights.size(); i++) {
+        world.create(Transform{ scene.lights[i].position, 0.0f, 1.0f }, LightSource{ scene.lights[i].color });
+    }
 
     // Initial robot position and target object coordinates
-    robotPosition = glm::vec3(0.0f, 0.0f, 0.0f);// Starting position
+    glm::vec3 robotPosition = scene.robotStarts.empty() ? glm::vec3(0.0f) : scene.robotStarts[0];// Starting position
 
     currentTargetIndex = 0;
     autoMode = true;
 
-    objectPositions = {
-        {3.0f, 0.0f, 3.0f},      // model1.obj
-        {-3.5f, 0.0f, -1.0f},    // model2.obj
-        {0.0f, 1.0f, -6.0f},     // model3.obj
-        {4.0f, 0.0f, -4.0f},     // model5.obj
-        {-3.5f, 0.0f, 2.5f}      // model4.obj
-    };
+    // Walkable floor: room walls, doorways and the exhibit footprints
+    std::vector<NavObstacle> obstacles;
+    for (size_t i = 0; i < scene.exhibits.size(); i++) {
+        obstacles.push_back({ scene.exhibits[i].position, scene.exhibits[i].scale * models[scene.exhibits[i].mesh]->footprintRadius });
+    }
+    navGrid = new NavGrid(roomOrigins, obstacles);
+
+    // The robot stops on the free spot closest to each exhibit
+    for (size_t i = 0; i < tour.size(); i++) {
+        objectPositions.push_back(navGrid->nearestWalkable(scene.exhibits[tour[i]].position));
+    }
+    objectVisited.assign(objectPositions.size(), false);
+
+    // Visiting order for the automatic mode, shortest walk over all stops
+    tourPlanner = new TourPlanner(navGrid);
+    tourPlanner->plan(robotPosition, objectPositions);
+    if (!objectPositions.empty()) {
+        std::vector<int> listOrder;
+        for (size_t i = 0; i < objectPositions.size(); i++) listOrder.push_back((int)i);
+        std::cout << "Tour: " << objectPositions.size() << " stops, " << tourPlanner->getTourLength() << " m (list order "
+                  << tourPlanner->getLength(listOrder) << " m), planned in " << tourPlanner->getPlanMilliseconds() << " ms\n";
+    }
+    currentTargetIndex = nextTourTarget();
+
+    // Visitors walk between all exhibits of the museum
+    if (!scene.visitorStarts.empty()) {
+        std::vector<glm::vec3> exhibitSpots;
+        for (size_t i = 0; i < scene.exhibits.size(); i++) exhibitSpots.push_back(navGrid->nearestWalkable(scene.exhibits[i].position));
+        crowd = new Crowd(navGrid, scene.visitorStarts, exhibitSpots, 1u);
+        crowdShader = new Shader("crowd_vertex.glsl", "fragment_shader.glsl");
+    }
+
+    // Robots: the guide walks, scans and shows popups, every other robot wanders on its own.
+    // Each robot owns one route (its index in routes).
+    Locomotion guideWalk = { robotPosition, 0.4f, 1.5f, 0.3f, 2.0f, 0, 0, BehaviorHandle(), false };
+    guide = world.create(Transform{ robotPosition, 0.0f, 1.0f }, guideWalk, Animation{ 0.0f }, Scanner{ 0.0f, -1, false, false });
+    routes.resize(1);
+    for (size_t i = 1; i < scene.robotStarts.size(); i++) {
+        Locomotion walk = { scene.robotStarts[i], 0.1f, 0.0f, 1.2f, 1.2f, (int)routes.size(), 0, BehaviorHandle(), false };
+        Wanderer wanderer = { scene.exhibits.empty() ? -1 : (int)(i % scene.exhibits.size()) };
+        wandererEntities.push_back(world.create(Transform{ scene.robotStarts[i], 0.0f, 1.0f }, walk, Animation{ 0.0f }, wanderer));
+        routes.push_back(std::vector<glm::vec3>());
+    }
+    wandererSkeletons.resize(wandererEntities.size());
+
+    // Scripts start once the robots they move exist
+    for (size_t i = 0; i < wandererEntities.size() && !exhibitEntities.empty(); i++) behaviors.spawn(wandererBehavior(wandererEntities[i]));
+    guideScript = behaviors.spawn(guideBehavior());
 
 }
 
@@ -40,6 +116,11 @@ Room::~Room() {
     glDeleteVertexArrays(1, &plinthVAO);
     glDeleteBuffers(1, &plinthVBO);
     delete shader;
+    delete objectStream;
+    delete crowd;
+    delete crowdShader;
+    delete tourPlanner;
+    delete navGrid;
     for (auto m : models) delete m; // Delete all models
 
 }
@@ -104,155 +185,406 @@ void Room::setupPlinth() {
     glEnableVertexAttribArray(1);
 }
 
-void Room::setupModels() {
-    // model1.obj
-    models.push_back(new ModelLoader("models/model1.obj"));
-    // model2.obj
-    models.push_back(new ModelLoader("models/model2.obj"));
-    // model3.obj
-    models.push_back(new ModelLoader("models/model3.obj"));
-    // model5.obj
-    models.push_back(new ModelLoader("models/model5.obj"));
-    // model4.obj
-    models.push_back(new ModelLoader("models/model4.obj"));
+void Room::setupModels(const std::vector<ExhibitMesh>& meshes, const AssetPack* pack, bool shareMeshes) {
+    for (size_t i = 0; i < meshes.size(); i++) {
+        // Cooked model, unless its source file changed after cooking
+        int asset = pack && !meshes[i].path.empty() ? pack->find(meshes[i].path) : -1;
+        if (asset >= 0 && !pack->isCurrent(asset, meshes[i].path)) {
+            std::cout << "Model changed since cooking, loading the file: " << meshes[i].path << std::endl;
+            asset = -1;
+        }
 
-}
+        if (asset >= 0)
+            models.push_back(new ModelLoader(*pack, asset, jobSystem));  // Asset pack
+        else if (!meshes[i].path.empty())
+            models.push_back(new ModelLoader(meshes[i].path, meshes[i].importer, jobSystem, shareMeshes));  // Model file
+        else
+            models.push_back(new ModelLoader(meshes[i].vertices)); // Generated mesh
+    }
 
-void Room::drawMuseumRoom(const glm::mat4& view, const glm::mat4& projection) {
-    shader->use();
+}
 
-    shader->setMat4("view", view);
-    shader->setMat4("projection", projection);
+long long Room::getExhibitTriangleCount() const {
+    long long triangles = 0;
+    for (size_t i = 0; i < exhibitEntities.size(); i++) {
+        triangles += models[world.get<ExhibitModel>(exhibitEntities[i])->mesh]->getTriangleCount();
+    }
+    return triangles;
+}
 
-    shader->setVec3("lightPos", glm::vec3(0.0f, 4.5f, 0.0f));
-    shader->setVec3("lightColor", glm::vec3(1.0f));
+void Room::replaceModel(int mesh, ModelLoader* model) {
+    delete models[mesh];
+    models[mesh] = model;
+    for (size_t i = 0; i < exhibitEntities.size(); i++) {
+        if (world.get<ExhibitModel>(exhibitEntities[i])->mesh != mesh) continue;
+        float scale = world.get<Transform>(exhibitEntities[i])->scale;
+        world.get<CullBounds>(exhibitEntities[i])->radius = scale * (glm::length(model->boundsCenter) + model->boundsRadius);
+    }
+}
 
-    // Floor
-    shader->setVec3("objectColor", glm::vec3(0.6f, 0.6f, 0.6f)); // Walls are light gray
+// Runs function over the exhibit chunks, on the job system when there is one
+void Room::runChunks(JobSystem* jobs, void (*function)(void*, int, int)) {
+    int count = (int)exhibitChunks.size();
+    if (jobs) {
+        jobs->parallelFor(count, 1, function, this);
+        return;
+    }
+    for (int chunk = 0; chunk < count; chunk++) function(this, chunk, chunk + 1);
+}
 
-    glm::mat4 model = glm::mat4(1.0f);
-    shader->setMat4("model", model);
-    glBindVertexArray(planeVAO);
-    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+void Room::cullExhibits(const glm::mat4& viewProjection, JobSystem* jobs) {
+    PROFILE_SCOPE("Room::cullExhibits");
+
+    // Frustum planes from the rows of the view-projection matrix (left, right, bottom, top, near, far)
+    glm::vec4 row0(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+    glm::vec4 row1(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+    glm::vec4 row2(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+    glm::vec4 row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+    frustumPlanes[0] = row3 + row0;
+    frustumPlanes[1] = row3 - row0;
+    frustumPlanes[2] = row3 + row1;
+    frustumPlanes[3] = row3 - row1;
+    frustumPlanes[4] = row3 + row2;
+    frustumPlanes[5] = row3 - row2;
+    for (int i = 0; i < 6; i++) {
+        frustumPlanes[i] /= glm::length(glm::vec3(frustumPlanes[i]));
+    }
+    depthPlane = row3;
+
+    // Every exhibit archetype split into chunks of its rows
+    exhibitChunks.clear();
+    const std::vector<int>& archetypes = exhibitQuery.getArchetypes(world);
+    for (size_t a = 0; a < archetypes.size(); a++) {
+        int count = world.getArchetype(archetypes[a]).count;
+        for (int begin = 0; begin < count; begin += EXHIBIT_CHUNK) {
+            exhibitChunks.push_back({ archetypes[a], begin, begin + EXHIBIT_CHUNK < count ? begin + EXHIBIT_CHUNK : count });
+        }
+    }
+    chunkVisibleCounts.assign(exhibitChunks.size(), 0);
+    runChunks(jobs, cullChunk);
+}
 
-    // 4 Walls
-    glm::vec3 wallColors[4] = {
-        {0.6f, 0.6f, 0.6f}, // Back
+void Room::cullChunk(void* data, int beginChunk, int endChunk) {
+    Room* room = (Room*)data;
+
+    for (int c = beginChunk; c < endChunk; c++) {
+        const ExhibitChunk& chunk = room->exhibitChunks[c];
+        World::Archetype& archetype = room->world.getArchetype(chunk.archetype);
+        const Transform* transforms = archetype.column<Transform>();
+        const CullBounds* bounds = archetype.column<CullBounds>();
+        Visibility* visibility = archetype.column<Visibility>();
+        int visible = 0;
+
+        for (int i = chunk.begin; i < chunk.end; i++) {
+            bool inside = true;
+            for (int p = 0; p < 6 && inside; p++) {
+                const glm::vec4& plane = room->frustumPlanes[p];
+                inside = glm::dot(glm::vec3(plane), transforms[i].position) + plane.w >= -bounds[i].radius;
+            }
 
-        {0.4f, 0.4f, 0.4f}, // Front
+            visibility[i].visible = inside ? 1 : 0;
+            if (inside) visible++;
 
-        {0.5f, 0.5f, 0.5f}, // Left
+            // Level of detail from the size on screen, plus the bias of an over-budget GPU
+            float depth = glm::dot(glm::vec3(room->depthPlane), transforms[i].position) + room->depthPlane.w;
+            float limit = EXHIBIT_LOD_SIZE * depth;
+            int lod = 0;
+            while (lod < EXHIBIT_MAX_LOD && bounds[i].radius < limit) {
+                lod++;
+                limit *= 0.5f;
+            }
+            lod += room->lodBias;
+            visibility[i].lod = (unsigned char)(lod < EXHIBIT_MAX_LOD ? lod : EXHIBIT_MAX_LOD);
+        }
+        room->chunkVisibleCounts[c] = visible;
+    }
+}
 
-        {0.7f, 0.7f, 0.7f}  // Right
-    };
+void Room::buildDrawList(const RoomSnapshot& state, JobSystem* jobs) {
+    PROFILE_SCOPE("Room::buildDrawList");
 
-    glm::vec3 positions[4] = {
-        {0, 0, -5}, {0, 0, 5}, {-5, 0, 0}, {5, 0, 0}
-    };
+    // Visible counts become start offsets, so every chunk writes its own part of the list
+    int total = 0;
+    for (size_t c = 0; c < chunkVisibleCounts.size(); c++) {
+        int count = chunkVisibleCounts[c];
+        chunkVisibleCounts[c] = total;
+        total += count;
+    }
 
-    glm::vec3 rotations[4] = {
-        {0, 0, 0}, {0, 180, 0}, {0, -90, 0}, {0, 90, 0}
-    };
+    drawList.resize(total);
+    drawListState = &state;
+    runChunks(jobs, buildChunk);
+    drawListState = nullptr;
 
-    for (int i = 0; i < 4; i++) {
-        model = glm::translate(glm::mat4(1.0f), positions[i]);
-        model = glm::rotate(model, glm::radians(rotations[i].y), glm::vec3(0, 1, 0));
+    // Offsets back to counts, in case the list is rebuilt without culling again
+    for (size_t c = 0; c < chunkVisibleCounts.size(); c++) {
+        int next = c + 1 < chunkVisibleCounts.size() ? chunkVisibleCounts[c + 1] : total;
+        chunkVisibleCounts[c] = next - chunkVisibleCounts[c];
+    }
+}
 
-        if (i == 2 || i == 3) { // Left or Right wall
+void Room::buildChunk(void* data, int beginChunk, int endChunk) {
+    Room* room = (Room*)data;
+    const RoomSnapshot& state = *room->drawListState;
+
+    for (int c = beginChunk; c < endChunk; c++) {
+        const ExhibitChunk& chunk = room->exhibitChunks[c];
+        World::Archetype& archetype = room->world.getArchetype(chunk.archetype);
+        const Transform* transforms = archetype.column<Transform>();
+        const ExhibitModel* looks = archetype.column<ExhibitModel>();
+        const Visibility* visibility = archetype.column<Visibility>();
+        int item = room->chunkVisibleCounts[c];
+
+        for (int i = chunk.begin; i < chunk.end; i++) {
+            if (!visibility[i].visible) continue;
+            const Transform& transform = transforms[i];
+            float yaw = transform.yaw;
+            glm::vec3 color = looks[i].color; // Default color
+
+            // Exhibit currently being scanned by the guide, it turns green and spins
+            if (looks[i].exhibit == state.scanningExhibit) {
+                color = glm::vec3(0.7f, 1.0f, 0.7f); // coloring
+                yaw += state.scanAngle;              // Apply rotation
+            }
 
-            model = glm::scale(model, glm::vec3(5.0f, 2.0f, 20.0f));
-        }
-        else {
-            model = glm::scale(model, glm::vec3(10.0f, 1.0f, 6.0f));
+            ExhibitDrawItem& draw = room->drawList[item++];
+            draw.model = glm::translate(glm::mat4(1.0f), transform.position);
+            draw.model = glm::rotate(draw.model, glm::radians(yaw), glm::vec3(0.0f, 1.0f, 0.0f));
+            draw.model = glm::scale(draw.model, glm::vec3(transform.scale));
+            draw.color = color;
+            draw.mesh = looks[i].mesh;
+            draw.lod = visibility[i].lod;
         }
+    }
+}
 
-        shader->setVec3("objectColor", wallColors[i]);
-        shader->setMat4("model", model);
-        glBindVertexArray(wallVAO);
-        glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+void Room::setSceneUniforms(Shader& target, const glm::mat4& view, const glm::mat4& projection) {
+    target.setMat4("view", view);
+    target.setMat4("projection", projection);
+
+    // Scene lights (the first MAX_SCENE_LIGHTS light entities)
+    int lightCount = 0;
+    lightQuery.each(world, [&](const Transform& transform, const LightSource& light) {
+        if (lightCount >= MAX_SCENE_LIGHTS) return;
+        std::string index = "[" + std::to_string(lightCount) + "]";
+        target.setVec3("lightPositions" + index, transform.position);
+        target.setVec3("lightColors" + index, light.color);
+        lightCount++;
+    });
+    target.setInt("lightCount", lightCount);
+    target.setFloat("lightAttenuation", lightAttenuation);
+
+    // Per-object data (see writeObjects)
+    target.setInt("objects", OBJECT_BUFFER_UNIT);
+}
+
+// Space for count objects of this frame in the stream buffer; objectOffset receives the
+// texel of the first one. Null and -1 when there is nothing to write, or (reported once) when
+// the frame is larger than the buffer can get.
+static ObjectData* allocateObjects(StreamBuffer* stream, int count, int& objectOffset) {
+    objectOffset = -1;
+    if (count == 0) return nullptr;
+    size_t offset = 0;
+    ObjectData* objects = (ObjectData*)stream->allocate(count * sizeof(ObjectData), offset);
+    if (objects) objectOffset = (int)(offset / sizeof(glm::vec4));
+    static bool reported = false;
+    if (!objects && !reported) {
+        std::cerr << "ERROR::ROOM::OBJECT_BUFFER_FULL: " << count << " objects do not fit, some are not drawn" << std::endl;
+        reported = true;
     }
+    return objects;
+}
 
-    // Draw all models
-    for (size_t i = 0; i < models.size(); ++i) {
-        glm::mat4 modelMatrix = glm::mat4(1.0f);
-        if (i == 0) { // model1.obj
-            modelMatrix = glm::translate(modelMatrix, glm::vec3(3.0f, 0.0f, 3.0f));
-            modelMatrix = glm::scale(modelMatrix, glm::vec3(1.2f, 1.2f, 1.2f));
-            shader->setVec3("objectColor", glm::vec3(1.0f, 0.95f, 0.7f));
+void Room::writeObjects(const RoomSnapshot& state) {
+    PROFILE_SCOPE("Room::writeObjects");
 
-            if (i == scannedObjectIndex && isScanning) {
-                shader->setVec3("objectColor", glm::vec3(0.7f, 1.0f, 0.7f)); // coloring
-                modelMatrix = glm::rotate(modelMatrix, glm::radians(scanAngle), glm::vec3(0.0f, 1.0f, 0.0f));// Apply rotation
+    // Exhibits sorted into their batches (counting sort of the draw list)
+    int levels = EXHIBIT_MAX_LOD + 1;
+    batchStarts.assign(models.size() * levels + 1, 0);
+    for (size_t i = 0; i < drawList.size(); i++) {
+        int lod = std::min(drawList[i].lod, models[drawList[i].mesh]->getLodCount() - 1);
+        batchStarts[drawList[i].mesh * levels + lod + 1]++;
+    }
+    int exhibitCount = 0;
+    for (size_t b = 0; b + 1 < batchStarts.size(); b++) {
+        int count = batchStarts[b + 1];
+        if (count > 0) exhibitCount += count * models[b / levels]->getPartCount((int)(b % levels));
+        batchStarts[b + 1] += batchStarts[b];
+    }
+    batchFill.assign(batchStarts.begin(), batchStarts.end() - 1);
+    batchItems.resize(drawList.size());
+    for (size_t i = 0; i < drawList.size(); i++) {
+        int lod = std::min(drawList[i].lod, models[drawList[i].mesh]->getLodCount() - 1);
+        batchItems[batchFill[drawList[i].mesh * levels + lod]++] = (int)i;
+    }
 
-            }
-            else {
-                shader->setVec3("objectColor", glm::vec3(1.0f, 0.95f, 0.7f));// Default color
+    int roomCount = (int)roomOrigins.size();
+    robotCount = 1 + (int)std::min(state.wandererPositions.size(), wandererSkeletons.size());
+    int robotParts = ROBOT_CUBE_PARTS + ROBOT_SPHERE_PARTS + ROBOT_CYLINDER_PARTS;
+    int crowdCount = crowdShader && !state.crowdInstances.empty() ? 2 : 0;
+    size_t objectCount = roomCount * 5 + exhibitCount + robotCount * robotParts + crowdCount;
+    objectStream->beginFrame(objectCount * sizeof(ObjectData));
+    ObjectData* objects;
 
-            }
+    // Floors of all rooms, then their 4 walls
+    objects = allocateObjects(objectStream, roomCount * 5, shellObjects);
+    if (objects) {
+        glm::vec3 wallColors[4] = {
+            {0.6f, 0.6f, 0.6f}, // Back
 
-        }
-        else if (i == 1) { // model2.obj
-            modelMatrix = glm::translate(modelMatrix, glm::vec3(-3.5f, 0.0f, -1.0f));
-            modelMatrix = glm::scale(modelMatrix, glm::vec3(1.5f, 1.5f, 1.5f));
-            shader->setVec3("objectColor", glm::vec3(1.0f, 0.95f, 0.7f));
-
-            if (i == scannedObjectIndex && isScanning) {
-                shader->setVec3("objectColor", glm::vec3(0.7f, 1.0f, 0.7f)); // coloring
-                modelMatrix = glm::rotate(modelMatrix, glm::radians(scanAngle), glm::vec3(0.0f, 1.0f, 0.0f));// Apply rotation
-            }
-            else {
-                shader->setVec3("objectColor", glm::vec3(1.0f, 0.95f, 0.7f));// Default color
-            }
-        }
-        else if (i == 2) { // model3.obj
-            modelMatrix = glm::translate(modelMatrix, glm::vec3(0.0f, 1.0f, -6.0f));// Further to the right and forward
+            {0.4f, 0.4f, 0.4f}, // Front
 
-            modelMatrix = glm::scale(modelMatrix, glm::vec3(2.0f, 2.0f, 2.0f));
-            shader->setVec3("objectColor", glm::vec3(1.0f, 0.95f, 0.7f));
+            {0.5f, 0.5f, 0.5f}, // Left
 
-            if (i == scannedObjectIndex && isScanning) {
-                shader->setVec3("objectColor", glm::vec3(0.7f, 1.0f, 0.7f)); //  coloring
-                modelMatrix = glm::rotate(modelMatrix, glm::radians(scanAngle), glm::vec3(0.0f, 1.0f, 0.0f)); // Apply rotation
-            }
-            else {
-                shader->setVec3("objectColor", glm::vec3(1.0f, 0.95f, 0.7f)); // Default color
+            {0.7f, 0.7f, 0.7f}  // Right
+        };
+
+        glm::vec3 positions[4] = {
+            {0, 0, -5}, {0, 0, 5}, {-5, 0, 0}, {5, 0, 0}
+        };
+
+        glm::vec3 rotations[4] = {
+            {0, 0, 0}, {0, 180, 0}, {0, -90, 0}, {0, 90, 0}
+        };
+
+        ObjectData* walls = objects + roomCount;
+        for (int r = 0; r < roomCount; r++) {
+            // Floor
+            objects[r] = { glm::translate(glm::mat4(1.0f), roomOrigins[r]), glm::vec4(0.6f, 0.6f, 0.6f, 1.0f) }; // Walls are light gray
+
+            for (int i = 0; i < 4; i++) {
+                glm::mat4 model = glm::translate(glm::mat4(1.0f), roomOrigins[r] + positions[i]);
+                model = glm::rotate(model, glm::radians(rotations[i].y), glm::vec3(0, 1, 0));
+
+                if (i == 2 || i == 3) { // Left or Right wall
+
+                    model = glm::scale(model, glm::vec3(5.0f, 2.0f, 20.0f));
+                }
+                else {
+                    model = glm::scale(model, glm::vec3(10.0f, 1.0f, 6.0f));
+                }
+                walls[r * 4 + i] = { model, glm::vec4(wallColors[i], 1.0f) };
             }
         }
-        else if (i == 3) { // model5.obj
-            modelMatrix = glm::translate(modelMatrix, glm::vec3(4.0f, 0.0f, -4.0f));
-            modelMatrix = glm::scale(modelMatrix, glm::vec3(1.8f, 1.8f, 1.8f));
-            shader->setVec3("objectColor", glm::vec3(1.0f, 0.95f, 0.7f));
-
-            if (i == scannedObjectIndex && isScanning) {
-                shader->setVec3("objectColor", glm::vec3(0.7f, 1.0f, 0.7f)); //  coloring
-                modelMatrix = glm::rotate(modelMatrix, glm::radians(scanAngle), glm::vec3(0.0f, 1.0f, 0.0f)); //Apply rotation
-            }
-            else {
-                shader->setVec3("objectColor", glm::vec3(1.0f, 0.95f, 0.7f)); // Default color
+    }
+
+    // Visible exhibits batch by batch, each batch part by part; parts add their transform
+    objects = allocateObjects(objectStream, exhibitCount, exhibitObjects);
+    if (objects) {
+        for (size_t b = 0; b + 1 < batchStarts.size(); b++) {
+            if (batchStarts[b] == batchStarts[b + 1]) continue;
+            const ModelLoader* model = models[b / levels];
+            int lod = (int)(b % levels);
+            for (int p = 0; p < model->getPartCount(lod); p++) {
+                const glm::mat4& part = model->getPartTransform(lod, p);
+                bool identity = part == glm::mat4(1.0f);
+                for (int k = batchStarts[b]; k < batchStarts[b + 1]; k++) {
+                    const ExhibitDrawItem& item = drawList[batchItems[k]];
+                    objects->model = identity ? item.model : item.model * part;
+                    objects->color = glm::vec4(item.color, 1.0f);
+                    objects++;
+                }
             }
         }
-        else if (i == 4) { // model4.obj
-            modelMatrix = glm::translate(modelMatrix, glm::vec3(-3.5f, 0.0f, 2.5f));
-            modelMatrix = glm::rotate(modelMatrix, glm::radians(-90.0f), glm::vec3(0.0f, 1.0f, 0.0f));// Rotated 90 degrees clockwise
+    }
 
-            modelMatrix = glm::scale(modelMatrix, glm::vec3(1.4f, 1.4f, 1.4f));
-            shader->setVec3("objectColor", glm::vec3(1.0f, 0.95f, 0.7f));
+    // Robot parts grouped by primitive: the cubes of all robots, then spheres, then cylinders
+    objects = allocateObjects(objectStream, robotCount * robotParts, robotObjects);
+    if (objects) {
+        ObjectData* cubes = objects;
+        ObjectData* spheres = cubes + robotCount * ROBOT_CUBE_PARTS;
+        ObjectData* cylinders = spheres + robotCount * ROBOT_SPHERE_PARTS;
+        poseHumanoidRobot(robotSkeleton, state.robotPosition, state.robotAnimationTime, state.isScanning, state.scanAngle);
+        writeHumanoidRobot(robotSkeleton, cubes, spheres, cylinders);
+        for (int i = 1; i < robotCount; i++) {
+            poseHumanoidRobot(wandererSkeletons[i - 1], state.wandererPositions[i - 1], state.wandererAnimationTimes[i - 1]);
+            writeHumanoidRobot(wandererSkeletons[i - 1], cubes + i * ROBOT_CUBE_PARTS, spheres + i * ROBOT_SPHERE_PARTS, cylinders + i * ROBOT_CYLINDER_PARTS);
+        }
+    }
 
-            if (i == scannedObjectIndex && isScanning) {
-                shader->setVec3("objectColor", glm::vec3(0.7f, 1.0f, 0.7f)); // coloring
-                modelMatrix = glm::rotate(modelMatrix, glm::radians(scanAngle), glm::vec3(0.0f, 1.0f, 0.0f)); // Apply rotation
-            }
-            else {
-                shader->setVec3("objectColor", glm::vec3(1.0f, 0.95f, 0.7f)); // Default color
-            }
+    // Visitor body and head, relative to each visitor's feet
+    objects = allocateObjects(objectStream, crowdCount, crowdObjects);
+    if (objects) {
+        glm::mat4 body = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.65f, 0.0f));
+        body = glm::scale(body, glm::vec3(0.18f, 1.3f, 0.18f));
+        objects[0] = { body, glm::vec4(0.35f, 0.4f, 0.55f, 1.0f) };
+
+        glm::mat4 head = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 1.45f, 0.0f));
+        head = glm::scale(head, glm::vec3(0.22f));
+        objects[1] = { head, glm::vec4(0.85f, 0.7f, 0.6f, 1.0f) };
+    }
+
+    objectStream->flush();
+}
+
+void Room::drawMuseumRoom(const glm::mat4& view, const glm::mat4& projection, const RoomSnapshot& state) {
+    PROFILE_SCOPE("Room::drawMuseumRoom");
+    writeObjects(state);
+    objectStream->bindTexture(OBJECT_BUFFER_UNIT);
+
+    shader->use();
+    setSceneUniforms(*shader, view, projection);
+
+    if (gpuProfiler) gpuProfiler->beginPass("Room shell");
+
+    // Floor and walls of every room
+    if (shellObjects >= 0) {
+        int roomCount = (int)roomOrigins.size();
+        shader->setInt("objectOffset", shellObjects);
+        glBindVertexArray(planeVAO);
+        glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, roomCount);
+
+        shader->setInt("objectOffset", shellObjects + roomCount * OBJECT_TEXELS);
+        glBindVertexArray(wallVAO);
+        glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, roomCount * 4);
+    }
+
+    if (gpuProfiler) gpuProfiler->endPass();
+    if (gpuProfiler) gpuProfiler->beginPass("Exhibits");
+
+    // Draw the visible exhibits prepared by cullExhibits and buildDrawList, one instanced
+    // draw per batch and part
+    if (exhibitObjects >= 0) {
+        int levels = EXHIBIT_MAX_LOD + 1;
+        int objectOffset = exhibitObjects;
+        for (size_t b = 0; b + 1 < batchStarts.size(); b++) {
+            int count = batchStarts[b + 1] - batchStarts[b];
+            if (count == 0) continue;
+            const ModelLoader* model = models[b / levels];
+            int lod = (int)(b % levels);
+            model->drawInstanced(*shader, lod, count, objectOffset);
+            objectOffset += count * model->getPartCount(lod) * OBJECT_TEXELS;
         }
+    }
+
+    if (gpuProfiler) gpuProfiler->endPass();
+    if (gpuProfiler) gpuProfiler->beginPass("Robot");
 
-        shader->setMat4("model", modelMatrix);
-        models[i]->drawModel();
+    // All robots in one draw per primitive
+    if (robotObjects >= 0) {
+        drawCubes(*shader, robotObjects, robotCount * ROBOT_CUBE_PARTS);
+        drawSpheres(*shader, robotObjects + robotCount * ROBOT_CUBE_PARTS * OBJECT_TEXELS, robotCount * ROBOT_SPHERE_PARTS);
+        drawCylinders(*shader, robotObjects + robotCount * (ROBOT_CUBE_PARTS + ROBOT_SPHERE_PARTS) * OBJECT_TEXELS, robotCount * ROBOT_CYLINDER_PARTS);
     }
-    drawHumanoidRobot(*shader, robotPosition, glfwGetTime(), isScanning, scanAngle);
+
+    if (gpuProfiler) gpuProfiler->endPass();
+
+    // Visitors: bodies and heads of the whole crowd in two instanced draws
+    if (crowdObjects >= 0) {
+        if (gpuProfiler) gpuProfiler->beginPass("Visitors");
+        crowdShader->use();
+        setSceneUniforms(*crowdShader, view, projection);
+        setPrimitiveInstances(state.crowdInstances);
+        drawCylinderInstanced(*crowdShader, crowdObjects);
+        drawCubeInstanced(*crowdShader, crowdObjects + OBJECT_TEXELS);
+        if (gpuProfiler) gpuProfiler->endPass();
+    }
+
+    // The GPU is done with this frame's objects once the draws above are
+    objectStream->endFrame();
 
     // --- IMGUI CONTROL PANEL ---
+    PROFILE_SCOPE("Room::controlPanel");
     ImGui::PushStyleColor(ImGuiCol_WindowBg, ImVec4(0.1f, 0.1f, 0.1f, 0.5f)); // Background
 
     ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.7f, 0.7f, 0.7f, 1.0f));   // Text color
@@ -262,37 +594,33 @@ void Room::drawMuseumRoom(const glm::mat4& view, const glm::mat4& projection) {
     ImGui::SetWindowFontScale(2.0f);
 
     // Toggle between automatic/manual mode
-    if (ImGui::Checkbox("Automatic Mode", &autoMode)) {
-        goToTargetManually = false;  // turn off manual flag when switching to auto
+    // The simulation may run on another thread, so the UI only sends commands
+    bool uiAutoMode = state.autoMode;
+    if (ImGui::Checkbox("Automatic Mode", &uiAutoMode)) {
+        pushCommand(ROOM_COMMAND_SET_AUTO_MODE, uiAutoMode ? 1 : 0);
+    }
+
+    // Planned walk over the remaining stops
+    ImGui::Text("Tour: %.1f m (planned in %.2f ms)", state.tourLength, state.tourPlanMilliseconds);
+    if (!state.crowdInstances.empty()) {
+        ImGui::Text("Visitors: %d (%.2f ms per tick)", (int)state.crowdInstances.size(), state.crowdMilliseconds);
     }
 
     ImGui::Separator();
 
     // Manual object targeting
-    if (!autoMode) {
-        if (ImGui::Button("Go to Object 1")) {
-            currentTargetIndex = 0;
-            goToTargetManually = true;
-        }
-        if (ImGui::Button("Go to Object 2")) {
-            currentTargetIndex = 1;
-            goToTargetManually = true;
-        }
-        if (ImGui::Button("Go to Object 3")) {
-            currentTargetIndex = 2;
-            goToTargetManually = true;
-        }
-        if (ImGui::Button("Go to Object 4")) {
-            currentTargetIndex = 3;
-            goToTargetManually = true;
-        }
-        if (ImGui::Button("Go to Object 5")) {
-            currentTargetIndex = 4;
-            goToTargetManually = true;
+    if (!uiAutoMode) {
+        for (int i = 0; i < (int)objectPositions.size(); i++) {
+            std::string label = "Go to Object " + std::to_string(i + 1);
+            if (ImGui::Button(label.c_str())) {
+                pushCommand(ROOM_COMMAND_GO_TO_OBJECT, i);
+            }
         }
     }
 
-    if (showScanPopup && scannedObjectIndex >= 0) {
+    drawSearchPanel();
+
+    if (state.showScanPopup && state.scannedObjectIndex >= 0) {
         ImGui::SetNextWindowPos(ImVec2(ImGui::GetIO().DisplaySize.x - 500, 20), ImGuiCond_Always);
         ImGui::SetNextWindowSize(ImVec2(500, 350));
 
@@ -308,26 +636,24 @@ void Room::drawMuseumRoom(const glm::mat4& view, const glm::mat4& projection) {
 
         ImGui::SetWindowFontScale(2.5f);
 
-        ImGui::TextColored(ImVec4(1.0f, 0.85f, 0.3f, 1.0f), "Object %d has been scanned!", scannedObjectIndex + 1); // Golden header
+        ImGui::TextColored(ImVec4(1.0f, 0.85f, 0.3f, 1.0f), "Object %d has been scanned!", state.scannedObjectIndex + 1); // Golden header
 
         ImGui::Spacing();
         ImGui::Separator();
         ImGui::TextWrapped(" ");
 
-        if (scannedObjectIndex == 0)
-            ImGui::TextWrapped("Sarcophagus of Achilles\nRoman Period (2nd Century AD)\nA marble tomb depicting the life of Achilles. Dated to the Late Antonine Period.");
-
-        else if (scannedObjectIndex == 1)
-            ImGui::TextWrapped("Man Statue\nRoman Period (1st Century AD)\nA bronze male figure discovered in Karata, Adana.");
+        // Title, period and description from the catalog
+        int catalogIndex = world.get<ExhibitModel>(exhibitEntities[tour[state.scannedObjectIndex]])->catalogIndex;
+        const CatalogEntry* entry = (catalog && catalogIndex >= 0) ? catalog->find((unsigned int)catalogIndex) : nullptr;
 
-        else if (scannedObjectIndex == 2)
-            ImGui::TextWrapped("Statue of Tarhunda with Chariot\nLate Hittite Period (8th Century BC)\nA monumental sculpture made of basalt and limestone, depicting the Storm God Tarhunda on his chariot. It was discovered in the Yregir district of Adana Province.");
+        if (catalogIndex < 0)
+            ImGui::TextWrapped("Synthetic exhibit %d\nGenerated for scaling tests.", tour[state.scannedObjectIndex] + 1);
 
-        else if (scannedObjectIndex == 3)
-            ImGui::TextWrapped("Tombstone with Figures\nRoman Period (2nd and 3rd Century AD)\nA stone tombstone decorated with human or symbolic figures.");
+        else if (entry)
+            ImGui::TextWrapped("%s\n%s\n%s", catalog->text(entry->title), catalog->text(entry->period), catalog->text(entry->description));
 
-        else if (scannedObjectIndex == 4)
-            ImGui::TextWrapped("Sarcophagus\nRoman Period (3rd Century AD)\nAn ancient marble sarcophagus from the Roman era.");
+        else
+            ImGui::TextWrapped("Catalog entry %d\nNo description available.", catalogIndex);
 
         ImGui::End();
         ImGui::PopStyleVar();
@@ -338,65 +664,286 @@ void Room::drawMuseumRoom(const glm::mat4& view, const glm::mat4& projection) {
     ImGui::PopStyleColor(2);
 }
 
-void Room::update(float deltaTime) {
-    // Do nothing if the target list is finished
-    if (currentTargetIndex >= objectPositions.size()) return;
+void Room::setCatalog(const ExhibitCatalog* exhibitCatalog) {
+    catalog = exhibitCatalog;
+    searchIndex = SearchIndex();
+    searchResults.clear();
+    searchMatches = searchedDocuments = 0;
+
+    // Exhibit models never change after construction, so this may run next to the simulation
+    catalogStops.clear();
+    for (int stop = 0; stop < (int)tour.size(); stop++) {
+        int catalogIndex = world.get<ExhibitModel>(exhibitEntities[tour[stop]])->catalogIndex;
+        if (catalogIndex >= 0) catalogStops[(unsigned int)catalogIndex] = stop;
+    }
+}
+
+void Room::indexCatalog() {
+    // Entries are added in catalog order, so document numbers are entry numbers
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    while (searchIndex.getDocumentCount() < catalog->getEntryCount()) {
+        const CatalogEntry& entry = catalog->getEntry(searchIndex.getDocumentCount());
+        searchIndex.addDocument(catalog->text(entry.title), catalog->text(entry.period), catalog->text(entry.description));
+        if ((searchIndex.getDocumentCount() & 63) == 0 &&
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() > SEARCH_INDEX_BUDGET_MS) break;
+    }
+}
+
+void Room::drawSearchPanel() {
+    if (!catalog) return;
+    PROFILE_SCOPE("Room::search");
+    indexCatalog();
+
+    // Results follow every keystroke (and the index while it is still growing)
+    ImGui::Separator();
+    bool edited = ImGui::InputText("Search", searchText, sizeof(searchText));
+    if (edited || searchedDocuments != searchIndex.getDocumentCount()) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        searchMatches = searchIndex.search(searchText, searchResults, SEARCH_MAX_RESULTS);
+        searchMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        searchedDocuments = searchIndex.getDocumentCount();
+    }
+    if (searchIndex.getDocumentCount() < catalog->getEntryCount()) {
+        ImGui::Text("Indexing catalog: %d / %d", searchIndex.getDocumentCount(), catalog->getEntryCount());
+    }
+    if (searchText[0] == '\0') return;
+
+    ImGui::Text("%d matches (%.3f ms)", searchMatches, searchMilliseconds);
+    for (size_t i = 0; i < searchResults.size(); i++) {
+        const CatalogEntry& entry = catalog->getEntry(searchResults[i].document);
+        std::unordered_map<unsigned int, int>::const_iterator stop = catalogStops.find(entry.id);
+
+        // Exhibits in the room send the guide there, the others are only listed
+        if (stop == catalogStops.end()) {
+            ImGui::TextDisabled("%s (%s, not on display)", catalog->text(entry.title), catalog->text(entry.period));
+            continue;
+        }
+        std::string label = std::string(catalog->text(entry.title)) + " (" + catalog->text(entry.period) + ")##" + std::to_string(i);
+        if (ImGui::Selectable(label.c_str())) {
+            pushCommand(ROOM_COMMAND_GO_TO_OBJECT, stop->second);
+        }
+    }
+}
+
+bool Room::startWalk(Entity robot, const glm::vec3& target) {
+    Locomotion& walk = *world.get<Locomotion>(robot);
+    const glm::vec3& position = world.get<Transform>(robot)->position;
+    if (glm::length(target - position) <= walk.arriveDistance) return false;
+
+    // The movement system follows the route and wakes the script on arrival
+    std::vector<glm::vec3>& path = routes[walk.route];
+    if (!navGrid->findPath(position, target, path)) path.clear();
+    walk.target = target;
+    walk.pathIndex = 0;
+    walk.script = behaviors.current();
+    walk.active = true;
+    return true;
+}
+
+BehaviorTask Room::wandererBehavior(Entity robot) {
+    // Walk to a spot in front of the exhibit, then pick another one at random
+    for (;;) {
+        int exhibit = world.get<Wanderer>(robot)->targetExhibit;
+        glm::vec3 spot = navGrid->nearestWalkable(world.get<Transform>(exhibitEntities[exhibit])->position + glm::vec3(0.0f, 0.0f, 0.6f));
+        if (startWalk(robot, spot)) co_await behaviors.park();
+
+        // Next exhibit from the next update on (it may be the same one)
+        co_await behaviors.wait(0.0f);
+        wanderRandom = wanderRandom * 1664525u + 1013904223u;
+        world.get<Wanderer>(robot)->targetExhibit = (int)((wanderRandom >> 8) % exhibitEntities.size());
+    }
+}
 
-    // Exit if no target is set in manual mode
-    if (!autoMode && !goToTargetManually) return;
+BehaviorTask Room::guideBehavior() {
+    for (;;) {
+        // A stop picked in the panel comes first, then the planned tour in automatic mode
+        int stop = manualTarget >= 0 ? manualTarget : (autoMode ? nextTourTarget() : -1);
+        manualTarget = -1;
+        if (stop < 0 || stop >= (int)objectPositions.size()) break;
+        currentTargetIndex = stop;
 
-    // Target position and direction
-    glm::vec3 target = objectPositions[currentTargetIndex];
-    glm::vec3 direction = glm::normalize(target - robotPosition);
-    float distance = glm::length(target - robotPosition);
+        // Walk around the exhibits, slowing down close to the stop
+        if (startWalk(guide, objectPositions[stop])) co_await behaviors.park();
 
-    float speed = glm::clamp(distance * 1.5f, 0.3f, 2.0f);
+        co_await scan(stop, 3.0f);
+        objectVisited[stop] = true;
 
-    // Robot should move until it gets close to the target
-    if (!isScanning && distance > 0.4f) {
-        robotPosition += direction * speed * deltaTime;
+        // The popup closes on its own while the robot walks on
+        behaviors.cancel(popupScript);
+        popupScript = behaviors.spawn(showPopup(3.0f));
     }
-    // --- If the target is reached, start scanning (not the popup yet, just the rotation)
-    else if (!isScanning && distance <= 0.4f && scannedObjectIndex != currentTargetIndex) {
-        isScanning = true;
-        scanAngle = 0.0f;
-        scanTimer = 3.0f;
-        scannedObjectIndex = currentTargetIndex;  // Only when arriving for the first time
 
-        showScanPopup = false;
+    // Nothing left to do until the next command
+    if (autoMode) currentTargetIndex = (int)objectPositions.size();
+}
 
-        // SCANNING SOUND (on start)
-        PlaySound(TEXT("scan_loop.wav"), NULL, SND_FILENAME | SND_ASYNC | SND_LOOP);
+BehaviorTask Room::scan(int stop, float seconds) {
+    // Rotation only (scanSystem turns the exhibit), the popup follows when it is done
+    Scanner& scanner = *world.get<Scanner>(guide);
+    scanner.scanning = true;
+    scanner.angle = 0.0f;
+    scanner.stop = stop;
+    behaviors.cancel(popupScript);
+    scanner.popup = false;
+
+    // Scanning hum at the robot while it turns, then the finish chime
+    glm::vec3 position = world.get<Transform>(guide)->position;
+    AudioVoice hum = audio ? audio->playAt(scanLoopSound, position, 1.0f, true) : 0;
+
+    co_await behaviors.wait(seconds);
+    world.get<Scanner>(guide)->scanning = false;
+
+    if (audio) {
+        audio->stopVoice(hum);
+        audio->playAt(scanDoneSound, position, 1.0f, false);
     }
+}
 
-    // Execute scanning process
-    if (isScanning) {
-        scanAngle += 120.0f * deltaTime;  // Rotates at 120 degrees per second
+BehaviorTask Room::showPopup(float seconds) {
+    world.get<Scanner>(guide)->popup = true;
+    co_await behaviors.wait(seconds);
+    world.get<Scanner>(guide)->popup = false;
+}
 
-        scanTimer -= deltaTime;
+void Room::setAudio(AudioEngine* engine) {
+    audio = engine;
+    scanLoopSound = audio ? audio->findSound("scan_loop.wav") : -1;
+    scanDoneSound = audio ? audio->findSound("scan_done.wav") : -1;
+}
 
-        if (scanTimer <= 0.0f) {
-            isScanning = false;
-            showScanPopup = true;   // Show popup when scanning is complete
+void Room::restartGuide() {
+    // A running scan always finishes, the guide picks up the change right after it
+    if (world.get<Scanner>(guide)->scanning) return;
+    world.get<Locomotion>(guide)->active = false;
+    behaviors.cancel(guideScript);
+    guideScript = behaviors.spawn(guideBehavior());
+}
 
-            popupTimer = 3.0f;
+void Room::pushCommand(RoomCommandType type, int value) {
+    std::lock_guard<std::mutex> lock(commandMutex);
+    pendingCommands.push_back({ type, value });
+}
 
-            // STOP SCANNING SOUND
-            PlaySound(NULL, 0, 0);
+bool Room::applyCommands() {
+    std::lock_guard<std::mutex> lock(commandMutex);
+    if (pendingCommands.empty()) return false;
+
+    for (size_t i = 0; i < pendingCommands.size(); i++) {
+        const RoomCommand& command = pendingCommands[i];
+        if (command.type == ROOM_COMMAND_SET_AUTO_MODE) {
+            autoMode = command.value != 0;
+            manualTarget = -1;  // a pending manual target is dropped when the mode changes
+
+            // After a manual detour the rest of the tour starts from where the robot is now
+            if (autoMode && tourInterrupted) {
+                tourPlanner->replanFrom(world.get<Transform>(guide)->position, objectVisited);
+                currentTargetIndex = nextTourTarget();
+                tourInterrupted = false;
+            }
+        }
+        else if (command.type == ROOM_COMMAND_GO_TO_OBJECT) {
+            currentTargetIndex = command.value;
+            manualTarget = command.value;
+            tourInterrupted = true;
+        }
+    }
+    pendingCommands.clear();
 
-            // FINISH SOUND
-            PlaySound(TEXT("scan_done.wav"), NULL, SND_FILENAME | SND_ASYNC);
+    // Cancels the current walk (or wakes an idle guide) with the new target
+    restartGuide();
+    return true;
+}
 
-            if (autoMode) currentTargetIndex++;
-            else goToTargetManually = false;
+void Room::writeSnapshot(RoomSnapshot& snapshot, bool changed) {
+    const Scanner& scanner = *world.get<Scanner>(guide);
+    snapshot.changed = changed;
+    snapshot.robotPosition = world.get<Transform>(guide)->position;
+    snapshot.robotAnimationTime = world.get<Animation>(guide)->time;
+    snapshot.isScanning = scanner.scanning;
+    snapshot.scanAngle = scanner.angle;
+    snapshot.scanningExhibit = (scanner.scanning && scanner.stop >= 0) ? tour[scanner.stop] : -1;
+    snapshot.showScanPopup = scanner.popup;
+    snapshot.scannedObjectIndex = scanner.stop;
+    snapshot.autoMode = autoMode;
+    snapshot.tourComplete = isTourComplete();
+    snapshot.tourLength = tourPlanner->getTourLength();
+    snapshot.tourPlanMilliseconds = tourPlanner->getPlanMilliseconds();
+
+    if (crowd) {
+        crowd->writeInstances(snapshot.crowdInstances);
+        snapshot.crowdMilliseconds = crowd->getUpdateMilliseconds();
+    }
+
+    // resize() keeps the capacity, so steady-state snapshots do not allocate
+    snapshot.wandererPositions.resize(wandererEntities.size());
+    snapshot.wandererAnimationTimes.resize(wandererEntities.size());
+    size_t wanderer = 0;
+    wandererQuery.each(world, [&](const Transform& transform, const Animation& animation, const Wanderer&) {
+        snapshot.wandererPositions[wanderer] = transform.position;
+        snapshot.wandererAnimationTimes[wanderer] = animation.time;
+        wanderer++;
+    });
+}
+
+void interpolateSnapshots(const RoomSnapshot& from, const RoomSnapshot& to, float alpha, RoomSnapshot& out) {
+    // Discrete state always comes from the newer snapshot
+    out = to;
+    out.robotPosition = glm::mix(from.robotPosition, to.robotPosition, alpha);
+    out.robotAnimationTime = glm::mix(from.robotAnimationTime, to.robotAnimationTime, alpha);
+
+    // The scan angle only blends while the same exhibit is being scanned
+    if (from.isScanning && to.isScanning && from.scanningExhibit == to.scanningExhibit) {
+        out.scanAngle = glm::mix(from.scanAngle, to.scanAngle, alpha);
+    }
+
+    if (from.wandererPositions.size() == to.wandererPositions.size()) {
+        for (size_t i = 0; i < to.wandererPositions.size(); i++) {
+            out.wandererPositions[i] = glm::mix(from.wandererPositions[i], to.wandererPositions[i], alpha);
+            out.wandererAnimationTimes[i] = glm::mix(from.wandererAnimationTimes[i], to.wandererAnimationTimes[i], alpha);
         }
     }
 
-    if (popupTimer > 0.0f) {
-        popupTimer -= deltaTime;
-        if (popupTimer <= 0.0f) {
-            showScanPopup = false;
+    // Visitors blend their positions, the heading comes from the newer snapshot
+    if (from.crowdInstances.size() == to.crowdInstances.size()) {
+        for (size_t i = 0; i < to.crowdInstances.size(); i++) {
+            out.crowdInstances[i].x = glm::mix(from.crowdInstances[i].x, to.crowdInstances[i].x, alpha);
+            out.crowdInstances[i].z = glm::mix(from.crowdInstances[i].z, to.crowdInstances[i].z, alpha);
         }
     }
+}
+
+int Room::nextTourTarget() const {
+    const std::vector<int>& order = tourPlanner->getOrder();
+    for (size_t i = 0; i < order.size(); i++) {
+        if (!objectVisited[order[i]]) return order[i];
+    }
+    return (int)objectPositions.size();
+}
+
+bool Room::isTourComplete() const {
+    const Scanner& scanner = *world.get<Scanner>(guide);
+    return autoMode && currentTargetIndex >= (int)objectPositions.size() && !world.get<Locomotion>(guide)->active &&
+           !scanner.scanning && !scanner.popup;
+}
+
+bool Room::update(float deltaTime) {
+    PROFILE_SCOPE("Room::update");
 
-}
\ No newline at end of file
+    bool changed = applyCommands();
+
+    // Visitors and wandering robots never stop
+    if (crowd) crowd->update(deltaTime, jobSystem);
+    bool alwaysMoving = !wandererEntities.empty() || crowd != nullptr;
+
+    // Systems step the robots; the scripts only run when a walk arrived or a wait is over
+    bool popupWasShown = world.get<Scanner>(guide)->popup;
+    movementSystem(world, movementQuery, routes, behaviors, deltaTime);
+    behaviors.update(deltaTime);
+    animationSystem(world, animationQuery, deltaTime);
+    scanSystem(world, scanQuery, deltaTime);
+
+    // The frame the popup closes still changes the picture
+    const Scanner& scanner = *world.get<Scanner>(guide);
+    changed = changed || world.get<Locomotion>(guide)->active || scanner.scanning || scanner.popup || popupWasShown;
+    return changed || alwaysMoving;
+}
@@ -5,21 +5,154 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <vector>           // For storing multiple models or positions
+#include <mutex>
+#include <unordered_map>
 
 #include "Shader.h"
 #include "ModelLoader.h"
+#include "RobotSkeleton.h"
+#include "SceneGenerator.h"
+#include "Behavior.h"
+#include "World.h"
+#include "Components.h"
+#include "SearchIndex.h"
+
+class GpuProfiler;
+class JobSystem;
+class NavGrid;
+class TourPlanner;
+class Crowd;
+class AudioEngine;
+class ExhibitCatalog;
+class AssetPack;
+class StreamBuffer;
+
+// Exhibits culled or drawn per job
+#define EXHIBIT_CHUNK 256
+
+// Level of detail: exhibits whose bounding radius is below this share of their view depth
+// use the first simplified level, every halving one level more (up to EXHIBIT_MAX_LOD)
+#define EXHIBIT_LOD_SIZE 0.1f
+#define EXHIBIT_MAX_LOD 3
+
+// Catalog search: results listed in the control panel, frame time spent indexing a large catalog
+#define SEARCH_MAX_RESULTS 10
+#define SEARCH_INDEX_BUDGET_MS 2.0
+
+// One exhibit draw prepared by Room::buildDrawList
+struct ExhibitDrawItem {
+    glm::mat4 model;
+    glm::vec3 color;
+    int mesh;
+    int lod;
+};
+
+// Exhibits of one archetype culled or drawn by one job
+struct ExhibitChunk {
+    int archetype;
+    int begin, end;             // Rows
+};
+
+// Copy of the simulation state handed to the renderer (see SimulationThread)
+struct RoomSnapshot {
+    double publishSeconds = 0.0;        // Steady clock time the snapshot was published
+    bool changed = false;               // Something moved during the tick
+
+    // Guide robot
+    glm::vec3 robotPosition = glm::vec3(0.0f);
+    float robotAnimationTime = 0.0f;
+    bool isScanning = false;
+    float scanAngle = 0.0f;
+    int scanningExhibit = -1;           // Exhibit being scanned, -1 if none
+
+    // Scan popup and control panel
+    bool showScanPopup = false;
+    int scannedObjectIndex = -1;        // Tour stop of the popup
+    bool autoMode = true;
+    bool tourComplete = false;
+    float tourLength = 0.0f;            // Walking distance of the remaining tour
+    float tourPlanMilliseconds = 0.0f;  // Time of the last tour planning
+
+    // Wandering robots
+    std::vector<glm::vec3> wandererPositions;
+    std::vector<float> wandererAnimationTimes;
+
+    // Visitors (xyz = position, w = heading) and the cost of their last tick
+    std::vector<glm::vec4> crowdInstances;
+    float crowdMilliseconds = 0.0f;
+};
+
+// Blends two snapshots for a frame drawn between simulation ticks (alpha 0 = from, 1 = to)
+void interpolateSnapshots(const RoomSnapshot& from, const RoomSnapshot& to, float alpha, RoomSnapshot& out);
+
+// Control panel requests, applied by the simulation at its next update
+enum RoomCommandType {
+    ROOM_COMMAND_SET_AUTO_MODE,     // value: 0 = manual, 1 = automatic
+    ROOM_COMMAND_GO_TO_OBJECT       // value: tour stop
+};
+
+struct RoomCommand {
+    RoomCommandType type;
+    int value;
+};
 
 // Room class handles the rendering and logic of the virtual museum scene
 class Room {
 public:
-    Room();                  // Constructor
+    // Constructor: builds the rooms, exhibits, robots and lights of a scene
+    // - jobs: threads for model parsing and the visitors (may be null, see setJobSystem)
+    // - pack: cooked models used instead of the model files they were cooked from (may be null)
+    // - shareMeshes: share imported model files with other running instances (see SharedMesh.h)
+    Room(const SceneDescription& scene, JobSystem* jobs = nullptr, const AssetPack* pack = nullptr, bool shareMeshes = false);
     ~Room();                 // Destructor
 
-    // Renders the museum room with camera view and projection
-    void drawMuseumRoom(const glm::mat4& view, const glm::mat4& projection);
+    // Frame preparation, split from drawing so it can run as parallel jobs (jobs may be null)
+    // Marks the exhibits whose bounding sphere touches the view frustum
+    void cullExhibits(const glm::mat4& viewProjection, JobSystem* jobs);
+    // Builds matrices and colors of the visible exhibits for drawMuseumRoom
+    void buildDrawList(const RoomSnapshot& state, JobSystem* jobs);
+    int getVisibleExhibitCount() const { return (int)drawList.size(); }
+
+    // Renders the museum room with camera view and projection (GL thread, after buildDrawList)
+    // - state: robot and exhibit state to draw (render thread, never touches simulation state)
+    void drawMuseumRoom(const glm::mat4& view, const glm::mat4& projection, const RoomSnapshot& state);
+
+    // Updates the scene state over time (e.g., robot movement), simulation thread only
+    // Returns false when nothing visible changed, so the caller may idle
+    bool update(float deltaTime);
+
+    // Copies the current simulation state for the renderer, simulation thread only
+    void writeSnapshot(RoomSnapshot& snapshot, bool changed);
 
-    // Updates the scene state over time (e.g., robot movement)
-    void update(float deltaTime);
+    // True once automatic mode has scanned every object and the last popup has closed
+    bool isTourComplete() const;
+
+    // Coarser exhibit levels of detail when the GPU is over budget (render thread, see DynamicResolution)
+    void setLodBias(int bias) { lodBias = bias; }
+
+    // Optional GPU profiler that times the room shell, exhibit and robot passes
+    void setGpuProfiler(GpuProfiler* profiler) { gpuProfiler = profiler; }
+
+    // Optional job system that moves the visitors in parallel (set before the simulation starts)
+    void setJobSystem(JobSystem* jobs) { jobSystem = jobs; }
+
+    // Optional catalog with the popup texts of the exhibits, searchable from the control panel
+    // (render thread, not owned)
+    void setCatalog(const ExhibitCatalog* exhibitCatalog);
+
+    // Optional audio engine for the scan sounds (set before the simulation starts, not owned)
+    void setAudio(AudioEngine* engine);
+
+    // Scene size, e.g. for scaling measurements
+    int getExhibitCount() const { return (int)exhibitEntities.size(); }
+    long long getExhibitTriangleCount() const;
+
+    // Hot reload (render thread, between frames, see AssetReloader): the room takes the new
+    // version of a mesh and deletes the old one; cull bounds follow, navigation keeps the
+    // footprints the museum started with
+    void replaceModel(int mesh, ModelLoader* model);
+    Shader* getShader() const { return shader; }
+    Shader* getCrowdShader() const { return crowdShader; }
 
 private:
     // Floor geometry
@@ -34,35 +167,131 @@ private:
     // Main shader used in the room
     Shader* shader;
 
-    // Popup display state for scanned objects
-    bool showScanPopup = false;
-    int scannedObjectIndex = -1;
-    float popupTimer = 0.0f;
+    // GPU pass timing (not owned, may be null)
+    GpuProfiler* gpuProfiler = nullptr;
+
+    // Parallel simulation work (not owned, may be null)
+    JobSystem* jobSystem = nullptr;
+
+    // Texts of the scanned exhibits (not owned, may be null)
+    const ExhibitCatalog* catalog = nullptr;
+
+    // Search box over the catalog (render thread only). The index grows by a few
+    // milliseconds of entries per frame, so large catalogs never stall the UI.
+    SearchIndex searchIndex;
+    std::unordered_map<unsigned int, int> catalogStops;    // Tour stop of every catalog id on display
+    char searchText[128] = "";
+    std::vector<SearchResult> searchResults;
+    int searchMatches = 0;
+    int searchedDocuments = 0;      // Index size of the last query, the query reruns as it grows
+    float searchMilliseconds = 0.0f;
+    void indexCatalog();
+    void drawSearchPanel();
+
+    // Scan sounds, played at the guide (not owned, may be null)
+    AudioEngine* audio = nullptr;
+    int scanLoopSound = -1;
+    int scanDoneSound = -1;
 
-    // List of models loaded and displayed in the museum
+    // Meshes loaded or generated for the exhibits
     std::vector<ModelLoader*> models;
 
+    // Scene content
+    std::vector<glm::vec3> roomOrigins;      // Center of every room's floor
+    std::vector<int> tour;                   // Exhibits visited by the guide robot, in order
+    float lightAttenuation;                  // Quadratic light falloff
+
+    // Exhibits, lights and robots. Entities are only created while the room is built,
+    // so the render thread may read exhibits and lights while the simulation moves robots.
+    World world;
+    std::vector<Entity> exhibitEntities;     // By exhibit index of the scene
+    Entity guide;                            // Guide robot
+    std::vector<Entity> wandererEntities;    // Robots besides the guide
+    std::vector<std::vector<glm::vec3> > routes;  // Corners of every robot's walk (Locomotion::route)
+
+    // Queries of the simulation systems
+    WorldQuery<Transform, Locomotion> movementQuery;
+    WorldQuery<Animation, Locomotion> animationQuery;
+    WorldQuery<Animation, Scanner> scanQuery;
+    WorldQuery<Transform, Animation, Wanderer> wandererQuery;
+
+    // Queries of the render side
+    WorldQuery<Transform, ExhibitModel, CullBounds, Visibility> exhibitQuery;
+    WorldQuery<Transform, LightSource> lightQuery;
+
+    // Culling and draw list (render side)
+    glm::vec4 frustumPlanes[6];              // xyz = normal, w = distance
+    glm::vec4 depthPlane;                    // View depth of a point (clip w), for the level of detail
+    int lodBias = 0;
+    std::vector<ExhibitChunk> exhibitChunks; // Rows of every exhibit archetype in EXHIBIT_CHUNK pieces
+    std::vector<int> chunkVisibleCounts;     // Visible exhibits per chunk, then start offsets
+    std::vector<ExhibitDrawItem> drawList;
+    const RoomSnapshot* drawListState = nullptr;  // State used while building
+    static void cullChunk(void* room, int begin, int end);
+    static void buildChunk(void* room, int begin, int end);
+    void runChunks(JobSystem* jobs, void (*function)(void*, int, int));
+
+    // Per-object data of the frame, written to the stream buffer before the first draw so the
+    // draws only set where their objects start (render side). Exhibits are drawn in batches
+    // of one mesh and level of detail (batch = mesh * (EXHIBIT_MAX_LOD + 1) + lod).
+    StreamBuffer* objectStream;
+    std::vector<int> batchStarts;            // Draw list items per batch, then start offsets
+    std::vector<int> batchFill;              // Next free slot per batch while sorting
+    std::vector<int> batchItems;             // Draw list indices sorted by batch
+    int shellObjects = -1;                   // Texel of each group's first object, -1 = not drawn
+    int exhibitObjects = -1;
+    int robotObjects = -1;
+    int crowdObjects = -1;
+    int robotCount = 0;                      // Guide and wanderers drawn this frame
+    void writeObjects(const RoomSnapshot& state);
+
+    // View, projection and lights of a shader drawing into the scene
+    void setSceneUniforms(Shader& target, const glm::mat4& view, const glm::mat4& projection);
+
     // Room setup methods
     void setupFloor();       // Initializes floor geometry
     void setupWall();        // Initializes walls
     void setupPlinth();      // Initializes object display stands
-    void setupModels();      // Loads 3D object models
+    void setupModels(const std::vector<ExhibitMesh>& meshes, const AssetPack* pack, bool shareMeshes);  // Loads or uploads the exhibit meshes
 
     // Robot-related state and navigation
-    std::vector<glm::vec3> objectPositions;  // Positions of models for robot to visit
-    glm::vec3 robotPosition;                 // Current robot position
+    NavGrid* navGrid;                        // Walkable floor around the exhibits
+    std::vector<glm::vec3> objectPositions;  // Free spots next to the models for robot to visit
+    TourPlanner* tourPlanner;                // Order of the stops in automatic mode
+    std::vector<bool> objectVisited;         // Stops scanned so far
+    bool tourInterrupted = false;            // A manual target was picked since the last plan
+    int nextTourTarget() const;              // First unvisited stop of the planned order
+    RobotSkeleton robotSkeleton;             // Body part transform hierarchy of the robot
     int currentTargetIndex;                 // Index of the object robot is moving toward
     bool autoMode;                          // If true, robot navigates automatically
-    bool goToTargetManually = false;        // Manual override for movement
+    int manualTarget = -1;                  // Stop picked in the control panel, -1 if none
 
-    // Scanning logic
-    float scanAngle = 0.0f;
-    bool isScanning = false;
-    float scanTimer = 0.0f;
+    // Robots besides the guide, wandering between random exhibits
+    unsigned int wanderRandom = 12345u;      // Random state for picking their next exhibit
+    std::vector<RobotSkeleton> wandererSkeletons;  // Render side transforms of the wanderers
+
+    // Starts a robot's walk around the exhibits, false if it is already there
+    bool startWalk(Entity robot, const glm::vec3& target);
+
+    // Scripts of the guide robot, its popup and the wanderers (simulation thread)
+    BehaviorScheduler behaviors;
+    BehaviorHandle guideScript;
+    BehaviorHandle popupScript;
+    BehaviorTask guideBehavior();                    // Walk, scan and show the popup, stop after stop
+    BehaviorTask scan(int stop, float seconds);      // Rotating scan with its sounds
+    BehaviorTask showPopup(float seconds);           // Popup of the last scanned stop
+    BehaviorTask wandererBehavior(Entity robot);     // Random exhibit after random exhibit
+    void restartGuide();                             // Applies a new target or mode to the guide
+
+    // Visitor crowd of generated scenes (null without visitors), drawn instanced with its own shader
+    Crowd* crowd = nullptr;
+    Shader* crowdShader = nullptr;
 
-    // State for tracking if all objects have been scanned
-    bool allScanned = false;
-    float allScannedTimer = 0.0f;
+    // Commands from the control panel, the only state written by both threads
+    std::mutex commandMutex;
+    std::vector<RoomCommand> pendingCommands;
+    void pushCommand(RoomCommandType type, int value);
+    bool applyCommands();   // Returns true if any command was applied
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,241 @@
+#include "SceneGenerator.h"
+#include "ExhibitCatalog.h"
+#include <cmath>
+#include <iostream>
+
+// Distance between neighbouring room centers (rooms are 10x10, walls must not overlap)
+static const float ROOM_SPACING = 11.0f;
+
+// Museum model files reused by generated scenes when no triangle count is given
+static const char* MUSEUM_MODELS[] = {
+    "models/model1.obj", "models/model2.obj", "models/model3.obj", "models/model5.obj", "models/model4.obj"
+};
+static const int MUSEUM_MODEL_COUNT = 5;
+
+// Number of different generated mesh shapes
+static const int GENERATED_VARIANTS = 4;
+
+// Small deterministic random generator (LCG), returns a value in [0, 1)
+static float nextRandom(unsigned int& state) {
+    state = state * 1664525u + 1013904223u;
+    return (state >> 8) * (1.0f / 16777216.0f);
+}
+
+SceneDescription defaultMuseumScene() {
+    SceneDescription scene;
+    scene.roomOrigins.push_back(glm::vec3(0.0f));
+
+    for (int i = 0; i < MUSEUM_MODEL_COUNT; i++) {
+        ExhibitMesh mesh;
+        mesh.path = MUSEUM_MODELS[i];
+        scene.meshes.push_back(mesh);
+    }
+
+    // Hand-placed exhibits: mesh, position, yaw, scale, color, catalog entry
+    glm::vec3 stone(1.0f, 0.95f, 0.7f);
+    scene.exhibits.push_back({ 0, glm::vec3(3.0f, 0.0f, 3.0f), 0.0f, 1.2f, stone, 0 });      // model1.obj
+    scene.exhibits.push_back({ 1, glm::vec3(-3.5f, 0.0f, -1.0f), 0.0f, 1.5f, stone, 1 });    // model2.obj
+    scene.exhibits.push_back({ 2, glm::vec3(0.0f, 1.0f, -6.0f), 0.0f, 2.0f, stone, 2 });     // model3.obj
+    scene.exhibits.push_back({ 3, glm::vec3(4.0f, 0.0f, -4.0f), 0.0f, 1.8f, stone, 3 });     // model5.obj
+    scene.exhibits.push_back({ 4, glm::vec3(-3.5f, 0.0f, 2.5f), -90.0f, 1.4f, stone, 4 });   // model4.obj
+
+    for (int i = 0; i < (int)scene.exhibits.size(); i++) scene.tour.push_back(i);
+
+    scene.robotStarts.push_back(glm::vec3(0.0f));
+    scene.lights.push_back({ glm::vec3(0.0f, 4.5f, 0.0f), glm::vec3(1.0f) });
+    return scene;
+}
+
+SceneDescription catalogMuseumScene(const ExhibitCatalog& catalog) {
+    SceneDescription scene;
+    scene.roomOrigins.push_back(glm::vec3(0.0f));
+
+    // One mesh per model file, shared by the entries that use it
+    glm::vec3 stone(1.0f, 0.95f, 0.7f);
+    for (int i = 0; i < catalog.getEntryCount(); i++) {
+        const CatalogEntry& entry = catalog.getEntry(i);
+        std::string model = catalog.text(entry.model);
+        if (model.empty()) continue;
+        ModelImporter importer = MODEL_IMPORTER_AUTO;
+        parseModelImporter(catalog.text(entry.importer), importer);
+
+        int mesh = 0;
+        while (mesh < (int)scene.meshes.size() && (scene.meshes[mesh].path != model || scene.meshes[mesh].importer != importer)) mesh++;
+        if (mesh == (int)scene.meshes.size()) {
+            ExhibitMesh added;
+            added.path = model;
+            added.importer = importer;
+            scene.meshes.push_back(added);
+        }
+        glm::vec3 position(entry.position[0], entry.position[1], entry.position[2]);
+        scene.exhibits.push_back({ mesh, position, entry.yaw, entry.scale, stone, (int)entry.id });
+    }
+    if (scene.exhibits.empty()) return defaultMuseumScene();
+
+    for (int i = 0; i < (int)scene.exhibits.size(); i++) scene.tour.push_back(i);
+
+    scene.robotStarts.push_back(glm::vec3(0.0f));
+    scene.lights.push_back({ glm::vec3(0.0f, 4.5f, 0.0f), glm::vec3(1.0f) });
+    return scene;
+}
+
+SceneDescription generateScene(const SceneParams& params) {
+    SceneDescription scene;
+    unsigned int random = params.seed * 2654435761u + 1u;
+
+    // Rooms on a square grid, the first room keeps the origin
+    int rooms = params.rooms > 0 ? params.rooms : 1;
+    int columns = (int)std::ceil(std::sqrt((float)rooms));
+    for (int i = 0; i < rooms; i++) {
+        scene.roomOrigins.push_back(glm::vec3((i % columns) * ROOM_SPACING, 0.0f, -(i / columns) * ROOM_SPACING));
+    }
+
+    // Meshes: either the museum models or generated shapes of the requested size
+    int meshCount;
+    if (params.trianglesPerExhibit > 0) {
+        meshCount = GENERATED_VARIANTS;
+        for (int i = 0; i < meshCount; i++) {
+            ExhibitMesh mesh;
+            mesh.vertices = generateExhibitMesh(i, params.trianglesPerExhibit);
+            scene.meshes.push_back(mesh);
+        }
+    }
+    else {
+        meshCount = MUSEUM_MODEL_COUNT;
+        for (int i = 0; i < meshCount; i++) {
+            ExhibitMesh mesh;
+            mesh.path = MUSEUM_MODELS[i];
+            scene.meshes.push_back(mesh);
+        }
+    }
+
+    // Exhibits on a jittered grid inside each room (8x8 usable floor)
+    int perRoom = params.exhibitsPerRoom > 0 ? params.exhibitsPerRoom : 0;
+    int grid = (int)std::ceil(std::sqrt((float)perRoom));
+    float cell = grid > 0 ? 8.0f / grid : 8.0f;
+    float scale = glm::clamp(cell * 0.5f, 0.05f, 1.5f);
+
+    for (int room = 0; room < rooms; room++) {
+        for (int i = 0; i < perRoom; i++) {
+            float jitterX = (nextRandom(random) - 0.5f) * cell * 0.3f;
+            float jitterZ = (nextRandom(random) - 0.5f) * cell * 0.3f;
+            glm::vec3 local(-4.0f + (i % grid + 0.5f) * cell + jitterX, 0.0f, -4.0f + (i / grid + 0.5f) * cell + jitterZ);
+
+            Exhibit exhibit;
+            exhibit.mesh = (int)(nextRandom(random) * meshCount) % meshCount;
+            exhibit.position = scene.roomOrigins[room] + local;
+            exhibit.yaw = nextRandom(random) * 360.0f;
+            exhibit.scale = scale * (0.8f + 0.4f * nextRandom(random));
+            exhibit.color = glm::vec3(0.6f + 0.4f * nextRandom(random), 0.6f + 0.4f * nextRandom(random), 0.6f + 0.4f * nextRandom(random));
+            exhibit.catalogIndex = -1;
+            scene.exhibits.push_back(exhibit);
+        }
+    }
+
+    // The guide visits the first exhibits of the first room
+    for (int i = 0; i < perRoom && i < params.tourLength; i++) scene.tour.push_back(i);
+
+    // Guide starts in the middle of the first room, the others anywhere
+    int robots = params.robots > 0 ? params.robots : 1;
+    scene.robotStarts.push_back(scene.roomOrigins[0]);
+    for (int i = 1; i < robots; i++) {
+        int room = (int)(nextRandom(random) * rooms) % rooms;
+        glm::vec3 local((nextRandom(random) - 0.5f) * 8.0f, 0.0f, (nextRandom(random) - 0.5f) * 8.0f);
+        scene.robotStarts.push_back(scene.roomOrigins[room] + local);
+    }
+
+    // Visitors spread evenly over the rooms
+    for (int i = 0; i < params.visitors; i++) {
+        glm::vec3 local((nextRandom(random) - 0.5f) * 8.0f, 0.0f, (nextRandom(random) - 0.5f) * 8.0f);
+        scene.visitorStarts.push_back(scene.roomOrigins[i % rooms] + local);
+    }
+
+    // Lights spread over the rooms under the ceiling
+    int lights = params.lights > 0 ? params.lights : 1;
+    if (lights > MAX_SCENE_LIGHTS) {
+        std::cerr << "Scene generator: " << lights << " lights requested, the shader supports "
+            << MAX_SCENE_LIGHTS << std::endl;
+        lights = MAX_SCENE_LIGHTS;
+    }
+    for (int i = 0; i < lights; i++) {
+        glm::vec3 local((nextRandom(random) - 0.5f) * 6.0f, 4.5f, (nextRandom(random) - 0.5f) * 6.0f);
+        glm::vec3 color(0.8f + 0.2f * nextRandom(random), 0.8f + 0.2f * nextRandom(random), 0.8f + 0.2f * nextRandom(random));
+        scene.lights.push_back({ scene.roomOrigins[i % rooms] + local, color });
+    }
+
+    // Several lights share a room, so they have to fade with distance
+    scene.lightAttenuation = lights > 1 ? 0.02f : 0.0f;
+    return scene;
+}
+
+// Radius of a generated shape at height t (0 = base, 1 = top) and angle
+static float profileRadius(int variant, float t, float angle) {
+    const float pi = 3.14159265f;
+    switch (variant % GENERATED_VARIANTS) {
+    case 0:  // Vase
+        return 0.2f + 0.12f * std::sin(t * pi * 1.5f) + 0.05f * t;
+    case 1:  // Fluted column
+        return 0.15f * (1.0f + 0.1f * std::cos(angle * 8.0f));
+    case 2:  // Rounded bust
+        return 0.05f + 0.35f * std::sqrt(t * (1.0f - t) * 4.0f) * 0.8f;
+    default: // Obelisk
+        return 0.05f + 0.2f * (1.0f - t);
+    }
+}
+
+// Appends one flat-shaded triangle
+static void addTriangle(std::vector<Vertex>& vertices, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+    glm::vec3 normal = glm::cross(b - a, c - a);
+    float length = glm::length(normal);
+    normal = length > 0.0f ? normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+
+    Vertex vertex;
+    vertex.Normal = normal;
+    vertex.Position = a; vertices.push_back(vertex);
+    vertex.Position = b; vertices.push_back(vertex);
+    vertex.Position = c; vertices.push_back(vertex);
+}
+
+std::vector<Vertex> generateExhibitMesh(int variant, int triangleCount) {
+    // Sides take 2 * rings * segments triangles, the two caps 2 * segments
+    int segments = glm::max(3, (int)std::sqrt(triangleCount * 0.5f));
+    int rings = glm::max(1, (triangleCount - 2 * segments) / (2 * segments));
+    float height = 1.0f;
+
+    // Ring points, bottom to top
+    std::vector<glm::vec3> points((rings + 1) * segments);
+    for (int r = 0; r <= rings; r++) {
+        float t = (float)r / rings;
+        for (int s = 0; s < segments; s++) {
+            float angle = s * 6.2831853f / segments;
+            float radius = profileRadius(variant, t, angle);
+            points[r * segments + s] = glm::vec3(radius * std::cos(angle), t * height, radius * std::sin(angle));
+        }
+    }
+
+    std::vector<Vertex> vertices;
+    vertices.reserve((2 * rings * segments + 2 * segments) * 3);
+
+    // Side quads, counter-clockwise seen from outside
+    for (int r = 0; r < rings; r++) {
+        for (int s = 0; s < segments; s++) {
+            int next = (s + 1) % segments;
+            const glm::vec3& a = points[r * segments + s];
+            const glm::vec3& b = points[r * segments + next];
+            const glm::vec3& c = points[(r + 1) * segments + next];
+            const glm::vec3& d = points[(r + 1) * segments + s];
+            addTriangle(vertices, a, c, b);
+            addTriangle(vertices, a, d, c);
+        }
+    }
+
+    // Bottom and top caps
+    glm::vec3 bottom(0.0f, 0.0f, 0.0f);
+    glm::vec3 top(0.0f, height, 0.0f);
+    for (int s = 0; s < segments; s++) {
+        int next = (s + 1) % segments;
+        addTriangle(vertices, bottom, points[s], points[next]);
+        addTriangle(vertices, top, points[rings * segments + next], points[rings * segments + s]);
+    }
+    return vertices;
+}
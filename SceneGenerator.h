@@ -0,0 +1,75 @@
+#ifndef SCENEGENERATOR_H
+#define SCENEGENERATOR_H
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include "ModelLoader.h"
+
+class ExhibitCatalog;
+
+// Largest number of lights the room shader accepts (see fragment_shader.glsl)
+#define MAX_SCENE_LIGHTS 32
+
+// Mesh used by exhibits: either a model file or generated vertices
+struct ExhibitMesh {
+    std::string path;               // Model file, empty for generated meshes
+    ModelImporter importer = MODEL_IMPORTER_AUTO;   // How the model file is read
+    std::vector<Vertex> vertices;   // Generated triangles (used when path is empty)
+};
+
+// One object on display
+struct Exhibit {
+    int mesh;               // Index into SceneDescription::meshes
+    glm::vec3 position;     // Position on the floor of its room
+    float yaw;              // Rotation around the up axis in degrees
+    float scale;            // Uniform scale
+    glm::vec3 color;        // Base color
+    int catalogIndex;       // Entry of the museum information texts, -1 for synthetic exhibits
+};
+
+// Point light
+struct SceneLight {
+    glm::vec3 position;
+    glm::vec3 color;
+};
+
+// Everything Room needs to build a museum
+struct SceneDescription {
+    std::vector<glm::vec3> roomOrigins;     // Center of every room's floor
+    std::vector<ExhibitMesh> meshes;
+    std::vector<Exhibit> exhibits;
+    std::vector<int> tour;                  // Exhibits the guide robot visits, in order
+    std::vector<glm::vec3> robotStarts;     // First entry is the guide robot, the others wander around
+    std::vector<glm::vec3> visitorStarts;   // Crowd of visitors walking between exhibits (see Crowd)
+    std::vector<SceneLight> lights;         // At most MAX_SCENE_LIGHTS
+    float lightAttenuation = 0.0f;          // Quadratic distance falloff, 0 = no falloff
+};
+
+// Parameters of a generated museum
+struct SceneParams {
+    int rooms = 1;                  // --rooms=N
+    int exhibitsPerRoom = 5;        // --exhibits=N
+    int robots = 1;                 // --robots=N (the first one is the guide)
+    int visitors = 0;               // --visitors=N
+    int lights = 1;                 // --lights=N
+    int trianglesPerExhibit = 0;    // --triangles=N (0 = reuse the museum's model files)
+    int tourLength = 5;             // Exhibits of the first room visited by the guide
+    unsigned int seed = 1;          // --seed=N
+};
+
+// The hand-placed museum: one room, five models, one robot and one light
+SceneDescription defaultMuseumScene();
+
+// The museum room laid out by a catalog: every entry with a model file becomes an exhibit
+// (falls back to defaultMuseumScene when no entry has a model)
+SceneDescription catalogMuseumScene(const ExhibitCatalog& catalog);
+
+// Builds a museum from parameters; the same parameters always give the same scene
+SceneDescription generateScene(const SceneParams& params);
+
+// Closed, lathed mesh with roughly the requested number of triangles
+// - variant: selects the profile (vase, column, bust, ...)
+std::vector<Vertex> generateExhibitMesh(int variant, int triangleCount);
+
+#endif
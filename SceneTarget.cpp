@@ -0,0 +1,110 @@
+#include "SceneTarget.h"
+#include <iostream>
+#include <algorithm>
+
+SceneTarget::SceneTarget() {
+    fbo = 0;
+    colorTexture = 0;
+    depthBuffer = 0;
+    width = height = 0;
+    renderWidth = renderHeight = 0;
+
+    glGenFramebuffers(1, &fbo);
+    glGenTextures(1, &colorTexture);
+    glGenRenderbuffers(1, &depthBuffer);
+    glGenVertexArrays(1, &emptyVAO);
+
+    upscaleShader = new Shader("upscale_vertex.glsl", "upscale_fragment.glsl");
+}
+
+SceneTarget::~SceneTarget() {
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteTextures(1, &colorTexture);
+    glDeleteRenderbuffers(1, &depthBuffer);
+    glDeleteVertexArrays(1, &emptyVAO);
+    delete upscaleShader;
+}
+
+void SceneTarget::resize(int newWidth, int newHeight) {
+    // Attachments are only reallocated when the window size changes,
+    // resolution scaling renders into a sub-rectangle instead
+    if (newWidth == width && newHeight == height) return;
+    if (newWidth <= 0 || newHeight <= 0) return;
+    width = newWidth;
+    height = newHeight;
+
+    // Color attachment, linear filtering is used by the upscale pass
+    glBindTexture(GL_TEXTURE_2D, colorTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // Depth attachment
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "ERROR::FRAMEBUFFER::SCENE_TARGET_INCOMPLETE\n";
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void SceneTarget::bind(int newRenderWidth, int newRenderHeight) {
+    // Never render outside of the allocated attachments
+    renderWidth = newRenderWidth < width ? newRenderWidth : width;
+    renderHeight = newRenderHeight < height ? newRenderHeight : height;
+    if (renderWidth < 1) renderWidth = 1;
+    if (renderHeight < 1) renderHeight = 1;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, renderWidth, renderHeight);
+}
+
+void SceneTarget::readPixels(std::vector<unsigned char>& pixels, int& outWidth, int& outHeight) {
+    outWidth = renderWidth;
+    outHeight = renderHeight;
+    pixels.resize((size_t)renderWidth * renderHeight * 4);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, renderWidth, renderHeight, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+    // OpenGL returns the bottom row first, images expect the top row first
+    size_t rowBytes = (size_t)renderWidth * 4;
+    std::vector<unsigned char> row(rowBytes);
+    for (int y = 0; y < renderHeight / 2; y++) {
+        unsigned char* top = &pixels[y * rowBytes];
+        unsigned char* bottom = &pixels[(renderHeight - 1 - y) * rowBytes];
+        std::copy(top, top + rowBytes, row.begin());
+        std::copy(bottom, bottom + rowBytes, top);
+        std::copy(row.begin(), row.end(), bottom);
+    }
+}
+
+void SceneTarget::present(int windowWidth, int windowHeight, float sharpness) {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, windowWidth, windowHeight);
+
+    upscaleShader->use();
+    upscaleShader->setInt("sceneTexture", 0);
+    upscaleShader->setVec2("uvScale", glm::vec2((float)renderWidth / width, (float)renderHeight / height));
+    upscaleShader->setVec2("texelSize", glm::vec2(1.0f / width, 1.0f / height));
+    upscaleShader->setFloat("sharpness", sharpness);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, colorTexture);
+
+    // One triangle covering the whole screen, positions are generated in the vertex shader
+    glBindVertexArray(emptyVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
@@ -0,0 +1,47 @@
+#ifndef SCENETARGET_H
+#define SCENETARGET_H
+
+#include <glad/glad.h>
+#include <vector>
+#include "Shader.h"
+
+// Offscreen framebuffer the 3D scene is rendered into, upscaled to the window afterwards
+class SceneTarget {
+public:
+    SceneTarget();
+    ~SceneTarget();
+
+    // Makes sure the color/depth attachments can hold width x height pixels
+    void resize(int width, int height);
+
+    // Binds the framebuffer and sets the viewport to the scaled render area
+    void bind(int renderWidth, int renderHeight);
+
+    // Draws the rendered area onto the default framebuffer with bilinear upscaling and sharpening
+    // - sharpness: 0 disables the sharpening filter, 1 is the strongest setting
+    void present(int windowWidth, int windowHeight, float sharpness);
+
+    // Copies the last rendered area into RGBA8 pixels, top row first
+    void readPixels(std::vector<unsigned char>& pixels, int& outWidth, int& outHeight);
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+    // Texture holding the rendered scene (valid after bind/draw)
+    unsigned int getColorTexture() const { return colorTexture; }
+
+    // Upscale pass program (for hot reloading)
+    Shader* getUpscaleShader() const { return upscaleShader; }
+
+private:
+    unsigned int fbo;              // Framebuffer object
+    unsigned int colorTexture;     // RGBA8 color attachment
+    unsigned int depthBuffer;      // Depth/stencil renderbuffer
+    unsigned int emptyVAO;         // Core profile needs a bound VAO for the fullscreen triangle
+    int width, height;             // Allocated size of the attachments
+    int renderWidth, renderHeight; // Area used by the last bind()
+
+    Shader* upscaleShader;         // Bilinear upscale + sharpening pass
+};
+
+#endif
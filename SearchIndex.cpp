@@ -0,0 +1,113 @@
+#include "SearchIndex.h"
+#include <algorithm>
+#include <cmath>
+
+// Words too common to narrow a search down, left out of the index
+static const char* STOP_WORDS[] = { "a", "an", "and", "at", "by", "from", "in", "is", "it", "of", "on", "or", "the", "to", "with" };
+
+static bool isStopWord(const std::string& word) {
+    if (word.size() > 4) return false;
+    for (size_t i = 0; i < sizeof(STOP_WORDS) / sizeof(STOP_WORDS[0]); i++) {
+        if (word == STOP_WORDS[i]) return true;
+    }
+    return false;
+}
+
+// Words are runs of letters and digits; UTF-8 bytes (accented letters) count as letters
+static bool isWordByte(unsigned char ch) {
+    return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') || ch >= 0x80;
+}
+
+// Words are lowercased, UTF-8 bytes are kept as they are
+void SearchIndex::tokenize(const char* text, std::vector<std::string>& words) {
+    std::string word;
+    for (const char* c = text; ; c++) {
+        unsigned char ch = (unsigned char)*c;
+        if (isWordByte(ch)) word += (ch >= 'A' && ch <= 'Z') ? (char)(ch + 32) : (char)ch;
+        else if (!word.empty()) {
+            words.push_back(word);
+            word.clear();
+        }
+        if (ch == '\0') break;
+    }
+}
+
+int SearchIndex::addDocument(const char* title, const char* period, const char* description) {
+    int document = documentCount++;
+
+    // Weight of every distinct word of the document (a handful, so a linear search is enough)
+    std::vector<std::string> words;
+    tokenize(title, words);
+    size_t titleWords = words.size();
+    tokenize(period, words);
+    tokenize(description, words);
+    std::vector<std::pair<std::string, float> > weights;
+    for (size_t i = 0; i < words.size(); i++) {
+        if (isStopWord(words[i])) continue;
+        float weight = i < titleWords ? SEARCH_TITLE_WEIGHT : SEARCH_TEXT_WEIGHT;
+        size_t w = 0;
+        while (w < weights.size() && weights[w].first != words[i]) w++;
+        if (w == weights.size()) weights.push_back(std::make_pair(words[i], weight));
+        else weights[w].second += weight;
+    }
+
+    // Documents are added in order, so every posting list stays sorted by document
+    for (size_t w = 0; w < weights.size(); w++) {
+        terms[weights[w].first].push_back({ document, weights[w].second });
+    }
+    accumulators.push_back({ 0, 0.0f });
+    return document;
+}
+
+int SearchIndex::search(const std::string& query, std::vector<SearchResult>& results, int maxResults) {
+    results.clear();
+    std::vector<std::string> words;
+    tokenize(query.c_str(), words);
+
+    // Stop words are not indexed, so complete ones are left out of the query; the last word
+    // may still be being typed ("the" on the way to "theatre") and stays a prefix
+    bool typing = !query.empty() && isWordByte((unsigned char)query.back());
+    size_t queryWords = 0;
+    for (size_t i = 0; i < words.size(); i++) {
+        if (!isStopWord(words[i]) || (typing && i + 1 == words.size())) words[queryWords++] = words[i];
+    }
+    words.resize(queryWords);
+    if (words.empty() || documentCount == 0) return 0;
+
+    // A document counts for word k only if it matched words 0..k-1 (every word must match)
+    for (int k = 0; k < (int)words.size(); k++) {
+        const std::string& prefix = words[k];
+        std::map<std::string, std::vector<Posting> >::const_iterator term = terms.lower_bound(prefix);
+        for (; term != terms.end() && term->first.compare(0, prefix.size(), prefix) == 0; ++term) {
+            // Rare words and whole-word matches rank higher
+            const std::vector<Posting>& postings = term->second;
+            float rarity = std::log(1.0f + (float)documentCount / postings.size());
+            float bonus = term->first.size() == prefix.size() ? 2.0f : 1.0f;
+            for (size_t p = 0; p < postings.size(); p++) {
+                Accumulator& accumulator = accumulators[postings[p].document];
+                if (accumulator.matchedWords < k) continue;
+                if (accumulator.matchedWords == 0) touched.push_back(postings[p].document);
+                accumulator.matchedWords = k + 1;
+                accumulator.score += postings[p].weight * rarity * bonus;
+            }
+        }
+    }
+
+    // Collect the documents that matched every word and reset the scratch
+    int wordCount = (int)words.size();
+    for (size_t i = 0; i < touched.size(); i++) {
+        Accumulator& accumulator = accumulators[touched[i]];
+        if (accumulator.matchedWords == wordCount) results.push_back({ touched[i], accumulator.score });
+        accumulator.matchedWords = 0;
+        accumulator.score = 0.0f;
+    }
+    touched.clear();
+
+    int matches = (int)results.size();
+    size_t kept = std::min(results.size(), (size_t)std::max(maxResults, 0));
+    std::partial_sort(results.begin(), results.begin() + kept, results.end(), [](const SearchResult& a, const SearchResult& b) {
+        return a.score != b.score ? a.score > b.score : a.document < b.document;
+    });
+    results.resize(kept);
+    return matches;
+}
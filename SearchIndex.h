@@ -0,0 +1,55 @@
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Weights of a word by the field it appears in
+#define SEARCH_TITLE_WEIGHT 3.0f
+#define SEARCH_TEXT_WEIGHT 1.0f
+
+// One hit of a query, best first
+struct SearchResult {
+    int document;       // Number returned by addDocument
+    float score;
+};
+
+// Inverted index over short documents (title, period, description): every word
+// maps to the documents containing it. The words are kept sorted, so all words
+// starting with a query prefix are one contiguous range.
+// Queries match documents containing every query word as a word prefix
+// ("sarc rom" finds "Sarcophagus ... Roman"), ranked by field weight, rarity of
+// the word and exact matches. Documents can be added at any time, e.g. a few
+// thousand per frame while a large catalog loads; queries see those added so far.
+class SearchIndex {
+public:
+    // Indexes a document, returns its number (0, 1, 2, ... in order of addition)
+    int addDocument(const char* title, const char* period, const char* description);
+    int getDocumentCount() const { return documentCount; }
+    int getTermCount() const { return (int)terms.size(); }
+
+    // Best matches first, at most maxResults; returns how many documents matched in total
+    int search(const std::string& query, std::vector<SearchResult>& results, int maxResults);
+
+private:
+    struct Posting {
+        int document;
+        float weight;   // Field weights of all occurrences in the document
+    };
+
+    std::map<std::string, std::vector<Posting> > terms;
+    int documentCount = 0;
+
+    // Query scratch, one slot per document (reset through the touched list)
+    struct Accumulator {
+        int matchedWords;
+        float score;
+    };
+    std::vector<Accumulator> accumulators;
+    std::vector<int> touched;
+
+    static void tokenize(const char* text, std::vector<std::string>& words);
+};
+
+#endif
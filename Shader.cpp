@@ -1,9 +1,43 @@
 #include "Shader.h"
+#include <cstring>
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// GL_KHR_parallel_shader_compile: programs link on driver threads and their status can be
+// asked without waiting
+static bool parallelCompileSupported() {
+    static int supported = -1;
+    if (supported < 0) {
+        int count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        supported = 0;
+        for (int i = 0; i < count && !supported; i++) {
+            const char* name = (const char*)glGetStringi(GL_EXTENSIONS, i);
+            if (name && std::strcmp(name, "GL_KHR_parallel_shader_compile") == 0) supported = 1;
+        }
+    }
+    return supported == 1;
+}
 
 // Constructor: loads and compiles vertex and fragment shaders
-Shader::Shader(const char* vertexPath, const char* fragmentPath) {
+Shader::Shader(const char* vertexPath, const char* fragmentPath) : vertexPath(vertexPath), fragmentPath(fragmentPath) {
     std::string vertexCode;
     std::string fragmentCode;
+    readFiles(vertexCode, fragmentCode);
+
+    unsigned int vertex, fragment;
+    ID = createProgram(vertexCode, fragmentCode, vertex, fragment);
+    checkProgram(ID, vertex, fragment);
+
+    // Delete the shaders as theyre linked into our program now and no longer necessary
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
+}
+
+// Reads both shader files, false (after printing why) if one cannot be read
+bool Shader::readFiles(std::string& vertexCode, std::string& fragmentCode) const {
     std::ifstream vShaderFile;
     std::ifstream fShaderFile;
 
@@ -13,14 +47,14 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath) {
 
     try {
         // Check if the vertex shader file can be opened
-        std::ifstream test(vertexPath);
+        std::ifstream test(vertexPath.c_str());
         if (!test.is_open()) {
             std::cout << "Vertex shader file could NOT be opened! >>> " << vertexPath << std::endl;
         }
 
         // Open shader files
-        vShaderFile.open(vertexPath);
-        fShaderFile.open(fragmentPath);
+        vShaderFile.open(vertexPath.c_str());
+        fShaderFile.open(fragmentPath.c_str());
 
         // Read file contents into string streams
         std::stringstream vShaderStream, fShaderStream;
@@ -37,21 +71,41 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath) {
     }
     catch (std::ifstream::failure& e) {
         std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ\n";
+        return false;
     }
+    return true;
+}
 
+// Compiles both stages and links them; the driver may still be working on it on return
+unsigned int Shader::createProgram(const std::string& vertexCode, const std::string& fragmentCode,
+                                   unsigned int& vertex, unsigned int& fragment) {
     // Convert strings to C-style strings for OpenGL
     const char* vShaderCode = vertexCode.c_str();
     const char* fShaderCode = fragmentCode.c_str();
 
-    unsigned int vertex, fragment;
-    int success;
-    char infoLog[512];
-
     // Compile vertex shader
     vertex = glCreateShader(GL_VERTEX_SHADER);
     glShaderSource(vertex, 1, &vShaderCode, NULL);
     glCompileShader(vertex);
 
+    // Compile fragment shader
+    fragment = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fragment, 1, &fShaderCode, NULL);
+    glCompileShader(fragment);
+
+    // Create shader program and link shaders
+    unsigned int program = glCreateProgram();
+    glAttachShader(program, vertex);
+    glAttachShader(program, fragment);
+    glLinkProgram(program);
+    return program;
+}
+
+// Prints the compile and link errors of a program, false if it cannot be used
+bool Shader::checkProgram(unsigned int program, unsigned int vertex, unsigned int fragment) {
+    int success;
+    char infoLog[512];
+
     // Check for vertex shader compile errors
     glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
     if (!success) {
@@ -59,11 +113,6 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath) {
         std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << "\n";
     }
 
-    // Compile fragment shader
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, NULL);
-    glCompileShader(fragment);
-
     // Check for fragment shader compile errors
     glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
     if (!success) {
@@ -71,22 +120,60 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath) {
         std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << "\n";
     }
 
-    // Create shader program and link shaders
-    ID = glCreateProgram();
-    glAttachShader(ID, vertex);
-    glAttachShader(ID, fragment);
-    glLinkProgram(ID);
-
     // Check for linking errors
-    glGetProgramiv(ID, GL_LINK_STATUS, &success);
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
     if (!success) {
-        glGetProgramInfoLog(ID, 512, NULL, infoLog);
+        glGetProgramInfoLog(program, 512, NULL, infoLog);
         std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << "\n";
     }
+    return success != 0;
+}
 
-    // Delete the shaders as theyre linked into our program now and no longer necessary
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+bool Shader::beginReload() {
+    cancelReload();
+    std::string vertexCode;
+    std::string fragmentCode;
+    if (!readFiles(vertexCode, fragmentCode)) return false;
+    pendingProgram = createProgram(vertexCode, fragmentCode, pendingVertex, pendingFragment);
+    pendingPolls = 0;
+    return true;
+}
+
+ShaderReloadState Shader::pollReload() {
+    if (pendingProgram == 0) return SHADER_RELOAD_NONE;
+
+    // Without parallel compiling, asking for the status can wait for the driver; asking one
+    // frame later gives drivers that compile on their own threads time to finish
+    if (parallelCompileSupported()) {
+        int done = 0;
+        glGetProgramiv(pendingProgram, GL_COMPLETION_STATUS_KHR, &done);
+        if (!done) return SHADER_RELOAD_PENDING;
+    }
+    else if (pendingPolls++ == 0) {
+        return SHADER_RELOAD_PENDING;
+    }
+
+    // A program with errors is dropped and the current one stays
+    bool linked = checkProgram(pendingProgram, pendingVertex, pendingFragment);
+    unsigned int program = pendingProgram;
+    pendingProgram = 0;
+    glDeleteShader(pendingVertex);
+    glDeleteShader(pendingFragment);
+    if (!linked) {
+        glDeleteProgram(program);
+        return SHADER_RELOAD_FAILED;
+    }
+    glDeleteProgram(ID);
+    ID = program;
+    return SHADER_RELOAD_DONE;
+}
+
+void Shader::cancelReload() {
+    if (pendingProgram == 0) return;
+    glDeleteShader(pendingVertex);
+    glDeleteShader(pendingFragment);
+    glDeleteProgram(pendingProgram);
+    pendingProgram = 0;
 }
 
 // Activate the shader program
@@ -109,6 +196,11 @@ void Shader::setFloat(const std::string& name, float value) const {
     glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
 }
 
+// Utility function to set a vec2 uniform (e.g., texture coordinate scale)
+void Shader::setVec2(const std::string& name, const glm::vec2& value) const {
+    glUniform2f(glGetUniformLocation(ID, name.c_str()), value.x, value.y);
+}
+
 // Utility function to set a 4x4 matrix uniform (e.g., for transformations)
 void Shader::setMat4(const std::string& name, const glm::mat4& mat) const {
     glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
@@ -8,6 +8,14 @@
 #include <sstream>
 #include <iostream>
 
+// Progress of a shader reload (see Shader::pollReload)
+enum ShaderReloadState {
+    SHADER_RELOAD_NONE,      // Nothing is compiling
+    SHADER_RELOAD_PENDING,   // Still compiling, the current program stays in use
+    SHADER_RELOAD_DONE,      // ID is the new program
+    SHADER_RELOAD_FAILED     // Errors were printed, ID is unchanged
+};
+
 // A utility class to manage vertex and fragment shaders
 class Shader {
 public:
@@ -17,6 +25,16 @@ public:
     // Constructor: builds the shader program from vertex and fragment shader file paths
     Shader(const char* vertexPath, const char* fragmentPath);
 
+    const std::string& getVertexPath() const { return vertexPath; }
+    const std::string& getFragmentPath() const { return fragmentPath; }
+
+    // Hot reload: compiles the shader files again into a new program while the current one
+    // stays in use (false if a file cannot be read). pollReload() swaps it in once the driver
+    // is done, without waiting on drivers with GL_KHR_parallel_shader_compile.
+    bool beginReload();
+    ShaderReloadState pollReload();
+    void cancelReload();
+
     // Activate the shader program
     void use();
 
@@ -24,8 +42,23 @@ public:
     void setBool(const std::string& name, bool value) const;     // Set a boolean uniform
     void setInt(const std::string& name, int value) const;       // Set an integer uniform
     void setFloat(const std::string& name, float value) const;   // Set a float uniform
+    void setVec2(const std::string& name, const glm::vec2& value) const; // Set a vec2 uniform (e.g., texture coordinate scale)
     void setVec3(const std::string& name, const glm::vec3& value) const; // Set a vec3 uniform (e.g., position, color)
     void setMat4(const std::string& name, const glm::mat4& mat) const;   // Set a 4x4 matrix uniform (e.g., transformations)
+
+private:
+    std::string vertexPath;
+    std::string fragmentPath;
+
+    // Program being compiled by beginReload(), 0 when none
+    unsigned int pendingProgram = 0;
+    unsigned int pendingVertex = 0, pendingFragment = 0;
+    int pendingPolls = 0;
+
+    bool readFiles(std::string& vertexCode, std::string& fragmentCode) const;
+    static unsigned int createProgram(const std::string& vertexCode, const std::string& fragmentCode,
+                                      unsigned int& vertex, unsigned int& fragment);
+    static bool checkProgram(unsigned int program, unsigned int vertex, unsigned int fragment);
 };
 
 #endif
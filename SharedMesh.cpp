@@ -0,0 +1,288 @@
+#include "SharedMesh.h"
+#include "AssetPack.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const unsigned int SHARED_MESH_MAGIC = 0x4D48534D;   // "MSHM"
+static const unsigned int SHARED_MESH_VERSION = 1;
+
+// Segment layout: this header, then vertexCount Vertex structs
+struct SharedMeshHeader {
+    unsigned int magic;
+    unsigned int version;
+    std::atomic<unsigned int> ready;    // Set last by the creator
+    unsigned int importer;
+    unsigned long long sourceSize;
+    long long sourceTime;
+    unsigned long long vertexCount;
+    float boundsCenter[3];
+    float boundsRadius;
+    float footprintRadius;
+    unsigned int reserved;
+};
+
+// FNV-1a of the model path and importer
+static std::string segmentName(const std::string& path, unsigned int importer) {
+    unsigned long long hash = 14695981039346656037ull;
+    for (size_t i = 0; i < path.size(); i++) {
+        hash ^= (unsigned char)path[i];
+        hash *= 1099511628211ull;
+    }
+    hash ^= importer;
+    hash *= 1099511628211ull;
+
+    char name[48];
+#ifdef _WIN32
+    std::snprintf(name, sizeof(name), "Local\\museum_mesh_%016llx", hash);
+#else
+    std::snprintf(name, sizeof(name), "/museum_mesh_%016llx", hash);   // Within macOS's 31 characters
+#endif
+    return name;
+}
+
+// True if the segment holds a published mesh that fits into its size
+static bool isComplete(const unsigned char* data, size_t size) {
+    if (!data || size < sizeof(SharedMeshHeader)) return false;
+    const SharedMeshHeader* header = (const SharedMeshHeader*)data;
+    if (header->ready.load(std::memory_order_acquire) == 0) return false;
+    if (header->magic != SHARED_MESH_MAGIC || header->version != SHARED_MESH_VERSION) return false;
+    return header->vertexCount <= (size - sizeof(SharedMeshHeader)) / sizeof(Vertex);
+}
+
+#ifndef _WIN32
+// Times an empty segment is opened again (1 ms apart) before it is taken for one whose creator
+// crashed; a live creator locks it right after creating it
+static const int SHARED_MESH_EMPTY_RETRIES = 20;
+static const int SHARED_MESH_OPEN_ATTEMPTS = 100;
+
+// Removes the segment's name if no other process holds a lock on it and the name still refers
+// to it. Mappings of the segment stay valid; the next process opening the name creates a new one.
+static bool removeIfUnused(int descriptor, const std::string& name) {
+    if (flock(descriptor, LOCK_EX | LOCK_NB) != 0) return false;
+    bool removed = false;
+    int named = shm_open(name.c_str(), O_RDONLY, 0);
+    if (named >= 0) {
+        struct stat own, current;
+        if (fstat(descriptor, &own) == 0 && fstat(named, &current) == 0 &&
+            own.st_dev == current.st_dev && own.st_ino == current.st_ino) {
+            removed = shm_unlink(name.c_str()) == 0;
+        }
+        ::close(named);
+    }
+    return removed;
+}
+#endif
+
+SharedMesh::SharedMesh() {
+    sourceSize = 0;
+    sourceTime = 0;
+    importer = 0;
+    data = nullptr;
+    size = 0;
+    creator = false;
+#ifdef _WIN32
+    mapping = NULL;
+    mutex = NULL;
+#else
+    descriptor = -1;
+#endif
+}
+
+SharedMesh::~SharedMesh() {
+    close();
+}
+
+SharedMeshState SharedMesh::open(const std::string& path, ModelImporter modelImporter) {
+    close();
+    if (!getSourceStamp(path, sourceSize, sourceTime)) return SHARED_MESH_UNAVAILABLE;
+    importer = (unsigned int)modelImporter;
+    name = segmentName(path, importer);
+    bool otherVersion = false;
+
+#ifdef _WIN32
+    // Creators hold the mutex until publish(); WAIT_ABANDONED means one crashed, and its
+    // unpublished mapping was closed with it
+    mutex = CreateMutexA(NULL, FALSE, (name + "_creator").c_str());
+    DWORD wait = mutex ? WaitForSingleObject(mutex, INFINITE) : WAIT_FAILED;
+    if (wait != WAIT_OBJECT_0 && wait != WAIT_ABANDONED) {
+        std::cerr << "ERROR::SHARED_MESH::LOCK_FAILED: " << name << std::endl;
+        close();
+        return SHARED_MESH_UNAVAILABLE;
+    }
+    mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name.c_str());
+    if (!mapping) {
+        creator = true;
+        return SHARED_MESH_CREATED;
+    }
+    ReleaseMutex(mutex);
+
+    // The mapping lives as long as a process has a handle to it
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    MEMORY_BASIC_INFORMATION region;
+    if (view) {
+        data = (unsigned char*)view;
+        size = VirtualQuery(view, &region, sizeof(region)) ? (size_t)region.RegionSize : 0;
+    }
+    if (isComplete(data, size)) {
+        const SharedMeshHeader* header = (const SharedMeshHeader*)data;
+        if (header->sourceSize == sourceSize && header->sourceTime == sourceTime) return SHARED_MESH_ATTACHED;
+        otherVersion = true;
+    }
+#else
+    for (int attempt = 0; attempt < SHARED_MESH_OPEN_ATTEMPTS; attempt++) {
+        int created = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (created >= 0) {
+            // Locked until publish(): processes opening the segment meanwhile block in flock
+            if (flock(created, LOCK_EX) != 0) {
+                shm_unlink(name.c_str());
+                ::close(created);
+                break;
+            }
+            descriptor = created;
+            creator = true;
+            return SHARED_MESH_CREATED;
+        }
+        if (errno != EEXIST) break;
+
+        int opened = shm_open(name.c_str(), O_RDONLY, 0);
+        if (opened < 0) {
+            if (errno == ENOENT) continue;  // Removed by its last user meanwhile
+            break;
+        }
+
+        // Held while the mesh is used, blocks while the creator imports
+        if (flock(opened, LOCK_SH) != 0) {
+            ::close(opened);
+            break;
+        }
+        struct stat info;
+        size_t length = fstat(opened, &info) == 0 ? (size_t)info.st_size : 0;
+        void* view = length >= sizeof(SharedMeshHeader) ? mmap(nullptr, length, PROT_READ, MAP_SHARED, opened, 0) : MAP_FAILED;
+        const unsigned char* contents = view != MAP_FAILED ? (const unsigned char*)view : nullptr;
+        otherVersion = isComplete(contents, length);
+        if (otherVersion) {
+            const SharedMeshHeader* header = (const SharedMeshHeader*)contents;
+            if (header->sourceSize == sourceSize && header->sourceTime == sourceTime) {
+                descriptor = opened;
+                data = (unsigned char*)view;
+                size = length;
+                return SHARED_MESH_ATTACHED;
+            }
+        }
+        if (contents) munmap(view, length);
+
+        // An empty segment's creator may not have locked it yet; anything else that is not
+        // current (crashed creator, older model file) is replaced when nobody uses it
+        bool waiting = length == 0 && attempt < SHARED_MESH_EMPTY_RETRIES;
+        bool removed = !waiting && removeIfUnused(opened, name);
+        ::close(opened);
+        if (waiting) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        else if (!removed) break;
+    }
+#endif
+
+    // Another instance still uses another version of the file
+    if (otherVersion) std::cout << "Shared mesh in use with an older version, importing separately: " << path << std::endl;
+    close();
+    return SHARED_MESH_UNAVAILABLE;
+}
+
+bool SharedMesh::publish(const std::vector<Vertex>& vertices, const glm::vec3& boundsCenter, float boundsRadius, float footprintRadius) {
+    if (!creator) return false;
+    size_t length = sizeof(SharedMeshHeader) + vertices.size() * sizeof(Vertex);
+#ifdef _WIN32
+    mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)((unsigned long long)length >> 32),
+                                 (DWORD)length, name.c_str());
+    void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, length) : NULL;
+#else
+    void* view = ftruncate(descriptor, (off_t)length) == 0 ?
+        mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0) : MAP_FAILED;
+    if (view == MAP_FAILED) view = nullptr;
+#endif
+    if (!view) {
+        std::cerr << "ERROR::SHARED_MESH::CREATE_FAILED: " << name << std::endl;
+        return false;
+    }
+
+    // New segments are zero-filled, so ready is 0 until the vertices are in
+    SharedMeshHeader* header = (SharedMeshHeader*)view;
+    header->magic = SHARED_MESH_MAGIC;
+    header->version = SHARED_MESH_VERSION;
+    header->importer = importer;
+    header->sourceSize = sourceSize;
+    header->sourceTime = sourceTime;
+    header->vertexCount = vertices.size();
+    header->boundsCenter[0] = boundsCenter.x;
+    header->boundsCenter[1] = boundsCenter.y;
+    header->boundsCenter[2] = boundsCenter.z;
+    header->boundsRadius = boundsRadius;
+    header->footprintRadius = footprintRadius;
+    if (!vertices.empty()) std::memcpy((void*)(header + 1), vertices.data(), vertices.size() * sizeof(Vertex));
+    header->ready.store(1, std::memory_order_release);
+
+    data = (unsigned char*)view;
+    size = length;
+    creator = false;
+#ifdef _WIN32
+    ReleaseMutex(mutex);
+#else
+    flock(descriptor, LOCK_SH);    // Waiting processes attach now
+#endif
+    return true;
+}
+
+void SharedMesh::close() {
+#ifdef _WIN32
+    if (data) UnmapViewOfFile(data);
+    if (mapping) CloseHandle(mapping);
+    if (mutex) {
+        if (creator) ReleaseMutex(mutex);
+        CloseHandle(mutex);
+    }
+    mapping = NULL;
+    mutex = NULL;
+#else
+    if (data) munmap(data, size);
+    if (descriptor >= 0) {
+        // Unpublished segments are only locked by their creator
+        if (creator) shm_unlink(name.c_str());
+        else removeIfUnused(descriptor, name);
+        ::close(descriptor);    // Drops the lock
+    }
+    descriptor = -1;
+#endif
+    data = nullptr;
+    size = 0;
+    creator = false;
+}
+
+const Vertex* SharedMesh::getVertices() const {
+    return data ? (const Vertex*)(data + sizeof(SharedMeshHeader)) : nullptr;
+}
+
+size_t SharedMesh::getVertexCount() const {
+    return data ? (size_t)((const SharedMeshHeader*)data)->vertexCount : 0;
+}
+
+void SharedMesh::getBounds(glm::vec3& boundsCenter, float& boundsRadius, float& footprintRadius) const {
+    if (!data) return;
+    const SharedMeshHeader* header = (const SharedMeshHeader*)data;
+    boundsCenter = glm::vec3(header->boundsCenter[0], header->boundsCenter[1], header->boundsCenter[2]);
+    boundsRadius = header->boundsRadius;
+    footprintRadius = header->footprintRadius;
+}
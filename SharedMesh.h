@@ -0,0 +1,62 @@
+#ifndef SHAREDMESH_H
+#define SHAREDMESH_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "ModelLoader.h"
+
+// Result of SharedMesh::open
+enum SharedMeshState {
+    SHARED_MESH_ATTACHED,     // Another process imported the model: getVertices() is valid
+    SHARED_MESH_CREATED,      // This process imports it and calls publish(); others opening it wait until then
+    SHARED_MESH_UNAVAILABLE   // No shared memory for this model (error, or an instance uses an older version)
+};
+
+// Imported triangles of a model file in named shared memory, so kiosk instances running side
+// by side import each model once and hold one copy of it between them. The segment is named
+// after the model path and importer and records the file's size and modification time.
+//
+// Every process using the segment holds a shared lock on it (Linux/macOS: flock on the
+// shm_open descriptor, Windows: the kernel's handle count of the file mapping). The creator
+// holds it exclusively until publish(), so others block instead of importing too. Locks and
+// handles are dropped by the OS when a process exits or crashes; the last process closing the
+// segment removes it, and a segment left behind by a crashed creator is removed by the next one
+// opening it.
+class SharedMesh {
+public:
+    SharedMesh();
+    ~SharedMesh();
+
+    SharedMeshState open(const std::string& path, ModelImporter importer);
+
+    // Copies the creator's triangles and bounds into the segment and lets the waiting
+    // processes attach; false (after printing why) if the segment cannot be filled
+    bool publish(const std::vector<Vertex>& vertices, const glm::vec3& boundsCenter, float boundsRadius, float footprintRadius);
+
+    void close();
+
+    const Vertex* getVertices() const;
+    size_t getVertexCount() const;
+    void getBounds(glm::vec3& boundsCenter, float& boundsRadius, float& footprintRadius) const;
+
+private:
+    std::string name;
+    unsigned long long sourceSize;
+    long long sourceTime;
+    unsigned int importer;
+    unsigned char* data;        // Header and vertices, null until attached or published
+    size_t size;
+    bool creator;               // Segment created and locked by this process, not published yet
+#ifdef _WIN32
+    void* mapping;              // HANDLEs of the file mapping and of the creator mutex
+    void* mutex;
+#else
+    int descriptor;             // shm_open descriptor carrying this process's lock
+#endif
+
+    SharedMesh(const SharedMesh&) = delete;
+    SharedMesh& operator=(const SharedMesh&) = delete;
+};
+
+#endif
@@ -0,0 +1,95 @@
+#include "SimulationThread.h"
+#include "CpuProfiler.h"
+#include "JobSystem.h"
+#include <chrono>
+
+// Largest backlog of ticks caught up at once; beyond that the simulation runs slower than real time
+static const int MAX_CATCH_UP_TICKS = 5;
+
+double steadySeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+SimulationThread::SimulationThread(Room* room, int ticksPerSecond, JobSystem* jobs) : room(room), jobs(jobs) {
+    tickSeconds = 1.0f / (ticksPerSecond > 0 ? ticksPerSecond : 60);
+    running = false;
+    skippedTicks = 0;
+    hasSnapshot = false;
+}
+
+SimulationThread::~SimulationThread() {
+    stop();
+}
+
+void SimulationThread::start() {
+    if (running) return;
+
+    // Initial state, so the first frame has something to draw
+    room->writeSnapshot(lastTick, true);
+    lastTick.publishSeconds = steadySeconds();
+    TickSnapshots& ticks = snapshots.writeBuffer();
+    ticks.previous = lastTick;
+    ticks.latest = lastTick;
+    snapshots.publish();
+
+    running = true;
+    thread = std::thread(&SimulationThread::run, this);
+}
+
+void SimulationThread::stop() {
+    running = false;
+    if (thread.joinable()) thread.join();
+}
+
+void SimulationThread::run() {
+    PROFILE_THREAD_NAME("Simulation");
+    // Crowd jobs go to this thread's own queue, the render thread never waits on them
+    if (jobs) jobs->attachCaller(1);
+    typedef std::chrono::steady_clock Clock;
+    const Clock::duration tick = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(tickSeconds));
+    Clock::time_point nextTick = Clock::now() + tick;
+
+    while (running) {
+        std::this_thread::sleep_until(nextTick);
+
+        // Catch up on missed ticks, but never spiral: drop the rest of a long stall
+        int ticks = 0;
+        bool changed = false;
+        while (Clock::now() >= nextTick && ticks < MAX_CATCH_UP_TICKS) {
+            PROFILE_SCOPE("Simulation tick");
+            // When catching up, the blend starts at the tick before the last one
+            if (ticks > 0) room->writeSnapshot(lastTick, changed);
+            changed |= room->update(tickSeconds);
+            nextTick += tick;
+            ticks++;
+        }
+        if (Clock::now() >= nextTick) {
+            long long behind = (long long)((Clock::now() - nextTick) / tick) + 1;
+            skippedTicks += behind;
+            nextTick += tick * behind;
+        }
+
+        TickSnapshots& snapshot = snapshots.writeBuffer();
+        snapshot.previous = lastTick;
+        room->writeSnapshot(snapshot.latest, changed);
+        snapshot.latest.publishSeconds = steadySeconds();
+        lastTick = snapshot.latest;
+        snapshots.publish();
+    }
+}
+
+bool SimulationThread::getRenderState(RoomSnapshot& state) {
+    bool fresh = snapshots.update();
+    if (fresh) hasSnapshot = true;
+    if (!hasSnapshot) return false;
+
+    // One tick behind real time: blend from the tick before the newest to the newest
+    const RoomSnapshot& previous = snapshots.readBuffer().previous;
+    const RoomSnapshot& latest = snapshots.readBuffer().latest;
+    float alpha = (float)((steadySeconds() - latest.publishSeconds) / tickSeconds);
+    if (alpha < 0.0f) alpha = 0.0f;
+    if (alpha > 1.0f) alpha = 1.0f;
+    interpolateSnapshots(previous, latest, alpha, state);
+
+    return latest.changed && (fresh || alpha < 1.0f);
+}
@@ -0,0 +1,62 @@
+#ifndef SIMULATIONTHREAD_H
+#define SIMULATIONTHREAD_H
+
+#include <atomic>
+#include <thread>
+#include "Room.h"
+#include "TripleBuffer.h"
+
+// The two newest simulation ticks, published together: the renderer blends ticks that are
+// one tick apart, however many published snapshots it missed while a frame was slow
+struct TickSnapshots {
+    RoomSnapshot previous;   // State one tick before latest
+    RoomSnapshot latest;
+};
+
+// Runs Room::update on its own thread at a fixed tick rate and publishes a
+// snapshot after every tick. The renderer blends the two newest ticks, so
+// slow frames never slow the robots down and slow ticks never block a frame.
+class SimulationThread {
+public:
+    // - ticksPerSecond: fixed simulation rate
+    // - jobs: the room's job system, if any, created with a second caller for this thread
+    SimulationThread(Room* room, int ticksPerSecond, JobSystem* jobs = nullptr);
+    ~SimulationThread();
+
+    // Publishes the initial state and starts ticking
+    void start();
+
+    // Stops and joins the thread (must happen before the room is deleted)
+    void stop();
+
+    // Render thread: state for the current time, between the two newest ticks
+    // Returns true when the drawn image may differ from the previous frame
+    bool getRenderState(RoomSnapshot& state);
+
+    // Simulation ticks that fell so far behind they were dropped (simulation slower than real time)
+    long long getSkippedTicks() const { return skippedTicks.load(std::memory_order_relaxed); }
+
+private:
+    Room* room;
+    JobSystem* jobs;
+    float tickSeconds;
+
+    std::thread thread;
+    std::atomic<bool> running;
+    std::atomic<long long> skippedTicks;
+
+    TripleBuffer<TickSnapshots> snapshots;
+
+    // Simulation thread only
+    RoomSnapshot lastTick;   // State after the newest tick
+
+    // Render thread only
+    bool hasSnapshot;
+
+    void run();
+};
+
+// Seconds on the steady clock, shared by both threads for interpolation
+double steadySeconds();
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <atomic>
+
+// Lock-free single producer / single consumer queue of fixed capacity.
+// The producer pushes at the head, the consumer pops at the tail; each index is
+// written by one side only, so neither side ever waits or takes a lock.
+// Capacity must be a power of two; a full ring rejects the push.
+template <class T, int CAPACITY>
+class SpscRing {
+public:
+    SpscRing() : head(0), tail(0) {
+        static_assert((CAPACITY & (CAPACITY - 1)) == 0, "capacity must be a power of two");
+    }
+
+    // Producer: false when the ring is full (the item is dropped)
+    bool push(const T& item) {
+        unsigned int position = head.load(std::memory_order_relaxed);
+        if (position - tail.load(std::memory_order_acquire) >= (unsigned int)CAPACITY) return false;
+        items[position & (CAPACITY - 1)] = item;
+        head.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: false when the ring is empty
+    bool pop(T& item) {
+        unsigned int position = tail.load(std::memory_order_relaxed);
+        if (position == head.load(std::memory_order_acquire)) return false;
+        item = items[position & (CAPACITY - 1)];
+        tail.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    // Padding keeps the two indices on separate cache lines
+    T items[CAPACITY];
+    char padding0[64];
+    std::atomic<unsigned int> head;     // Next slot to write, producer side
+    char padding1[64];
+    std::atomic<unsigned int> tail;     // Next slot to read, consumer side
+    char padding2[64];
+};
+
+#endif
@@ -0,0 +1,167 @@
+#include "StreamBuffer.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+// GL 4.4 / GL_ARB_buffer_storage, not part of the GL 3.3 loader
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+typedef void (APIENTRYP BufferStorageFunction)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+static BufferStorageFunction bufferStorage = nullptr;
+
+// Smallest region, so a few objects do not regrow the buffer every frame
+static const size_t STREAM_BUFFER_MIN_SIZE = 64 * 1024;
+
+// Allocations start on texel boundaries
+static size_t alignTexel(size_t bytes) {
+    return (bytes + 15) & ~(size_t)15;
+}
+
+void loadBufferStorage(GLADloadproc load) {
+    int major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    bool supported = major > 4 || (major == 4 && minor >= 4);
+
+    int count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (int i = 0; i < count && !supported; i++) {
+        const char* name = (const char*)glGetStringi(GL_EXTENSIONS, i);
+        if (name && std::strcmp(name, "GL_ARB_buffer_storage") == 0) supported = true;
+    }
+
+    bufferStorage = supported ? (BufferStorageFunction)load("glBufferStorage") : nullptr;
+    std::cout << "Per-frame data: " << (bufferStorage ? "persistently mapped buffers" : "orphaned buffers (no buffer storage)") << std::endl;
+}
+
+StreamBuffer::StreamBuffer() {
+    persistent = bufferStorage != nullptr;
+    for (int i = 0; i < STREAM_BUFFER_FRAMES; i++) fences[i] = nullptr;
+
+    // The buffer texture addresses the whole buffer, all regions included
+    int maxTexels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    maxSize = (size_t)std::max(maxTexels, 65536) * 16;
+    if (persistent) maxSize = (maxSize / STREAM_BUFFER_FRAMES) & ~(size_t)15;
+
+    glGenTextures(1, &texture);
+    resize(STREAM_BUFFER_MIN_SIZE);
+}
+
+StreamBuffer::~StreamBuffer() {
+    deleteFences();
+    if (mapped) {
+        glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+        glUnmapBuffer(GL_TEXTURE_BUFFER);
+    }
+    glDeleteBuffers(1, &buffer);
+    glDeleteTextures(1, &texture);
+}
+
+void StreamBuffer::deleteFences() {
+    for (int i = 0; i < STREAM_BUFFER_FRAMES; i++) {
+        if (fences[i]) glDeleteSync(fences[i]);
+        fences[i] = nullptr;
+    }
+}
+
+void StreamBuffer::resize(size_t size) {
+    // The GPU may still read the old buffer; GL keeps its storage until it is done
+    if (mapped) {
+        glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+        glUnmapBuffer(GL_TEXTURE_BUFFER);
+        mapped = nullptr;
+    }
+    if (buffer) glDeleteBuffers(1, &buffer);
+    deleteFences();
+    regionSize = size;
+    region = 0;
+
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    if (persistent) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        size_t total = regionSize * STREAM_BUFFER_FRAMES;
+        bufferStorage(GL_TEXTURE_BUFFER, total, nullptr, flags);
+        mapped = (unsigned char*)glMapBufferRange(GL_TEXTURE_BUFFER, 0, total, flags);
+        if (!mapped) {
+            std::cerr << "ERROR::STREAM_BUFFER::MAP_FAILED, uploading per-frame data instead" << std::endl;
+            persistent = false;
+            glDeleteBuffers(1, &buffer);
+            glGenBuffers(1, &buffer);
+            glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+        }
+    }
+    if (!persistent) {
+        glBufferData(GL_TEXTURE_BUFFER, regionSize, nullptr, GL_STREAM_DRAW);
+        staging.resize(regionSize);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, buffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+void StreamBuffer::beginFrame(size_t bytes) {
+    used = 0;
+    flushed = 0;
+
+    // Grows by doubling, so a growing scene only reallocates a few times
+    bytes = alignTexel(bytes);
+    if (bytes > regionSize && regionSize < maxSize) {
+        resize(std::min(std::max(bytes, regionSize * 2), maxSize));
+    }
+
+    // The region was last written STREAM_BUFFER_FRAMES frames ago; usually its fence has
+    // long signaled, otherwise the CPU is that far ahead and waits for the GPU
+    if (persistent && fences[region]) {
+        GLenum result = glClientWaitSync(fences[region], 0, 0);
+        while (result == GL_TIMEOUT_EXPIRED) {
+            result = glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);    // 1 ms
+        }
+        glDeleteSync(fences[region]);
+        fences[region] = nullptr;
+    }
+}
+
+void* StreamBuffer::allocate(size_t bytes, size_t& offset) {
+    bytes = alignTexel(bytes);
+    if (used + bytes > regionSize) return nullptr;
+    size_t start = used;
+    used += bytes;
+    if (persistent) {
+        offset = region * regionSize + start;
+        return mapped + offset;
+    }
+    offset = start;
+    return staging.data() + start;
+}
+
+void StreamBuffer::flush() {
+    // Coherent mappings are seen by the GPU without an explicit flush
+    if (persistent || used == flushed) return;
+
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    // Orphans the storage at the first upload of a frame: the driver hands out new memory
+    // instead of waiting for draws of the last frame that still read the old one
+    if (flushed == 0) glBufferData(GL_TEXTURE_BUFFER, regionSize, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_TEXTURE_BUFFER, flushed, used - flushed, staging.data() + flushed);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    flushed = used;
+}
+
+void StreamBuffer::endFrame() {
+    if (!persistent) return;
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    region = (region + 1) % STREAM_BUFFER_FRAMES;
+}
+
+void StreamBuffer::bindTexture(int unit) const {
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+}
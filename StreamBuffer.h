@@ -0,0 +1,76 @@
+#ifndef STREAMBUFFER_H
+#define STREAMBUFFER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+// Frames whose streamed data may still be read by the GPU while the CPU writes the next one
+static const int STREAM_BUFFER_FRAMES = 3;
+
+// Per-object data of the museum's vertex shaders, read from a stream buffer's texels
+// (see vertex_shader.glsl): the columns of the model matrix, then the color
+struct ObjectData {
+    glm::mat4 model;
+    glm::vec4 color;            // rgb, a unused
+};
+
+// RGBA32F texels per ObjectData
+static const int OBJECT_TEXELS = (int)(sizeof(ObjectData) / sizeof(glm::vec4));
+
+// Loads glBufferStorage when the context has it (GL 4.4 or GL_ARB_buffer_storage), after
+// glad; without it stream buffers fall back to orphaning
+void loadBufferStorage(GLADloadproc load);
+
+// Ring allocator for data written by the CPU every frame and read by the GPU in the same
+// frame. With buffer storage the buffer is mapped once, persistently and coherently, and split
+// into STREAM_BUFFER_FRAMES regions; a fence per region keeps the CPU from overwriting a
+// region before the GPU has read it. On plain GL 3.3 the frame is collected in memory and
+// uploaded at flush() into freshly orphaned storage. The buffer is also a GL_RGBA32F buffer
+// texture, so shaders index the data with texelFetch.
+class StreamBuffer {
+public:
+    StreamBuffer();
+    ~StreamBuffer();
+
+    // Starts a frame that will allocate up to bytes; waits until the GPU is done with the
+    // region and grows the buffer if needed (up to the largest buffer texture)
+    void beginFrame(size_t bytes);
+
+    // Space for bytes of this frame, 16 byte aligned; offset receives its byte offset in the
+    // buffer. Null when the frame is full.
+    void* allocate(size_t bytes, size_t& offset);
+
+    // Makes the data written so far visible to the GPU (before the draws that read it)
+    void flush();
+
+    // Ends the frame after its last draw
+    void endFrame();
+
+    // Binds the buffer texture to a texture unit
+    void bindTexture(int unit) const;
+
+    bool isPersistent() const { return persistent; }
+
+private:
+    unsigned int buffer = 0;
+    unsigned int texture = 0;
+    bool persistent;                // Mapped buffer storage, else orphaning
+    size_t regionSize = 0;          // Bytes per frame
+    size_t maxSize;                 // Largest buffer the buffer texture can address
+    size_t used = 0;                // Bytes allocated in this frame
+    size_t flushed = 0;             // Bytes already uploaded (orphaning)
+    int region = 0;                 // Region of this frame (persistent)
+    unsigned char* mapped = nullptr;
+    GLsync fences[STREAM_BUFFER_FRAMES];
+    std::vector<unsigned char> staging;     // Frame data before the upload (orphaning)
+
+    // Replaces the buffer by one with regions of the given size
+    void resize(size_t size);
+    void deleteFences();
+
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+};
+
+#endif
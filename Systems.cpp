@@ -0,0 +1,49 @@
+#include "Systems.h"
+#include "CpuProfiler.h"
+
+void movementSystem(World& world, WorldQuery<Transform, Locomotion>& query, const std::vector<std::vector<glm::vec3> >& routes,
+                    BehaviorScheduler& scheduler, float deltaTime) {
+    PROFILE_SCOPE("movementSystem");
+    query.eachArchetype(world, [&](int count, Transform* transforms, Locomotion* walks) {
+        for (int i = 0; i < count; i++) {
+            Locomotion& walk = walks[i];
+            if (!walk.active) continue;
+            glm::vec3& position = transforms[i].position;
+
+            float distance = glm::length(walk.target - position);
+            if (distance <= walk.arriveDistance) {
+                walk.active = false;
+                scheduler.wake(walk.script);
+                continue;
+            }
+
+            // Skip the corners already reached and walk toward the next one (or the target)
+            glm::vec3 waypoint = walk.target;
+            if (walk.route >= 0) {
+                const std::vector<glm::vec3>& path = routes[walk.route];
+                while (walk.pathIndex < (int)path.size() && glm::length(path[walk.pathIndex] - position) < 0.05f) walk.pathIndex++;
+                if (walk.pathIndex < (int)path.size()) waypoint = path[walk.pathIndex];
+            }
+            glm::vec3 toWaypoint = waypoint - position;
+            float waypointDistance = glm::length(toWaypoint);
+
+            float speed = glm::clamp(distance * walk.speedPerMeter, walk.minSpeed, walk.maxSpeed);
+            float step = speed * deltaTime < waypointDistance ? speed * deltaTime : waypointDistance;
+            if (waypointDistance > 0.0f) position += toWaypoint / waypointDistance * step;
+        }
+    });
+}
+
+void animationSystem(World& world, WorldQuery<Animation, Locomotion>& query, float deltaTime) {
+    query.each(world, [deltaTime](Animation& animation, const Locomotion& walk) {
+        if (walk.active) animation.time += deltaTime;
+    });
+}
+
+void scanSystem(World& world, WorldQuery<Animation, Scanner>& query, float deltaTime) {
+    query.each(world, [deltaTime](Animation& animation, Scanner& scanner) {
+        if (!scanner.scanning) return;
+        scanner.angle += 120.0f * deltaTime;  // Rotates at 120 degrees per second
+        animation.time += deltaTime;
+    });
+}
@@ -0,0 +1,21 @@
+#ifndef SYSTEMS_H
+#define SYSTEMS_H
+
+#include <vector>
+#include "World.h"
+#include "Components.h"
+
+// Simulation systems of the museum entities, each visiting its components with its own query
+
+// Steps every active walk toward its target along its route and wakes the walk's script on arrival
+// - routes: corner lists referenced by Locomotion::route
+void movementSystem(World& world, WorldQuery<Transform, Locomotion>& query, const std::vector<std::vector<glm::vec3> >& routes,
+                    BehaviorScheduler& scheduler, float deltaTime);
+
+// Advances the walk cycle of the robots that are walking
+void animationSystem(World& world, WorldQuery<Animation, Locomotion>& query, float deltaTime);
+
+// Turns the exhibit being scanned and keeps the scanning robot's arms moving
+void scanSystem(World& world, WorldQuery<Animation, Scanner>& query, float deltaTime);
+
+#endif
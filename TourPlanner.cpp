@@ -0,0 +1,183 @@
+#include "TourPlanner.h"
+#include "NavGrid.h"
+#include "CpuProfiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// Smallest change counted as an improvement (avoids cycling on rounding noise)
+static const float TOUR_EPSILON = 1e-4f;
+
+// Improvement rounds before the planner settles for the current order
+static const int TOUR_MAX_ROUNDS = 100;
+
+// Longest run of stops moved as one piece by Or-opt
+static const int TOUR_MAX_SEGMENT = 3;
+
+TourPlanner::TourPlanner(NavGrid* grid) : grid(grid) {
+    tourLength = 0.0f;
+    planMilliseconds = 0.0f;
+}
+
+void TourPlanner::measure(int node) {
+    if (grid) {
+        grid->measureDistances(positions[node], positions, distances[node]);
+        return;
+    }
+
+    // Without a grid, straight lines on the floor
+    distances[node].resize(positions.size());
+    for (size_t i = 0; i < positions.size(); i++) {
+        glm::vec3 offset = positions[i] - positions[node];
+        distances[node][i] = std::sqrt(offset.x * offset.x + offset.z * offset.z);
+    }
+}
+
+void TourPlanner::plan(const glm::vec3& start, const std::vector<glm::vec3>& stops) {
+    PROFILE_SCOPE("TourPlanner::plan");
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+    positions.assign(1, start);
+    positions.insert(positions.end(), stops.begin(), stops.end());
+    distances.assign(positions.size(), std::vector<float>());
+    for (size_t i = 0; i < positions.size(); i++) measure((int)i);
+
+    // Nearest neighbour: always walk to the closest stop not visited yet
+    order.clear();
+    std::vector<bool> used(stops.size(), false);
+    int current = 0;
+    for (size_t n = 0; n < stops.size(); n++) {
+        int best = -1;
+        for (size_t s = 0; s < stops.size(); s++) {
+            if (used[s]) continue;
+            if (best < 0 || distance(current, (int)s + 1) < distance(current, best + 1)) best = (int)s;
+        }
+        used[best] = true;
+        order.push_back(best);
+        current = best + 1;
+    }
+
+    improve();
+    planMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+
+void TourPlanner::replanFrom(const glm::vec3& position, const std::vector<bool>& visited) {
+    PROFILE_SCOPE("TourPlanner::replanFrom");
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+    // New start: one row of distances, the rest of the order is the starting point
+    positions[0] = position;
+    measure(0);
+
+    std::vector<int> remaining;
+    for (size_t i = 0; i < order.size(); i++) {
+        if (order[i] >= (int)visited.size() || !visited[order[i]]) remaining.push_back(order[i]);
+    }
+    order.swap(remaining);
+
+    improve();
+    planMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+
+float TourPlanner::getLength(const std::vector<int>& stops) const {
+    float length = 0.0f;
+    int previous = 0;
+    for (size_t i = 0; i < stops.size(); i++) {
+        length += distance(previous, stops[i] + 1);
+        previous = stops[i] + 1;
+    }
+    return length;
+}
+
+void TourPlanner::improve() {
+    // Route with the start in front (entries are positions indices)
+    std::vector<int> route(1, 0);
+    for (size_t i = 0; i < order.size(); i++) route.push_back(order[i] + 1);
+
+    for (int round = 0; round < TOUR_MAX_ROUNDS; round++) {
+        bool improved = twoOpt(route);
+        improved = orOpt(route) || improved;
+        if (!improved) break;
+    }
+
+    for (size_t i = 1; i < route.size(); i++) order[i - 1] = route[i] - 1;
+    tourLength = getLength(order);
+}
+
+bool TourPlanner::twoOpt(std::vector<int>& route) {
+    bool improved = false;
+    int last = (int)route.size() - 1;
+
+    // Reversing route[i+1..j] swaps the edges (i, i+1) and (j, j+1) for (i, j) and (i+1, j+1);
+    // the tour is open, so past the last stop there is no edge to pay for
+    for (int i = 0; i < last - 1; i++) {
+        for (int j = i + 2; j <= last; j++) {
+            float before = distance(route[i], route[i + 1]);
+            float after = distance(route[i], route[j]);
+            if (j < last) {
+                before += distance(route[j], route[j + 1]);
+                after += distance(route[i + 1], route[j + 1]);
+            }
+            if (after < before - TOUR_EPSILON) {
+                std::reverse(route.begin() + i + 1, route.begin() + j + 1);
+                improved = true;
+            }
+        }
+    }
+    return improved;
+}
+
+bool TourPlanner::orOpt(std::vector<int>& route) {
+    bool improved = false;
+    int last = (int)route.size() - 1;
+    std::vector<int> segment;
+
+    // Moves runs of 1 to 3 stops to the place (and direction) where they cost least
+    for (int length = 1; length <= TOUR_MAX_SEGMENT; length++) {
+        for (int i = 1; i + length - 1 <= last; i++) {
+            int first = route[i];
+            int end = route[i + length - 1];
+            int before = route[i - 1];
+            int after = i + length <= last ? route[i + length] : -1;
+
+            // Length saved by taking the run out
+            float removed = distance(before, first);
+            if (after >= 0) removed += distance(end, after) - distance(before, after);
+
+            float bestGain = TOUR_EPSILON;
+            int bestPlace = -1;
+            bool bestReversed = false;
+            for (int k = 0; k <= last; k++) {
+                if (k >= i - 1 && k <= i + length - 1) continue;   // Its own place
+                int left = route[k];
+                int right = k < last ? route[k + 1] : -1;
+                float edge = right >= 0 ? distance(left, right) : 0.0f;
+
+                float forward = distance(left, first) + (right >= 0 ? distance(end, right) : 0.0f) - edge;
+                if (removed - forward > bestGain) {
+                    bestGain = removed - forward;
+                    bestPlace = k;
+                    bestReversed = false;
+                }
+                if (length > 1) {
+                    float backward = distance(left, end) + (right >= 0 ? distance(first, right) : 0.0f) - edge;
+                    if (removed - backward > bestGain) {
+                        bestGain = removed - backward;
+                        bestPlace = k;
+                        bestReversed = true;
+                    }
+                }
+            }
+            if (bestPlace < 0) continue;
+
+            // Take the run out and put it back after route[bestPlace]
+            segment.assign(route.begin() + i, route.begin() + i + length);
+            if (bestReversed) std::reverse(segment.begin(), segment.end());
+            route.erase(route.begin() + i, route.begin() + i + length);
+            int insertAt = bestPlace < i ? bestPlace + 1 : bestPlace + 1 - length;
+            route.insert(route.begin() + insertAt, segment.begin(), segment.end());
+            improved = true;
+        }
+    }
+    return improved;
+}
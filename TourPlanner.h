@@ -0,0 +1,52 @@
+#ifndef TOURPLANNER_H
+#define TOURPLANNER_H
+
+#include <glm/glm.hpp>
+#include <vector>
+
+class NavGrid;
+
+// Visiting order of the guide's stops: an open tour from the robot's position
+// that visits every stop once, as short as possible in walking distance.
+// Built with nearest neighbour, then improved with 2-opt and Or-opt moves.
+// After a detour the rest of the tour starts from the current order and only the
+// distances from the new position are measured.
+class TourPlanner {
+public:
+    // - grid: measures walking distances (straight lines when null)
+    TourPlanner(NavGrid* grid);
+
+    // Plans the whole tour from start over all stops
+    void plan(const glm::vec3& start, const std::vector<glm::vec3>& stops);
+
+    // Continues from a new position (e.g. after a manual detour) without the visited stops
+    void replanFrom(const glm::vec3& position, const std::vector<bool>& visited);
+
+    // Stops still to visit, in order
+    const std::vector<int>& getOrder() const { return order; }
+
+    // Walking distance of an order from the start position (e.g. to compare with another order)
+    float getLength(const std::vector<int>& stops) const;
+
+    // Results of the last plan or replanFrom
+    float getTourLength() const { return tourLength; }
+    float getPlanMilliseconds() const { return planMilliseconds; }
+
+private:
+    NavGrid* grid;
+    std::vector<glm::vec3> positions;               // [0] = start, then the stops
+    std::vector<std::vector<float> > distances;     // Walking distances between positions
+    std::vector<int> order;                         // Stop indices (positions index - 1)
+    float tourLength;
+    float planMilliseconds;
+
+    // Distance between two entries of the route (0 = start, stop i = i + 1)
+    float distance(int from, int to) const { return distances[from][to]; }
+
+    void measure(int node);     // Distances from one position to all others
+    void improve();             // 2-opt and Or-opt until no move shortens the tour
+    bool twoOpt(std::vector<int>& route);
+    bool orOpt(std::vector<int>& route);
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+
+// Lock-free single writer / single reader hand-over of the latest value.
+// The writer fills writeBuffer() and publishes it; the reader picks up the newest
+// published value with update(). Neither side ever waits for the other, values
+// published while the reader is busy are simply replaced by newer ones.
+template <class T>
+class TripleBuffer {
+public:
+    TripleBuffer() : middle(1), backIndex(0), frontIndex(2) {}
+
+    // Writer: buffer to fill, owned by the writer until publish()
+    T& writeBuffer() { return buffers[backIndex].value; }
+
+    // Writer: makes the filled buffer the newest value and takes the spare one back
+    void publish() {
+        int old = middle.exchange(backIndex | NEW_DATA, std::memory_order_acq_rel);
+        backIndex = old & INDEX_MASK;
+    }
+
+    // Reader: switches to the newest value, returns false when nothing new was published
+    bool update() {
+        if (!(middle.load(std::memory_order_relaxed) & NEW_DATA)) return false;
+        int old = middle.exchange(frontIndex, std::memory_order_acq_rel);
+        frontIndex = old & INDEX_MASK;
+        return true;
+    }
+
+    // Reader: newest value picked up by update(), owned by the reader until the next update()
+    const T& readBuffer() const { return buffers[frontIndex].value; }
+
+private:
+    static const int INDEX_MASK = 3;
+    static const int NEW_DATA = 4;
+
+    // Every slot and index on its own cache lines, so the two threads never share one
+    struct alignas(64) Slot {
+        T value;
+    };
+
+    Slot buffers[3];
+    alignas(64) std::atomic<int> middle;    // Index of the buffer in between, plus the NEW_DATA flag
+    alignas(64) int backIndex;              // Writer side only
+    alignas(64) int frontIndex;             // Reader side only
+};
+
+#endif
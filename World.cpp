@@ -0,0 +1,132 @@
+#include "World.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+// Sizes of the registered component types
+static std::atomic<int> registeredComponents(0);
+static size_t componentSizes[WORLD_MAX_COMPONENTS];
+
+int registerComponent(size_t size) {
+    int id = registeredComponents.fetch_add(1);
+    if (id >= WORLD_MAX_COMPONENTS) {
+        std::cerr << "ERROR::WORLD::TOO_MANY_COMPONENT_TYPES (raise WORLD_MAX_COMPONENTS)" << std::endl;
+        std::abort();
+    }
+    componentSizes[id] = size;
+    return id;
+}
+
+size_t componentSize(int id) {
+    return componentSizes[id];
+}
+
+World::World() {
+    entityCount = 0;
+}
+
+World::~World() {
+    for (size_t i = 0; i < archetypes.size(); i++) delete archetypes[i];
+}
+
+int World::findArchetype(ComponentMask mask) {
+    for (size_t i = 0; i < archetypes.size(); i++) {
+        if (archetypes[i]->mask == mask) return (int)i;
+    }
+
+    Archetype* archetype = new Archetype();
+    archetype->mask = mask;
+    archetype->count = 0;
+    for (int id = 0; id < WORLD_MAX_COMPONENTS; id++) {
+        archetype->columnOf[id] = -1;
+        if (!(mask & (1u << id))) continue;
+        archetype->columnOf[id] = (int)archetype->columns.size();
+        archetype->columns.push_back(std::vector<unsigned char>());
+        archetype->columnComponents.push_back(id);
+    }
+    archetypes.push_back(archetype);
+    return (int)archetypes.size() - 1;
+}
+
+int World::addRow(Archetype& archetype, unsigned int entityIndex) {
+    int row = archetype.count++;
+    for (size_t c = 0; c < archetype.columns.size(); c++) {
+        archetype.columns[c].resize(archetype.count * componentSize(archetype.columnComponents[c]));
+    }
+    archetype.entities.push_back(entityIndex);
+    return row;
+}
+
+void World::removeRow(Archetype& archetype, int row) {
+    int last = archetype.count - 1;
+    for (size_t c = 0; c < archetype.columns.size(); c++) {
+        size_t size = componentSize(archetype.columnComponents[c]);
+        unsigned char* data = archetype.columns[c].data();
+        if (row != last) std::memcpy(data + row * size, data + last * size, size);
+        archetype.columns[c].resize(last * size);
+    }
+    if (row != last) {
+        archetype.entities[row] = archetype.entities[last];
+        records[archetype.entities[row]].row = row;
+    }
+    archetype.entities.pop_back();
+    archetype.count = last;
+}
+
+Entity World::allocate(int archetype) {
+    unsigned int index;
+    if (!freeRecords.empty()) {
+        index = freeRecords.back();
+        freeRecords.pop_back();
+    }
+    else {
+        index = (unsigned int)records.size();
+        records.push_back({ -1, -1, 0u });
+    }
+    records[index].archetype = archetype;
+    records[index].row = addRow(*archetypes[archetype], index);
+    entityCount++;
+
+    Entity entity;
+    entity.index = index;
+    entity.generation = records[index].generation;
+    return entity;
+}
+
+void World::destroy(Entity entity) {
+    if (!isAlive(entity)) return;
+    Record& record = records[entity.index];
+    removeRow(*archetypes[record.archetype], record.row);
+    record.archetype = -1;
+    record.generation++;
+    freeRecords.push_back(entity.index);
+    entityCount--;
+}
+
+bool World::isAlive(Entity entity) const {
+    return entity.index < records.size() && records[entity.index].generation == entity.generation &&
+           records[entity.index].archetype >= 0;
+}
+
+void World::moveEntity(Entity entity, ComponentMask mask) {
+    Record& record = records[entity.index];
+    int to = findArchetype(mask);       // May add an archetype, so look both up afterwards
+    Archetype& source = *archetypes[record.archetype];
+    Archetype& target = *archetypes[to];
+    int sourceRow = record.row;
+    int targetRow = addRow(target, entity.index);
+
+    // Components both archetypes have are copied, new ones stay zero
+    for (size_t c = 0; c < target.columns.size(); c++) {
+        int id = target.columnComponents[c];
+        int sourceColumn = source.columnOf[id];
+        if (sourceColumn < 0) continue;
+        size_t size = componentSize(id);
+        std::memcpy(target.columns[c].data() + targetRow * size, source.columns[sourceColumn].data() + sourceRow * size, size);
+    }
+
+    removeRow(source, sourceRow);
+    record.archetype = to;
+    record.row = targetRow;
+}
@@ -0,0 +1,178 @@
+#ifndef WORLD_H
+#define WORLD_H
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+// Component types a world can hold (one bit each in an archetype mask)
+#define WORLD_MAX_COMPONENTS 32
+
+typedef unsigned int ComponentMask;
+
+// Component type ids, handed out on first use of a type
+int registerComponent(size_t size);
+size_t componentSize(int id);
+
+template <typename T>
+int componentId() {
+    static_assert(std::is_trivially_copyable<T>::value, "components are moved between archetypes with memcpy");
+    static const int id = registerComponent(sizeof(T));
+    return id;
+}
+
+template <typename... T>
+ComponentMask componentMask() {
+    return (0u | ... | (1u << componentId<T>()));
+}
+
+// Entity handle, stays invalid (get returns null) after the entity was destroyed
+struct Entity {
+    unsigned int index = 0xFFFFFFFFu;
+    unsigned int generation = 0;
+};
+
+// Entities grouped by archetype (their exact set of component types). Every
+// archetype stores each component in its own contiguous array, so a system
+// that needs positions and routes streams through exactly those two arrays,
+// and entities of the same kind sit next to each other.
+// Components are plain data (trivially copyable) and are moved with memcpy.
+// Adding or removing entities and components may move component arrays: pointers
+// from get() and queries are only valid until the next structural change.
+// Not thread-safe for structural changes; threads may read and write different
+// components of an unchanging set of entities at the same time.
+class World {
+public:
+    // Entities that share one set of component types
+    struct Archetype {
+        ComponentMask mask;
+        int count;
+        int columnOf[WORLD_MAX_COMPONENTS];                 // Column of each component id, -1 if absent
+        std::vector<std::vector<unsigned char> > columns;   // One array per component type
+        std::vector<int> columnComponents;                  // Component id of each column
+        std::vector<unsigned int> entities;                 // Entity index of each row
+
+        template <typename T>
+        T* column() { return (T*)columns[columnOf[componentId<T>()]].data(); }
+    };
+
+    World();
+    ~World();
+
+    // New entity with the given components
+    template <typename... T>
+    Entity create(const T&... components) {
+        Entity entity = allocate(findArchetype(componentMask<T...>()));
+        ((*get<T>(entity) = components), ...);
+        return entity;
+    }
+
+    void destroy(Entity entity);
+    bool isAlive(Entity entity) const;
+
+    // Component of an entity, null if the entity is gone or lacks it
+    template <typename T>
+    T* get(Entity entity) {
+        if (!isAlive(entity)) return nullptr;
+        const Record& record = records[entity.index];
+        Archetype& archetype = *archetypes[record.archetype];
+        int column = archetype.columnOf[componentId<T>()];
+        return column < 0 ? nullptr : (T*)archetype.columns[column].data() + record.row;
+    }
+
+    template <typename T>
+    const T* get(Entity entity) const {
+        return const_cast<World*>(this)->get<T>(entity);
+    }
+
+    // Adds or replaces a component (the entity moves to another archetype when it is new)
+    template <typename T>
+    void add(Entity entity, const T& component) {
+        if (!isAlive(entity)) return;
+        ComponentMask bit = 1u << componentId<T>();
+        ComponentMask mask = archetypes[records[entity.index].archetype]->mask;
+        if (!(mask & bit)) moveEntity(entity, mask | bit);
+        *get<T>(entity) = component;
+    }
+
+    template <typename T>
+    void remove(Entity entity) {
+        if (!isAlive(entity)) return;
+        ComponentMask bit = 1u << componentId<T>();
+        ComponentMask mask = archetypes[records[entity.index].archetype]->mask;
+        if (mask & bit) moveEntity(entity, mask & ~bit);
+    }
+
+    // Archetypes in creation order (queries remember how many they have seen)
+    int getArchetypeCount() const { return (int)archetypes.size(); }
+    Archetype& getArchetype(int index) { return *archetypes[index]; }
+    int getEntityCount() const { return entityCount; }
+
+private:
+    struct Record {
+        int archetype;
+        int row;
+        unsigned int generation;    // Bumped on destroy, old handles stop matching
+    };
+
+    std::vector<Archetype*> archetypes;
+    std::vector<Record> records;
+    std::vector<unsigned int> freeRecords;
+    int entityCount;
+
+    int findArchetype(ComponentMask mask);          // Creates it when it does not exist yet
+    Entity allocate(int archetype);
+    int addRow(Archetype& archetype, unsigned int entityIndex);     // Zero-filled row
+    void removeRow(Archetype& archetype, int row);                  // Last row moves into its place
+    void moveEntity(Entity entity, ComponentMask mask);
+};
+
+// Entities with at least the components T..., visited archetype by archetype.
+// Each system keeps its own query, which remembers the matching archetypes and
+// only checks archetypes created since its last use.
+template <typename... T>
+class WorldQuery {
+public:
+    // function(count, T* columns...) once per matching archetype with entities
+    template <typename Function>
+    void eachArchetype(World& world, Function function) {
+        refresh(world);
+        for (size_t i = 0; i < matches.size(); i++) {
+            World::Archetype& archetype = world.getArchetype(matches[i]);
+            if (archetype.count > 0) function(archetype.count, archetype.template column<T>()...);
+        }
+    }
+
+    // function(T&...) for every matching entity
+    template <typename Function>
+    void each(World& world, Function function) {
+        eachArchetype(world, [&](int count, T*... columns) {
+            for (int i = 0; i < count; i++) function(columns[i]...);
+        });
+    }
+
+    // Matching archetype indices, e.g. to split their rows into jobs
+    const std::vector<int>& getArchetypes(World& world) {
+        refresh(world);
+        return matches;
+    }
+
+    int count(World& world) {
+        int total = 0;
+        eachArchetype(world, [&](int rows, T*...) { total += rows; });
+        return total;
+    }
+
+private:
+    std::vector<int> matches;
+    int checked = 0;
+
+    void refresh(World& world) {
+        ComponentMask mask = componentMask<T...>();
+        for (; checked < world.getArchetypeCount(); checked++) {
+            if ((world.getArchetype(checked).mask & mask) == mask) matches.push_back(checked);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,248 @@
+#include "BenchHarness.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+// One benchmark function with one argument
+struct BenchCase {
+    std::string name;       // "BM_Name" or "BM_Name/arg"
+    BenchFunction function;
+    int argument;
+};
+
+// Result of one case, median of the repetitions
+struct BenchResult {
+    std::string name;
+    long long iterations;
+    double nsPerIteration;      // Median
+    double minNsPerIteration;   // Fastest repetition
+    double itemsPerSecond;
+    double bytesPerSecond;
+    std::vector<std::pair<std::string, double> > counters;  // Per iteration
+};
+
+// Registered cases, filled before main by the static registrations
+static std::vector<BenchCase>& benchCases() {
+    static std::vector<BenchCase> cases;
+    return cases;
+}
+
+BenchState::BenchState(long long iterations, int argument)
+    : totalIterations(iterations), remaining(iterations), argument(argument) {
+    started = false;
+    elapsed = 0.0;
+    itemsProcessed = 0;
+    bytesProcessed = 0;
+}
+
+bool BenchState::keepRunning() {
+    if (!started) {
+        started = true;
+        startTime = std::chrono::steady_clock::now();
+    }
+    if (remaining > 0) {
+        remaining--;
+        return true;
+    }
+    pauseTiming();
+    return false;
+}
+
+void BenchState::pauseTiming() {
+    elapsed += std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void BenchState::resumeTiming() {
+    startTime = std::chrono::steady_clock::now();
+}
+
+void BenchState::setCounter(const std::string& name, double totalValue) {
+    counters.push_back(std::make_pair(name, totalValue));
+}
+
+BenchRegistration::BenchRegistration(const char* name, BenchFunction function, std::vector<int> arguments) {
+    if (arguments.empty()) {
+        benchCases().push_back({ name, function, 0 });
+        return;
+    }
+    for (size_t i = 0; i < arguments.size(); i++) {
+        benchCases().push_back({ std::string(name) + "/" + std::to_string(arguments[i]), function, arguments[i] });
+    }
+}
+
+// Runs one case: grows the iteration count until a run takes minTime, then repeats
+static BenchResult runCase(const BenchCase& benchCase, double minTime, int repetitions) {
+    long long iterations = 1;
+    for (;;) {
+        BenchState state(iterations, benchCase.argument);
+        benchCase.function(state);
+        double seconds = state.elapsedSeconds();
+        if (seconds >= minTime || iterations >= 1000000000LL) break;
+
+        // Aim 40% past the target, but grow at most 10x at a time
+        double factor = seconds > 0.0 ? minTime * 1.4 / seconds : 10.0;
+        if (factor > 10.0) factor = 10.0;
+        if (factor < 1.5) factor = 1.5;
+        iterations = (long long)(iterations * factor) + 1;
+    }
+
+    std::vector<double> times;
+    BenchResult result;
+    result.name = benchCase.name;
+    result.iterations = iterations;
+    result.itemsPerSecond = 0.0;
+    result.bytesPerSecond = 0.0;
+
+    for (int r = 0; r < repetitions; r++) {
+        BenchState state(iterations, benchCase.argument);
+        benchCase.function(state);
+        double seconds = state.elapsedSeconds();
+        times.push_back(seconds * 1e9 / iterations);
+
+        // Throughput and counters come from the last repetition
+        if (r == repetitions - 1) {
+            if (seconds > 0.0) {
+                result.itemsPerSecond = state.getItemsProcessed() / seconds;
+                result.bytesPerSecond = state.getBytesProcessed() / seconds;
+            }
+            result.counters = state.getCounters();
+            for (size_t c = 0; c < result.counters.size(); c++) result.counters[c].second /= iterations;
+        }
+    }
+
+    std::sort(times.begin(), times.end());
+    result.nsPerIteration = times[times.size() / 2];
+    result.minNsPerIteration = times[0];
+    return result;
+}
+
+// Reads "name" -> ns_per_iteration from a file written by writeJson
+static std::map<std::string, double> readJson(const std::string& path) {
+    std::map<std::string, double> baseline;
+    std::ifstream file(path.c_str());
+    if (!file.is_open()) {
+        std::cerr << "Could not open baseline: " << path << std::endl;
+        return baseline;
+    }
+
+    // One benchmark per line: {"name": "...", "iterations": N, "ns_per_iteration": X, ...}
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t name = line.find("\"name\": \"");
+        size_t time = line.find("\"ns_per_iteration\": ");
+        if (name == std::string::npos || time == std::string::npos) continue;
+        name += 9;
+        size_t nameEnd = line.find('"', name);
+        baseline[line.substr(name, nameEnd - name)] = std::atof(line.c_str() + time + 20);
+    }
+    return baseline;
+}
+
+// Writes the results, one benchmark per line so diffs between commits stay readable
+static bool writeJson(const std::string& path, const std::vector<BenchResult>& results) {
+    std::ofstream file(path.c_str());
+    if (!file.is_open()) {
+        std::cerr << "Could not write " << path << std::endl;
+        return false;
+    }
+
+    file << "{\n  \"context\": {\"compiler\": \"";
+#if defined(_MSC_VER)
+    file << "msvc " << _MSC_VER;
+#elif defined(__clang__)
+    file << "clang " << __clang_major__ << "." << __clang_minor__;
+#elif defined(__GNUC__)
+    file << "gcc " << __GNUC__ << "." << __GNUC_MINOR__;
+#endif
+#ifdef NDEBUG
+    file << "\", \"build\": \"release\"},\n";
+#else
+    file << "\", \"build\": \"debug\"},\n";
+#endif
+
+    file << "  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& result = results[i];
+        file << "    {\"name\": \"" << result.name << "\", \"iterations\": " << result.iterations
+            << ", \"ns_per_iteration\": " << result.nsPerIteration
+            << ", \"min_ns_per_iteration\": " << result.minNsPerIteration
+            << ", \"items_per_second\": " << result.itemsPerSecond
+            << ", \"bytes_per_second\": " << result.bytesPerSecond;
+        for (size_t c = 0; c < result.counters.size(); c++) {
+            file << ", \"" << result.counters[c].first << "\": " << result.counters[c].second;
+        }
+        file << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n}\n";
+    return true;
+}
+
+// Formats a time in ns/us/ms
+static std::string formatTime(double ns) {
+    char text[32];
+    if (ns < 1e3) snprintf(text, sizeof(text), "%.1f ns", ns);
+    else if (ns < 1e6) snprintf(text, sizeof(text), "%.2f us", ns / 1e3);
+    else snprintf(text, sizeof(text), "%.2f ms", ns / 1e6);
+    return text;
+}
+
+int runBenchmarks(int argc, char** argv) {
+    std::string filter, jsonPath, comparePath;
+    double minTime = 0.2;
+    int repetitions = 5;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = (eq == std::string::npos) ? "" : arg.substr(eq + 1);
+
+        if (key == "--filter") filter = value;
+        else if (key == "--min-time") minTime = std::atof(value.c_str());
+        else if (key == "--repetitions") repetitions = std::max(1, std::atoi(value.c_str()));
+        else if (key == "--json") jsonPath = value;
+        else if (key == "--compare") comparePath = value;
+        else {
+            std::cerr << "Unknown option: " << arg << "\n"
+                << "Usage: " << argv[0] << " [--filter=TEXT] [--min-time=S] [--repetitions=N] [--json=FILE] [--compare=FILE]\n";
+            return 1;
+        }
+    }
+
+    std::map<std::string, double> baseline;
+    if (!comparePath.empty()) baseline = readJson(comparePath);
+
+    printf("%-40s %12s %12s %14s  %s\n", "Benchmark", "Time", "Min", "Iterations", "Throughput / counters");
+    std::vector<BenchResult> results;
+    const std::vector<BenchCase>& cases = benchCases();
+    for (size_t i = 0; i < cases.size(); i++) {
+        if (!filter.empty() && cases[i].name.find(filter) == std::string::npos) continue;
+
+        BenchResult result = runCase(cases[i], minTime, repetitions);
+        results.push_back(result);
+
+        std::ostringstream extra;
+        extra << std::fixed << std::setprecision(1);
+        if (result.itemsPerSecond > 0.0) extra << result.itemsPerSecond / 1e6 << " M items/s  ";
+        if (result.bytesPerSecond > 0.0) extra << result.bytesPerSecond / (1024.0 * 1024.0) << " MB/s  ";
+        for (size_t c = 0; c < result.counters.size(); c++) {
+            extra << result.counters[c].first << "=" << result.counters[c].second << "  ";
+        }
+        std::map<std::string, double>::const_iterator old = baseline.find(result.name);
+        if (old != baseline.end() && old->second > 0.0) {
+            extra << "(" << (result.nsPerIteration / old->second - 1.0) * 100.0 << "% vs baseline)";
+        }
+
+        printf("%-40s %12s %12s %14lld  %s\n", result.name.c_str(), formatTime(result.nsPerIteration).c_str(),
+            formatTime(result.minNsPerIteration).c_str(), result.iterations, extra.str().c_str());
+        fflush(stdout);
+    }
+
+    if (!jsonPath.empty() && !writeJson(jsonPath, results)) return 1;
+    return 0;
+}
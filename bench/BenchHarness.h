@@ -0,0 +1,85 @@
+#ifndef BENCHHARNESS_H
+#define BENCHHARNESS_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Timing state of one benchmark run, used Google Benchmark style:
+//     static void BM_Something(BenchState& state) {
+//         while (state.keepRunning()) { ... }
+//     }
+class BenchState {
+public:
+    BenchState(long long iterations, int argument);
+
+    // True while more iterations have to run; the timer covers the loop only
+    bool keepRunning();
+
+    // Excludes setup work inside the loop from the measurement
+    void pauseTiming();
+    void resumeTiming();
+
+    // Argument given with BENCHMARK_ARGS (0 when there is none)
+    int arg() const { return argument; }
+    long long iterations() const { return totalIterations; }
+
+    // Throughput reported as items/s and MB/s (totals over all iterations)
+    void setItemsProcessed(long long items) { itemsProcessed = items; }
+    void setBytesProcessed(long long bytes) { bytesProcessed = bytes; }
+
+    // Extra value reported per iteration (e.g. GL calls counted by the mock context)
+    void setCounter(const std::string& name, double totalValue);
+
+    // Results read by the runner
+    double elapsedSeconds() const { return elapsed; }
+    long long getItemsProcessed() const { return itemsProcessed; }
+    long long getBytesProcessed() const { return bytesProcessed; }
+    const std::vector<std::pair<std::string, double> >& getCounters() const { return counters; }
+
+private:
+    long long totalIterations;
+    long long remaining;
+    int argument;
+    bool started;
+
+    std::chrono::steady_clock::time_point startTime;
+    double elapsed;
+
+    long long itemsProcessed;
+    long long bytesProcessed;
+    std::vector<std::pair<std::string, double> > counters;
+};
+
+typedef void (*BenchFunction)(BenchState& state);
+
+// Adds a benchmark to the global list (used by the macros below)
+struct BenchRegistration {
+    BenchRegistration(const char* name, BenchFunction function, std::vector<int> arguments);
+};
+
+#define BENCHMARK(function) \
+    static BenchRegistration function##_registration(#function, function, std::vector<int>())
+#define BENCHMARK_ARGS(function, ...) \
+    static BenchRegistration function##_registration(#function, function, std::vector<int>{ __VA_ARGS__ })
+
+// Keeps the compiler from removing a computation whose result is otherwise unused
+template <class T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+// Runs the registered benchmarks
+// --filter=TEXT        only benchmarks whose name contains TEXT
+// --min-time=SECONDS   minimum measured time per repetition (default 0.2)
+// --repetitions=N      repetitions per benchmark, the median is reported (default 5)
+// --json=FILE          write the results for later comparison
+// --compare=FILE       print the change against an earlier --json file
+int runBenchmarks(int argc, char** argv);
+
+#endif
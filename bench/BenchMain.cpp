@@ -0,0 +1,480 @@
+// Microbenchmarks for the loader, math and simulation hot paths.
+// The renderer runs against a mocked GL context (see MockGL.h), so no window or GPU is needed.
+#include "BenchHarness.h"
+#include "MockGL.h"
+#include "ModelLoader.h"
+#include "Shader.h"
+#include "Primitives.h"
+#include "RobotSkeleton.h"
+#include "Room.h"
+#include "SceneGenerator.h"
+#include "JobSystem.h"
+#include "NavGrid.h"
+#include "TourPlanner.h"
+#include "Crowd.h"
+#include "Behavior.h"
+#include "World.h"
+#include "Systems.h"
+#include "SearchIndex.h"
+#include "ObjParser.h"
+#include "AssetPack.h"
+#include "imgui/imgui.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <cmath>
+#include <cstdio>
+
+// Fills an Assimp mesh with n vertices on a sphere
+static void makeSphereMesh(aiMesh& mesh, unsigned int n) {
+    mesh.mNumVertices = n;
+    mesh.mVertices = new aiVector3D[n];
+    mesh.mNormals = new aiVector3D[n];
+    for (unsigned int i = 0; i < n; i++) {
+        float a = i * 0.618034f * 6.2831853f;
+        float y = 1.0f - 2.0f * (i + 0.5f) / n;
+        float r = std::sqrt(1.0f - y * y);
+        mesh.mVertices[i] = aiVector3D(r * std::cos(a), y, r * std::sin(a));
+        mesh.mNormals[i] = mesh.mVertices[i];
+    }
+}
+
+// Copies positions and normals out of an Assimp mesh
+static void BM_ProcessMesh(BenchState& state) {
+    aiMesh mesh;
+    makeSphereMesh(mesh, state.arg());
+    ModelLoader loader(std::vector<Vertex>(3));
+
+    while (state.keepRunning()) {
+        loader.vertices.clear();
+        loader.processMesh(&mesh);
+        doNotOptimize(loader.vertices.data());
+    }
+    state.setItemsProcessed(state.iterations() * state.arg());
+    state.setBytesProcessed(state.iterations() * state.arg() * (long long)sizeof(Vertex));
+}
+BENCHMARK_ARGS(BM_ProcessMesh, 1000, 100000);
+
+// Writes a generated mesh as an OBJ file without normals (as scan exports usually are),
+// returns its size in bytes
+static long long writeBenchObj(const char* path, int triangles) {
+    std::vector<Vertex> mesh = generateExhibitMesh(0, triangles);
+    FILE* file = std::fopen(path, "w");
+    if (!file) return 0;
+    for (size_t i = 0; i < mesh.size(); i++) {
+        std::fprintf(file, "v %.6f %.6f %.6f\n", mesh[i].Position.x, mesh[i].Position.y, mesh[i].Position.z);
+    }
+    for (size_t i = 0; i + 2 < mesh.size(); i += 3) std::fprintf(file, "f %d %d %d\n", (int)i + 1, (int)i + 2, (int)i + 3);
+    long long size = std::ftell(file);
+    std::fclose(file);
+    return size;
+}
+
+// Whole OBJ import through Assimp (parse, triangulate, generate normals, copy out)
+static void BM_LoadObjAssimp(BenchState& state) {
+    long long bytes = writeBenchObj("bench_model.obj", 200000);
+    while (state.keepRunning()) {
+        ModelLoader model("bench_model.obj", MODEL_IMPORTER_ASSIMP);
+        doNotOptimize(model.vertices.data());
+    }
+    state.setBytesProcessed(state.iterations() * bytes);
+    std::remove("bench_model.obj");
+}
+BENCHMARK(BM_LoadObjAssimp);
+
+// The same file through the parallel OBJ parser on N worker threads
+static void BM_LoadObjParallel(BenchState& state) {
+    long long bytes = writeBenchObj("bench_model.obj", 200000);
+    JobSystem jobs(state.arg());
+    while (state.keepRunning()) {
+        ModelLoader model("bench_model.obj", MODEL_IMPORTER_OBJ, &jobs);
+        doNotOptimize(model.vertices.data());
+    }
+    state.setBytesProcessed(state.iterations() * bytes);
+    std::remove("bench_model.obj");
+}
+BENCHMARK_ARGS(BM_LoadObjParallel, 0, 1, 3, 7);
+
+// Decoding a packed 200k triangle mesh (quantized vertices, as museum_cook writes them)
+// on N worker threads; MB/s of decompressed data
+static void BM_PackDecode(BenchState& state) {
+    std::vector<Vertex> mesh = generateExhibitMesh(0, 200000);
+    std::vector<CookedVertex> vertices(mesh.size());
+    for (size_t i = 0; i < mesh.size(); i++) {
+        for (int k = 0; k < 3; k++) {
+            vertices[i].position[k] = (unsigned short)((glm::clamp(mesh[i].Position[k], -2.0f, 2.0f) + 2.0f) * 16383.0f);
+            vertices[i].normal[k] = (signed char)(glm::clamp(mesh[i].Normal[k], -1.0f, 1.0f) * 127.0f);
+        }
+        vertices[i].position[3] = 0;
+        vertices[i].normal[3] = 0;
+    }
+    size_t bytes = vertices.size() * sizeof(CookedVertex);
+    {
+        AssetPackWriter writer;
+        writer.begin("bench_assets.pack");
+        writer.addAsset("bench", PACK_ASSET_MESH, 0, nullptr, 0, (const unsigned char*)vertices.data(), bytes, 0, 0, nullptr);
+        writer.finish();
+    }
+
+    AssetPack pack;
+    pack.open("bench_assets.pack");
+    JobSystem jobs(state.arg());
+    std::vector<unsigned char> decoded(bytes);
+    while (state.keepRunning()) {
+        pack.decompress(0, decoded.data(), &jobs);
+        doNotOptimize(decoded.data());
+    }
+    state.setBytesProcessed(state.iterations() * (long long)bytes);
+    pack.close();
+    std::remove("bench_assets.pack");
+}
+BENCHMARK_ARGS(BM_PackDecode, 0, 1, 3, 7);
+
+// Uniform upload paths: every setter looks the location up by name
+static void BM_ShaderSetMat4(BenchState& state) {
+    Shader shader("vertex_shader.glsl", "fragment_shader.glsl");
+    glm::mat4 matrix(1.0f);
+    while (state.keepRunning()) {
+        shader.setMat4("view", matrix);
+    }
+}
+BENCHMARK(BM_ShaderSetMat4);
+
+static void BM_ShaderSetVec3(BenchState& state) {
+    Shader shader("vertex_shader.glsl", "fragment_shader.glsl");
+    glm::vec3 color(1.0f, 0.95f, 0.7f);
+    while (state.keepRunning()) {
+        shader.setVec3("lightColors[0]", color);
+    }
+}
+BENCHMARK(BM_ShaderSetVec3);
+
+static void BM_ShaderSetFloat(BenchState& state) {
+    Shader shader("vertex_shader.glsl", "fragment_shader.glsl");
+    while (state.keepRunning()) {
+        shader.setFloat("lightAttenuation", 0.02f);
+    }
+}
+BENCHMARK(BM_ShaderSetFloat);
+
+// 4x4 matrix products: the skeleton's SSE path against plain GLM
+static void BM_MultiplyMat4(BenchState& state) {
+    glm::mat4 a = glm::rotate(glm::mat4(1.0f), 0.3f, glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 b = glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 2.0f, 3.0f));
+    glm::mat4 out;
+    while (state.keepRunning()) {
+        multiplyMat4(a, b, out);
+        doNotOptimize(out);
+    }
+    state.setItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MultiplyMat4);
+
+static void BM_GlmMat4Multiply(BenchState& state) {
+    glm::mat4 a = glm::rotate(glm::mat4(1.0f), 0.3f, glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 b = glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 2.0f, 3.0f));
+    glm::mat4 out;
+    while (state.keepRunning()) {
+        out = a * b;
+        doNotOptimize(out);
+    }
+    state.setItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GlmMat4Multiply);
+
+// Exhibit matrix construction as done per object in drawMuseumRoom
+static void BM_ExhibitMatrix(BenchState& state) {
+    glm::vec3 position(3.0f, 0.0f, 3.0f);
+    float yaw = 0.0f;
+    while (state.keepRunning()) {
+        glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), position);
+        modelMatrix = glm::rotate(modelMatrix, glm::radians(yaw), glm::vec3(0.0f, 1.0f, 0.0f));
+        modelMatrix = glm::scale(modelMatrix, glm::vec3(1.2f));
+        doNotOptimize(modelMatrix);
+        yaw += 1.0f;
+    }
+    state.setItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ExhibitMatrix);
+
+// Walking robot: every limb is dirty each frame
+static void BM_RobotSkeletonUpdate(BenchState& state) {
+    RobotSkeleton skeleton;
+    float time = 0.0f;
+    while (state.keepRunning()) {
+        time += 1.0f / 60.0f;
+        skeleton.setRootPosition(glm::vec3(time, 0.0f, 0.0f));
+        skeleton.setLimbSwing(std::sin(time * 4.0f) * 0.5f);
+        skeleton.updateWorldTransforms();
+        doNotOptimize(skeleton.getPartMatrix(ROBOT_HEAD));
+    }
+}
+BENCHMARK(BM_RobotSkeletonUpdate);
+
+// Whole robot: skeleton and the per-object data of its parts (drawn with the other robots)
+static void BM_WriteHumanoidRobot(BenchState& state) {
+    RobotSkeleton skeleton;
+    ObjectData objects[ROBOT_CUBE_PARTS + ROBOT_SPHERE_PARTS + ROBOT_CYLINDER_PARTS];
+    float time = 0.0f;
+    while (state.keepRunning()) {
+        time += 1.0f / 60.0f;
+        poseHumanoidRobot(skeleton, glm::vec3(time, 0.0f, 0.0f), time);
+        writeHumanoidRobot(skeleton, objects, objects + ROBOT_CUBE_PARTS, objects + ROBOT_CUBE_PARTS + ROBOT_SPHERE_PARTS);
+        doNotOptimize(objects[0].model);
+    }
+}
+BENCHMARK(BM_WriteHumanoidRobot);
+
+// Generated single room scene with the given number of exhibits and robots
+static SceneDescription benchScene(int exhibits, int robots) {
+    SceneParams params;
+    params.exhibitsPerRoom = exhibits;
+    params.robots = robots;
+    params.trianglesPerExhibit = 200;
+    return generateScene(params);
+}
+
+// Full CPU side of a room frame: per-object data, its upload, draw calls and the control panel
+static void BM_DrawMuseumRoom(BenchState& state) {
+    Room room(benchScene(state.arg(), 1));
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 3.0f, 10.0f), glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(55.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+
+    RoomSnapshot snapshot;
+    room.writeSnapshot(snapshot, true);
+
+    resetMockGLCounters();
+    while (state.keepRunning()) {
+        ImGui::NewFrame();
+        room.cullExhibits(projection * view, nullptr);
+        room.buildDrawList(snapshot, nullptr);
+        room.drawMuseumRoom(view, projection, snapshot);
+        ImGui::EndFrame();
+    }
+    state.setItemsProcessed(state.iterations() * state.arg());
+    state.setCounter("draws", (double)mockGLCounters.drawCalls);
+    state.setCounter("uniforms", (double)mockGLCounters.uniformUploads);
+    state.setCounter("bytes", (double)mockGLCounters.bufferBytes);
+}
+BENCHMARK_ARGS(BM_DrawMuseumRoom, 5, 100, 1000, 10000);
+
+// Frustum culling and draw list building of 10000 exhibits on N worker threads
+static void BM_PrepareExhibits(BenchState& state) {
+    Room room(benchScene(10000, 1));
+    JobSystem jobs(state.arg());
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 3.0f, 10.0f), glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(55.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+
+    RoomSnapshot snapshot;
+    room.writeSnapshot(snapshot, true);
+
+    while (state.keepRunning()) {
+        room.cullExhibits(projection * view, &jobs);
+        room.buildDrawList(snapshot, &jobs);
+    }
+    state.setItemsProcessed(state.iterations() * 10000);
+    state.setCounter("visible", (double)room.getVisibleExhibitCount() * state.iterations());
+}
+BENCHMARK_ARGS(BM_PrepareExhibits, 0, 1, 3, 7);
+
+// Simulation step with the guide and a number of wandering robots
+static void BM_RoomUpdate(BenchState& state) {
+    Room room(benchScene(25, state.arg()));
+    while (state.keepRunning()) {
+        doNotOptimize(room.update(1.0f / 60.0f));
+    }
+    state.setItemsProcessed(state.iterations() * state.arg());
+}
+BENCHMARK_ARGS(BM_RoomUpdate, 1, 100, 1000);
+
+// Navigation grid of a generated museum with N rooms and 9 exhibits per room
+static NavGrid* benchNavGrid(int rooms, std::vector<glm::vec3>& spots) {
+    SceneParams params;
+    params.rooms = rooms;
+    params.exhibitsPerRoom = 9;
+    params.trianglesPerExhibit = 200;
+    SceneDescription scene = generateScene(params);
+
+    std::vector<NavObstacle> obstacles;
+    for (size_t i = 0; i < scene.exhibits.size(); i++) {
+        obstacles.push_back({ scene.exhibits[i].position, scene.exhibits[i].scale * 0.5f });
+    }
+    NavGrid* grid = new NavGrid(scene.roomOrigins, obstacles);
+    for (size_t i = 0; i < scene.exhibits.size(); i++) spots.push_back(grid->nearestWalkable(scene.exhibits[i].position));
+    return grid;
+}
+
+// Route planning between random exhibits of N rooms, every query planned from scratch
+static void BM_FindPathUncached(BenchState& state) {
+    std::vector<glm::vec3> spots;
+    NavGrid* grid = benchNavGrid(state.arg(), spots);
+    std::vector<glm::vec3> path;
+    unsigned int random = 1u;
+
+    while (state.keepRunning()) {
+        random = random * 1664525u + 1013904223u;
+        const glm::vec3& from = spots[(random >> 8) % spots.size()];
+        random = random * 1664525u + 1013904223u;
+        const glm::vec3& to = spots[(random >> 8) % spots.size()];
+        grid->clearCache();
+        doNotOptimize(grid->findPath(from, to, path));
+    }
+    delete grid;
+}
+BENCHMARK_ARGS(BM_FindPathUncached, 1, 100, 1000);
+
+// Stop-to-stop routes of a guided tour, answered from the path cache
+static void BM_FindPathCached(BenchState& state) {
+    std::vector<glm::vec3> spots;
+    NavGrid* grid = benchNavGrid(state.arg(), spots);
+    std::vector<glm::vec3> path;
+    size_t stops = spots.size() < 16 ? spots.size() : 16;
+    size_t stop = 0;
+
+    while (state.keepRunning()) {
+        doNotOptimize(grid->findPath(spots[stop % stops], spots[(stop + 1) % stops], path));
+        stop++;
+    }
+    state.setCounter("hit_rate", (double)grid->getCacheHits() / (grid->getCacheHits() + grid->getCacheMisses()) * state.iterations());
+    delete grid;
+}
+BENCHMARK_ARGS(BM_FindPathCached, 100);
+
+// Visiting order over every exhibit of N rooms: distances, nearest neighbour, 2-opt and Or-opt
+static void BM_PlanTour(BenchState& state) {
+    std::vector<glm::vec3> spots;
+    NavGrid* grid = benchNavGrid(state.arg(), spots);
+    TourPlanner planner(grid);
+
+    while (state.keepRunning()) {
+        planner.plan(spots[0], spots);
+        doNotOptimize(planner.getTourLength());
+    }
+    state.setCounter("meters", planner.getTourLength() * state.iterations());
+    state.setItemsProcessed(state.iterations() * spots.size());
+    delete grid;
+}
+BENCHMARK_ARGS(BM_PlanTour, 1, 10, 50);
+
+// One tick of 10000 visitors walking between the exhibits of 100 rooms, on N worker threads
+static void BM_CrowdUpdate(BenchState& state) {
+    SceneParams params;
+    params.rooms = 100;
+    params.exhibitsPerRoom = 5;
+    params.trianglesPerExhibit = 200;
+    params.visitors = 10000;
+    SceneDescription scene = generateScene(params);
+
+    std::vector<NavObstacle> obstacles;
+    for (size_t i = 0; i < scene.exhibits.size(); i++) {
+        obstacles.push_back({ scene.exhibits[i].position, scene.exhibits[i].scale * 0.5f });
+    }
+    NavGrid grid(scene.roomOrigins, obstacles);
+    std::vector<glm::vec3> spots;
+    for (size_t i = 0; i < scene.exhibits.size(); i++) spots.push_back(grid.nearestWalkable(scene.exhibits[i].position));
+    Crowd crowd(&grid, scene.visitorStarts, spots, 1u);
+    JobSystem jobs(state.arg());
+
+    while (state.keepRunning()) {
+        crowd.update(1.0f / 60.0f, &jobs);
+    }
+    state.setItemsProcessed(state.iterations() * crowd.getAgentCount());
+}
+BENCHMARK_ARGS(BM_CrowdUpdate, 0, 1, 3, 7);
+
+// Scripted agent: walk to a random spot of a 30 m square, look at it for 2 to 4 s, repeat
+static BehaviorTask benchStroll(World& world, BehaviorScheduler& scheduler, Entity agent, unsigned int seed) {
+    unsigned int random = seed;
+    for (;;) {
+        random = random * 1664525u + 1013904223u;
+        Locomotion& walk = *world.get<Locomotion>(agent);
+        walk.target = glm::vec3((random >> 8) % 300 * 0.1f, 0.0f, (random >> 16) % 300 * 0.1f);
+        walk.script = scheduler.current();
+        walk.active = true;
+        co_await scheduler.park();
+        co_await scheduler.wait(2.0f + (random >> 24) % 3);
+    }
+}
+
+// One simulation step of N scripted agents walking and waiting: movement system, then the scheduler
+static void BM_BehaviorUpdate(BenchState& state) {
+    World world;
+    BehaviorScheduler scheduler;
+    WorldQuery<Transform, Locomotion> query;
+    std::vector<std::vector<glm::vec3> > routes;
+    for (int i = 0; i < state.arg(); i++) {
+        glm::vec3 start(15.0f, 0.0f, 15.0f);
+        Locomotion walk = { start, 0.1f, 0.0f, 1.2f, 1.2f, -1, 0, BehaviorHandle(), false };
+        Entity agent = world.create(Transform{ start, 0.0f, 1.0f }, walk);
+        scheduler.spawn(benchStroll(world, scheduler, agent, (unsigned int)i + 1u));
+    }
+
+    while (state.keepRunning()) {
+        movementSystem(world, query, routes, scheduler, 1.0f / 60.0f);
+        scheduler.update(1.0f / 60.0f);
+    }
+    state.setItemsProcessed(state.iterations() * state.arg());
+}
+BENCHMARK_ARGS(BM_BehaviorUpdate, 1000, 10000, 50000);
+
+// Script that ends at its first resume
+static BehaviorTask benchShortScript(BehaviorScheduler& scheduler) {
+    co_await scheduler.wait(0.0f);
+}
+
+// Spawning and finishing scripts: coroutine frames come from the frame pool
+static void BM_BehaviorSpawn(BenchState& state) {
+    BehaviorScheduler scheduler;
+    while (state.keepRunning()) {
+        for (int i = 0; i < 100; i++) scheduler.spawn(benchShortScript(scheduler));
+        scheduler.update(1.0f / 60.0f);
+    }
+    state.setItemsProcessed(state.iterations() * 100);
+}
+BENCHMARK(BM_BehaviorSpawn);
+
+// Snapshot copy published by the simulation thread after every tick
+static void BM_WriteSnapshot(BenchState& state) {
+    Room room(benchScene(25, state.arg()));
+    RoomSnapshot snapshot;
+    while (state.keepRunning()) {
+        room.writeSnapshot(snapshot, true);
+        doNotOptimize(snapshot.robotPosition);
+    }
+}
+BENCHMARK_ARGS(BM_WriteSnapshot, 1, 1000);
+
+// Catalog search box: the query of one keystroke over a collection of the given size
+static void BM_SearchQuery(BenchState& state) {
+    static const char* periods[] = { "Roman Period", "Hittite Period", "Byzantine Period", "Ottoman Period", "Bronze Age" };
+    static const char* objects[] = { "marble", "bronze", "statue", "coin", "vase", "amphora", "relief", "tomb", "lamp", "mosaic", "altar" };
+    SearchIndex index;
+    for (int i = 0; i < state.arg(); i++) {
+        std::string title = std::string(objects[i % 11]) + " " + objects[(i / 11) % 11] + " " + std::to_string(i);
+        std::string description = "Item " + std::to_string(i) + " of the reserve, found near site " + std::to_string(i % 997);
+        index.addDocument(title.c_str(), periods[i % 5], description.c_str());
+    }
+
+    std::vector<SearchResult> results;
+    while (state.keepRunning()) {
+        index.search("roman mar", results, SEARCH_MAX_RESULTS);
+        doNotOptimize(results.data());
+    }
+}
+BENCHMARK_ARGS(BM_SearchQuery, 1000, 100000);
+
+int main(int argc, char** argv) {
+    installMockGL();
+
+    // UI without a backend: the control panel is laid out but never rendered
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.DisplaySize = ImVec2(1280.0f, 720.0f);
+    io.IniFilename = nullptr;
+    unsigned char* pixels;
+    int width, height;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+
+    int result = runBenchmarks(argc, argv);
+
+    ImGui::DestroyContext();
+    return result;
+}
@@ -0,0 +1,135 @@
+#include "MockGL.h"
+#include <glad/glad.h>
+
+MockGLCounters mockGLCounters;
+
+// Object names handed out by glGen*/glCreate*
+static GLuint nextName = 1;
+
+static void APIENTRY mockGenNames(GLsizei n, GLuint* names) {
+    for (GLsizei i = 0; i < n; i++) names[i] = nextName++;
+}
+static void APIENTRY mockDeleteNames(GLsizei, const GLuint*) {}
+static GLuint APIENTRY mockCreateShader(GLenum) { return nextName++; }
+static GLuint APIENTRY mockCreateProgram() { return nextName++; }
+static void APIENTRY mockShaderSource(GLuint, GLsizei, const GLchar* const*, const GLint*) {}
+static void APIENTRY mockObject(GLuint) {}
+static void APIENTRY mockAttachShader(GLuint, GLuint) {}
+
+// Compile and link always succeed, queries report results as available
+static void APIENTRY mockGetObjectiv(GLuint, GLenum, GLint* params) { *params = GL_TRUE; }
+static void APIENTRY mockGetInfoLog(GLuint, GLsizei size, GLsizei* length, GLchar* log) {
+    if (length) *length = 0;
+    if (size > 0) log[0] = '\0';
+}
+static void APIENTRY mockGetQueryObjectuiv(GLuint, GLenum, GLuint* params) { *params = 1; }
+static void APIENTRY mockGetQueryObjectui64v(GLuint, GLenum, GLuint64* params) { *params = 1000; }
+static void APIENTRY mockBeginQuery(GLenum, GLuint) {}
+static void APIENTRY mockEndQuery(GLenum) {}
+
+// Limits of a GL 3.3 context without extensions (so stream buffers orphan instead of mapping)
+static void APIENTRY mockGetIntegerv(GLenum name, GLint* params) {
+    if (name == GL_MAX_TEXTURE_BUFFER_SIZE) *params = 1 << 27;
+    else if (name == GL_MAJOR_VERSION) *params = 3;
+    else if (name == GL_MINOR_VERSION) *params = 3;
+    else *params = 0;
+}
+
+// Binds
+static void APIENTRY mockUseProgram(GLuint) { mockGLCounters.stateChanges++; }
+static void APIENTRY mockBindVertexArray(GLuint) { mockGLCounters.stateChanges++; }
+static void APIENTRY mockBindBuffer(GLenum, GLuint) { mockGLCounters.stateChanges++; }
+static void APIENTRY mockBindTexture(GLenum, GLuint) { mockGLCounters.stateChanges++; }
+static void APIENTRY mockActiveTexture(GLenum) {}
+
+// Buffers and vertex layout
+static void APIENTRY mockBufferData(GLenum, GLsizeiptr size, const void*, GLenum) { mockGLCounters.bufferBytes += size; }
+static void APIENTRY mockBufferSubData(GLenum, GLintptr, GLsizeiptr size, const void*) { mockGLCounters.bufferBytes += size; }
+static void APIENTRY mockVertexAttribPointer(GLuint, GLint, GLenum, GLboolean, GLsizei, const void*) {}
+static void APIENTRY mockEnableVertexAttribArray(GLuint) {}
+static void APIENTRY mockVertexAttribDivisor(GLuint, GLuint) {}
+static void APIENTRY mockTexBuffer(GLenum, GLenum, GLuint) {}
+
+// Draws
+static void APIENTRY mockDrawArrays(GLenum, GLint, GLsizei) { mockGLCounters.drawCalls++; }
+static void APIENTRY mockDrawElements(GLenum, GLsizei, GLenum, const void*) { mockGLCounters.drawCalls++; }
+static void APIENTRY mockDrawArraysInstanced(GLenum, GLint, GLsizei, GLsizei) { mockGLCounters.drawCalls++; }
+static void APIENTRY mockDrawElementsInstanced(GLenum, GLsizei, GLenum, const void*, GLsizei) { mockGLCounters.drawCalls++; }
+
+// Uniform lookup hashes the name like a driver would, so string costs stay visible
+static GLint APIENTRY mockGetUniformLocation(GLuint, const GLchar* name) {
+    mockGLCounters.uniformLookups++;
+    unsigned int hash = 2166136261u;
+    for (const GLchar* c = name; *c; c++) hash = (hash ^ (unsigned char)*c) * 16777619u;
+    return (GLint)(hash & 1023);
+}
+static void APIENTRY mockUniform1i(GLint, GLint) { mockGLCounters.uniformUploads++; }
+static void APIENTRY mockUniform1f(GLint, GLfloat) { mockGLCounters.uniformUploads++; }
+static void APIENTRY mockUniform2f(GLint, GLfloat, GLfloat) { mockGLCounters.uniformUploads++; }
+static void APIENTRY mockUniform3fv(GLint, GLsizei, const GLfloat*) { mockGLCounters.uniformUploads++; }
+static void APIENTRY mockUniformMatrix4fv(GLint, GLsizei, GLboolean, const GLfloat*) { mockGLCounters.uniformUploads++; }
+
+void installMockGL() {
+    glad_glGenVertexArrays = mockGenNames;
+    glad_glGenBuffers = mockGenNames;
+    glad_glGenQueries = mockGenNames;
+    glad_glGenTextures = mockGenNames;
+    glad_glDeleteVertexArrays = mockDeleteNames;
+    glad_glDeleteBuffers = mockDeleteNames;
+    glad_glDeleteQueries = mockDeleteNames;
+    glad_glDeleteTextures = mockDeleteNames;
+
+    glad_glCreateShader = mockCreateShader;
+    glad_glShaderSource = mockShaderSource;
+    glad_glCompileShader = mockObject;
+    glad_glGetShaderiv = mockGetObjectiv;
+    glad_glGetShaderInfoLog = mockGetInfoLog;
+    glad_glDeleteShader = mockObject;
+    glad_glCreateProgram = mockCreateProgram;
+    glad_glAttachShader = mockAttachShader;
+    glad_glLinkProgram = mockObject;
+    glad_glGetProgramiv = mockGetObjectiv;
+    glad_glGetProgramInfoLog = mockGetInfoLog;
+    glad_glDeleteProgram = mockObject;
+
+    glad_glBeginQuery = mockBeginQuery;
+    glad_glEndQuery = mockEndQuery;
+    glad_glGetQueryObjectiv = mockGetObjectiv;
+    glad_glGetQueryObjectuiv = mockGetQueryObjectuiv;
+    glad_glGetQueryObjectui64v = mockGetQueryObjectui64v;
+    glad_glGetIntegerv = mockGetIntegerv;
+
+    glad_glUseProgram = mockUseProgram;
+    glad_glBindVertexArray = mockBindVertexArray;
+    glad_glBindBuffer = mockBindBuffer;
+    glad_glBindTexture = mockBindTexture;
+    glad_glActiveTexture = mockActiveTexture;
+    glad_glBufferData = mockBufferData;
+    glad_glBufferSubData = mockBufferSubData;
+    glad_glVertexAttribPointer = mockVertexAttribPointer;
+    glad_glEnableVertexAttribArray = mockEnableVertexAttribArray;
+    glad_glVertexAttribDivisor = mockVertexAttribDivisor;
+    glad_glTexBuffer = mockTexBuffer;
+
+    glad_glDrawArrays = mockDrawArrays;
+    glad_glDrawElements = mockDrawElements;
+    glad_glDrawArraysInstanced = mockDrawArraysInstanced;
+    glad_glDrawElementsInstanced = mockDrawElementsInstanced;
+
+    glad_glGetUniformLocation = mockGetUniformLocation;
+    glad_glUniform1i = mockUniform1i;
+    glad_glUniform1f = mockUniform1f;
+    glad_glUniform2f = mockUniform2f;
+    glad_glUniform3fv = mockUniform3fv;
+    glad_glUniformMatrix4fv = mockUniformMatrix4fv;
+
+    resetMockGLCounters();
+}
+
+void resetMockGLCounters() {
+    mockGLCounters.drawCalls = 0;
+    mockGLCounters.uniformLookups = 0;
+    mockGLCounters.uniformUploads = 0;
+    mockGLCounters.bufferBytes = 0;
+    mockGLCounters.stateChanges = 0;
+}
@@ -0,0 +1,22 @@
+#ifndef MOCKGL_H
+#define MOCKGL_H
+
+// Calls made into the mock context, so benchmarks can report GL work per iteration
+struct MockGLCounters {
+    long long drawCalls;         // glDrawArrays / glDrawElements and their instanced versions
+    long long uniformLookups;    // glGetUniformLocation
+    long long uniformUploads;    // glUniform*
+    long long bufferBytes;       // glBufferData / glBufferSubData sizes
+    long long stateChanges;      // Program, VAO, buffer and texture binds
+};
+
+extern MockGLCounters mockGLCounters;
+
+// Points the glad function pointers at cheap CPU stubs, so the renderer code
+// runs without a window or GPU; shaders always compile and link successfully
+void installMockGL();
+
+// Sets all counters to zero
+void resetMockGLCounters();
+
+#endif
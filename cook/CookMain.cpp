@@ -0,0 +1,165 @@
+// museum_cook: imports the exhibit models and sounds once and writes them into one
+// compressed asset pack (museum.pack) that the museum loads instead of the loose files.
+// Cooking is incremental: assets whose source file did not change since the last run are
+// copied from the previous pack as they are.
+#include "AssetPack.h"
+#include "ExhibitCatalog.h"
+#include "JobSystem.h"
+#include "MeshCooker.h"
+#include "SceneGenerator.h"
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <set>
+
+// Version of sound assets (stored as the WAV file)
+static const unsigned int SOUND_COOK_VERSION = 1;
+
+struct CookOptions {
+    std::string catalogPath = "catalog.txt";
+    std::string packPath = "museum.pack";
+    std::string soundDir = ".";
+    bool force = false;
+    int jobThreads = -1;
+};
+
+static void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+        << "  --catalog=FILE               Exhibit catalog naming the models (default catalog.txt)\n"
+        << "  --out=FILE                   Pack to write (default museum.pack)\n"
+        << "  --sounds=DIR                 Directory whose .wav files are packed (default .)\n"
+        << "  --force                      Cook every asset again, even if its source did not change\n"
+        << "  --job-threads=N              Worker threads for parsing and compression (default one per core)\n";
+}
+
+static bool parseCookOptions(int argc, char** argv, CookOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = (eq == std::string::npos) ? "" : arg.substr(eq + 1);
+
+        if (key == "--catalog") options.catalogPath = value;
+        else if (key == "--out") options.packPath = value;
+        else if (key == "--sounds") options.soundDir = value;
+        else if (key == "--force") options.force = true;
+        else if (key == "--job-threads") {
+            options.jobThreads = std::atoi(value.c_str());
+            if (options.jobThreads < 0) options.jobThreads = 0;
+        }
+        else {
+            if (key != "--help") std::cerr << "Unknown option: " << arg << "\n";
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool readFile(const std::string& path, std::vector<unsigned char>& data) {
+    std::ifstream file(path.c_str(), std::ios::binary);
+    if (!file) return false;
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+int main(int argc, char** argv) {
+    CookOptions options;
+    if (!parseCookOptions(argc, argv, options)) return 1;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    JobSystem jobs(options.jobThreads >= 0 ? options.jobThreads : JobSystem::defaultWorkerCount());
+
+    // Models of the scene the museum shows (the catalog's, or the built-in one without catalog)
+    std::string catalogBinary = std::filesystem::path(options.catalogPath).replace_extension(".bin").string();
+    ExhibitCatalog catalog;
+    loadExhibitCatalog(options.catalogPath, catalogBinary, catalog);
+    SceneDescription scene = catalog.isOpen() ? catalogMuseumScene(catalog) : defaultMuseumScene();
+
+    AssetPack previous;
+    std::error_code error;
+    if (!options.force && std::filesystem::exists(options.packPath, error)) previous.open(options.packPath);
+
+    AssetPackWriter writer;
+    if (!writer.begin(options.packPath)) return 1;
+    int cooked = 0, reused = 0, failed = 0;
+
+    // Unchanged sources keep their cooked data
+    auto reuse = [&](const std::string& name, const std::string& path, unsigned int version) -> bool {
+        int asset = previous.isOpen() ? previous.find(name) : -1;
+        if (asset < 0 || previous.getAsset(asset).cookVersion != version || !previous.isCurrent(asset, path)) return false;
+        if (!writer.copyAsset(previous, asset)) return false;
+        reused++;
+        return true;
+    };
+
+    std::set<std::string> names;
+    for (size_t i = 0; i < scene.meshes.size(); i++) {
+        const ExhibitMesh& mesh = scene.meshes[i];
+        if (mesh.path.empty() || !names.insert(mesh.path).second) continue;
+
+        // Binary glTF already uploads straight from the file
+        bool glbFile = mesh.path.size() >= 4 && (mesh.path.compare(mesh.path.size() - 4, 4, ".glb") == 0 || mesh.path.compare(mesh.path.size() - 4, 4, ".GLB") == 0);
+        if (mesh.importer == MODEL_IMPORTER_GLTF || (mesh.importer == MODEL_IMPORTER_AUTO && glbFile)) {
+            std::cout << "skipped  " << mesh.path << " (glTF is loaded from the file)\n";
+            continue;
+        }
+
+        unsigned int version = meshCookVersion(mesh.importer);
+        if (reuse(mesh.path, mesh.path, version)) continue;
+
+        unsigned long long sourceSize;
+        long long sourceTime;
+        std::vector<Vertex> triangles;
+        CookedMeshInfo info;
+        std::vector<unsigned char> payload;
+        if (!getSourceStamp(mesh.path, sourceSize, sourceTime) || !ModelLoader::importFile(mesh.path, mesh.importer, &jobs, triangles) ||
+            !cookMesh(triangles, info, payload)) {
+            std::cerr << "ERROR::COOK::MODEL_FAILED: " << mesh.path << std::endl;
+            failed++;
+            continue;
+        }
+        if (!writer.addAsset(mesh.path, PACK_ASSET_MESH, version, &info, sizeof(info), payload.data(), payload.size(),
+                             sourceSize, sourceTime, &jobs)) return 1;
+        cooked++;
+
+        std::cout << "cooked   " << mesh.path << ": " << triangles.size() / 3 << " triangles, " << info.vertexCount
+                  << " vertices, LOD triangles";
+        for (unsigned int l = 0; l < info.lodCount; l++) std::cout << " " << info.lods[l].indexCount / 3;
+        std::cout << "\n";
+    }
+
+    // Every sound of the sound directory, named by its file name as main loads them
+    std::filesystem::directory_iterator entries(options.soundDir, error);
+    for (; !error && entries != std::filesystem::directory_iterator(); entries.increment(error)) {
+        std::filesystem::path file = entries->path();
+        if (file.extension() != ".wav" && file.extension() != ".WAV") continue;
+        std::string name = file.filename().string();
+        std::string path = file.generic_string();
+        if (reuse(name, path, SOUND_COOK_VERSION)) continue;
+
+        unsigned long long sourceSize;
+        long long sourceTime;
+        std::vector<unsigned char> data;
+        if (!getSourceStamp(path, sourceSize, sourceTime) || !readFile(path, data)) {
+            std::cerr << "ERROR::COOK::SOUND_FAILED: " << path << std::endl;
+            failed++;
+            continue;
+        }
+        if (!writer.addAsset(name, PACK_ASSET_SOUND, SOUND_COOK_VERSION, nullptr, 0, data.data(), data.size(),
+                             sourceSize, sourceTime, &jobs)) return 1;
+        cooked++;
+        std::cout << "cooked   " << name << "\n";
+    }
+
+    // The previous pack is replaced by the new one
+    previous.close();
+    if (!writer.finish()) return 1;
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << options.packPath << ": " << cooked << " cooked, " << reused << " unchanged, " << failed << " failed, "
+              << writer.getRawBytes() / 1024 << " KB -> " << writer.getCompressedBytes() / 1024 << " KB in "
+              << seconds << " s" << std::endl;
+    return failed > 0 ? 1 : 0;
+}
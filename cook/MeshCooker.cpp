@@ -0,0 +1,313 @@
+#include "MeshCooker.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+// Post-transform cache modelled by the triangle ordering
+static const int CACHE_SIZE = 32;
+
+// Grid cells along the largest box axis of LOD 1, 2 and 3
+static const int LOD_GRID_BITS[COOKED_MAX_LODS - 1] = { 6, 5, 4 };
+
+// A level is kept only if it has at most this share of the previous level's triangles
+static const float LOD_MIN_REDUCTION = 0.75f;
+
+unsigned int meshCookVersion(ModelImporter importer) {
+    return (COOKED_MESH_VERSION << 8) | (unsigned int)importer;
+}
+
+// Quantized vertices compare and hash as their 12 bytes
+struct CookedVertexHash {
+    size_t operator()(const CookedVertex& vertex) const {
+        unsigned char bytes[sizeof(CookedVertex)];
+        std::memcpy(bytes, &vertex, sizeof(bytes));
+        size_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < sizeof(bytes); i++) hash = (hash ^ bytes[i]) * 1099511628211ull;
+        return hash;
+    }
+};
+
+struct CookedVertexEqual {
+    bool operator()(const CookedVertex& a, const CookedVertex& b) const { return std::memcmp(&a, &b, sizeof(CookedVertex)) == 0; }
+};
+
+// One level of detail while cooking
+struct CookLevel {
+    std::vector<CookedVertex> vertices;
+    std::vector<unsigned int> indices;
+};
+
+static signed char quantizeNormal(float value) {
+    return (signed char)std::lround(std::max(-1.0f, std::min(1.0f, value)) * 127.0f);
+}
+
+static void setNormal(CookedVertex& vertex, glm::vec3 normal) {
+    float length = glm::length(normal);
+    normal = length > 0.0f ? normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+    vertex.normal[0] = quantizeNormal(normal.x);
+    vertex.normal[1] = quantizeNormal(normal.y);
+    vertex.normal[2] = quantizeNormal(normal.z);
+    vertex.normal[3] = 0;
+}
+
+// Level 0: quantized and welded triangle list
+static void weld(const std::vector<Vertex>& triangles, const glm::vec3& low, const glm::vec3& scale, CookLevel& level) {
+    std::unordered_map<CookedVertex, unsigned int, CookedVertexHash, CookedVertexEqual> welded;
+    welded.reserve(triangles.size());
+    level.indices.reserve(triangles.size());
+    for (size_t i = 0; i < triangles.size(); i++) {
+        CookedVertex vertex;
+        glm::vec3 unit = (triangles[i].Position - low) / scale;
+        vertex.position[0] = (unsigned short)std::lround(std::max(0.0f, std::min(1.0f, unit.x)) * 65535.0f);
+        vertex.position[1] = (unsigned short)std::lround(std::max(0.0f, std::min(1.0f, unit.y)) * 65535.0f);
+        vertex.position[2] = (unsigned short)std::lround(std::max(0.0f, std::min(1.0f, unit.z)) * 65535.0f);
+        vertex.position[3] = 0;
+        setNormal(vertex, triangles[i].Normal);
+
+        std::pair<std::unordered_map<CookedVertex, unsigned int, CookedVertexHash, CookedVertexEqual>::iterator, bool> added =
+            welded.insert(std::make_pair(vertex, (unsigned int)level.vertices.size()));
+        if (added.second) level.vertices.push_back(vertex);
+        level.indices.push_back(added.first->second);
+    }
+}
+
+// Coarser level by vertex clustering: every vertex moves to the average of its grid cell,
+// triangles that collapse or repeat are dropped
+static void cluster(const CookLevel& source, int gridBits, CookLevel& level) {
+    int shift = 16 - gridBits;
+    std::unordered_map<unsigned long long, unsigned int> cells;
+    std::vector<unsigned int> remap(source.vertices.size());
+    std::vector<glm::dvec3> positionSums;
+    std::vector<glm::vec3> normalSums;
+    std::vector<int> counts;
+    for (size_t i = 0; i < source.vertices.size(); i++) {
+        const CookedVertex& vertex = source.vertices[i];
+        unsigned long long cell = ((unsigned long long)(vertex.position[0] >> shift) << 32) |
+                                  ((unsigned long long)(vertex.position[1] >> shift) << 16) | (vertex.position[2] >> shift);
+        std::pair<std::unordered_map<unsigned long long, unsigned int>::iterator, bool> added =
+            cells.insert(std::make_pair(cell, (unsigned int)counts.size()));
+        if (added.second) {
+            positionSums.push_back(glm::dvec3(0.0));
+            normalSums.push_back(glm::vec3(0.0f));
+            counts.push_back(0);
+        }
+        unsigned int target = added.first->second;
+        remap[i] = target;
+        positionSums[target] += glm::dvec3(vertex.position[0], vertex.position[1], vertex.position[2]);
+        normalSums[target] += glm::vec3(vertex.normal[0], vertex.normal[1], vertex.normal[2]);
+        counts[target]++;
+    }
+
+    level.vertices.resize(counts.size());
+    for (size_t i = 0; i < counts.size(); i++) {
+        glm::dvec3 average = positionSums[i] / (double)counts[i];
+        level.vertices[i].position[0] = (unsigned short)std::lround(average.x);
+        level.vertices[i].position[1] = (unsigned short)std::lround(average.y);
+        level.vertices[i].position[2] = (unsigned short)std::lround(average.z);
+        level.vertices[i].position[3] = 0;
+        setNormal(level.vertices[i], normalSums[i]);
+    }
+
+    std::unordered_set<unsigned long long> seen;
+    for (size_t i = 0; i + 2 < source.indices.size(); i += 3) {
+        unsigned int a = remap[source.indices[i]], b = remap[source.indices[i + 1]], c = remap[source.indices[i + 2]];
+        if (a == b || b == c || a == c) continue;
+
+        // Same triangle with the same winding, whatever corner it starts at (the grid has
+        // at most 2^18 cells, so three cluster numbers fit a 64-bit key exactly)
+        unsigned int first = std::min(a, std::min(b, c));
+        unsigned int second = first == a ? b : (first == b ? c : a);
+        unsigned int third = first == a ? c : (first == b ? a : b);
+        unsigned long long key = (unsigned long long)first | ((unsigned long long)second << 21) | ((unsigned long long)third << 42);
+        if (!seen.insert(key).second) continue;
+        level.indices.push_back(a);
+        level.indices.push_back(b);
+        level.indices.push_back(c);
+    }
+
+    // Unused clusters (all their triangles collapsed) are removed by reorderVertices
+}
+
+// Forsyth's vertex score: recently used vertices and vertices with few remaining
+// triangles are preferred, so triangles are emitted while their vertices are cached
+static float vertexScore(int cachePosition, int remaining) {
+    if (remaining == 0) return -1.0f;
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        if (cachePosition < 3) score = 0.75f;
+        else score = std::pow(1.0f - (float)(cachePosition - 3) / (CACHE_SIZE - 3), 1.5f);
+    }
+    return score + 2.0f / std::sqrt((float)remaining);
+}
+
+static void optimizeVertexCache(CookLevel& level) {
+    size_t vertexCount = level.vertices.size();
+    int triangleCount = (int)level.indices.size() / 3;
+    if (triangleCount == 0) return;
+
+    // Triangles of every vertex
+    std::vector<int> remaining(vertexCount, 0), adjacencyStart(vertexCount + 1, 0);
+    for (size_t i = 0; i < level.indices.size(); i++) remaining[level.indices[i]]++;
+    for (size_t v = 0; v < vertexCount; v++) adjacencyStart[v + 1] = adjacencyStart[v] + remaining[v];
+    std::vector<int> adjacency(level.indices.size()), fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+    for (int t = 0; t < triangleCount; t++) {
+        for (int k = 0; k < 3; k++) adjacency[fill[level.indices[t * 3 + k]]++] = t;
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> score(vertexCount), triangleScore(triangleCount, 0.0f);
+    std::vector<bool> emitted(triangleCount, false);
+    for (size_t v = 0; v < vertexCount; v++) score[v] = vertexScore(-1, remaining[v]);
+    for (int t = 0; t < triangleCount; t++) {
+        for (int k = 0; k < 3; k++) triangleScore[t] += score[level.indices[t * 3 + k]];
+    }
+
+    std::vector<unsigned int> output;
+    output.reserve(level.indices.size());
+    std::vector<unsigned int> cache, nextCache;
+    int best = 0, scanCursor = 0;
+    for (int emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+        // No candidate next to the cache: continue with the first triangle left
+        if (best < 0) {
+            while (emitted[scanCursor]) scanCursor++;
+            best = scanCursor;
+        }
+        emitted[best] = true;
+        nextCache.clear();
+        for (int k = 0; k < 3; k++) {
+            unsigned int v = level.indices[best * 3 + k];
+            output.push_back(v);
+            nextCache.push_back(v);
+
+            // Triangle no longer adjacent to its vertices
+            int* begin = &adjacency[adjacencyStart[v]];
+            int* end = begin + remaining[v];
+            *std::find(begin, end, best) = *(end - 1);
+            remaining[v]--;
+        }
+        for (size_t i = 0; i < cache.size(); i++) {
+            if (std::find(nextCache.begin(), nextCache.end(), cache[i]) == nextCache.end()) nextCache.push_back(cache[i]);
+        }
+
+        // New scores of the cached and just evicted vertices and of their triangles
+        for (size_t i = 0; i < nextCache.size(); i++) {
+            unsigned int v = nextCache[i];
+            cachePosition[v] = i < (size_t)CACHE_SIZE ? (int)i : -1;
+            float newScore = vertexScore(cachePosition[v], remaining[v]);
+            float change = newScore - score[v];
+            score[v] = newScore;
+            for (int j = 0; j < remaining[v]; j++) triangleScore[adjacency[adjacencyStart[v] + j]] += change;
+        }
+        if (nextCache.size() > (size_t)CACHE_SIZE) nextCache.resize(CACHE_SIZE);
+        cache.swap(nextCache);
+
+        best = -1;
+        float bestScore = -1.0f;
+        for (size_t i = 0; i < cache.size(); i++) {
+            unsigned int v = cache[i];
+            for (int j = 0; j < remaining[v]; j++) {
+                int t = adjacency[adjacencyStart[v] + j];
+                if (triangleScore[t] > bestScore) {
+                    bestScore = triangleScore[t];
+                    best = t;
+                }
+            }
+        }
+    }
+    level.indices.swap(output);
+}
+
+// Vertices in the order the triangles first use them (fetch locality), unused ones dropped
+static void reorderVertices(CookLevel& level) {
+    std::vector<unsigned int> remap(level.vertices.size(), 0xFFFFFFFFu);
+    std::vector<CookedVertex> ordered;
+    ordered.reserve(level.vertices.size());
+    for (size_t i = 0; i < level.indices.size(); i++) {
+        unsigned int& target = remap[level.indices[i]];
+        if (target == 0xFFFFFFFFu) {
+            target = (unsigned int)ordered.size();
+            ordered.push_back(level.vertices[level.indices[i]]);
+        }
+        level.indices[i] = target;
+    }
+    level.vertices.swap(ordered);
+}
+
+bool cookMesh(const std::vector<Vertex>& triangles, CookedMeshInfo& info, std::vector<unsigned char>& payload) {
+    if (triangles.size() < 3) return false;
+    std::memset(&info, 0, sizeof(info));
+
+    // Bounds as ModelLoader computes them for loose files
+    glm::vec3 low = triangles[0].Position, high = triangles[0].Position;
+    for (size_t i = 1; i < triangles.size(); i++) {
+        low = glm::min(low, triangles[i].Position);
+        high = glm::max(high, triangles[i].Position);
+    }
+    glm::vec3 center = (low + high) * 0.5f;
+    float radiusSquared = 0.0f, footprintSquared = 0.0f;
+    for (size_t i = 0; i < triangles.size(); i++) {
+        glm::vec3 offset = triangles[i].Position - center;
+        radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+        const glm::vec3& position = triangles[i].Position;
+        footprintSquared = std::max(footprintSquared, position.x * position.x + position.z * position.z);
+    }
+    // One scale for all axes: the model matrix then scales uniformly, so its inverse transpose
+    // keeps the 8-bit normals' directions (a per-axis scale would bend them on thin boxes)
+    glm::vec3 extent = high - low;
+    glm::vec3 scale(std::max(std::max(extent.x, extent.y), std::max(extent.z, 1e-6f)));
+
+    std::vector<CookLevel> levels(1);
+    weld(triangles, low, scale, levels[0]);
+    for (int l = 0; l < COOKED_MAX_LODS - 1; l++) {
+        CookLevel coarse;
+        cluster(levels.back(), LOD_GRID_BITS[l], coarse);
+        if (coarse.indices.size() < 12 || coarse.indices.size() > levels.back().indices.size() * LOD_MIN_REDUCTION) break;
+        levels.push_back(coarse);
+    }
+
+    size_t vertexCount = 0, indexCount = 0;
+    for (size_t l = 0; l < levels.size(); l++) {
+        optimizeVertexCache(levels[l]);
+        reorderVertices(levels[l]);
+        vertexCount += levels[l].vertices.size();
+        indexCount += levels[l].indices.size();
+    }
+
+    info.vertexCount = (unsigned int)vertexCount;
+    info.indexSize = vertexCount > 65535 ? 4 : 2;
+    info.lodCount = (unsigned int)levels.size();
+    for (int k = 0; k < 3; k++) {
+        info.boxLow[k] = low[k];
+        info.boxScale[k] = scale[k];
+        info.boundsCenter[k] = center[k];
+    }
+    info.boundsRadius = std::sqrt(radiusSquared);
+    info.footprintRadius = std::sqrt(footprintSquared);
+
+    // Payload: all vertices, then all indices (offset to the level's first vertex)
+    payload.resize(vertexCount * sizeof(CookedVertex) + indexCount * info.indexSize);
+    unsigned char* vertexOut = payload.data();
+    unsigned char* indexOut = payload.data() + vertexCount * sizeof(CookedVertex);
+    unsigned int baseVertex = 0, firstIndex = 0;
+    for (size_t l = 0; l < levels.size(); l++) {
+        const CookLevel& level = levels[l];
+        std::memcpy(vertexOut, level.vertices.data(), level.vertices.size() * sizeof(CookedVertex));
+        vertexOut += level.vertices.size() * sizeof(CookedVertex);
+        for (size_t i = 0; i < level.indices.size(); i++) {
+            unsigned int index = baseVertex + level.indices[i];
+            if (info.indexSize == 2) {
+                unsigned short shortIndex = (unsigned short)index;
+                std::memcpy(indexOut, &shortIndex, 2);
+            }
+            else std::memcpy(indexOut, &index, 4);
+            indexOut += info.indexSize;
+        }
+        info.lods[l].firstIndex = firstIndex;
+        info.lods[l].indexCount = (unsigned int)level.indices.size();
+        baseVertex += (unsigned int)level.vertices.size();
+        firstIndex += (unsigned int)level.indices.size();
+    }
+    return true;
+}
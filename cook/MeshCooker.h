@@ -0,0 +1,21 @@
+#ifndef MESHCOOKER_H
+#define MESHCOOKER_H
+
+#include <vector>
+#include "AssetPack.h"
+#include "ModelLoader.h"
+
+// Cook version of a mesh asset: payload format and the importer it was read with, so
+// changing either rebuilds the asset
+unsigned int meshCookVersion(ModelImporter importer);
+
+// Turns a triangle list into a cooked mesh payload (see CookedMeshInfo):
+// - quantization: positions to 16 bits inside the cube around the bounding box, normals to 8 bits
+// - welding: identical quantized vertices are stored once and indexed
+// - LODs: vertex clustering on coarser and coarser grids, kept while it removes triangles
+// - cache optimization: triangles reordered for the post-transform cache (Forsyth),
+//   vertices reordered by first use
+// Returns false for meshes without triangles.
+bool cookMesh(const std::vector<Vertex>& triangles, CookedMeshInfo& info, std::vector<unsigned char>& payload);
+
+#endif
@@ -0,0 +1,40 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec4 aInstance;   // Per visitor: xyz = position, w = heading in radians
+
+uniform mat4 view;
+uniform mat4 projection;
+
+// Body part relative to the visitor's feet and its color: one object of the streamed
+// per-object data (see vertex_shader.glsl), shared by every visitor of the draw
+uniform samplerBuffer objects;
+uniform int objectOffset;
+
+out vec3 FragPos;
+out vec3 Normal;
+flat out vec3 ObjectColor;
+
+void main() {
+    mat4 model = mat4(
+        texelFetch(objects, objectOffset),
+        texelFetch(objects, objectOffset + 1),
+        texelFetch(objects, objectOffset + 2),
+        texelFetch(objects, objectOffset + 3));
+    ObjectColor = texelFetch(objects, objectOffset + 4).rgb;
+
+    // Turn around the up axis, then move to the visitor's position
+    float c = cos(aInstance.w);
+    float s = sin(aInstance.w);
+    mat4 placement = mat4(
+        c, 0.0, -s, 0.0,
+        0.0, 1.0, 0.0, 0.0,
+        s, 0.0, c, 0.0,
+        aInstance.xyz, 1.0);
+    mat4 world = placement * model;
+
+    FragPos = vec3(world * vec4(aPos, 1.0));
+    Normal = mat3(transpose(inverse(world))) * aNormal;
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
@@ -6,27 +6,37 @@ out vec4 FragColor;
 // Inputs from the vertex shader
 in vec3 FragPos;   // Fragment position in world space
 in vec3 Normal;    // Normal vector at the fragment
+flat in vec3 ObjectColor;   // Base color of the object
+
+// Must match MAX_SCENE_LIGHTS in SceneGenerator.h
+#define MAX_LIGHTS 32
 
 // Uniforms (passed in from the CPU program)
-uniform vec3 lightPos;     // Position of the light source
-uniform vec3 lightColor;   // Color of the light
-uniform vec3 objectColor;  // Base color of the object
+uniform int lightCount;                    // Number of lights in use
+uniform vec3 lightPositions[MAX_LIGHTS];   // Positions of the light sources
+uniform vec3 lightColors[MAX_LIGHTS];      // Colors of the lights
+uniform float lightAttenuation;            // Quadratic distance falloff (0 = none)
 
 void main() {
     // ----- Ambient Lighting -----
     // A small constant light that simulates global illumination
     float ambientStrength = 0.3;
-    vec3 ambient = ambientStrength * lightColor;
+    vec3 ambient = ambientStrength * lightColors[0];
 
     // ----- Diffuse Lighting -----
     // Light that depends on angle between light direction and surface normal
     vec3 norm = normalize(Normal);                       // Normalize the surface normal
-    vec3 lightDir = normalize(lightPos - FragPos);       // Direction from fragment to light
-    float diff = max(dot(norm, lightDir), 0.0);          // Lambert's cosine law
-    vec3 diffuse = diff * lightColor;                    // Final diffuse component
+    vec3 diffuse = vec3(0.0);
+    for (int i = 0; i < lightCount; i++) {
+        vec3 toLight = lightPositions[i] - FragPos;
+        vec3 lightDir = normalize(toLight);              // Direction from fragment to light
+        float diff = max(dot(norm, lightDir), 0.0);      // Lambert's cosine law
+        float falloff = 1.0 / (1.0 + lightAttenuation * dot(toLight, toLight));
+        diffuse += diff * falloff * lightColors[i];      // Final diffuse component
+    }
 
     // Combine ambient and diffuse lighting
-    vec3 result = (ambient + diffuse) * objectColor;
+    vec3 result = (ambient + diffuse) * ObjectColor;
 
     // Set final fragment color
     FragColor = vec4(result, 1.0); // Alpha = 1.0 (fully opaque)
@@ -1,13 +1,43 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <iostream>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include "Room.h"
+#include "SimulationThread.h"
+#include "JobSystem.h"
+#include "AudioEngine.h"
+#include "AssetPack.h"
+#include "AssetReloader.h"
+#include "ExhibitCatalog.h"
+#include "AppOptions.h"
+#include "FrameScheduler.h"
+#include "SceneTarget.h"
+#include "StreamBuffer.h"
+#include "DynamicResolution.h"
+#include "GpuProfiler.h"
+#include "CpuProfiler.h"
+#include "FrameCapture.h"
+#include "Benchmark.h"
 #include "imgui/imgui.h"
 #include "imgui/imgui_impl_glfw.h"
 #include "imgui/imgui_impl_opengl3.h"
 
+// Loads a sound from the asset pack, or from its file when the pack does not have it or
+// the file changed after cooking
+static void loadSound(AudioEngine* audio, const AssetPack* pack, JobSystem* jobs, const std::string& path) {
+    int asset = pack ? pack->find(path) : -1;
+    if (asset >= 0 && pack->getAsset(asset).type == PACK_ASSET_SOUND && pack->isCurrent(asset, path)) {
+        std::vector<unsigned char> data(pack->getAsset(asset).size);
+        if (pack->decompress(asset, data.data(), jobs) && audio->loadSound(path, data.data(), data.size()) >= 0) return;
+    }
+    audio->loadSound(path);
+}
+
 // Callback function to adjust the viewport when the window size changes
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
     glViewport(0, 0, width, height);
@@ -18,9 +48,39 @@ void processInput(GLFWwindow* window) {
     // Close the window when ESC key is pressed
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
+
+    // F9 starts a CPU trace capture, pressing it again writes cpu_trace.json
+    static bool traceKeyWasDown = false;
+    bool traceKeyDown = glfwGetKey(window, GLFW_KEY_F9) == GLFW_PRESS;
+    if (traceKeyDown && !traceKeyWasDown) {
+        if (cpuProfilerIsCapturing()) cpuProfilerStopCapture();
+        else cpuProfilerStartCapture(0, "cpu_trace.json");
+    }
+    traceKeyWasDown = traceKeyDown;
 }
 
-int main() {
+int main(int argc, char** argv) {
+    // Read command line settings (frame pacing, ...)
+    AppOptions options;
+    if (!parseAppOptions(argc, argv, options)) {
+        return -1;
+    }
+
+    // Optionally trace startup (model imports) and the first frames
+    PROFILE_THREAD_NAME("Main");
+    if (options.traceFrames > 0) {
+        cpuProfilerStartCapture(options.traceFrames, "cpu_trace.json");
+    }
+
+    // Headless mode runs on GLFW's null platform (no display server needed)
+    if (options.headless) {
+#if GLFW_VERSION_MAJOR > 3 || (GLFW_VERSION_MAJOR == 3 && GLFW_VERSION_MINOR >= 4)
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#else
+        std::cerr << "Headless mode needs GLFW 3.4, falling back to a hidden window\n";
+#endif
+    }
+
     // Initialize GLFW
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW\n";
@@ -35,8 +95,15 @@ int main() {
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // Compatibility for macOS
 #endif
 
+    // Headless contexts come from EGL (surfaceless) or OSMesa (software, e.g. llvmpipe)
+    if (options.headless) {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API,
+            options.headlessApi == "osmesa" ? GLFW_OSMESA_CONTEXT_API : GLFW_EGL_CONTEXT_API);
+    }
+
     // Create a windowed mode window and its OpenGL context
-    GLFWwindow* window = glfwCreateWindow(800, 600, "Virtual Museum Assignment", nullptr, nullptr);
+    GLFWwindow* window = glfwCreateWindow(options.width, options.height, "Virtual Museum Assignment", nullptr, nullptr);
     if (window == nullptr) {
         std::cerr << "Failed to create GLFW window\n";
         glfwTerminate();
@@ -61,36 +128,171 @@ int main() {
         return -1;
     }
 
+    // Persistently mapped per-frame data where the driver supports it (GL 3.3 has no buffer storage)
+    loadBufferStorage((GLADloadproc)glfwGetProcAddress);
+
     // Set initial OpenGL viewport size
-    glViewport(0, 0, 800, 600);
+    glViewport(0, 0, options.width, options.height);
+
+    if (options.headless) {
+        std::cout << "Headless renderer: " << glGetString(GL_RENDERER) << " (" << glGetString(GL_VERSION) << ")\n";
+    }
 
     float lastFrame = 0.0f;
 
+    // Frame pacing (vsync, capped or idle) chosen on the command line
+    FrameScheduler scheduler(options.frameMode, options.targetFps);
+    scheduler.begin();
+
+    // Exhibit texts and placements, recompiled from catalog.txt when it changed and memory-mapped
+    ExhibitCatalog catalog;
+    loadExhibitCatalog("catalog.txt", "catalog.bin", catalog);
+
+    // Worker threads for the model parser, the frame jobs below and the crowd simulation,
+    // created before the simulation thread starts using them. This thread and the simulation
+    // thread wait with their own queues, so neither runs the other's jobs.
+    JobSystem* jobSystem = new JobSystem(options.jobThreads >= 0 ? options.jobThreads : JobSystem::defaultWorkerCount(), 2);
+
+    // Cooked models and sounds written by museum_cook, loose files without a pack
+    AssetPack assetPack;
+    std::error_code packError;
+    if (options.packPath != "off" && std::filesystem::exists(options.packPath, packError) && assetPack.open(options.packPath)) {
+        std::cout << "Asset pack: " << options.packPath << " (" << assetPack.getAssetCount() << " assets)" << std::endl;
+    }
+    const AssetPack* pack = assetPack.isOpen() ? &assetPack : nullptr;
+
     // Create a Room object which manages the scene
     Room* room;
-    room = new Room();
+    AssetReloader* reloader = nullptr;
+    {
+        SceneDescription scene = options.generateScene ? generateScene(options.sceneParams) :
+            catalog.isOpen() ? catalogMuseumScene(catalog) : defaultMuseumScene();
+        room = new Room(scene, jobSystem, pack, options.sharedMeshes);
+
+        // Edited model files are imported again while the museum runs
+        if (options.hotReload) reloader = new AssetReloader(room, scene.meshes);
+    }
+    room->setCatalog(&catalog);
+    std::cout << "Scene: " << room->getExhibitCount() << " exhibits, "
+        << room->getExhibitTriangleCount() << " exhibit triangles" << std::endl;
+
+    // The scene is rendered offscreen at a resolution that follows the GPU time budget
+    SceneTarget* sceneTarget = new SceneTarget();
+    DynamicResolution* dynamicResolution = new DynamicResolution(options.gpuBudgetMs);
+
+    // Edited shader files are compiled again while the museum runs
+    if (reloader) {
+        reloader->watchShader(room->getShader());
+        if (room->getCrowdShader()) reloader->watchShader(room->getCrowdShader());
+        reloader->watchShader(sceneTarget->getUpscaleShader());
+    }
+
+    // Per pass GPU timings shown in the "GPU Profiler" panel
+    GpuProfiler* gpuProfiler = new GpuProfiler();
+    room->setGpuProfiler(gpuProfiler);
+
+    // PNG dumps and golden image comparison of the rendered scene
+    FrameCapture frameCapture(options.dumpDir, options.goldenDir, options.goldenTolerance);
+
+    // Tour benchmark: per-frame CPU times here, GPU times arrive through the profiler
+    BenchmarkRecorder* benchmark = nullptr;
+    if (options.benchmark) {
+        benchmark = new BenchmarkRecorder(options.hitchThresholdMs);
+        gpuProfiler->setFrameSink(benchmark->getGpuFrameTimes());
+        benchmark->setSceneSize(room->getExhibitCount(), room->getExhibitTriangleCount());
+    }
+    float simulatedTime = 0.0f;
+
+    // Safety limit in case the tour never finishes (10 simulated minutes)
+    const int maxBenchmarkFrames = 60 * 60 * 10;
+
+    // Scan sounds decoded up front and mixed on their own thread (--audio=off runs silently)
+    AudioEngine* audio = nullptr;
+    if (options.audioOutput != "off") {
+        AudioBackend* backend = createAudioBackend(options.audioOutput);
+        if (backend) {
+            audio = new AudioEngine(backend);
+            loadSound(audio, pack, jobSystem, "scan_loop.wav");
+            loadSound(audio, pack, jobSystem, "scan_done.wav");
+            if (audio->start()) room->setAudio(audio);
+            else {
+                delete audio;
+                audio = nullptr;
+            }
+        }
+    }
+
+    // Robot simulation on its own thread at a fixed rate; fixed-step runs stay on this
+    // thread so every frame sees exactly one simulation step
+    SimulationThread* simulation = nullptr;
+    if (options.simulationHz > 0 && options.fixedTimestep <= 0.0f) {
+        simulation = new SimulationThread(room, options.simulationHz, jobSystem);
+        simulation->start();
+    }
+    RoomSnapshot renderState;
+
+    // Frame work before GL submission as a task graph: simulate -> cull -> build draw lists.
+    // Culling and draw list building are split into chunks across all cores; everything
+    // that touches the GL context stays on this thread after the graph has run.
+    struct FrameContext {
+        float deltaTime;
+        bool sceneChanged;
+        bool visible;              // False while the window is minimized
+        glm::mat4 viewProjection;
+    } frame;
+    TaskGraph frameGraph;
+    int simulateTask = frameGraph.addTask("Simulate", [&]() {
+        // Update the room (e.g., animations, robot movement, etc.) or pick up the simulation thread's state
+        if (simulation) {
+            frame.sceneChanged = simulation->getRenderState(renderState);
+        }
+        else {
+            frame.sceneChanged = room->update(frame.deltaTime);
+            room->writeSnapshot(renderState, frame.sceneChanged);
+        }
+    }, true);
+    int cullTask = frameGraph.addTask("Cull", [&]() {
+        if (frame.visible) room->cullExhibits(frame.viewProjection, jobSystem);
+    });
+    int drawListTask = frameGraph.addTask("Build draw lists", [&]() {
+        if (frame.visible) room->buildDrawList(renderState, jobSystem);
+    });
+    frameGraph.addDependency(simulateTask, cullTask);
+    frameGraph.addDependency(cullTask, drawListTask);
+
+    // CPU time of every frame, reported when a fixed number of frames was requested
+    std::vector<double> frameTimesMs;
+    std::chrono::steady_clock::time_point runStart = std::chrono::steady_clock::now();
+    int frameIndex = 0;
 
     // Main application loop
     while (!glfwWindowShouldClose(window)) {
+        if (options.frameCount > 0 && frameIndex >= options.frameCount) break;
+
         float currentFrame = glfwGetTime();
+        std::chrono::steady_clock::time_point frameStart = std::chrono::steady_clock::now();
+        PROFILE_SCOPE("Frame");
+        jobSystem->beginFrame();
 
         // Start a new ImGui frame
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
+        {
+            PROFILE_SCOPE("ImGui::NewFrame");
+            ImGui_ImplOpenGL3_NewFrame();
+            ImGui_ImplGlfw_NewFrame();
+            ImGui::NewFrame();
+        }
 
-        float deltaTime = currentFrame - lastFrame;
+        // Fixed steps make headless runs reproducible frame by frame
+        float deltaTime = options.fixedTimestep > 0.0f ? options.fixedTimestep : currentFrame - lastFrame;
         lastFrame = currentFrame;
+        simulatedTime += deltaTime;
 
         // Handle user input
         processInput(window);
 
-        // Update the room (e.g., animations, robot movement, etc.)
-        room->update(deltaTime);
-
-        // Clear the screen with a dark gray color
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        // Window size can change at any time, the projection follows it
+        int windowWidth, windowHeight;
+        glfwGetFramebufferSize(window, &windowWidth, &windowHeight);
 
         // Set up the camera view matrix
         glm::mat4 view = glm::lookAt(
@@ -98,22 +300,144 @@ int main() {
             glm::vec3(0.0f, 2.0f, 0.0f),     // Look at the center of the room
             glm::vec3(0.0f, 1.0f, 0.0f)      // Up vector
         );
+        if (benchmark) view = benchmarkCameraView(simulatedTime);
+
+        // The camera hears the robots: position and right vector of the view
+        if (audio) audio->setListener(glm::vec3(glm::inverse(view)[3]), glm::vec3(view[0][0], view[1][0], view[2][0]));
 
         // Set up the perspective projection matrix
-        glm::mat4 projection = glm::perspective(glm::radians(55.0f), 800.f / 600.f, 0.1f, 100.0f);
+        float aspect = windowHeight > 0 ? (float)windowWidth / (float)windowHeight : 1.0f;
+        glm::mat4 projection = glm::perspective(glm::radians(55.0f), aspect, 0.1f, 100.0f);
+
+        // Simulate, cull and build the draw lists
+        frame.deltaTime = deltaTime;
+        frame.visible = windowWidth > 0 && windowHeight > 0;
+        frame.viewProjection = projection * view;
+        room->setLodBias(dynamicResolution->getLodBias());
+        if (reloader) reloader->update();
+        frameGraph.run(*jobSystem);
+        bool sceneChanged = frame.sceneChanged;
 
-        // Render the room with current view and projection
-        room->drawMuseumRoom(view, projection);
+        if (!frame.visible) {
+            // Minimized: nothing to draw, but keep the UI frame balanced
+            ImGui::Render();
+            glfwSwapBuffers(window);
+            scheduler.endFrame(sceneChanged);
+            jobSystem->endFrame();
+            PROFILE_FRAME_END();
+            continue;
+        }
+        sceneTarget->resize(windowWidth, windowHeight);
 
-        // Render ImGui UI elements
-        ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        // Render the scene into the offscreen target at the current scale
+        gpuProfiler->beginFrame();
+        dynamicResolution->beginFrame();
+        float renderScale = dynamicResolution->getRenderScale();
+        sceneTarget->bind((int)(windowWidth * renderScale), (int)(windowHeight * renderScale));
+
+        // Clear the screen with a dark gray color
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // Swap buffers and poll window events
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        // Submit the room with current view and projection (GL calls, this thread only)
+        room->drawMuseumRoom(view, projection, renderState);
+        dynamicResolution->endFrame();
+
+        // Save or compare the scene image (UI excluded, it is not part of the golden images)
+        frameCapture.capture(*sceneTarget, frameIndex);
+
+        if (options.headless) {
+            // Nothing to present: finish the UI frame
+            ImGui::Render();
+        }
+        else {
+            // Upscale the scene to the window, the UI is drawn on top at native resolution
+            gpuProfiler->beginPass("Upscale");
+            sceneTarget->present(windowWidth, windowHeight, options.sharpness);
+            gpuProfiler->endPass();
+
+            // Render ImGui UI elements
+            {
+                PROFILE_SCOPE("ImGui::Render");
+                gpuProfiler->drawPanel();
+                jobSystem->drawPanel(&frameGraph);
+                ImGui::Render();
+                gpuProfiler->beginPass("ImGui");
+                ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+                gpuProfiler->endPass();
+            }
+        }
+        gpuProfiler->endFrame();
+        jobSystem->endFrame();
+
+        // CPU cost of the frame, without the time spent waiting for the display
+        if (benchmark) {
+            benchmark->recordCpuFrame(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frameStart).count());
+        }
+
+        if (options.headless) {
+            glfwPollEvents();
+        }
+        else {
+            // Swap buffers, then wait for the next frame and poll window events
+            PROFILE_SCOPE("SwapAndWait");
+            glfwSwapBuffers(window);
+            scheduler.endFrame(sceneChanged);
+        }
+        PROFILE_FRAME_END();
+
+        frameTimesMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count());
+        frameIndex++;
+
+        // The benchmark ends with the tour
+        if (benchmark && (renderState.tourComplete || frameIndex >= maxBenchmarkFrames)) break;
+    }
+
+    // Reports give the resolution actually rendered, which the window system may have changed
+    int framebufferWidth, framebufferHeight;
+    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+
+    // Benchmark report with the GPU times of the last frames in flight
+    if (benchmark) {
+        gpuProfiler->flush();
+        const char* renderer = (const char*)glGetString(GL_RENDERER);
+        benchmark->writeReport(options.benchmarkReport, simulatedTime, framebufferWidth, framebufferHeight,
+            renderer ? renderer : "unknown");
+        delete benchmark;
+    }
+
+    // Timing report for fixed length (e.g. headless) runs
+    bool goldenPassed = true;
+    if (options.frameCount > 0 && !frameTimesMs.empty()) {
+        glFinish();
+        double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - runStart).count();
+        double sum = 0.0;
+        for (size_t i = 0; i < frameTimesMs.size(); i++) sum += frameTimesMs[i];
+
+        std::cout << "Rendered " << frameTimesMs.size() << " frames at " << framebufferWidth << "x" << framebufferHeight
+            << " in " << totalMs / 1000.0 << " s\n"
+            << "  frame time avg " << sum / frameTimesMs.size() << " ms, min "
+            << *std::min_element(frameTimesMs.begin(), frameTimesMs.end()) << " ms, max "
+            << *std::max_element(frameTimesMs.begin(), frameTimesMs.end()) << " ms\n"
+            << "  " << frameTimesMs.size() * 1000.0 / totalMs << " frames per second\n";
+        goldenPassed = frameCapture.printSummary();
     }
 
+    // The simulation must stop before the room goes away
+    delete simulation;
+    delete jobSystem;
+    delete audio;
+
+    // Flush a capture that is still running
+    cpuProfilerStopCapture();
+
+    // Release GPU resources while the context is still alive
+    delete reloader;
+    delete gpuProfiler;
+    delete dynamicResolution;
+    delete sceneTarget;
+    delete room;
+
     // Cleanup ImGui resources
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
@@ -121,5 +445,5 @@ int main() {
 
     // Terminate GLFW and clean up
     glfwTerminate();
-    return 0;
+    return goldenPassed ? 0 : 1;
 }
@@ -0,0 +1,123 @@
+// Checks of the asset pack (AssetPack): LZ4 blocks compressed and decoded back, corrupt
+// blocks rejected, and packs written, mapped and decompressed on one or more threads
+#include "TestMain.h"
+#include "AssetPack.h"
+#include "JobSystem.h"
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Same sequence on every platform
+static unsigned char nextByte(unsigned int& state) {
+    state = state * 1664525u + 1013904223u;
+    return (unsigned char)(state >> 24);
+}
+
+// Repeating records with a counter, like vertex data: compresses well
+static std::vector<unsigned char> recordData(size_t size) {
+    std::vector<unsigned char> data(size);
+    for (size_t i = 0; i < size; i++) data[i] = (unsigned char)(i % 16 < 12 ? i % 7 : (i / 16) & 0xFF);
+    return data;
+}
+
+static std::vector<unsigned char> randomData(size_t size, unsigned int seed) {
+    std::vector<unsigned char> data(size);
+    for (size_t i = 0; i < size; i++) data[i] = nextByte(seed);
+    return data;
+}
+
+static void testBlocks() {
+    std::vector<unsigned char> data = recordData(100000);
+    std::vector<unsigned char> compressed(data.size());
+    size_t compressedSize = packCompress(data.data(), data.size(), compressed.data(), compressed.size());
+    check(compressedSize > 0 && compressedSize < data.size() / 2, "pack: repeating data compresses");
+
+    std::vector<unsigned char> decoded(data.size());
+    check(packDecompress(compressed.data(), compressedSize, decoded.data(), decoded.size()) && decoded == data, "pack: block decodes to the input");
+
+    // Every byte value and a run that overlaps its own match
+    std::vector<unsigned char> run(5000, 'a');
+    for (int i = 0; i < 256; i++) run[i] = (unsigned char)i;
+    std::vector<unsigned char> runCompressed(run.size());
+    size_t runSize = packCompress(run.data(), run.size(), runCompressed.data(), runCompressed.size());
+    std::vector<unsigned char> runDecoded(run.size());
+    check(runSize > 0 && packDecompress(runCompressed.data(), runSize, runDecoded.data(), runDecoded.size()) && runDecoded == run,
+          "pack: overlapping match decodes");
+
+    std::vector<unsigned char> noise = randomData(4096, 3u);
+    std::vector<unsigned char> noiseCompressed(noise.size());
+    check(packCompress(noise.data(), noise.size(), noiseCompressed.data(), noiseCompressed.size()) == 0, "pack: random data is not compressed");
+
+    // Cut short, or decoded into a smaller size than it holds
+    check(!packDecompress(compressed.data(), compressedSize / 2, decoded.data(), decoded.size()), "pack: truncated block rejected");
+    check(!packDecompress(compressed.data(), compressedSize, decoded.data(), decoded.size() - 1), "pack: block longer than its size rejected");
+    std::vector<unsigned char> corrupt(compressed.begin(), compressed.begin() + compressedSize);
+    for (size_t i = 0; i < corrupt.size(); i += 7) corrupt[i] ^= 0x5A;
+    std::vector<unsigned char> corruptDecoded(data.size());
+    bool decodedCorrupt = packDecompress(corrupt.data(), corrupt.size(), corruptDecoded.data(), corruptDecoded.size());
+    check(!decodedCorrupt || corruptDecoded != data, "pack: corrupt block never decodes to the input");
+}
+
+static void testPack(const std::string& path, const std::string& copyPath) {
+    // Several chunks of compressible data with an info block, and one chunk stored as it is
+    std::vector<unsigned char> mesh = recordData(3 * PACK_CHUNK_SIZE + 1000);
+    std::vector<unsigned char> sound = randomData(5000, 9u);
+    unsigned int info[4] = { 1, 2, 3, 4 };
+    JobSystem jobs(3);
+
+    AssetPackWriter writer;
+    check(writer.begin(path), "pack: writer starts");
+    check(writer.addAsset("models/vase.obj", PACK_ASSET_MESH, 7, info, sizeof(info), mesh.data(), mesh.size(), 100, 200, &jobs),
+          "pack: mesh asset added");
+    check(writer.addAsset("chime.wav", PACK_ASSET_SOUND, 1, nullptr, 0, sound.data(), sound.size(), 0, 0, nullptr), "pack: sound asset added");
+    check(writer.finish(), "pack: writer finishes");
+    check(writer.getCompressedBytes() < writer.getRawBytes(), "pack: written smaller than the payloads");
+
+    AssetPack pack;
+    check(pack.open(path), "pack: written pack opens");
+    check(pack.getAssetCount() == 2, "pack: both assets listed");
+    int meshAsset = pack.find("models/vase.obj");
+    int soundAsset = pack.find("chime.wav");
+    check(meshAsset >= 0 && soundAsset >= 0 && pack.find("missing.obj") == -1, "pack: assets found by name");
+    if (meshAsset < 0 || soundAsset < 0) return;
+
+    const PackAsset& meshEntry = pack.getAsset(meshAsset);
+    check(meshEntry.type == PACK_ASSET_MESH && meshEntry.cookVersion == 7 && meshEntry.size == mesh.size(), "pack: mesh entry read back");
+    check(meshEntry.chunkCount == 4, "pack: mesh split into chunks");
+    const unsigned int* readInfo = (const unsigned int*)pack.getInfo(meshAsset);
+    check(readInfo && readInfo[0] == 1 && readInfo[3] == 4, "pack: info block read back");
+    check(pack.getInfo(soundAsset) == nullptr, "pack: asset without info has none");
+    const PackChunk& soundChunk = pack.getChunk(pack.getAsset(soundAsset).firstChunk);
+    check(soundChunk.compressedSize == soundChunk.size, "pack: incompressible chunk stored as it is");
+
+    std::vector<unsigned char> decoded(mesh.size());
+    check(pack.decompress(meshAsset, decoded.data(), nullptr) && decoded == mesh, "pack: mesh decompressed on one thread");
+    std::vector<unsigned char> parallel(mesh.size());
+    check(pack.decompress(meshAsset, parallel.data(), &jobs) && parallel == mesh, "pack: mesh decompressed on worker threads");
+    std::vector<unsigned char> soundDecoded(sound.size());
+    check(pack.decompress(soundAsset, soundDecoded.data(), &jobs) && soundDecoded == sound, "pack: stored sound read back");
+
+    // A missing source file counts as current, a different one does not
+    check(pack.isCurrent(meshAsset, path + ".missing"), "pack: asset without source file is current");
+    check(!pack.isCurrent(meshAsset, path), "pack: asset with a different source file is stale");
+
+    // Copied into a new pack without decoding
+    AssetPackWriter copier;
+    check(copier.begin(copyPath) && copier.copyAsset(pack, meshAsset) && copier.finish(), "pack: asset copied into a new pack");
+    AssetPack copy;
+    std::vector<unsigned char> copied(mesh.size());
+    check(copy.open(copyPath) && copy.getAssetCount() == 1 && copy.decompress(0, copied.data(), &jobs) && copied == mesh,
+          "pack: copied asset decompresses to the payload");
+    copy.close();
+    pack.close();
+}
+
+void testAssetPack() {
+    std::string path = (std::filesystem::temp_directory_path() / "museum_tests.pack").string();
+    std::string copyPath = (std::filesystem::temp_directory_path() / "museum_tests_copy.pack").string();
+    testBlocks();
+    testPack(path, copyPath);
+    std::remove(path.c_str());
+    std::remove(copyPath.c_str());
+}
@@ -0,0 +1,126 @@
+// Checks of the mixer (AudioEngine) through the WAV file backend: sounds decoded from memory,
+// voices summed, panned and attenuated, and voices ending or stopped
+#include "TestMain.h"
+#include "AudioEngine.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static void appendUint32(std::vector<unsigned char>& data, unsigned int value) {
+    for (int i = 0; i < 4; i++) data.push_back((unsigned char)(value >> (i * 8)));
+}
+
+static void appendUint16(std::vector<unsigned char>& data, unsigned int value) {
+    data.push_back((unsigned char)value);
+    data.push_back((unsigned char)(value >> 8));
+}
+
+// 16-bit PCM WAV at the mixer rate holding the same frame `frames` times
+static std::vector<unsigned char> constantWav(int frames, float left, float right, int channels) {
+    std::vector<unsigned char> data;
+    unsigned int bytes = frames * channels * 2;
+    data.insert(data.end(), { 'R', 'I', 'F', 'F' });
+    appendUint32(data, 36 + bytes);
+    data.insert(data.end(), { 'W', 'A', 'V', 'E', 'f', 'm', 't', ' ' });
+    appendUint32(data, 16);
+    appendUint16(data, 1);
+    appendUint16(data, channels);
+    appendUint32(data, AUDIO_SAMPLE_RATE);
+    appendUint32(data, AUDIO_SAMPLE_RATE * channels * 2);
+    appendUint16(data, channels * 2);
+    appendUint16(data, 16);
+    data.insert(data.end(), { 'd', 'a', 't', 'a' });
+    appendUint32(data, bytes);
+    for (int f = 0; f < frames; f++) {
+        appendUint16(data, (unsigned short)(short)std::lround(left * 32768.0f));
+        if (channels == 2) appendUint16(data, (unsigned short)(short)std::lround(right * 32768.0f));
+    }
+    return data;
+}
+
+// Waits (up to two seconds of mixing) until the mixer reports the number of voices
+static bool waitForVoices(const AudioEngine& engine, int voices) {
+    for (int i = 0; i < 200 && engine.getActiveVoices() != voices; i++) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    return engine.getActiveVoices() == voices;
+}
+
+// Stereo samples of a recorded mix, as floats
+static std::vector<float> readMix(const std::string& path) {
+    std::ifstream file(path.c_str(), std::ios::binary);
+    std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::vector<float> samples;
+    if (data.size() < 44 || std::string((const char*)&data[36], 4) != "data") return samples;
+    for (size_t i = 44; i + 1 < data.size(); i += 2) samples.push_back((short)(data[i] | (data[i + 1] << 8)) / 32767.0f);
+    return samples;
+}
+
+// Every frame of [begin, end) holds the expected left and right sample
+static bool framesEqual(const std::vector<float>& mix, int begin, int end, float left, float right) {
+    if ((int)mix.size() < end * 2) return false;
+    for (int f = begin; f < end; f++) {
+        if (std::fabs(mix[f * 2] - left) > 0.001f || std::fabs(mix[f * 2 + 1] - right) > 0.001f) return false;
+    }
+    return true;
+}
+
+static void testMix(const std::string& path) {
+    AudioEngine engine(createAudioBackend("wav:" + path));
+    std::vector<unsigned char> shortWav = constantWav(1000, 0.25f, 0.25f, 1);
+    std::vector<unsigned char> stereoWav = constantWav(3000, 0.1f, -0.1f, 2);
+    std::vector<unsigned char> loopWav = constantWav(100, 0.05f, 0.05f, 1);
+    int shortSound = engine.loadSound("short.wav", shortWav.data(), shortWav.size());
+    int stereoSound = engine.loadSound("stereo.wav", stereoWav.data(), stereoWav.size());
+    int loopSound = engine.loadSound("loop.wav", loopWav.data(), loopWav.size());
+    check(shortSound == 0 && stereoSound == 1 && loopSound == 2, "audio: sounds decoded from memory");
+    check(engine.findSound("stereo.wav") == stereoSound, "audio: sound found by name");
+    check(engine.play(7, 1.0f, false) == 0, "audio: unknown sound does not play");
+
+    // Queued before the mixer starts, so all three begin on the first frame
+    engine.play(shortSound, 1.0f, false);
+    engine.play(stereoSound, 1.0f, false);
+    AudioVoice loop = engine.play(loopSound, 1.0f, true);
+    check(engine.start(), "audio: WAV backend starts");
+
+    // The two sounds end by themselves, the loop plays until it is stopped
+    check(waitForVoices(engine, 1), "audio: voices end with their sound, the loop keeps playing");
+    engine.stopVoice(loop);
+    check(waitForVoices(engine, 0), "audio: stopped loop ends");
+    engine.stop();
+
+    std::vector<float> mix = readMix(path);
+    check(framesEqual(mix, 0, 1000, 0.4f, 0.2f), "audio: three voices summed");
+    check(framesEqual(mix, 1000, 3000, 0.15f, -0.05f), "audio: short voice ended, stereo channels kept apart");
+    // (the stop arrives after the block in which the stereo voice ended, frames 2560 to 3071)
+    check(framesEqual(mix, 3000, 6 * AUDIO_BLOCK_FRAMES, 0.05f, 0.05f), "audio: loop repeats its sound");
+    check(framesEqual(mix, (int)mix.size() / 2 - AUDIO_BLOCK_FRAMES, (int)mix.size() / 2, 0.0f, 0.0f), "audio: silence after the loop stopped");
+}
+
+static void testPositional(const std::string& path) {
+    AudioEngine engine(createAudioBackend("wav:" + path));
+    // Ten blocks long, so the voice is seen playing before it ends
+    std::vector<unsigned char> wav = constantWav(10 * AUDIO_BLOCK_FRAMES, 0.25f, 0.25f, 1);
+    int sound = engine.loadSound("tone.wav", wav.data(), wav.size());
+
+    // Five meters to the right of the listener at the origin
+    engine.playAt(sound, glm::vec3(5.0f, 0.0f, 0.0f), 1.0f, false);
+    engine.start();
+    check(waitForVoices(engine, 1) && waitForVoices(engine, 0), "audio: positional voice plays and ends");
+    engine.stop();
+
+    // 1 / (1 + 0.3 * (5 - 1)) of the volume, all of it on the right
+    std::vector<float> mix = readMix(path);
+    float right = 0.25f / (1.0f + 0.3f * 4.0f) * 1.414214f;
+    check(framesEqual(mix, 0, 10 * AUDIO_BLOCK_FRAMES, 0.0f, right), "audio: positional voice panned and attenuated");
+}
+
+void testAudioEngine() {
+    std::string path = (std::filesystem::temp_directory_path() / "museum_tests_mix.wav").string();
+    testMix(path);
+    testPositional(path);
+    std::remove(path.c_str());
+}
@@ -0,0 +1,112 @@
+// Checks of the exhibit catalog (ExhibitCatalog): the text catalog compiled to the binary
+// layout and mapped back, lookups by id, and catalogs with errors rejected
+#include "TestMain.h"
+#include "ExhibitCatalog.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+static void writeText(const std::string& path, const std::string& text) {
+    std::ofstream file(path.c_str(), std::ios::binary);
+    file << text;
+}
+
+static bool sameText(const char* text, const char* expected) {
+    return std::strcmp(text, expected) == 0;
+}
+
+static void testRoundTrip(const std::string& sourcePath, const std::string& binaryPath) {
+    // Windows line endings, a comment, and ids out of order with a gap
+    writeText(sourcePath,
+        "# Test catalog\r\n"
+        "id: 12\r\n"
+        "title: Bronze Mirror\r\n"
+        "period: Roman\r\n"
+        "description: Polished on one side\r\n"
+        "model: models/mirror.obj\r\n"
+        "importer: obj\r\n"
+        "position: 1.5 0 -2\r\n"
+        "yaw: 90\r\n"
+        "scale: 0.5\r\n"
+        "\r\n"
+        "id: 3\r\n"
+        "title: Oil Lamp\r\n"
+        "period: Roman\r\n");
+    check(compileExhibitCatalog(sourcePath, binaryPath), "catalog: text catalog compiles");
+
+    ExhibitCatalog catalog;
+    check(catalog.open(binaryPath), "catalog: compiled catalog opens");
+    check(catalog.getEntryCount() == 2, "catalog: one entry per block");
+
+    const CatalogEntry* mirror = catalog.find(12);
+    check(mirror != nullptr && mirror->id == 12, "catalog: entry found by id");
+    if (mirror) {
+        check(sameText(catalog.text(mirror->title), "Bronze Mirror"), "catalog: title read back");
+        check(sameText(catalog.text(mirror->description), "Polished on one side"), "catalog: description read back");
+        check(sameText(catalog.text(mirror->model), "models/mirror.obj"), "catalog: model read back");
+        check(sameText(catalog.text(mirror->importer), "obj"), "catalog: importer read back");
+        check(mirror->position[0] == 1.5f && mirror->position[1] == 0.0f && mirror->position[2] == -2.0f, "catalog: position read back");
+        check(mirror->yaw == 90.0f && mirror->scale == 0.5f, "catalog: yaw and scale read back");
+    }
+
+    const CatalogEntry* lamp = catalog.find(3);
+    check(lamp != nullptr && sameText(catalog.text(lamp->title), "Oil Lamp"), "catalog: second entry found by id");
+    if (lamp && mirror) {
+        check(lamp->period == mirror->period, "catalog: repeated string stored once");
+        check(sameText(catalog.text(lamp->model), "") && lamp->scale == 1.0f, "catalog: missing keys are empty, scale defaults to 1");
+    }
+    check(catalog.find(4) == nullptr && catalog.find(13) == nullptr && catalog.find(1000000) == nullptr, "catalog: unused ids have no entry");
+    check(sameText(catalog.text(0xFFFFFFFFu), ""), "catalog: string outside the pool is empty");
+    catalog.close();
+}
+
+static void testErrors(const std::string& sourcePath, const std::string& binaryPath) {
+    writeText(sourcePath, "id: 1\ntitle: Vase\n\nid: 1\ntitle: Bowl\n");
+    check(!compileExhibitCatalog(sourcePath, binaryPath), "catalog: duplicate id rejected");
+    writeText(sourcePath, "id: 1\ntitle: Vase\ncolour: red\n");
+    check(!compileExhibitCatalog(sourcePath, binaryPath), "catalog: unknown key rejected");
+    writeText(sourcePath, "id: 1\nperiod: Roman\n");
+    check(!compileExhibitCatalog(sourcePath, binaryPath), "catalog: entry without a title rejected");
+    writeText(sourcePath, "id: 1\ntitle Vase\n");
+    check(!compileExhibitCatalog(sourcePath, binaryPath), "catalog: line without a colon rejected");
+    writeText(sourcePath, "id: 1x\ntitle: Vase\n");
+    check(!compileExhibitCatalog(sourcePath, binaryPath), "catalog: invalid id rejected");
+    writeText(sourcePath, "id: 1\ntitle: Vase\nimporter: fbx\n");
+    check(!compileExhibitCatalog(sourcePath, binaryPath), "catalog: unknown importer rejected");
+
+    writeText(binaryPath, "MCAT but far too short");
+    ExhibitCatalog catalog;
+    check(!catalog.open(binaryPath) && !catalog.isOpen(), "catalog: truncated binary rejected");
+}
+
+static void testLoad(const std::string& sourcePath, const std::string& binaryPath) {
+    std::remove(binaryPath.c_str());
+    writeText(sourcePath, "id: 5\ntitle: Amphora\n");
+    ExhibitCatalog catalog;
+    check(loadExhibitCatalog(sourcePath, binaryPath, catalog) && catalog.find(5) != nullptr, "catalog: missing binary compiled on load");
+    catalog.close();
+
+    // A newer source with an error keeps the last good binary
+    writeText(sourcePath, "id: 5\ntitle: Amphora\nweight: 4\n");
+    std::error_code error;
+    std::filesystem::last_write_time(sourcePath, std::filesystem::last_write_time(binaryPath, error) + std::chrono::seconds(10), error);
+    check(loadExhibitCatalog(sourcePath, binaryPath, catalog) && catalog.find(5) != nullptr, "catalog: broken source keeps the last good binary");
+    catalog.close();
+
+    // Without a binary to fall back on, loading fails
+    std::remove(binaryPath.c_str());
+    check(!loadExhibitCatalog(sourcePath, binaryPath, catalog), "catalog: broken source without a binary fails");
+}
+
+void testExhibitCatalog() {
+    std::string sourcePath = (std::filesystem::temp_directory_path() / "museum_tests_catalog.txt").string();
+    std::string binaryPath = (std::filesystem::temp_directory_path() / "museum_tests_catalog.bin").string();
+    testRoundTrip(sourcePath, binaryPath);
+    testErrors(sourcePath, binaryPath);
+    testLoad(sourcePath, binaryPath);
+    std::remove(sourcePath.c_str());
+    std::remove(binaryPath.c_str());
+}
@@ -0,0 +1,119 @@
+// Checks of the navigation grid (NavGrid): routes inside a room and through doorways, the
+// path cache, walking distances and the crowd flow fields
+#include "TestMain.h"
+#include "NavGrid.h"
+#include <cmath>
+#include <vector>
+
+// Room spacing of the scene generator
+static const float ROOM_SPACING = 11.0f;
+
+// Length of the route from start through every waypoint
+static float pathLength(const glm::vec3& start, const std::vector<glm::vec3>& path) {
+    float length = 0.0f;
+    glm::vec3 from = start;
+    for (size_t i = 0; i < path.size(); i++) {
+        length += glm::length(path[i] - from);
+        from = path[i];
+    }
+    return length;
+}
+
+// Every point of the route, sampled each 5 cm, is on walkable floor
+static bool pathWalkable(const NavGrid& grid, const glm::vec3& start, const std::vector<glm::vec3>& path) {
+    glm::vec3 from = start;
+    for (size_t i = 0; i < path.size(); i++) {
+        int steps = (int)(glm::length(path[i] - from) / 0.05f) + 1;
+        for (int s = 1; s <= steps; s++) {
+            if (!grid.isWalkable(from + (path[i] - from) * ((float)s / steps))) return false;
+        }
+        from = path[i];
+    }
+    return true;
+}
+
+static void testRoomRoutes() {
+    std::vector<glm::vec3> rooms(1, glm::vec3(0.0f));
+    std::vector<NavObstacle> obstacles(1, NavObstacle{ glm::vec3(0.0f), 1.0f });
+    NavGrid grid(rooms, obstacles);
+    check(!grid.isWalkable(glm::vec3(0.0f)), "nav: exhibit footprint is blocked");
+    check(!grid.isWalkable(glm::vec3(4.9f, 0.0f, 0.0f)), "nav: floor next to the wall is blocked");
+    check(grid.isWalkable(glm::vec3(3.0f, 0.0f, 3.0f)), "nav: open floor is walkable");
+
+    // A free line is walked straight
+    glm::vec3 start(-3.0f, 0.0f, -3.0f);
+    glm::vec3 goal(-3.0f, 0.0f, 3.0f);
+    std::vector<glm::vec3> path;
+    check(grid.findPath(start, goal, path), "nav: route along a free line");
+    check(path.size() == 1 && path.back() == goal, "nav: free line is a single segment ending at the goal");
+
+    // Around the exhibit: longer than the straight line, never through the footprint
+    start = glm::vec3(-3.0f, 0.0f, 0.0f);
+    goal = glm::vec3(3.0f, 0.0f, 0.0f);
+    check(grid.findPath(start, goal, path), "nav: route around an exhibit");
+    check(!path.empty() && path.back() == goal, "nav: route around an exhibit ends at the goal");
+    check(pathLength(start, path) > 6.0f && pathLength(start, path) < 8.0f, "nav: route around an exhibit is a short detour");
+    check(pathWalkable(grid, start, path), "nav: route around an exhibit stays on walkable floor");
+
+    // The same trip again comes from the cache
+    long long hits = grid.getCacheHits();
+    std::vector<glm::vec3> cached;
+    check(grid.findPath(start, goal, cached) && cached == path, "nav: cached route is the same route");
+    check(grid.getCacheHits() == hits + 1, "nav: repeated trip is a cache hit");
+
+    // A goal inside the footprint ends next to it
+    check(grid.findPath(start, glm::vec3(0.0f), path) && grid.isWalkable(path.back()), "nav: blocked goal ends on walkable floor");
+}
+
+static void testDoorways() {
+    // Two neighbouring rooms joined by a doorway, and a third one too far away to be joined
+    std::vector<glm::vec3> rooms;
+    rooms.push_back(glm::vec3(0.0f));
+    rooms.push_back(glm::vec3(ROOM_SPACING, 0.0f, 0.0f));
+    rooms.push_back(glm::vec3(0.0f, 0.0f, 3.0f * ROOM_SPACING));
+    NavGrid grid(rooms, std::vector<NavObstacle>());
+    check(grid.getPortalCount() == 1, "nav: one doorway between the neighbouring rooms");
+
+    glm::vec3 start(0.0f, 0.0f, 3.0f);
+    glm::vec3 goal(ROOM_SPACING, 0.0f, 3.0f);
+    std::vector<glm::vec3> path;
+    check(grid.findPath(start, goal, path), "nav: route into the next room");
+    check(!path.empty() && path.back() == goal, "nav: route into the next room ends at the goal");
+    check(pathWalkable(grid, start, path), "nav: route into the next room goes through the doorway");
+
+    // Walking distances: straight inside the room, through the doorway into the next one,
+    // the straight line where there is no route
+    std::vector<glm::vec3> targets;
+    targets.push_back(glm::vec3(0.0f, 0.0f, -3.0f));
+    targets.push_back(goal);
+    targets.push_back(rooms[2]);
+    std::vector<float> distances;
+    grid.measureDistances(start, targets, distances);
+    check(distances.size() == 3, "nav: one distance per target");
+    check(std::fabs(distances[0] - 6.0f) < 0.5f, "nav: distance inside a room is the straight line");
+    // (measured over grid cells, so a little longer than the smoothed route)
+    float routeLength = pathLength(start, path);
+    check(distances[1] >= routeLength - 0.1f && distances[1] < routeLength * 1.15f, "nav: distance to the next room is the route length");
+    check(std::fabs(distances[2] - glm::length(rooms[2] - start)) < 0.01f, "nav: distance without a route is the straight line");
+    check(!grid.findPath(start, rooms[2], path) && path.empty(), "nav: no route into a room without a doorway");
+
+    // Following the flow field from the first room reaches the goal in the next one
+    std::vector<unsigned char> field;
+    grid.buildFlowField(goal, field);
+    check(field.size() == (size_t)grid.getCellCount(), "nav: flow field has one entry per cell");
+    glm::vec3 position = start;
+    bool walkable = true;
+    for (int step = 0; step < 1000 && glm::length(grid.flowDirection(field, position)) > 0.0f; step++) {
+        position += grid.flowDirection(field, position) * 0.05f;
+        walkable = walkable && grid.isWalkable(position);
+    }
+    glm::vec3 offset = position - goal;
+    check(std::sqrt(offset.x * offset.x + offset.z * offset.z) < 0.5f, "nav: flow field leads to the goal");
+    check(walkable, "nav: flow field stays on walkable floor");
+    check(glm::length(grid.flowDirection(field, rooms[2])) == 0.0f, "nav: flow field has no direction without a route");
+}
+
+void testNavGrid() {
+    testRoomRoutes();
+    testDoorways();
+}
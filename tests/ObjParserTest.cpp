@@ -0,0 +1,120 @@
+// Checks of the parallel OBJ reader (ObjParser): face corner forms, fanned polygons, flat
+// normals where the file has none, out of range indices, and the same triangles when a
+// large file is split into chunks on worker threads
+#include "TestMain.h"
+#include "ObjParser.h"
+#include "JobSystem.h"
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+static void writeText(const std::string& path, const std::string& text) {
+    std::ofstream file(path.c_str(), std::ios::binary);
+    file << text;
+}
+
+static bool sameVector(const glm::vec3& a, const glm::vec3& b) {
+    return std::fabs(a.x - b.x) < 1e-5f && std::fabs(a.y - b.y) < 1e-5f && std::fabs(a.z - b.z) < 1e-5f;
+}
+
+static void testFaces(const std::string& path) {
+    // A quad with normals (v//vn), a triangle without (v and v/vt) and one with
+    // negative indices and texture coordinates (v/vt/vn); comments and unknown lines skipped
+    writeText(path,
+        "# quad and triangles\r\n"
+        "o test\r\n"
+        "v 0 0 0\r\n"
+        "v 1 0 0\r\n"
+        "v 1 1 0\r\n"
+        "v 0 1 0\r\n"
+        "vn 0 0 1\r\n"
+        "vt 0.5 0.5\r\n"
+        "f 1//1 2//1 3//1 4//1\r\n"
+        "usemtl stone\r\n"
+        "f 1 2/1 4\n"
+        "v 2.5 -1e1 .5\n"
+        "vn 0 -1 0\n"
+        "f -1/1/-1 -4/1/-1 -3/1/-1\n");
+    std::vector<Vertex> vertices;
+    check(parseObjFile(path, vertices, nullptr), "obj: file parses");
+    check(vertices.size() == 12, "obj: quad fanned into two triangles, three vertices per triangle");
+    if (vertices.size() != 12) return;
+
+    check(sameVector(vertices[0].Position, glm::vec3(0.0f)) && sameVector(vertices[1].Position, glm::vec3(1.0f, 0.0f, 0.0f)) &&
+          sameVector(vertices[2].Position, glm::vec3(1.0f, 1.0f, 0.0f)), "obj: first fan triangle");
+    check(sameVector(vertices[3].Position, glm::vec3(0.0f)) && sameVector(vertices[4].Position, glm::vec3(1.0f, 1.0f, 0.0f)) &&
+          sameVector(vertices[5].Position, glm::vec3(0.0f, 1.0f, 0.0f)), "obj: second fan triangle");
+    bool fileNormals = true;
+    for (int i = 0; i < 6; i++) fileNormals = fileNormals && sameVector(vertices[i].Normal, glm::vec3(0.0f, 0.0f, 1.0f));
+    check(fileNormals, "obj: normals of the file kept");
+
+    // Counter-clockwise seen from +z, so the flat normal points at +z
+    bool flatNormals = true;
+    for (int i = 6; i < 9; i++) flatNormals = flatNormals && sameVector(vertices[i].Normal, glm::vec3(0.0f, 0.0f, 1.0f));
+    check(flatNormals, "obj: flat normal where the file has none");
+
+    check(sameVector(vertices[9].Position, glm::vec3(2.5f, -10.0f, 0.5f)), "obj: negative index and exponent parsed");
+    check(sameVector(vertices[10].Position, glm::vec3(1.0f, 0.0f, 0.0f)) && sameVector(vertices[11].Position, glm::vec3(1.0f, 1.0f, 0.0f)),
+          "obj: negative indices count back from the last position");
+    check(sameVector(vertices[10].Normal, glm::vec3(0.0f, -1.0f, 0.0f)), "obj: negative normal index");
+}
+
+static void testInvalid(const std::string& path) {
+    std::vector<Vertex> vertices(1);
+    writeText(path, "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 4\n");
+    check(!parseObjFile(path, vertices, nullptr) && vertices.size() == 1, "obj: position index out of range rejected, vertices unchanged");
+    writeText(path, "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1//1 2//1 3//1\n");
+    check(!parseObjFile(path, vertices, nullptr), "obj: normal index out of range rejected");
+    check(!parseObjFile(path + ".missing", vertices, nullptr), "obj: missing file rejected");
+}
+
+static void testChunks(const std::string& path) {
+    // A grid of quads large enough for several chunks, half of them with relative indices
+    // that point back across the chunk borders
+    std::string text;
+    const int size = 200;
+    for (int z = 0; z <= size; z++) {
+        for (int x = 0; x <= size; x++) text += "v " + std::to_string(x * 0.1f) + " 0 " + std::to_string(z * -0.1f) + "\n";
+    }
+    text += "vn 0 1 0\n";
+    int positions = (size + 1) * (size + 1);
+    for (int z = 0; z < size; z++) {
+        for (int x = 0; x < size; x++) {
+            int corner = z * (size + 1) + x + 1;
+            int corners[4] = { corner, corner + 1, corner + size + 2, corner + size + 1 };
+            text += "f";
+            for (int k = 0; k < 4; k++) {
+                if (x % 2 == 0) text += " " + std::to_string(corners[k]);
+                else text += " " + std::to_string(corners[k] - positions - 1) + "//-1";
+            }
+            text += "\n";
+        }
+    }
+    writeText(path, text);
+
+    std::vector<Vertex> serial, parallel;
+    check(parseObjFile(path, serial, nullptr), "obj: large file parses on one thread");
+    JobSystem jobs(3);
+    check(parseObjFile(path, parallel, &jobs), "obj: large file parses in chunks");
+    check(serial.size() == (size_t)size * size * 6, "obj: every quad of the large file read");
+
+    bool same = serial.size() == parallel.size();
+    bool up = true;
+    for (size_t i = 0; same && i < serial.size(); i++) {
+        same = sameVector(serial[i].Position, parallel[i].Position) && sameVector(serial[i].Normal, parallel[i].Normal);
+        up = up && sameVector(serial[i].Normal, glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+    check(same, "obj: chunks on worker threads give the same triangles");
+    check(up, "obj: flat and file normals of the large file point up");
+}
+
+void testObjParser() {
+    std::string path = (std::filesystem::temp_directory_path() / "museum_tests_model.obj").string();
+    testFaces(path);
+    testInvalid(path);
+    testChunks(path);
+    std::remove(path.c_str());
+}
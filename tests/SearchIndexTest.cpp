@@ -0,0 +1,49 @@
+// Checks of the catalog search (SearchIndex): queries typed into the control panel's search box
+// against exhibits of catalog.txt
+#include "TestMain.h"
+#include "SearchIndex.h"
+#include <string>
+#include <vector>
+
+// Exhibits as listed in catalog.txt (title, period, description)
+static const char* EXHIBITS[][3] = {
+    { "Sarcophagus of Achilles", "Roman Period (2nd Century AD)", "A marble tomb depicting the life of Achilles. Dated to the Late Antonine Period." },
+    { "Man Statue", "Roman Period (1st Century AD)", "A bronze male figure discovered in Karatas, Adana." },
+    { "Statue of Tarhunda with Chariot", "Late Hittite Period (8th Century BC)", "A monumental sculpture made of basalt and limestone, depicting the Storm God Tarhunda on his chariot." },
+    { "Tombstone with Figures", "Roman Period (2nd and 3rd Century AD)", "A stone tombstone decorated with human or symbolic figures." },
+    { "Sarcophagus", "Roman Period (3rd Century AD)", "An ancient marble sarcophagus from the Roman era." }
+};
+
+// The query must match exactly `matches` documents, the best one being `best` (-1 = any)
+static void expectSearch(SearchIndex& index, const std::string& query, int matches, int best) {
+    std::vector<SearchResult> results;
+    int found = index.search(query, results, 10);
+    bool ok = found == matches && (best < 0 || (!results.empty() && results[0].document == best));
+    std::string what = "search \"" + query + "\" matched " + std::to_string(found) + " (expected " + std::to_string(matches) + ")";
+    if (!results.empty()) what += ", best " + std::to_string(results[0].document) + " (expected " + std::to_string(best) + ")";
+    check(ok, what);
+}
+
+void testSearchIndex() {
+    SearchIndex index;
+    for (size_t i = 0; i < sizeof(EXHIBITS) / sizeof(EXHIBITS[0]); i++) {
+        index.addDocument(EXHIBITS[i][0], EXHIBITS[i][1], EXHIBITS[i][2]);
+    }
+
+    // Whole titles, stop words included
+    expectSearch(index, "Sarcophagus of Achilles", 1, 0);
+    expectSearch(index, "Statue of Tarhunda with Chariot", 1, 2);
+    expectSearch(index, "Tombstone with Figures", 1, 3);
+
+    // Stop words anywhere but at the end of the query are ignored
+    expectSearch(index, "statue with chariot", 1, 2);
+    expectSearch(index, "the sarc", 2, 4);
+    expectSearch(index, "of the ", 0, -1);
+
+    // Prefixes and ranking: title words first
+    expectSearch(index, "sarc", 2, 4);
+    expectSearch(index, "roman mar", 2, -1);
+    expectSearch(index, "tomb", 2, 3);
+    expectSearch(index, "hittite", 1, 2);
+    expectSearch(index, "pyramid", 0, -1);
+}
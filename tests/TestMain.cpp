@@ -0,0 +1,27 @@
+// MuseumTests: runs every suite, prints every failed check and returns 1 if there was one
+#include "TestMain.h"
+#include <iostream>
+
+static int checks = 0;
+static int failures = 0;
+
+void check(bool ok, const std::string& what) {
+    checks++;
+    if (ok) return;
+    std::cerr << "FAILED: " << what << std::endl;
+    failures++;
+}
+
+int main() {
+    testAssetPack();
+    testAudioEngine();
+    testExhibitCatalog();
+    testSearchIndex();
+    testNavGrid();
+    testObjParser();
+    testTourPlanner();
+
+    if (failures == 0) std::cout << "MuseumTests: all " << checks << " checks passed" << std::endl;
+    else std::cout << "MuseumTests: " << failures << " of " << checks << " checks failed" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,18 @@
+#ifndef TESTMAIN_H
+#define TESTMAIN_H
+
+#include <string>
+
+// Records a check: prints what failed when ok is false
+void check(bool ok, const std::string& what);
+
+// Test suites, one per file of tests/
+void testAssetPack();
+void testAudioEngine();
+void testExhibitCatalog();
+void testSearchIndex();
+void testNavGrid();
+void testObjParser();
+void testTourPlanner();
+
+#endif
@@ -0,0 +1,119 @@
+// Checks of the tour ordering (TourPlanner) over straight-line distances: every stop once,
+// 2-opt and Or-opt never lengthen the nearest neighbour tour, and replanning after a detour
+#include "TestMain.h"
+#include "TourPlanner.h"
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+// Same sequence on every platform
+static float nextRandom(unsigned int& state) {
+    state = state * 1664525u + 1013904223u;
+    return (state >> 8) * (1.0f / 16777216.0f);
+}
+
+static float floorDistance(const glm::vec3& a, const glm::vec3& b) {
+    return std::sqrt((a.x - b.x) * (a.x - b.x) + (a.z - b.z) * (a.z - b.z));
+}
+
+// Length of the nearest neighbour tour the planner starts from
+static float nearestNeighbourLength(const glm::vec3& start, const std::vector<glm::vec3>& stops) {
+    std::vector<bool> used(stops.size(), false);
+    glm::vec3 current = start;
+    float length = 0.0f;
+    for (size_t n = 0; n < stops.size(); n++) {
+        int best = -1;
+        for (size_t s = 0; s < stops.size(); s++) {
+            if (!used[s] && (best < 0 || floorDistance(current, stops[s]) < floorDistance(current, stops[best]))) best = (int)s;
+        }
+        used[best] = true;
+        length += floorDistance(current, stops[best]);
+        current = stops[best];
+    }
+    return length;
+}
+
+// Shortest open tour over every order of the stops
+static float optimalLength(const glm::vec3& start, const std::vector<glm::vec3>& stops) {
+    std::vector<int> order;
+    for (size_t i = 0; i < stops.size(); i++) order.push_back((int)i);
+    float best = -1.0f;
+    do {
+        float length = floorDistance(start, stops[order[0]]);
+        for (size_t i = 1; i < order.size(); i++) length += floorDistance(stops[order[i - 1]], stops[order[i]]);
+        if (best < 0.0f || length < best) best = length;
+    } while (std::next_permutation(order.begin(), order.end()));
+    return best;
+}
+
+// Every stop of the list exactly once
+static bool visitsEachOnce(const std::vector<int>& order, int stops) {
+    std::vector<int> sorted = order;
+    std::sort(sorted.begin(), sorted.end());
+    if ((int)sorted.size() != stops) return false;
+    for (int i = 0; i < stops; i++) {
+        if (sorted[i] != i) return false;
+    }
+    return true;
+}
+
+static void testRandomTours() {
+    unsigned int random = 7u;
+    for (int tour = 0; tour < 50; tour++) {
+        std::string name = "tour " + std::to_string(tour) + ": ";
+        glm::vec3 start(nextRandom(random) * 20.0f, 0.0f, nextRandom(random) * 20.0f);
+        std::vector<glm::vec3> stops;
+        for (int i = 0; i < 8; i++) stops.push_back(glm::vec3(nextRandom(random) * 20.0f, 0.0f, nextRandom(random) * 20.0f));
+
+        TourPlanner planner(nullptr);
+        planner.plan(start, stops);
+        const std::vector<int>& order = planner.getOrder();
+        check(visitsEachOnce(order, (int)stops.size()), name + "every stop once");
+        check(std::fabs(planner.getTourLength() - planner.getLength(order)) < 1e-3f, name + "reported length is the order's length");
+        check(planner.getTourLength() <= nearestNeighbourLength(start, stops) + 1e-3f, name + "not longer than nearest neighbour");
+        check(planner.getTourLength() <= optimalLength(start, stops) * 1.1f, name + "within 10% of the shortest tour");
+    }
+}
+
+static void testLine() {
+    // Stops on a line, listed out of order: the shortest tour walks it once from the start
+    std::vector<glm::vec3> stops;
+    int positions[] = { 7, 2, 9, 4, 1, 8, 3, 6, 5 };
+    for (int i = 0; i < 9; i++) stops.push_back(glm::vec3((float)positions[i], 0.0f, 0.0f));
+    TourPlanner planner(nullptr);
+    planner.plan(glm::vec3(0.0f), stops);
+    check(std::fabs(planner.getTourLength() - 9.0f) < 1e-3f, "tour: stops on a line are walked once");
+
+    std::vector<int> listOrder;
+    for (int i = 0; i < 9; i++) listOrder.push_back(i);
+    check(planner.getLength(listOrder) > planner.getTourLength(), "tour: list order is longer than the plan");
+}
+
+static void testReplan() {
+    unsigned int random = 11u;
+    std::vector<glm::vec3> stops;
+    for (int i = 0; i < 12; i++) stops.push_back(glm::vec3(nextRandom(random) * 20.0f, 0.0f, nextRandom(random) * 20.0f));
+    TourPlanner planner(nullptr);
+    planner.plan(glm::vec3(0.0f), stops);
+
+    // The first three stops of the tour were visited, then the robot was sent elsewhere
+    std::vector<bool> visited(stops.size(), false);
+    std::vector<int> remaining;
+    for (size_t i = 0; i < planner.getOrder().size(); i++) {
+        if (i < 3) visited[planner.getOrder()[i]] = true;
+        else remaining.push_back(planner.getOrder()[i]);
+    }
+    planner.replanFrom(glm::vec3(20.0f, 0.0f, 0.0f), visited);
+    const std::vector<int>& order = planner.getOrder();
+    bool skipsVisited = order.size() == remaining.size();
+    for (size_t i = 0; i < order.size(); i++) skipsVisited = skipsVisited && !visited[order[i]];
+    check(skipsVisited, "replan: only the stops not visited are left");
+    check(planner.getTourLength() <= planner.getLength(remaining) + 1e-3f, "replan: not longer than the old order from the new position");
+}
+
+void testTourPlanner() {
+    testRandomTours();
+    testLine();
+    testReplan();
+}
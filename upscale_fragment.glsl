@@ -0,0 +1,44 @@
+#version 330 core
+
+// Output color of the fragment
+out vec4 FragColor;
+
+// Screen position from the vertex shader (0..1)
+in vec2 TexCoord;
+
+// Uniforms (passed in from the CPU program)
+uniform sampler2D sceneTexture;  // Scene rendered at reduced resolution
+uniform vec2 uvScale;            // Part of the texture that holds the scene
+uniform vec2 texelSize;          // 1 / texture size
+uniform float sharpness;         // 0 = plain bilinear, 1 = strongest sharpening
+
+// Samples the scene without bleeding past the rendered area
+vec3 sampleScene(vec2 uv) {
+    return texture(sceneTexture, clamp(uv, vec2(0.0), uvScale - 0.5 * texelSize)).rgb;
+}
+
+void main() {
+    vec2 uv = TexCoord * uvScale;
+
+    // ----- Bilinear upscale -----
+    vec3 center = sampleScene(uv);
+
+    // ----- Contrast adaptive sharpening -----
+    // Cross neighborhood in the low resolution image
+    vec3 north = sampleScene(uv + vec2(0.0, texelSize.y));
+    vec3 south = sampleScene(uv - vec2(0.0, texelSize.y));
+    vec3 east  = sampleScene(uv + vec2(texelSize.x, 0.0));
+    vec3 west  = sampleScene(uv - vec2(texelSize.x, 0.0));
+
+    // Sharpen less where the local contrast is already high to avoid halos
+    vec3 minColor = min(center, min(min(north, south), min(east, west)));
+    vec3 maxColor = max(center, max(max(north, south), max(east, west)));
+    vec3 contrast = maxColor - minColor;
+    vec3 amount = sharpness * 0.25 * clamp(1.0 - contrast, 0.0, 1.0);
+
+    // Unsharp mask: push the center away from the average of its neighbors
+    vec3 average = (north + south + east + west) * 0.25;
+    vec3 result = clamp(center + (center - average) * amount * 4.0, minColor, maxColor);
+
+    FragColor = vec4(result, 1.0);
+}
@@ -0,0 +1,11 @@
+#version 330 core
+
+// Texture coordinate of the fullscreen triangle
+out vec2 TexCoord;
+
+void main() {
+    // Three vertices that cover the whole screen: (-1,-1), (3,-1), (-1,3)
+    vec2 pos = vec2((gl_VertexID == 1) ? 3.0 : -1.0, (gl_VertexID == 2) ? 3.0 : -1.0);
+    TexCoord = pos * 0.5 + 0.5;
+    gl_Position = vec4(pos, 0.0, 1.0);
+}
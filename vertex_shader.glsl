@@ -3,16 +3,29 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 
-uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+// Per-object data streamed every frame (see StreamBuffer.h): 5 texels per object, the
+// columns of the model matrix, then the color. Instance i of a draw is the i-th object
+// from the texel objectOffset.
+uniform samplerBuffer objects;
+uniform int objectOffset;
 
 out vec3 FragPos;
 out vec3 Normal;
+flat out vec3 ObjectColor;
 
 void main() {
+    int texel = objectOffset + gl_InstanceID * 5;
+    mat4 model = mat4(
+        texelFetch(objects, texel),
+        texelFetch(objects, texel + 1),
+        texelFetch(objects, texel + 2),
+        texelFetch(objects, texel + 3));
+    ObjectColor = texelFetch(objects, texel + 4).rgb;
+
     FragPos = vec3(model * vec4(aPos, 1.0));
     Normal = mat3(transpose(inverse(model))) * aNormal;
     gl_Position = projection * view * vec4(FragPos, 1.0);
-}
\ No newline at end of file
+}